@@ -0,0 +1,1159 @@
+/**
+ * @file css-selector.c
+ * @date 2022/12/16
+ * @brief The CSS selector engine and the element indexes of the documents
+ *      based on the DOM of PurC.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc-document.h"
+#include "purc-errors.h"
+#include "purc-html.h"
+
+#include "private/document.h"
+#include "private/hashtable.h"
+#include "private/map.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+ * The selectors supported (a subset of CSS Selectors Level 3):
+ *
+ *  - the type selector `tag` and the universal selector `*`;
+ *  - `#id`, `.class`;
+ *  - `[attr]`, `[attr=val]`, `[attr~=val]`, `[attr|=val]`, `[attr^=val]`,
+ *    `[attr$=val]`, and `[attr*=val]`, with the optional flag ` i`;
+ *  - the combinators: descendant (whitespace), `>`, `+`, and `~`;
+ *  - the selector list separated by `,`.
+ */
+
+enum css_simple_type {
+    CSS_SIMPLE_ID,
+    CSS_SIMPLE_CLASS,
+    CSS_SIMPLE_ATTR,
+};
+
+enum css_attr_op {
+    CSS_ATTR_EXISTS,        // [attr]
+    CSS_ATTR_EQUAL,         // [attr=val]
+    CSS_ATTR_INCLUDES,      // [attr~=val]
+    CSS_ATTR_DASH,          // [attr|=val]
+    CSS_ATTR_PREFIX,        // [attr^=val]
+    CSS_ATTR_SUFFIX,        // [attr$=val]
+    CSS_ATTR_SUBSTRING,     // [attr*=val]
+};
+
+enum css_combinator {
+    CSS_COMB_NONE,          // the leftmost compound selector
+    CSS_COMB_DESCENDANT,
+    CSS_COMB_CHILD,
+    CSS_COMB_ADJACENT,      // `+`
+    CSS_COMB_SIBLING,       // `~`
+};
+
+struct css_simple {
+    enum css_simple_type    type;
+    enum css_attr_op        op;
+    bool                    icase;
+
+    /* the id, the class, or the attribute name */
+    char                   *name;
+    size_t                  name_len;
+
+    /* the attribute value */
+    char                   *value;
+    size_t                  value_len;
+};
+
+struct css_compound {
+    /* the combinator between this one and the previous compound */
+    enum css_combinator     comb;
+
+    /* the type selector; NULL for `*` or none */
+    char                   *tag;
+    size_t                  tag_len;
+
+    struct css_simple      *simples;
+    size_t                  nr_simples;
+};
+
+struct css_complex {
+    struct css_compound    *compounds;
+    size_t                  nr_compounds;
+};
+
+struct pcdoc_selector {
+    struct css_complex     *complexes;
+    size_t                  nr_complexes;
+};
+
+/* the maximal number of the candidates from the indexes to be sorted
+   in the document order; a walk of the subtree is used for more ones */
+#define MAX_SORTED_CANDIDATES       64
+
+struct pcdoc_elem_index {
+    /* id -> the set of elements (struct pcutils_map) */
+    struct pchash_table    *ids;
+
+    /* class -> the set of elements (struct pcutils_map) */
+    struct pchash_table    *classes;
+};
+
+/* ---------------------------------------------------------------------- */
+/* The parser */
+
+struct css_parser {
+    const char *p;
+    bool        failed;
+};
+
+static inline bool is_css_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static inline bool is_ident_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '-' || c == '_' ||
+        (unsigned char)c >= 0x80 || c == '\\';
+}
+
+static inline void skip_ws(struct css_parser *parser)
+{
+    while (is_css_ws(*parser->p))
+        parser->p++;
+}
+
+static size_t utf8_encode(uint32_t uc, char *buf)
+{
+    if (uc == 0 || uc > 0x10FFFF || (uc >= 0xD800 && uc <= 0xDFFF))
+        uc = 0xFFFD;
+
+    if (uc < 0x80) {
+        buf[0] = (char)uc;
+        return 1;
+    }
+    else if (uc < 0x800) {
+        buf[0] = (char)(0xC0 | (uc >> 6));
+        buf[1] = (char)(0x80 | (uc & 0x3F));
+        return 2;
+    }
+    else if (uc < 0x10000) {
+        buf[0] = (char)(0xE0 | (uc >> 12));
+        buf[1] = (char)(0x80 | ((uc >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (uc & 0x3F));
+        return 3;
+    }
+
+    buf[0] = (char)(0xF0 | (uc >> 18));
+    buf[1] = (char)(0x80 | ((uc >> 12) & 0x3F));
+    buf[2] = (char)(0x80 | ((uc >> 6) & 0x3F));
+    buf[3] = (char)(0x80 | (uc & 0x3F));
+    return 4;
+}
+
+/* Reads an escape after the backslash into buf; returns the bytes written. */
+static size_t read_escape(struct css_parser *parser, char *buf)
+{
+    const char *p = parser->p;
+
+    if (*p == '\0' || *p == '\n') {
+        parser->failed = true;
+        return 0;
+    }
+
+    if (isxdigit((unsigned char)*p)) {
+        uint32_t uc = 0;
+        int n = 0;
+        while (n < 6 && isxdigit((unsigned char)*p)) {
+            char c = *p++;
+            uc = uc * 16 + (isdigit((unsigned char)c) ? c - '0' :
+                    (tolower((unsigned char)c) - 'a' + 10));
+            n++;
+        }
+
+        /* a whitespace terminates the hexadecimal escape */
+        if (is_css_ws(*p))
+            p++;
+
+        parser->p = p;
+        return utf8_encode(uc, buf);
+    }
+
+    buf[0] = *p;
+    parser->p = p + 1;
+    return 1;
+}
+
+/* Skips an escape after the backslash by the rules of read_escape(). */
+static const char *skip_escape(const char *p)
+{
+    if (isxdigit((unsigned char)*p)) {
+        int n = 0;
+        while (n < 6 && isxdigit((unsigned char)*p)) {
+            p++;
+            n++;
+        }
+
+        if (is_css_ws(*p))
+            p++;
+        return p;
+    }
+
+    return *p ? p + 1 : p;
+}
+
+/* Reads an identifier (or the unquoted value); returns a new string. */
+static char *read_ident(struct css_parser *parser, size_t *len)
+{
+    const char *start = parser->p;
+    const char *p = start;
+    while (is_ident_char(*p)) {
+        if (*p == '\\')
+            p = skip_escape(p + 1);
+        else
+            p++;
+    }
+
+    if (p == start) {
+        parser->failed = true;
+        return NULL;
+    }
+
+    /* an escape takes at most 4 bytes after the decoding */
+    char *ident = malloc((p - start) * 4 + 1);
+    if (ident == NULL) {
+        parser->failed = true;
+        return NULL;
+    }
+
+    size_t n = 0;
+    while (is_ident_char(*parser->p)) {
+        if (*parser->p == '\\') {
+            parser->p++;
+            n += read_escape(parser, ident + n);
+            if (parser->failed) {
+                free(ident);
+                return NULL;
+            }
+        }
+        else {
+            ident[n++] = *parser->p++;
+        }
+    }
+
+    ident[n] = '\0';
+    *len = n;
+    return ident;
+}
+
+/* Reads a quoted string; returns a new string. */
+static char *read_string(struct css_parser *parser, size_t *len)
+{
+    char quote = *parser->p++;
+    const char *end = parser->p;
+    while (*end && *end != quote) {
+        if (*end == '\\' && end[1])
+            end++;
+        end++;
+    }
+
+    if (*end != quote) {
+        parser->failed = true;
+        return NULL;
+    }
+
+    char *str = malloc((end - parser->p) * 4 + 1);
+    if (str == NULL) {
+        parser->failed = true;
+        return NULL;
+    }
+
+    size_t n = 0;
+    while (*parser->p != quote) {
+        if (*parser->p == '\\') {
+            parser->p++;
+            /* an escaped newline is ignored */
+            if (*parser->p == '\n') {
+                parser->p++;
+                continue;
+            }
+            n += read_escape(parser, str + n);
+            if (parser->failed) {
+                free(str);
+                return NULL;
+            }
+        }
+        else {
+            str[n++] = *parser->p++;
+        }
+    }
+    parser->p++;
+
+    str[n] = '\0';
+    *len = n;
+    return str;
+}
+
+static inline void str_to_lower(char *str)
+{
+    for (; *str; str++)
+        *str = tolower((unsigned char)*str);
+}
+
+static struct css_simple *
+new_simple(struct css_parser *parser, struct css_compound *compound)
+{
+    struct css_simple *simples = realloc(compound->simples,
+            sizeof(*simples) * (compound->nr_simples + 1));
+    if (simples == NULL) {
+        parser->failed = true;
+        return NULL;
+    }
+
+    compound->simples = simples;
+    struct css_simple *simple = simples + compound->nr_simples++;
+    memset(simple, 0, sizeof(*simple));
+    return simple;
+}
+
+static void parse_attr(struct css_parser *parser, struct css_simple *simple)
+{
+    simple->type = CSS_SIMPLE_ATTR;
+
+    skip_ws(parser);
+    simple->name = read_ident(parser, &simple->name_len);
+    if (simple->name == NULL)
+        return;
+    /* the names of the attributes are case-insensitive in HTML */
+    str_to_lower(simple->name);
+
+    skip_ws(parser);
+    const char *p = parser->p;
+    if (*p == ']') {
+        parser->p++;
+        simple->op = CSS_ATTR_EXISTS;
+        return;
+    }
+
+    switch (*p) {
+    case '=':
+        simple->op = CSS_ATTR_EQUAL;
+        break;
+    case '~':
+        simple->op = CSS_ATTR_INCLUDES;
+        break;
+    case '|':
+        simple->op = CSS_ATTR_DASH;
+        break;
+    case '^':
+        simple->op = CSS_ATTR_PREFIX;
+        break;
+    case '$':
+        simple->op = CSS_ATTR_SUFFIX;
+        break;
+    case '*':
+        simple->op = CSS_ATTR_SUBSTRING;
+        break;
+    default:
+        parser->failed = true;
+        return;
+    }
+
+    if (simple->op == CSS_ATTR_EQUAL)
+        parser->p++;
+    else if (p[1] == '=')
+        parser->p += 2;
+    else {
+        parser->failed = true;
+        return;
+    }
+
+    skip_ws(parser);
+    if (*parser->p == '"' || *parser->p == '\'')
+        simple->value = read_string(parser, &simple->value_len);
+    else
+        simple->value = read_ident(parser, &simple->value_len);
+    if (simple->value == NULL)
+        return;
+
+    skip_ws(parser);
+    if (*parser->p == 'i' || *parser->p == 'I') {
+        simple->icase = true;
+        parser->p++;
+        skip_ws(parser);
+    }
+
+    if (*parser->p != ']') {
+        parser->failed = true;
+        return;
+    }
+    parser->p++;
+}
+
+/* Parses a compound selector; returns false if there is none. */
+static bool
+parse_compound(struct css_parser *parser, struct css_compound *compound)
+{
+    const char *start = parser->p;
+
+    if (*parser->p == '*') {
+        parser->p++;
+    }
+    else if (is_ident_char(*parser->p)) {
+        compound->tag = read_ident(parser, &compound->tag_len);
+        if (compound->tag == NULL)
+            return false;
+        /* the tag names are case-insensitive in HTML */
+        str_to_lower(compound->tag);
+    }
+
+    while (!parser->failed) {
+        char c = *parser->p;
+        struct css_simple *simple;
+
+        if (c == '#' || c == '.') {
+            parser->p++;
+            simple = new_simple(parser, compound);
+            if (simple == NULL)
+                break;
+            simple->type = (c == '#') ? CSS_SIMPLE_ID : CSS_SIMPLE_CLASS;
+            simple->name = read_ident(parser, &simple->name_len);
+        }
+        else if (c == '[') {
+            parser->p++;
+            simple = new_simple(parser, compound);
+            if (simple == NULL)
+                break;
+            parse_attr(parser, simple);
+        }
+        else {
+            break;
+        }
+    }
+
+    return !parser->failed && parser->p > start;
+}
+
+static void
+parse_complex(struct css_parser *parser, struct css_complex *complex)
+{
+    enum css_combinator comb = CSS_COMB_NONE;
+
+    for (;;) {
+        struct css_compound *compounds = realloc(complex->compounds,
+                sizeof(*compounds) * (complex->nr_compounds + 1));
+        if (compounds == NULL) {
+            parser->failed = true;
+            return;
+        }
+
+        complex->compounds = compounds;
+        struct css_compound *compound;
+        compound = compounds + complex->nr_compounds++;
+        memset(compound, 0, sizeof(*compound));
+        compound->comb = comb;
+
+        if (!parse_compound(parser, compound)) {
+            parser->failed = true;
+            return;
+        }
+
+        const char *p = parser->p;
+        skip_ws(parser);
+        switch (*parser->p) {
+        case '>':
+            comb = CSS_COMB_CHILD;
+            break;
+        case '+':
+            comb = CSS_COMB_ADJACENT;
+            break;
+        case '~':
+            comb = CSS_COMB_SIBLING;
+            break;
+        case ',':
+        case '\0':
+            return;
+        default:
+            if (parser->p == p) {
+                /* an unsupported character, e.g., `:` */
+                parser->failed = true;
+                return;
+            }
+            comb = CSS_COMB_DESCENDANT;
+            continue;
+        }
+
+        parser->p++;
+        skip_ws(parser);
+    }
+}
+
+struct pcdoc_selector *
+pcdoc_selector_new(const char *selector)
+{
+    struct pcdoc_selector *sel = calloc(1, sizeof(*sel));
+    if (sel == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    struct css_parser parser = { selector, false };
+    for (;;) {
+        struct css_complex *complexes = realloc(sel->complexes,
+                sizeof(*complexes) * (sel->nr_complexes + 1));
+        if (complexes == NULL) {
+            pcdoc_selector_delete(sel);
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
+
+        sel->complexes = complexes;
+        struct css_complex *complex = complexes + sel->nr_complexes++;
+        memset(complex, 0, sizeof(*complex));
+
+        skip_ws(&parser);
+        parse_complex(&parser, complex);
+        if (parser.failed)
+            break;
+
+        if (*parser.p == '\0')
+            return sel;
+
+        /* skip `,` */
+        parser.p++;
+    }
+
+    PC_DEBUG("bad CSS selector: %s\n", selector);
+    pcdoc_selector_delete(sel);
+    purc_set_error(PURC_ERROR_INVALID_VALUE);
+    return NULL;
+}
+
+void
+pcdoc_selector_delete(struct pcdoc_selector *selector)
+{
+    for (size_t i = 0; i < selector->nr_complexes; i++) {
+        struct css_complex *complex = selector->complexes + i;
+
+        for (size_t j = 0; j < complex->nr_compounds; j++) {
+            struct css_compound *compound = complex->compounds + j;
+
+            for (size_t k = 0; k < compound->nr_simples; k++) {
+                free(compound->simples[k].name);
+                free(compound->simples[k].value);
+            }
+            free(compound->simples);
+            free(compound->tag);
+        }
+        free(complex->compounds);
+    }
+
+    free(selector->complexes);
+    free(selector);
+}
+
+/* ---------------------------------------------------------------------- */
+/* The matcher */
+
+static inline pcdom_element_t *parent_element(pcdom_element_t *elem)
+{
+    pcdom_node_t *node = pcdom_interface_node(elem)->parent;
+    if (node && node->type == PCDOM_NODE_TYPE_ELEMENT)
+        return pcdom_interface_element(node);
+    return NULL;
+}
+
+static inline pcdom_element_t *prev_element(pcdom_element_t *elem)
+{
+    pcdom_node_t *node = pcdom_interface_node(elem)->prev;
+    while (node && node->type != PCDOM_NODE_TYPE_ELEMENT)
+        node = node->prev;
+    return pcdom_interface_element(node);
+}
+
+/* Checks whether the whitespace-separated list contains the token. */
+static bool
+has_token(const char *list, size_t list_len, const char *token,
+        size_t token_len, bool icase)
+{
+    const char *end = list + list_len;
+
+    while (list < end) {
+        while (list < end && is_css_ws(*list))
+            list++;
+
+        const char *start = list;
+        while (list < end && !is_css_ws(*list))
+            list++;
+
+        if ((size_t)(list - start) == token_len && (icase ?
+                    strncasecmp(start, token, token_len) :
+                    strncmp(start, token, token_len)) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static inline bool
+match_bytes(const char *s, const char *t, size_t len, bool icase)
+{
+    return (icase ? strncasecmp(s, t, len) : strncmp(s, t, len)) == 0;
+}
+
+static bool
+match_attr(const struct css_simple *simple, pcdom_element_t *elem)
+{
+    size_t len;
+    const char *val = (const char *)pcdom_element_get_attribute(elem,
+            (const unsigned char *)simple->name, simple->name_len, &len);
+    if (val == NULL)
+        return false;
+
+    const char *ref = simple->value;
+    size_t ref_len = simple->value_len;
+    bool icase = simple->icase;
+
+    switch (simple->op) {
+    case CSS_ATTR_EXISTS:
+        return true;
+
+    case CSS_ATTR_EQUAL:
+        return len == ref_len && match_bytes(val, ref, len, icase);
+
+    case CSS_ATTR_INCLUDES:
+        return ref_len > 0 && has_token(val, len, ref, ref_len, icase);
+
+    case CSS_ATTR_DASH:
+        return (len == ref_len || (len > ref_len && val[ref_len] == '-')) &&
+            match_bytes(val, ref, ref_len, icase);
+
+    case CSS_ATTR_PREFIX:
+        return ref_len > 0 && len >= ref_len &&
+            match_bytes(val, ref, ref_len, icase);
+
+    case CSS_ATTR_SUFFIX:
+        return ref_len > 0 && len >= ref_len &&
+            match_bytes(val + len - ref_len, ref, ref_len, icase);
+
+    case CSS_ATTR_SUBSTRING:
+        if (ref_len == 0)
+            return false;
+        for (size_t i = 0; i + ref_len <= len; i++) {
+            if (match_bytes(val + i, ref, ref_len, icase))
+                return true;
+        }
+        return false;
+    }
+
+    return false;
+}
+
+static bool
+match_compound(const struct css_compound *compound, pcdom_element_t *elem)
+{
+    if (compound->tag) {
+        size_t len;
+        const char *name = (const char *)pcdom_element_local_name(elem, &len);
+        if (len != compound->tag_len ||
+                strncasecmp(name, compound->tag, len))
+            return false;
+    }
+
+    for (size_t i = 0; i < compound->nr_simples; i++) {
+        const struct css_simple *simple = compound->simples + i;
+        const char *val;
+        size_t len;
+
+        switch (simple->type) {
+        case CSS_SIMPLE_ID:
+            val = (const char *)pcdom_element_id(elem, &len);
+            if (val == NULL || len != simple->name_len ||
+                    memcmp(val, simple->name, len))
+                return false;
+            break;
+
+        case CSS_SIMPLE_CLASS:
+            val = (const char *)pcdom_element_class(elem, &len);
+            if (val == NULL || !has_token(val, len,
+                        simple->name, simple->name_len, false))
+                return false;
+            break;
+
+        case CSS_SIMPLE_ATTR:
+            if (!match_attr(simple, elem))
+                return false;
+            break;
+        }
+    }
+
+    return true;
+}
+
+/* Matches the compounds of the complex selector from right to left. */
+static bool
+match_complex(const struct css_complex *complex, size_t idx,
+        pcdom_element_t *elem)
+{
+    const struct css_compound *compound = complex->compounds + idx;
+    if (!match_compound(compound, elem))
+        return false;
+
+    if (idx == 0)
+        return true;
+
+    switch (compound->comb) {
+    case CSS_COMB_DESCENDANT:
+        while ((elem = parent_element(elem))) {
+            if (match_complex(complex, idx - 1, elem))
+                return true;
+        }
+        break;
+
+    case CSS_COMB_CHILD:
+        elem = parent_element(elem);
+        return elem && match_complex(complex, idx - 1, elem);
+
+    case CSS_COMB_ADJACENT:
+        elem = prev_element(elem);
+        return elem && match_complex(complex, idx - 1, elem);
+
+    case CSS_COMB_SIBLING:
+        while ((elem = prev_element(elem))) {
+            if (match_complex(complex, idx - 1, elem))
+                return true;
+        }
+        break;
+
+    case CSS_COMB_NONE:
+        break;
+    }
+
+    return false;
+}
+
+bool
+pcdoc_selector_match(struct pcdoc_selector *selector, pcdoc_element_t elem)
+{
+    pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+
+    for (size_t i = 0; i < selector->nr_complexes; i++) {
+        const struct css_complex *complex = selector->complexes + i;
+        if (match_complex(complex, complex->nr_compounds - 1, dom_elem))
+            return true;
+    }
+
+    return false;
+}
+
+/* ---------------------------------------------------------------------- */
+/* The indexes */
+
+static int comp_elem(const void *key1, const void *key2)
+{
+    if (key1 < key2)
+        return -1;
+    return key1 > key2;
+}
+
+static void free_index_entry(struct pchash_entry *entry)
+{
+    free(pchash_entry_k(entry));
+    pcutils_map_destroy((pcutils_map *)pchash_entry_v(entry));
+}
+
+static void
+index_add_name(struct pchash_table *table, const char *name, size_t len,
+        pcdom_element_t *elem)
+{
+    char buf[64];
+    char *key = (len < sizeof(buf)) ? buf : malloc(len + 1);
+    if (key == NULL)
+        return;
+    memcpy(key, name, len);
+    key[len] = '\0';
+
+    pcutils_map *set;
+    if (!pchash_table_lookup_ex(table, key, (void **)&set)) {
+        set = pcutils_map_create(NULL, NULL, NULL, NULL, comp_elem, false);
+        char *dup = strdup(key);
+        if (set == NULL || dup == NULL ||
+                pchash_table_insert(table, dup, set)) {
+            if (set)
+                pcutils_map_destroy(set);
+            free(dup);
+            set = NULL;
+        }
+    }
+
+    if (set)
+        pcutils_map_find_replace_or_insert(set, elem, NULL, NULL);
+
+    if (key != buf)
+        free(key);
+}
+
+static void
+index_remove_name(struct pchash_table *table, const char *name, size_t len,
+        pcdom_element_t *elem)
+{
+    char buf[64];
+    char *key = (len < sizeof(buf)) ? buf : malloc(len + 1);
+    if (key == NULL)
+        return;
+    memcpy(key, name, len);
+    key[len] = '\0';
+
+    struct pchash_entry *entry = pchash_table_lookup_entry(table, key);
+    if (entry) {
+        pcutils_map *set = (pcutils_map *)pchash_entry_v(entry);
+        pcutils_map_erase(set, elem);
+        if (pcutils_map_get_size(set) == 0)
+            pchash_table_delete_entry(table, entry);
+    }
+
+    if (key != buf)
+        free(key);
+}
+
+typedef void (*index_name_fn)(struct pchash_table *table,
+        const char *name, size_t len, pcdom_element_t *elem);
+
+static void
+index_element(struct pcdoc_elem_index *index, pcdom_element_t *elem,
+        index_name_fn fn)
+{
+    const char *val;
+    size_t len;
+
+    val = (const char *)pcdom_element_id(elem, &len);
+    if (val && len > 0)
+        fn(index->ids, val, len, elem);
+
+    val = (const char *)pcdom_element_class(elem, &len);
+    if (val) {
+        const char *end = val + len;
+        while (val < end) {
+            while (val < end && is_css_ws(*val))
+                val++;
+
+            const char *start = val;
+            while (val < end && !is_css_ws(*val))
+                val++;
+
+            if (val > start)
+                fn(index->classes, start, val - start, elem);
+        }
+    }
+}
+
+static void
+index_subtree(struct pcdoc_elem_index *index, pcdom_element_t *root,
+        index_name_fn fn)
+{
+    pcdom_node_t *top = pcdom_interface_node(root);
+    pcdom_node_t *node = top;
+
+    /* walk the subtree in the pre-order without the recursion */
+    while (node) {
+        if (node->type == PCDOM_NODE_TYPE_ELEMENT)
+            index_element(index, pcdom_interface_element(node), fn);
+
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+
+        while (node != top && node->next == NULL)
+            node = node->parent;
+        node = (node == top) ? NULL : node->next;
+    }
+}
+
+struct pcdoc_elem_index *
+pcdoc_elem_index_new(pcdoc_element_t root)
+{
+    struct pcdoc_elem_index *index = calloc(1, sizeof(*index));
+    if (index == NULL)
+        goto failed;
+
+    index->ids = pchash_kstr_table_new(64, free_index_entry);
+    index->classes = pchash_kstr_table_new(64, free_index_entry);
+    if (index->ids == NULL || index->classes == NULL)
+        goto failed;
+
+    if (root)
+        index_subtree(index, pcdom_interface_element(root), index_add_name);
+    return index;
+
+failed:
+    if (index)
+        pcdoc_elem_index_delete(index);
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return NULL;
+}
+
+void
+pcdoc_elem_index_delete(struct pcdoc_elem_index *index)
+{
+    if (index->ids)
+        pchash_table_free(index->ids);
+    if (index->classes)
+        pchash_table_free(index->classes);
+    free(index);
+}
+
+void
+pcdoc_elem_index_add(struct pcdoc_elem_index *index, pcdoc_element_t elem,
+        bool subtree)
+{
+    pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+    if (subtree)
+        index_subtree(index, dom_elem, index_add_name);
+    else
+        index_element(index, dom_elem, index_add_name);
+}
+
+void
+pcdoc_elem_index_remove(struct pcdoc_elem_index *index, pcdoc_element_t elem,
+        bool subtree)
+{
+    pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+    if (subtree)
+        index_subtree(index, dom_elem, index_remove_name);
+    else
+        index_element(index, dom_elem, index_remove_name);
+}
+
+/* ---------------------------------------------------------------------- */
+/* The selection */
+
+static unsigned
+node_depth(pcdom_node_t *node)
+{
+    unsigned depth = 0;
+    while ((node = node->parent))
+        depth++;
+    return depth;
+}
+
+/* Compares the positions of two different nodes in the document order. */
+static int
+compare_position(pcdom_node_t *a, pcdom_node_t *b)
+{
+    unsigned depth_a = node_depth(a);
+    unsigned depth_b = node_depth(b);
+
+    /* an ancestor precedes its descendants */
+    for (; depth_a > depth_b; depth_a--) {
+        a = a->parent;
+        if (a == b)
+            return 1;
+    }
+    for (; depth_b > depth_a; depth_b--) {
+        b = b->parent;
+        if (b == a)
+            return -1;
+    }
+
+    while (a->parent != b->parent) {
+        a = a->parent;
+        b = b->parent;
+    }
+
+    /* now a and b are the siblings; search in both directions */
+    pcdom_node_t *next = a->next, *prev = a->prev;
+    while (next || prev) {
+        if (next == b)
+            return -1;
+        if (prev == b)
+            return 1;
+        next = next ? next->next : NULL;
+        prev = prev ? prev->prev : NULL;
+    }
+
+    return 0;
+}
+
+static int comp_position(const void *v1, const void *v2)
+{
+    pcdom_node_t *a = *(pcdom_node_t **)v1;
+    pcdom_node_t *b = *(pcdom_node_t **)v2;
+    if (a == b)
+        return 0;
+    return compare_position(a, b);
+}
+
+static inline bool
+is_in_scope(pcdom_element_t *elem, pcdom_element_t *scope)
+{
+    pcdom_node_t *node = pcdom_interface_node(elem);
+    for (; node; node = node->parent) {
+        if (node == pcdom_interface_node(scope))
+            return true;
+    }
+    return false;
+}
+
+/* Returns the set of the elements from the indexes for the complex
+   selector, or NULL if the rightmost compound has no id or class. */
+static pcutils_map *
+index_candidates(struct pcdoc_elem_index *index,
+        const struct css_complex *complex, bool *none)
+{
+    const struct css_compound *compound;
+    compound = complex->compounds + complex->nr_compounds - 1;
+
+    const struct css_simple *key = NULL;
+    for (size_t i = 0; i < compound->nr_simples; i++) {
+        if (compound->simples[i].type == CSS_SIMPLE_ID) {
+            key = compound->simples + i;
+            break;
+        }
+        else if (key == NULL && compound->simples[i].type == CSS_SIMPLE_CLASS)
+            key = compound->simples + i;
+    }
+
+    *none = false;
+    if (key == NULL)
+        return NULL;
+
+    void *set;
+    if (!pchash_table_lookup_ex(key->type == CSS_SIMPLE_ID ?
+                index->ids : index->classes, key->name, &set)) {
+        *none = true;
+        return NULL;
+    }
+
+    return (pcutils_map *)set;
+}
+
+struct walk_args {
+    struct pcdoc_selector  *selector;
+    struct pcutils_arrlist *found;
+    size_t                  max_found;
+};
+
+static int
+select_by_walking(struct walk_args *args, pcdom_element_t *scope)
+{
+    pcdom_node_t *top = pcdom_interface_node(scope);
+    pcdom_node_t *node = top;
+
+    while (node) {
+        if (node->type == PCDOM_NODE_TYPE_ELEMENT &&
+                pcdoc_selector_match(args->selector, (pcdoc_element_t)node)) {
+            if (pcutils_arrlist_append(args->found, node)) {
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+
+            if (args->max_found &&
+                    pcutils_arrlist_length(args->found) >= args->max_found)
+                break;
+        }
+
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+
+        while (node != top && node->next == NULL)
+            node = node->parent;
+        node = (node == top) ? NULL : node->next;
+    }
+
+    return 0;
+}
+
+int
+pcdoc_selector_select(struct pcdoc_selector *selector,
+        struct pcdoc_elem_index *index, pcdoc_element_t scope,
+        struct pcutils_arrlist *found, size_t max_found)
+{
+    struct walk_args args = { selector, found, max_found };
+    pcdom_element_t *dom_scope = pcdom_interface_element(scope);
+
+    if (index == NULL)
+        return select_by_walking(&args, dom_scope);
+
+    /* use the indexes if every complex selector has an id or a class
+       in the rightmost compound */
+    size_t nr_candidates = 0;
+    for (size_t i = 0; i < selector->nr_complexes; i++) {
+        bool none;
+        pcutils_map *set;
+        set = index_candidates(index, selector->complexes + i, &none);
+        if (set)
+            nr_candidates += pcutils_map_get_size(set);
+        else if (!none)
+            return select_by_walking(&args, dom_scope);
+    }
+
+    if (nr_candidates > MAX_SORTED_CANDIDATES)
+        return select_by_walking(&args, dom_scope);
+
+    size_t first = pcutils_arrlist_length(found);
+    for (size_t i = 0; i < selector->nr_complexes; i++) {
+        bool none;
+        pcutils_map *set;
+        set = index_candidates(index, selector->complexes + i, &none);
+        if (set == NULL)
+            continue;
+
+        struct pcutils_map_iterator it = pcutils_map_it_begin_first(set);
+        struct pcutils_map_entry *entry;
+        while ((entry = pcutils_map_it_value(&it))) {
+            pcdom_element_t *elem = entry->key;
+            pcutils_map_it_next(&it);
+
+            if (!is_in_scope(elem, dom_scope) ||
+                    !pcdoc_selector_match(selector, (pcdoc_element_t)elem))
+                continue;
+
+            /* skip the element matched by a previous complex selector */
+            bool dup = false;
+            for (size_t j = first; j < pcutils_arrlist_length(found); j++) {
+                if (pcutils_arrlist_get_idx(found, j) == elem) {
+                    dup = true;
+                    break;
+                }
+            }
+
+            if (!dup && pcutils_arrlist_append(found, elem)) {
+                pcutils_map_it_end(&it);
+                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                return -1;
+            }
+        }
+        pcutils_map_it_end(&it);
+    }
+
+    size_t nr = pcutils_arrlist_length(found) - first;
+    if (nr > 1)
+        qsort(found->array + first, nr, sizeof(void *), comp_position);
+
+    if (max_found && nr > max_found)
+        pcutils_arrlist_del_idx(found, first + max_found, nr - max_found);
+
+    return 0;
+}
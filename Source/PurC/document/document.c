@@ -303,10 +303,10 @@ pcdoc_element_children_count(purc_document_t doc, pcdoc_element_t elem,
                 *nr_text_nodes = nrs[PCDOC_NODE_TEXT];
             if (nr_data_nodes)
                 *nr_data_nodes = nrs[PCDOC_NODE_DATA];
+            return 0;
         }
-        else {
-            return -1;
-        }
+
+        return -1;
     }
 
     if (nr_elements)
@@ -361,6 +361,41 @@ pcdoc_element_get_child_data_node(purc_document_t doc, pcdoc_element_t elem,
     return NULL;
 }
 
+pcdoc_node
+pcdoc_element_first_child(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_node_type type)
+{
+    pcdoc_node node = { };
+    node.type = PCDOC_NODE_VOID;
+
+    if (doc->ops->first_child) {
+        node = doc->ops->first_child(doc, elem);
+        while (type != PCDOC_NODE_VOID && node.type != PCDOC_NODE_VOID &&
+                node.type != type)
+            node = doc->ops->next_sibling(doc, node);
+    }
+
+    return node;
+}
+
+pcdoc_node
+pcdoc_node_next_sibling(purc_document_t doc, pcdoc_node node,
+        pcdoc_node_type type)
+{
+    if (doc->ops->next_sibling && node.type != PCDOC_NODE_VOID) {
+        do {
+            node = doc->ops->next_sibling(doc, node);
+        } while (type != PCDOC_NODE_VOID && node.type != PCDOC_NODE_VOID &&
+                node.type != type);
+    }
+    else {
+        node.type = PCDOC_NODE_VOID;
+        node.elem = NULL;
+    }
+
+    return node;
+}
+
 pcdoc_element_t
 pcdoc_node_get_parent(purc_document_t doc, pcdoc_node node)
 {
@@ -546,7 +581,7 @@ pcdoc_elem_coll_new_from_descendants(purc_document_t doc,
 }
 
 pcdoc_elem_coll_t
-pcdoc_elem_coll_filter(purc_document_t doc,
+pcdoc_elem_coll_select(purc_document_t doc,
         pcdoc_elem_coll_t elem_coll, const char *selector)
 {
     pcdoc_elem_coll_t dst_coll = element_collection_new(selector);
@@ -568,6 +603,7 @@ pcdoc_elem_coll_delete(purc_document_t doc,
 {
     UNUSED_PARAM(doc);
 
+    free(elem_coll->selector);
     pcutils_arrlist_free(elem_coll->elems);
     return free(elem_coll);
 }
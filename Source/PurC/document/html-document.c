@@ -30,6 +30,33 @@
 
 #include "private/document.h"
 #include "private/debug.h"
+#include "private/list.h"
+
+/* The children of an element by the node type, cached in the `user` field
+   of the DOM node on the first access by index. */
+struct child_cache {
+    struct list_head         ln;
+    pcdom_node_t            *owner;
+
+    size_t                   nrs[PCDOC_NODE_OTHERS + 1];
+    pcdom_node_t           **nodes[PCDOC_NODE_OTHERS + 1];
+};
+
+struct html_document {
+    struct purc_document     doc;   // must be the first member
+
+    /* the id and class indexes; built on the first query by a selector */
+    struct pcdoc_elem_index *index;
+
+    /* all child caches */
+    struct list_head         child_caches;
+    size_t                   nr_child_caches;
+};
+
+static inline struct pcdoc_elem_index *doc_index(purc_document_t doc)
+{
+    return ((struct html_document *)doc)->index;
+}
 
 static purc_document_t create(const char *content, size_t length)
 {
@@ -56,7 +83,10 @@ static purc_document_t create(const char *content, size_t length)
         PC_WARN("bad content\n");
     }
 
-    purc_document_t doc = calloc(1, sizeof(*doc));
+    struct html_document *html = calloc(1, sizeof(*html));
+    list_head_init(&html->child_caches);
+
+    purc_document_t doc = &html->doc;
     doc->type = PCDOC_K_TYPE_HTML;
     doc->def_text_type = PCRDR_MSG_DATA_TYPE_HTML;
     doc->need_rdr = 1;
@@ -74,7 +104,15 @@ static purc_document_t create(const char *content, size_t length)
 
 static void destroy(purc_document_t doc)
 {
+    struct html_document *html = (struct html_document *)doc;
+    struct child_cache *cache, *tmp;
+    list_for_each_entry_safe(cache, tmp, &html->child_caches, ln) {
+        free(cache);
+    }
+
     assert(doc->impl);
+    if (doc_index(doc))
+        pcdoc_elem_index_delete(doc_index(doc));
     pchtml_html_document_destroy(doc->impl);
     free(doc);
 }
@@ -151,6 +189,97 @@ dom_clear_element(pcdom_element_t *element)
     }
 }
 
+/* removes the descendant elements of the node from the indexes */
+static void
+unindex_children(purc_document_t doc, pcdom_node_t *parent)
+{
+    struct pcdoc_elem_index *index = doc_index(doc);
+    if (index == NULL)
+        return;
+
+    pcdom_node_t *child = parent->first_child;
+    for (; child; child = child->next) {
+        if (child->type == PCDOM_NODE_TYPE_ELEMENT)
+            pcdoc_elem_index_remove(index, (pcdoc_element_t)child, true);
+    }
+}
+
+static inline void
+child_cache_delete(purc_document_t doc, pcdom_node_t *owner)
+{
+    struct html_document *html = (struct html_document *)doc;
+    struct child_cache *cache = owner->user;
+
+    if (cache) {
+        owner->user = NULL;
+        list_del(&cache->ln);
+        free(cache);
+        html->nr_child_caches--;
+    }
+}
+
+/* deletes the child caches in the subtree to be destroyed */
+static void
+drop_child_caches(purc_document_t doc, pcdom_node_t *root)
+{
+    struct html_document *html = (struct html_document *)doc;
+    pcdom_node_t *node = root;
+
+    while (node && html->nr_child_caches > 0) {
+        child_cache_delete(doc, node);
+
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+
+        while (node != root && node->next == NULL)
+            node = node->parent;
+        node = (node == root) ? NULL : node->next;
+    }
+}
+
+/*
+ * Updates the child caches before the children of the element are changed
+ * by the operation.  The callers keep the indexes up to date themselves.
+ */
+static void
+before_children_change(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_operation op)
+{
+    pcdom_node_t *node = pcdom_interface_node(elem);
+
+    switch (op) {
+    case PCDOC_OP_APPEND:
+    case PCDOC_OP_PREPEND:
+        child_cache_delete(doc, node);
+        break;
+
+    case PCDOC_OP_INSERTBEFORE:
+    case PCDOC_OP_INSERTAFTER:
+        if (node->parent)
+            child_cache_delete(doc, node->parent);
+        break;
+
+    case PCDOC_OP_ERASE:
+        if (node->parent)
+            child_cache_delete(doc, node->parent);
+        drop_child_caches(doc, node);
+        break;
+
+    case PCDOC_OP_DISPLACE:
+    case PCDOC_OP_CLEAR:
+        for (pcdom_node_t *child = node->first_child; child;
+                child = child->next)
+            drop_child_caches(doc, child);
+        child_cache_delete(doc, node);
+        break;
+
+    default:
+        break;
+    }
+}
+
 static pcdoc_element_t operate_element(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation op,
             const char *tag, bool self_close)
@@ -158,10 +287,15 @@ static pcdoc_element_t operate_element(purc_document_t doc,
     UNUSED_PARAM(self_close);
 
     if (op == PCDOC_OP_ERASE) {
+        if (doc_index(doc))
+            pcdoc_elem_index_remove(doc_index(doc), elem, true);
+        before_children_change(doc, elem, op);
         dom_erase_element(pcdom_interface_element(elem));
         return NULL;
     }
     else if (op == PCDOC_OP_CLEAR) {
+        unindex_children(doc, pcdom_interface_node(elem));
+        before_children_change(doc, elem, op);
         dom_clear_element(pcdom_interface_element(elem));
         return elem;
     }
@@ -177,6 +311,9 @@ static pcdoc_element_t operate_element(purc_document_t doc,
     new_elem = pcdom_document_create_element(dom_doc,
             (const unsigned char*)tag, strlen(tag), NULL);
     if (new_elem) {
+        if (op == PCDOC_OP_DISPLACE)
+            unindex_children(doc, pcdom_interface_node(elem));
+        before_children_change(doc, elem, op);
         dom_node_ops[op](dom_elem, pcdom_interface_node(new_elem));
     }
     else {
@@ -203,6 +340,9 @@ static pcdoc_text_node_t new_text_content(purc_document_t doc,
     text_node = pcdom_document_create_text_node(dom_doc,
             (const unsigned char *)text, length ? length : strlen(text));
     if (text_node) {
+        if (op == PCDOC_OP_DISPLACE)
+            unindex_children(doc, pcdom_interface_node(elem));
+        before_children_change(doc, elem, op);
         dom_node_ops[op](dom_elem, pcdom_interface_node(text_node));
     }
     else {
@@ -385,6 +525,20 @@ static pcdoc_node new_content(purc_document_t doc,
             content, length ? length : strlen(content));
 
     if (subtree) {
+        if (op == PCDOC_OP_DISPLACE)
+            unindex_children(doc, pcdom_interface_node(dom_elem));
+        before_children_change(doc, elem, op);
+
+        /* the children of the wrapper `div` are to be inserted */
+        struct pcdoc_elem_index *index = doc_index(doc);
+        if (index && subtree->first_child) {
+            pcdom_node_t *child = subtree->first_child->first_child;
+            for (; child; child = child->next) {
+                if (child->type == PCDOM_NODE_TYPE_ELEMENT)
+                    pcdoc_elem_index_add(index, (pcdoc_element_t)child, true);
+            }
+        }
+
         dom_subtree_ops[op](dom_elem, subtree);
     }
     else {
@@ -425,24 +579,36 @@ static int set_attribute(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_operation op,
             const char *name, const char *val, size_t len)
 {
-    UNUSED_PARAM(doc);
-
     pcdom_element_t *dom_elem = pcdom_interface_element(elem);
+    int ret;
+
+    if (op != PCDOC_OP_ERASE && op != PCDOC_OP_CLEAR &&
+            op != PCDOC_OP_DISPLACE) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    /* keep the indexes in sync with the id and the class */
+    struct pcdoc_elem_index *index = doc_index(doc);
+    if (index && strcasecmp(name, "id") && strcasecmp(name, "class"))
+        index = NULL;
+    if (index)
+        pcdoc_elem_index_remove(index, elem, false);
+
     if (op == PCDOC_OP_ERASE) {
-        return dom_remove_element_attr(dom_elem, name);
+        ret = dom_remove_element_attr(dom_elem, name);
     }
     else if (op == PCDOC_OP_CLEAR) {
-        return dom_set_element_attribute(dom_elem, name, "", 0);
-    }
-    else if (op == PCDOC_OP_DISPLACE) {
-        return dom_set_element_attribute(dom_elem, name,
-                val, len ? len : strlen(val));
+        ret = dom_set_element_attribute(dom_elem, name, "", 0);
     }
     else {
-        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        ret = dom_set_element_attribute(dom_elem, name,
+                val, len ? len : strlen(val));
     }
 
-    return -1;
+    if (index)
+        pcdoc_elem_index_add(index, elem, false);
+    return ret;
 }
 
 static pcdoc_element_t special_elem(purc_document_t doc,
@@ -477,33 +643,6 @@ static pcdoc_element_t get_parent(purc_document_t doc, pcdoc_node node)
     return (pcdoc_element_t)dom_node->parent;
 }
 
-static int children_count(purc_document_t doc, pcdoc_element_t elem,
-        size_t *nrs)
-{
-    UNUSED_PARAM(doc);
-
-    pcdom_node_t *dom_node = pcdom_interface_node(elem);
-    pcdom_node_t *child = dom_node->first_child;
-    while (child) {
-        if (child->type == PCDOM_NODE_TYPE_ELEMENT) {
-            nrs[PCDOC_NODE_ELEMENT]++;
-        }
-        else if (child->type == PCDOM_NODE_TYPE_TEXT) {
-            nrs[PCDOC_NODE_TEXT]++;
-        }
-        else if (child->type == PCDOM_NODE_TYPE_CDATA_SECTION) {
-            nrs[PCDOC_NODE_CDATA_SECTION]++;
-        }
-        else {
-            nrs[PCDOC_NODE_OTHERS]++;
-        }
-
-        child = child->next;
-    }
-
-    return 0;
-}
-
 static inline pcdoc_node_type
 node_type(pcdom_node_type_t type)
 {
@@ -522,35 +661,110 @@ node_type(pcdom_node_type_t type)
     return PCDOC_NODE_OTHERS;
 }
 
+/* gets the child cache of the element; builds it if there is none */
+static struct child_cache *
+get_child_cache(purc_document_t doc, pcdom_node_t *owner)
+{
+    if (owner->user)
+        return owner->user;
+
+    size_t nrs[PCDOC_NODE_OTHERS + 1] = { };
+    size_t total = 0;
+    pcdom_node_t *child;
+    for (child = owner->first_child; child; child = child->next) {
+        nrs[node_type(child->type)]++;
+        total++;
+    }
+
+    struct child_cache *cache;
+    cache = malloc(sizeof(*cache) + sizeof(pcdom_node_t *) * total);
+    if (cache == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    /* the nodes of all types share the space after the header */
+    pcdom_node_t **slots = (pcdom_node_t **)(cache + 1);
+    for (size_t i = 0; i <= PCDOC_NODE_OTHERS; i++) {
+        cache->nodes[i] = slots;
+        slots += nrs[i];
+        cache->nrs[i] = 0;
+    }
+
+    for (child = owner->first_child; child; child = child->next) {
+        pcdoc_node_type type = node_type(child->type);
+        cache->nodes[type][cache->nrs[type]++] = child;
+    }
+
+    struct html_document *html = (struct html_document *)doc;
+    cache->owner = owner;
+    list_add_tail(&cache->ln, &html->child_caches);
+    html->nr_child_caches++;
+    owner->user = cache;
+    return cache;
+}
+
+static int children_count(purc_document_t doc, pcdoc_element_t elem,
+        size_t *nrs)
+{
+    struct child_cache *cache;
+    cache = get_child_cache(doc, pcdom_interface_node(elem));
+    if (cache == NULL)
+        return -1;
+
+    for (size_t i = 0; i <= PCDOC_NODE_OTHERS; i++)
+        nrs[i] += cache->nrs[i];
+    return 0;
+}
+
 static pcdoc_node get_child(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_node_type type, size_t idx)
 {
-    UNUSED_PARAM(doc);
-
     pcdoc_node node;
     node.type = PCDOC_NODE_VOID;
     node.elem = NULL;
 
-    size_t i = 0;
-    pcdom_node_t *dom_node = pcdom_interface_node(elem);
-    pcdom_node_t *child = dom_node->first_child;
-    while (child) {
-        if (node_type(child->type) == type) {
-            if (i == idx) {
-                node.type = type;
-                node.elem = (pcdoc_element_t)child;
-                return node;
-            }
+    if (type > PCDOC_NODE_OTHERS)
+        return node;
 
-            i++;
-        }
+    struct child_cache *cache;
+    cache = get_child_cache(doc, pcdom_interface_node(elem));
+    if (cache && idx < cache->nrs[type]) {
+        node.type = type;
+        node.elem = (pcdoc_element_t)cache->nodes[type][idx];
+    }
+
+    return node;
+}
 
-        child = child->next;
+static inline pcdoc_node
+make_node(pcdom_node_t *dom_node)
+{
+    pcdoc_node node;
+    if (dom_node) {
+        node.type = node_type(dom_node->type);
+        node.elem = (pcdoc_element_t)dom_node;
+    }
+    else {
+        node.type = PCDOC_NODE_VOID;
+        node.elem = NULL;
     }
 
     return node;
 }
 
+static pcdoc_node first_child(purc_document_t doc, pcdoc_element_t elem)
+{
+    UNUSED_PARAM(doc);
+    return make_node(pcdom_interface_node(elem)->first_child);
+}
+
+static pcdoc_node next_sibling(purc_document_t doc, pcdoc_node node)
+{
+    UNUSED_PARAM(doc);
+    return make_node(pcdom_interface_node(node.elem)->next);
+}
+
 static int get_attribute(purc_document_t doc, pcdoc_element_t elem,
             const char *name, const char **val, size_t *len)
 {
@@ -667,6 +881,81 @@ static int serialize(purc_document_t doc, pcdoc_node node,
     }
 }
 
+/* builds the indexes on the first query */
+static struct pcdoc_elem_index *
+get_index(purc_document_t doc)
+{
+    struct html_document *html_doc = (struct html_document *)doc;
+    if (html_doc->index == NULL) {
+        pcdom_document_t *dom_doc = pcdom_interface_document(doc->impl);
+        html_doc->index = pcdoc_elem_index_new(
+                (pcdoc_element_t)dom_doc->element);
+    }
+
+    return html_doc->index;
+}
+
+static pcdoc_element_t find_elem(purc_document_t doc, pcdoc_element_t scope,
+            const char *selector)
+{
+    struct pcdoc_selector *sel = pcdoc_selector_new(selector);
+    if (sel == NULL)
+        return NULL;
+
+    pcdoc_element_t found = NULL;
+    struct pcutils_arrlist *elems = pcutils_arrlist_new_ex(NULL, 1);
+    if (elems && pcdoc_selector_select(sel, get_index(doc), scope,
+                elems, 1) == 0 && pcutils_arrlist_length(elems) > 0)
+        found = pcutils_arrlist_get_idx(elems, 0);
+
+    if (elems)
+        pcutils_arrlist_free(elems);
+    pcdoc_selector_delete(sel);
+    return found;
+}
+
+/* returns non-zero for success */
+static int elem_coll_select(purc_document_t doc,
+            pcdoc_elem_coll_t coll, pcdoc_element_t scope,
+            const char *selector)
+{
+    struct pcdoc_selector *sel = pcdoc_selector_new(selector);
+    if (sel == NULL)
+        return 0;
+
+    int ret = pcdoc_selector_select(sel, get_index(doc), scope,
+            coll->elems, 0);
+    pcdoc_selector_delete(sel);
+    return ret == 0;
+}
+
+/* returns non-zero for success */
+static int elem_coll_filter(purc_document_t doc,
+            pcdoc_elem_coll_t dst_coll,
+            pcdoc_elem_coll_t src_coll, const char *selector)
+{
+    UNUSED_PARAM(doc);
+
+    struct pcdoc_selector *sel = pcdoc_selector_new(selector);
+    if (sel == NULL)
+        return 0;
+
+    int ret = 1;
+    size_t n = pcutils_arrlist_length(src_coll->elems);
+    for (size_t i = 0; i < n; i++) {
+        pcdoc_element_t elem = pcutils_arrlist_get_idx(src_coll->elems, i);
+        if (pcdoc_selector_match(sel, elem) &&
+                pcutils_arrlist_append(dst_coll->elems, elem)) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            ret = 0;
+            break;
+        }
+    }
+
+    pcdoc_selector_delete(sel);
+    return ret;
+}
+
 struct purc_document_ops _pcdoc_html_ops = {
     .create = create,
     .destroy = destroy,
@@ -679,13 +968,16 @@ struct purc_document_ops _pcdoc_html_ops = {
     .get_parent = get_parent,
     .children_count = children_count,
     .get_child = get_child,
+    .first_child = first_child,
+    .next_sibling = next_sibling,
     .get_attribute = get_attribute,
     .get_special_attr = get_special_attr,
     .get_text = get_text,
     .get_data = NULL,
     .travel = travel,
     .serialize = serialize,
-    .elem_coll_select = NULL,
-    .elem_coll_filter = NULL,
+    .find_elem = find_elem,
+    .elem_coll_select = elem_coll_select,
+    .elem_coll_filter = elem_coll_filter,
 };
 
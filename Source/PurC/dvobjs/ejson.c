@@ -613,13 +613,17 @@ parse_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         goto failed;
     }
 
+    purc_variant_t retv;
+    retv = pcvariant_make_from_strict_json(string, length);
+    if (retv)
+        return retv;
+
     struct purc_ejson_parse_tree *ptree;
     ptree = purc_variant_ejson_parse_string(string, length);
     if (ptree == NULL) {
         goto failed;
     }
 
-    purc_variant_t retv;
     retv = purc_variant_ejson_parse_tree_evalute(ptree, NULL, NULL, silently);
     purc_variant_ejson_parse_tree_destroy(ptree);
     return retv;
@@ -1930,9 +1934,7 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         ssize_t sz = purc_variant_array_get_size(argv[0]);
 
         if (sz > 1) {
-            struct pcutils_array_list *al = variant_array_get_data(argv[0]);
-            struct pcutils_array_list_node *p;
-            array_list_for_each(al, p) {
+            for (size_t idx = 0; idx < (size_t)sz; idx++) {
 
                 size_t new_idx;
                 if (sz < RAND_MAX) {
@@ -1943,8 +1945,8 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
                     new_idx = new_idx * sz / RAND_MAX;
                 }
 
-                if (new_idx != p->idx)
-                    pcutils_array_list_swap(al, p->idx, new_idx);
+                if (new_idx != idx)
+                    pcvariant_array_swap(argv[0], idx, new_idx);
             }
         }
     }
@@ -2056,6 +2058,66 @@ static void map_free_val(void *val)
     pcutils_map_destroy(sort_arg.map);
 #endif
 
+static bool
+is_number_variant(purc_variant_t val)
+{
+    switch (purc_variant_get_type(val)) {
+    case PURC_VARIANT_TYPE_NUMBER:
+    case PURC_VARIANT_TYPE_LONGINT:
+    case PURC_VARIANT_TYPE_ULONGINT:
+    case PURC_VARIANT_TYPE_LONGDOUBLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* purc_variant_compare_ex() with PCVARIANT_COMPARE_OPT_AUTO compares two
+   members by number if the first one is a number, and by string otherwise;
+   this is the same for all pairs only if the types agree. */
+static uintptr_t
+sort_auto_cmpopt(purc_variant_t container, size_t totalsize)
+{
+    size_t nr_numbers = 0, nr_others = 0;
+    bool is_array = purc_variant_is_array(container);
+    for (size_t i = 0; i < totalsize; i++) {
+        purc_variant_t val = is_array ?
+            purc_variant_array_get(container, i) :
+            purc_variant_set_get_by_index(container, i);
+        if (is_number_variant(val))
+            nr_numbers++;
+        else
+            nr_others++;
+
+        if (nr_numbers > 0 && nr_others > 0)
+            return PCVARIANT_COMPARE_OPT_AUTO;
+    }
+
+    return nr_numbers ? PCVARIANT_COMPARE_OPT_NUMBER :
+        PCVARIANT_COMPARE_OPT_CASE;
+}
+
+/* stringifies or numberifies a member once as purc_variant_compare_ex()
+   does on every comparison */
+static int
+sort_decorate(purc_variant_t val, struct pcvariant_sort_key *key, void *ud)
+{
+    uintptr_t sort_opt = (uintptr_t)ud;
+    if ((sort_opt & PCVARIANT_CMPOPT_MASK) == PCVARIANT_COMPARE_OPT_NUMBER) {
+        key->d = purc_variant_numberify(val);
+        return 0;
+    }
+
+    if (purc_variant_stringify_alloc(&key->s, val) < 0) {
+        key->s = strdup("");
+        if (key->s == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+    }
+    return 0;
+}
+
 static purc_variant_t
 sort_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         bool silently)
@@ -2162,8 +2224,30 @@ sort_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         }
     }
 
-    /* use the default variant comparison function */
-    if (purc_variant_is_array(argv[0])) {
+    if ((sort_opt & PCVARIANT_CMPOPT_MASK) == PCVARIANT_COMPARE_OPT_AUTO)
+        sort_opt |= sort_auto_cmpopt(argv[0], totalsize);
+
+    if ((sort_opt & PCVARIANT_CMPOPT_MASK) != PCVARIANT_COMPARE_OPT_AUTO) {
+        enum pcvariant_sort_key_type type;
+        switch (sort_opt & PCVARIANT_CMPOPT_MASK) {
+        case PCVARIANT_COMPARE_OPT_NUMBER:
+            type = PCVARIANT_SORT_KEY_NUMBER;
+            break;
+        case PCVARIANT_COMPARE_OPT_CASELESS:
+            type = PCVARIANT_SORT_KEY_CASELESS;
+            break;
+        default:
+            type = PCVARIANT_SORT_KEY_STRING;
+            break;
+        }
+
+        if (pcvariant_sort_by_keys(argv[0], &type, 1,
+                    sort_opt & PCVARIANT_SORT_DESC, sort_decorate,
+                    (void *)sort_opt))
+            goto failed;
+    }
+    /* use the default variant comparison function for mixed types */
+    else if (purc_variant_is_array(argv[0])) {
         pcvariant_array_sort(argv[0], (void *)sort_opt, NULL);
     }
     else {
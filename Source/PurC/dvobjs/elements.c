@@ -25,6 +25,7 @@
 
 #include "purc-errors.h"
 
+#include "private/document.h"
 #include "private/dvobjs.h"
 #include "private/stringbuilder.h"
 
@@ -538,11 +539,37 @@ visit_element(purc_document_t doc, pcdoc_element_t element, void *ud)
     return 0;
 }
 
+/* selects the elements by the selector engine of the document */
+static bool
+select_elements(struct pcdvobjs_elements *elems, pcdoc_element_t root,
+        const char *css)
+{
+    pcdoc_elem_coll_t coll;
+    coll = pcdoc_elem_coll_new_from_descendants(elems->doc, root, css);
+    if (coll == NULL)
+        return false;
+
+    bool ok = true;
+    size_t n = pcutils_arrlist_length(coll->elems);
+    for (size_t i = 0; i < n; i++) {
+        if (!add_element(elems, pcutils_arrlist_get_idx(coll->elems, i))) {
+            ok = false;
+            break;
+        }
+    }
+
+    pcdoc_elem_coll_delete(elems->doc, coll);
+    return ok;
+}
+
 purc_variant_t
 pcdvobjs_query_elements(purc_document_t doc, pcdoc_element_t root,
         const char *css)
 {
-    if (strcmp(css, "*") != 0) {
+    if (doc->ops->elem_coll_select) {
+        /* the selector is checked by the selector engine */
+    }
+    else if (strcmp(css, "*") != 0) {
         if (css[0] != '.' && css[0] != '#') {
             pcinst_set_error(PURC_ERROR_ARGUMENT_MISSED);
             return PURC_VARIANT_INVALID;
@@ -570,6 +597,15 @@ pcdvobjs_query_elements(purc_document_t doc, pcdoc_element_t root,
         return PURC_VARIANT_INVALID;
     }
 
+    if (doc->ops->elem_coll_select) {
+        if (!select_elements(elems, root, css)) {
+            purc_variant_unref(elements);
+            return PURC_VARIANT_INVALID;
+        }
+
+        return elements;
+    }
+
     struct visit_args args;
     args.elements = (struct pcdvobjs_elements*)entity;
     args.css      = css;
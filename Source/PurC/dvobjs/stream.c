@@ -113,6 +113,10 @@ enum {
     K_KW_writelines,
 #define _KW_readbytes               "readbytes"
     K_KW_readbytes,
+#define _KW_readjson                "readjson"
+    K_KW_readjson,
+#define _KW_readndjson              "readndjson"
+    K_KW_readndjson,
 #define _KW_writebytes              "writebytes"
     K_KW_writebytes,
 #define _KW_writeeof                "writeeof"
@@ -151,6 +155,8 @@ static struct keyword_to_atom {
     { _KW_readlines, 0},            // readlines
     { _KW_writelines, 0},           // writelines
     { _KW_readbytes, 0},            // readbytes
+    { _KW_readjson, 0},             // readjson
+    { _KW_readndjson, 0},           // readndjson
     { _KW_writebytes, 0},           // writebytes
     { _KW_writeeof, 0},             // writeeof
     { _KW_status, 0},               // status
@@ -181,6 +187,10 @@ struct pcdvobjs_stream {
     uintptr_t monitor4r, monitor4w;
     int fd4r, fd4w;
 
+    /* the reader of readjson/readndjson, keeps the bytes read ahead */
+    purc_json_reader_t json_reader;
+    unsigned int json_flags;
+
     pid_t cpid;                 /* only for pipe, the pid of child */
     purc_atom_t cid;
 };
@@ -220,6 +230,11 @@ static void native_stream_close(struct pcdvobjs_stream *stream)
     stream->stm4w = NULL;
     stream->stm4r = NULL;
 
+    if (stream->json_reader) {
+        purc_json_reader_delete(stream->json_reader);
+        stream->json_reader = NULL;
+    }
+
     if (stream->option) {
         purc_variant_unref(stream->option);
         stream->option = PURC_VARIANT_INVALID;
@@ -673,6 +688,81 @@ out:
     return PURC_VARIANT_INVALID;
 }
 
+/*
+ * Reads the next record by the JSON reader of the stream. Returns undefined
+ * if no record is complete but the stream has no data now, e.g., a
+ * non-blocking pipe; the next call resumes the record.
+ */
+static purc_variant_t
+read_json_record(void *native_entity, unsigned int flags, bool silently)
+{
+    struct pcdvobjs_stream *stream;
+    purc_variant_t ret_var;
+
+    if (native_entity == NULL) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto out;
+    }
+
+    stream = get_stream(native_entity);
+    if (stream->stm4r == NULL) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto out;
+    }
+
+    /* switch the reader with the bytes read ahead kept; fails in the
+       middle of a record or an array read by elements */
+    if (stream->json_reader && stream->json_flags != flags) {
+        if (!purc_json_reader_set_flags(stream->json_reader, flags))
+            goto out;
+        stream->json_flags = flags;
+    }
+
+    if (stream->json_reader == NULL) {
+        stream->json_reader = purc_json_reader_new(flags);
+        if (stream->json_reader == NULL)
+            goto out;
+        stream->json_flags = flags;
+    }
+
+    ret_var = purc_json_reader_read(stream->json_reader, stream->stm4r);
+    if (ret_var == PURC_VARIANT_INVALID &&
+            purc_get_last_error() == PURC_ERROR_NOT_READY) {
+        purc_clr_error();
+        return purc_variant_make_undefined();
+    }
+
+    if (ret_var)
+        return ret_var;
+
+out:
+    if (silently)
+        return purc_variant_make_undefined();
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+readjson_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
+                bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    return read_json_record(native_entity, PCVRNT_JSON_READER_FLAG_ELEMENTS,
+            silently);
+}
+
+static purc_variant_t
+readndjson_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
+                bool silently)
+{
+    UNUSED_PARAM(nr_args);
+    UNUSED_PARAM(argv);
+
+    return read_json_record(native_entity, PCVRNT_JSON_READER_FLAG_NONE,
+            silently);
+}
+
 static purc_variant_t
 writebytes_getter(void *native_entity, size_t nr_args, purc_variant_t *argv,
                 bool silently)
@@ -1087,6 +1177,12 @@ property_getter(const char *name)
     else if (atom == keywords2atoms[K_KW_readbytes].atom) {
         return readbytes_getter;
     }
+    else if (atom == keywords2atoms[K_KW_readjson].atom) {
+        return readjson_getter;
+    }
+    else if (atom == keywords2atoms[K_KW_readndjson].atom) {
+        return readndjson_getter;
+    }
     else if (atom == keywords2atoms[K_KW_writebytes].atom) {
         return writebytes_getter;
     }
@@ -32,6 +32,8 @@
 #include "purc-errors.h"
 #include "private/errors.h"
 #include "private/tkz-helper.h"
+#include "private/rwstream.h"
+#include "private/simd.h"
 
 #if HAVE(GLIB)
 #include <gmodule.h>
@@ -39,9 +41,12 @@
 #include <stdlib.h>
 #endif
 
-#define NR_CONSUMED_LIST_LIMIT   10
 #define MIN_BUFFER_CAPACITY      32
 
+/* must be a power of 2 */
+#define NR_CONSUMED_RING         16
+#define SZ_READ_WINDOW           4096
+
 #if HAVE(GLIB)
 #define    PCHVML_ALLOC(sz)   g_slice_alloc0(sz)
 #define    PCHVML_FREE(p)     g_slice_free1(sizeof(*p), (gpointer)p)
@@ -52,27 +57,32 @@
 
 struct tkz_reader {
     purc_rwstream_t rws;
-    struct list_head reconsume_list;
-    struct list_head consumed_list;
-    size_t nr_consumed_list;
+
+    /* the read cursor of a memory-backed rwstream, decoded in place */
+    uint8_t **mem_here;
+    uint8_t **mem_stop;
+
+    /* the window of bytes read ahead from other rwstreams */
+    uint8_t *win_here;
+    uint8_t *win_stop;
+    bool win_eof;
+
+    /* the last consumed characters, the oldest one at `consumed_first` */
+    struct tkz_uc consumed[NR_CONSUMED_RING];
+    size_t consumed_first;
+    size_t nr_consumed;
+
+    /* the characters to reconsume, the next one at the top */
+    struct tkz_uc reconsume[NR_CONSUMED_RING];
+    size_t nr_reconsume;
 
     struct tkz_uc curr_uc;
     int line;
     int column;
-    int consumed;
-};
+    int consumed_chars;
 
-struct tkz_uc *tkz_uc_new(void)
-{
-    return PCHVML_ALLOC(sizeof(struct tkz_uc));
-}
-
-void tkz_uc_destroy(struct tkz_uc *uc)
-{
-    if (uc) {
-        PCHVML_FREE(uc);
-    }
-}
+    uint8_t window[SZ_READ_WINDOW];
+};
 
 struct tkz_reader *tkz_reader_new(void)
 {
@@ -80,36 +90,157 @@ struct tkz_reader *tkz_reader_new(void)
     if (!reader) {
         return NULL;
     }
-    INIT_LIST_HEAD(&reader->reconsume_list);
-    INIT_LIST_HEAD(&reader->consumed_list);
     reader->line = 1;
     reader->column = 0;
-    reader->consumed = 0;
+    reader->consumed_chars = 0;
     return reader;
 }
 
 void tkz_reader_set_rwstream(struct tkz_reader *reader,
         purc_rwstream_t rws)
 {
+    if (reader->rws == rws) {
+        return;
+    }
+
     reader->rws = rws;
+    reader->mem_here = NULL;
+    reader->mem_stop = NULL;
+    reader->win_here = reader->window;
+    reader->win_stop = reader->window;
+    reader->win_eof = false;
+    if (rws) {
+        pcutils_rwstream_get_mem_cursor(rws,
+                &reader->mem_here, &reader->mem_stop);
+    }
+}
+
+static uint32_t utf8_to_uint32_t(const unsigned char *utf8_char,
+        int utf8_char_len);
+
+static inline int
+utf8_char_len(uint8_t c)
+{
+    if (c < 0x80)
+        return 1;
+
+    int n = 1;
+    while (c & (0x80 >> n))
+        n++;
+    return n;
+}
+
+/*
+ * Decodes one character from [*here, stop) and moves *here past it.
+ * The rules are the same as purc_rwstream_read_utf8_char(): a NUL byte
+ * means end of file, and only characters up to 3 bytes are accepted.
+ */
+static uint32_t
+decode_utf8_char(const uint8_t **here, const uint8_t *stop)
+{
+    const uint8_t *p = *here;
+    uint8_t c = *p;
+
+    if (c < 0x80) {
+        *here = p + 1;
+        return c;
+    }
+
+    int len = utf8_char_len(c);
+    *here = p + 1;
+    if (c > 0xFD || len < 2 || len > 3 || stop - p < len) {
+        return TKZ_INVALID_CHARACTER;
+    }
+
+    size_t nr_chars;
+    if (!pcutils_string_check_utf8_len((const char *)p, len,
+                &nr_chars, NULL)) {
+        return TKZ_INVALID_CHARACTER;
+    }
+
+    *here = p + len;
+    return utf8_to_uint32_t(p, len);
+}
+
+static uint32_t
+read_from_mem(struct tkz_reader *reader)
+{
+    const uint8_t *here = *reader->mem_here;
+    const uint8_t *stop = *reader->mem_stop;
+    if (here >= stop) {
+        return TKZ_END_OF_FILE;
+    }
+
+    uint32_t uc = decode_utf8_char(&here, stop);
+    *reader->mem_here = (uint8_t *)here;
+    return uc;
+}
+
+static bool
+fill_window(struct tkz_reader *reader)
+{
+    size_t left = reader->win_stop - reader->win_here;
+    if (left) {
+        memmove(reader->window, reader->win_here, left);
+    }
+    reader->win_here = reader->window;
+    reader->win_stop = reader->window + left;
+
+    ssize_t nr_read = purc_rwstream_read(reader->rws, reader->win_stop,
+            SZ_READ_WINDOW - left);
+    if (nr_read < 0) {
+        return false;
+    }
+    else if (nr_read == 0) {
+        reader->win_eof = true;
+    }
+    reader->win_stop += nr_read;
+    return true;
+}
+
+static uint32_t
+read_from_window(struct tkz_reader *reader)
+{
+    size_t left;
+    while (!reader->win_eof) {
+        left = reader->win_stop - reader->win_here;
+        if (left > 0 && left >= (size_t)utf8_char_len(*reader->win_here)) {
+            break;
+        }
+
+        if (!fill_window(reader)) {
+            return TKZ_INVALID_CHARACTER;
+        }
+    }
+
+    if (reader->win_here == reader->win_stop) {
+        return TKZ_END_OF_FILE;
+    }
+
+    const uint8_t *here = reader->win_here;
+    uint32_t uc = decode_utf8_char(&here, reader->win_stop);
+    reader->win_here = (uint8_t *)here;
+    return uc;
 }
 
 static struct tkz_uc*
 tkz_reader_read_from_rwstream(struct tkz_reader *reader)
 {
-    char c[8] = {0};
-    uint32_t uc = 0;
-    int nr_c = purc_rwstream_read_utf8_char(reader->rws, c, &uc);
-    if (nr_c < 0) {
-        uc = TKZ_INVALID_CHARACTER;
+    uint32_t uc;
+    if (reader->mem_here) {
+        uc = read_from_mem(reader);
     }
+    else {
+        uc = read_from_window(reader);
+    }
+
     reader->column++;
-    reader->consumed++;
+    reader->consumed_chars++;
 
     reader->curr_uc.character = uc;
     reader->curr_uc.line = reader->line;
     reader->curr_uc.column = reader->column;
-    reader->curr_uc.position = reader->consumed;
+    reader->curr_uc.position = reader->consumed_chars;
     if (uc == '\n') {
         reader->line++;
         reader->column = 0;
@@ -120,99 +251,58 @@ tkz_reader_read_from_rwstream(struct tkz_reader *reader)
 static struct tkz_uc*
 tkz_reader_read_from_reconsume_list(struct tkz_reader *reader)
 {
-    struct tkz_uc *puc = list_entry(reader->reconsume_list.next,
-            struct tkz_uc, list);
-    reader->curr_uc = *puc;
-    list_del_init(&puc->list);
-    tkz_uc_destroy(puc);
+    reader->curr_uc = reader->reconsume[--reader->nr_reconsume];
     return &reader->curr_uc;
 }
 
-#define print_uc_list(uc_list, tag)                                         \
-    do {                                                                    \
-        PC_DEBUG("begin print %s list\n|", tag);                            \
-        struct list_head *p, *n;                                            \
-        list_for_each_safe(p, n, uc_list) {                                 \
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);        \
-            PC_DEBUG("%c", puc->character);                                 \
-        }                                                                   \
-        PC_DEBUG("|\nend print %s list\n", tag);                            \
-    } while(0)
-
-#define PRINT_CONSUMED_LIST(reader)    \
-        print_uc_list(&reader->consumed_list, "consumed")
-
-#define PRINT_RECONSUM_LIST(reader)    \
-        print_uc_list(&reader->reconsume_list, "reconsume")
-
-static bool
+static void
 tkz_reader_add_consumed(struct tkz_reader *reader, struct tkz_uc *uc)
 {
-    struct tkz_uc *p = tkz_uc_new();
-    if (!p) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return false;
-    }
-
-    *p = *uc;
-    list_add_tail(&p->list, &reader->consumed_list);
-    reader->nr_consumed_list++;
+    size_t idx = (reader->consumed_first + reader->nr_consumed) &
+        (NR_CONSUMED_RING - 1);
+    reader->consumed[idx] = *uc;
 
-    if (reader->nr_consumed_list > NR_CONSUMED_LIST_LIMIT) {
-        struct tkz_uc *first = list_first_entry(
-                &reader->consumed_list, struct tkz_uc, list);
-        list_del_init(&first->list);
-        tkz_uc_destroy(first);
-        reader->nr_consumed_list--;
+    if (reader->nr_consumed == NR_CONSUMED_RING) {
+        reader->consumed_first = (reader->consumed_first + 1) &
+            (NR_CONSUMED_RING - 1);
+    }
+    else {
+        reader->nr_consumed++;
     }
-    return true;
 }
 
 bool tkz_reader_reconsume_last_char(struct tkz_reader *reader)
 {
-    if (!reader->nr_consumed_list) {
+    if (!reader->nr_consumed) {
         return true;
     }
 
-    struct tkz_uc *last = list_last_entry(
-            &reader->consumed_list, struct tkz_uc, list);
-    list_del_init(&last->list);
-    reader->nr_consumed_list--;
+    reader->nr_consumed--;
+    size_t idx = (reader->consumed_first + reader->nr_consumed) &
+        (NR_CONSUMED_RING - 1);
 
-    list_add(&last->list, &reader->reconsume_list);
+    /* never overflows: every reconsumed character comes from the ring */
+    reader->reconsume[reader->nr_reconsume++] = reader->consumed[idx];
     return true;
 }
 
 struct tkz_uc *tkz_reader_next_char(struct tkz_reader *reader)
 {
     struct tkz_uc *ret = NULL;
-    if (list_empty(&reader->reconsume_list)) {
+    if (reader->nr_reconsume == 0) {
         ret = tkz_reader_read_from_rwstream(reader);
     }
     else {
         ret = tkz_reader_read_from_reconsume_list(reader);
     }
 
-    if (tkz_reader_add_consumed(reader, ret)) {
-        return ret;
-    }
-    return NULL;
+    tkz_reader_add_consumed(reader, ret);
+    return ret;
 }
 
 void tkz_reader_destroy(struct tkz_reader *reader)
 {
     if (reader) {
-        struct list_head *p, *n;
-        list_for_each_safe(p, n, &reader->reconsume_list) {
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);
-            list_del_init(&puc->list);
-            tkz_uc_destroy(puc);
-        }
-        list_for_each_safe(p, n, &reader->consumed_list) {
-            struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);
-            list_del_init(&puc->list);
-            tkz_uc_destroy(puc);
-        }
         PCHVML_FREE(reader);
     }
 }
@@ -288,14 +378,7 @@ void tkz_buffer_append_bytes(struct tkz_buffer *buffer, const char *bytes,
         size_t nr_bytes)
 {
     tkz_buffer_append_inner(buffer, bytes, nr_bytes);
-    const uint8_t *p = (const uint8_t*)bytes;
-    const uint8_t *end = p + nr_bytes;
-    while (p != end) {
-        if (is_utf8_leading_byte(*p)) {
-            buffer->nr_chars++;
-        }
-        p++;
-    }
+    buffer->nr_chars += pcutils_utf8_count_chars(bytes, nr_bytes);
 }
 
 static inline size_t uc_to_utf8(uint32_t c, char *outbuf)
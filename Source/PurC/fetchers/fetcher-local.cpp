@@ -25,19 +25,81 @@
 #include "config.h"
 
 #include "fetcher-internal.h"
+#include "private/list.h"
+#include "private/map.h"
+#include "private/rwstream.h"
 
+#include <wtf/Condition.h>
+#include <wtf/Lock.h>
+#include <wtf/Threading.h>
 #include <wtf/URL.h>
 #include <wtf/RunLoop.h>
+#include <wtf/Vector.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <unistd.h>
 
 #include <stdlib.h>
+#include <atomic>
+
+/* the maximal number of the worker threads doing the file I/O */
+#define LOCAL_FETCHER_MAX_WORKERS       4
+
+/* the files not smaller than this are mapped into memory instead of read */
+#define LOCAL_FETCHER_MMAP_THRESHOLD    (64 * 1024)
+
+/* the content of a local file, shared by the cache and the responses */
+struct local_content {
+    struct list_head        ln;     /* the node in the LRU list if cached */
+    char                   *path;
+
+    /* the key of the content besides the path */
+    dev_t                   dev;
+    ino_t                   ino;
+    off_t                   size;
+    struct timespec         mtime;
+
+    void                   *data;
+    bool                    mapped;
+    bool                    cached;
+    std::atomic<unsigned>   refc;
+};
+
+/* a request to be done by a worker */
+struct local_request {
+    struct list_head        ln;
+    char                   *path;
+    RunLoop                *runloop;
+    struct pcfetcher_callback_info *info;
+
+    /* the result */
+    struct pcfetcher_resp_header header;
+    purc_rwstream_t         rws;
+};
 
 struct pcfetcher_local {
     struct pcfetcher base;
     char* base_uri;
+
+    Lock lock;
+
+    /* the worker pool, started by the first asynchronous request */
+    Condition cond_request;
+    Condition cond_idle;
+    Vector<RefPtr<Thread>> workers;
+    struct list_head requests;
+    size_t nr_pending;
+    bool quit;
+
+    /* the contents cached: path -> struct local_content */
+    pcutils_map *cache;
+    struct list_head lru;           /* the most recently used is the first */
+    size_t cache_size;
+    size_t cache_quota;             /* in bytes */
 };
 
 struct mime_type {
@@ -55,6 +117,10 @@ struct mime_type  mime_types[] = {
 static const char* get_mime(const char* name)
 {
     const char* ext = strrchr(name, '.');
+    if (ext == NULL) {
+        return mime_types[0].mime;
+    }
+
     size_t sz = sizeof(mime_types) / sizeof(struct mime_type);
     for (size_t i = 1; i < sz; i++) {
         if (strcmp(ext, mime_types[i].ext) == 0) {
@@ -64,14 +130,319 @@ static const char* get_mime(const char* name)
     return mime_types[0].mime;
 }
 
+static void unref_content(struct local_content *content)
+{
+    if (content->refc.fetch_sub(1) != 1)
+        return;
+
+    if (content->mapped) {
+        munmap(content->data, content->size);
+    }
+    else {
+        free(content->data);
+    }
+    free(content->path);
+    delete content;
+}
+
+static void release_content(void *ctxt)
+{
+    unref_content((struct local_content *)ctxt);
+}
+
+static bool is_same_file(const struct local_content *content,
+        const struct stat *st)
+{
+    return content->dev == st->st_dev && content->ino == st->st_ino &&
+        content->size == st->st_size &&
+#if OS(LINUX)
+        content->mtime.tv_sec == st->st_mtim.tv_sec &&
+        content->mtime.tv_nsec == st->st_mtim.tv_nsec;
+#else
+        content->mtime.tv_sec == st->st_mtime;
+#endif
+}
+
+/* Reads or maps the file; no PurC API is called here, because the workers
+   do not own any PurC instance. Returns NULL and sets errno on failure. */
+static struct local_content *read_content(const char *path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct local_content *content = NULL;
+    struct stat st;
+    if (fstat(fd, &st)) {
+        goto done;
+    }
+    else if (!S_ISREG(st.st_mode)) {
+        errno = EISDIR;
+        goto done;
+    }
+
+    content = new local_content();
+    content->path = strdup(path);
+    content->dev = st.st_dev;
+    content->ino = st.st_ino;
+    content->size = st.st_size;
+#if OS(LINUX)
+    content->mtime = st.st_mtim;
+#else
+    content->mtime.tv_sec = st.st_mtime;
+#endif
+    content->refc = 1;
+
+    if (st.st_size >= LOCAL_FETCHER_MMAP_THRESHOLD) {
+        content->data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (content->data == MAP_FAILED) {
+            content->data = NULL;
+        }
+        else {
+            content->mapped = true;
+        }
+    }
+
+    if (!content->mapped) {
+        size_t nr_read = 0;
+        content->data = malloc(st.st_size + 1);
+        while (content->data && nr_read < (size_t)st.st_size) {
+            ssize_t n = read(fd, (char *)content->data + nr_read,
+                    st.st_size - nr_read);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            nr_read += n;
+        }
+
+        /* the file was truncated */
+        content->size = nr_read;
+    }
+
+    if (content->data == NULL || content->path == NULL) {
+        errno = ENOMEM;
+        content->size = 0;
+        unref_content(content);
+        content = NULL;
+    }
+
+done:
+    close(fd);
+    return content;
+}
+
+/* Evicts the content from the cache; the caller holds the lock. */
+static void evict_content(struct pcfetcher_local *local,
+        struct local_content *content)
+{
+    list_del(&content->ln);
+    pcutils_map_erase(local->cache, content->path);
+    local->cache_size -= content->size;
+    content->cached = false;
+    unref_content(content);
+}
+
+/* Returns a new reference to the content of the file, from the cache if
+   the file is not changed. Called by the workers and the callers of
+   the synchronous requests. */
+static struct local_content *load_content(struct pcfetcher_local *local,
+        const char *path)
+{
+    struct local_content *content = NULL;
+    struct stat st;
+
+    if (local->cache_quota && stat(path, &st) == 0) {
+        auto locker = holdLock(local->lock);
+        pcutils_map_entry *entry = pcutils_map_find(local->cache, path);
+        if (entry) {
+            content = (struct local_content *)entry->val;
+            if (is_same_file(content, &st)) {
+                list_del(&content->ln);
+                list_add(&content->ln, &local->lru);
+                content->refc++;
+                return content;
+            }
+
+            evict_content(local, content);
+        }
+    }
+
+    content = read_content(path);
+    if (content == NULL || local->cache_quota == 0 ||
+            (size_t)content->size > local->cache_quota) {
+        return content;
+    }
+
+    auto locker = holdLock(local->lock);
+    if (pcutils_map_find(local->cache, path)) {
+        /* loaded by another worker meanwhile */
+        return content;
+    }
+
+    while (!list_empty(&local->lru) &&
+            local->cache_size + content->size > local->cache_quota) {
+        struct local_content *lru;
+        lru = list_last_entry(&local->lru, struct local_content, ln);
+        evict_content(local, lru);
+    }
+
+    if (pcutils_map_insert(local->cache, content->path, content) == 0) {
+        content->refc++;
+        content->cached = true;
+        list_add(&content->ln, &local->lru);
+        local->cache_size += content->size;
+    }
+
+    return content;
+}
+
+/* Makes the response of the file; called by the workers too. */
+static purc_rwstream_t make_response(struct pcfetcher_local *local,
+        const char *path, struct pcfetcher_resp_header *resp_header)
+{
+    struct local_content *content = load_content(local, path);
+    if (content == NULL) {
+        resp_header->ret_code = 404;
+        resp_header->sz_resp = 0;
+        resp_header->mime_type = NULL;
+        return NULL;
+    }
+
+    purc_rwstream_t rws = pcutils_rwstream_new_from_shared_mem(content->data,
+            content->size, release_content, content);
+    if (rws == NULL) {
+        unref_content(content);
+        resp_header->ret_code = 500;
+        resp_header->sz_resp = 0;
+        resp_header->mime_type = NULL;
+        return NULL;
+    }
+
+    resp_header->ret_code = 200;
+    resp_header->sz_resp = content->size;
+    resp_header->mime_type = strdup(get_mime(path));
+    return rws;
+}
+
+/* Returns the path of the local file, or NULL if the url does not refer
+   to a local file. The caller should free the path. */
+static char *resolve_path(struct pcfetcher_local *local, const char *url)
+{
+    String uri;
+    if (local->base_uri &&
+            strncmp(url, local->base_uri, strlen(local->base_uri)) != 0) {
+        uri.append(local->base_uri);
+    }
+    uri.append(url);
+    PurCWTF::URL wurl(URL(), uri);
+    if (!wurl.isLocalFile()) {
+        return NULL;
+    }
+
+    const StringView path = wurl.path();
+    const CString& cpath = path.utf8();
+    return strdup(cpath.data());
+}
+
+static void post_response(struct local_request *request)
+{
+    RunLoop *runloop = request->runloop;
+
+#ifdef NDEBUG
+    runloop->dispatch([request] {
+#else
+    // random
+    double tm = randomNumber() * 10;
+    runloop->dispatchAfter(Seconds(tm), [request] {
+#endif
+                struct pcfetcher_callback_info *info = request->info;
+                if (!info->cancelled) {
+                    info->header = request->header;
+                    info->rws = request->rws;
+                    info->handler(info->req_id, info->ctxt, &info->header,
+                            info->rws);
+                    info->rws = NULL;
+                }
+                else {
+                    if (request->header.mime_type)
+                        free(request->header.mime_type);
+                    if (request->rws)
+                        purc_rwstream_destroy(request->rws);
+                }
+                pcfetcher_destroy_callback_info(info);
+                free(request);
+            });
+}
+
+static void worker_main(struct pcfetcher_local *local)
+{
+    while (true) {
+        struct local_request *request;
+        {
+            auto locker = holdLock(local->lock);
+            while (!local->quit && list_empty(&local->requests)) {
+                local->cond_request.wait(local->lock);
+            }
+
+            if (list_empty(&local->requests)) {
+                break;
+            }
+
+            request = list_first_entry(&local->requests,
+                    struct local_request, ln);
+            list_del(&request->ln);
+        }
+
+        request->rws = make_response(local, request->path, &request->header);
+        free(request->path);
+        request->path = NULL;
+        post_response(request);
+
+        auto locker = holdLock(local->lock);
+        if (--local->nr_pending == 0) {
+            local->cond_idle.notifyAll();
+        }
+    }
+}
+
+/* Queues the request to the workers; the caller holds the lock. */
+static void queue_request(struct pcfetcher_local *local,
+        struct local_request *request)
+{
+    if (local->workers.isEmpty()) {
+        size_t nr_workers = local->base.max_conns;
+        if (nr_workers > LOCAL_FETCHER_MAX_WORKERS)
+            nr_workers = LOCAL_FETCHER_MAX_WORKERS;
+        else if (nr_workers == 0)
+            nr_workers = 1;
+
+        for (size_t i = 0; i < nr_workers; i++) {
+            local->workers.append(Thread::create("PcFetcherLocal_Worker",
+                        [local] { worker_main(local); }));
+        }
+    }
+
+    list_add_tail(&request->ln, &local->requests);
+    local->nr_pending++;
+    local->cond_request.notifyOne();
+}
+
 struct pcfetcher* pcfetcher_local_init(size_t max_conns, size_t cache_quota)
 {
-    struct pcfetcher_local* local = (struct pcfetcher_local*)malloc(
-            sizeof(struct pcfetcher_local));
+    struct pcfetcher_local* local = new pcfetcher_local();
     if (local == NULL) {
         return NULL;
     }
 
+    local->cache = pcutils_map_create(NULL, NULL, NULL, NULL,
+            comp_key_string, false);
+    if (local->cache == NULL) {
+        delete local;
+        return NULL;
+    }
+
     struct pcfetcher* fetcher = (struct pcfetcher*) local;
     fetcher->max_conns = max_conns;
     fetcher->cache_quota = cache_quota;
@@ -87,6 +458,10 @@ struct pcfetcher* pcfetcher_local_init(size_t max_conns, size_t cache_quota)
     fetcher->check_response = pcfetcher_local_check_response;
 
     local->base_uri = NULL;
+    INIT_LIST_HEAD(&local->requests);
+    INIT_LIST_HEAD(&local->lru);
+    /* the cache quota is given in KiB */
+    local->cache_quota = cache_quota * 1024;
 
     return fetcher;
 }
@@ -98,10 +473,32 @@ int pcfetcher_local_term(struct pcfetcher* fetcher)
     }
 
     struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    {
+        auto locker = holdLock(local->lock);
+        while (local->nr_pending > 0) {
+            local->cond_idle.wait(local->lock);
+        }
+
+        local->quit = true;
+        local->cond_request.notifyAll();
+    }
+
+    for (auto& worker : local->workers) {
+        worker->waitForCompletion();
+    }
+    local->workers.clear();
+
+    /* the contents still used by the responses are freed by them */
+    struct local_content *p, *n;
+    list_for_each_entry_safe(p, n, &local->lru, ln) {
+        evict_content(local, p);
+    }
+    pcutils_map_destroy(local->cache);
+
     if (local->base_uri) {
         free(local->base_uri);
     }
-    free(local);
+    delete local;
     return 0;
 }
 
@@ -171,55 +568,45 @@ purc_variant_t pcfetcher_local_request_async(
         pcfetcher_response_handler handler,
         void* ctxt)
 {
-    UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(url);
     UNUSED_PARAM(method);
     UNUSED_PARAM(params);
     UNUSED_PARAM(timeout);
-    UNUSED_PARAM(handler);
-    UNUSED_PARAM(ctxt);
 
     if (!fetcher || !url || !handler) {
         return PURC_VARIANT_INVALID;
     }
 
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    struct local_request *request = (struct local_request *)calloc(1,
+            sizeof(*request));
     struct pcfetcher_callback_info *info = pcfetcher_create_callback_info();
-    info->rws = pcfetcher_local_request_sync(fetcher, url, method,
-            params, timeout, &info->header);
+    if (request == NULL || info == NULL) {
+        free(request);
+        free(info);
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
     info->handler = handler;
     info->ctxt = ctxt;
     info->req_id = purc_variant_make_native(info, NULL);
 
-    if (!info->rws) {
-        info->header.ret_code = 404;
+    request->info = info;
+    request->runloop = &RunLoop::current();
+    request->path = resolve_path(local, url);
+    if (request->path == NULL) {
+        request->header.ret_code = 404;
+        post_response(request);
+    }
+    else {
+        /* the file is opened and read by a worker */
+        auto locker = holdLock(local->lock);
+        queue_request(local, request);
     }
-
-    RunLoop *runloop = &RunLoop::current();
-#ifdef NDEBUG
-    runloop->dispatch([info] {
-#else
-    // random
-    double tm = randomNumber() * 10;
-    runloop->dispatchAfter(Seconds(tm), [info] {
-#endif
-                if (!info->cancelled) {
-                    info->handler(info->req_id, info->ctxt, &info->header,
-                            info->rws);
-                    info->rws = NULL;
-                }
-                pcfetcher_destroy_callback_info(info);
-            });
 
     return info->req_id;
 }
 
-off_t filesize(const char* filename)
-{
-    struct stat statbuf;
-    stat(filename,&statbuf);
-    return statbuf.st_size;
-}
-
 purc_rwstream_t pcfetcher_local_request_sync(
         struct pcfetcher* fetcher,
         const char* url,
@@ -228,45 +615,26 @@ purc_rwstream_t pcfetcher_local_request_sync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header)
 {
-    UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(url);
     UNUSED_PARAM(method);
     UNUSED_PARAM(params);
     UNUSED_PARAM(timeout);
-    UNUSED_PARAM(resp_header);
 
     if (!fetcher || !url) {
         return NULL;
     }
+
     struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
-    String uri;
-    if (local->base_uri &&
-            strncmp(url, local->base_uri, strlen(local->base_uri)) != 0) {
-        uri.append(local->base_uri);
-    }
-    uri.append(url);
-    PurCWTF::URL wurl(URL(), uri);
-    if (!wurl.isLocalFile()) {
+    char *path = resolve_path(local, url);
+    if (path == NULL) {
         resp_header->ret_code = 404;
         resp_header->sz_resp = 0;
         resp_header->mime_type = NULL;
         return NULL;
     }
 
-    const StringView path = wurl.path();
-    const CString& cpath = path.utf8();
-
-    const char* file = cpath.data();
-
-    purc_rwstream_t rws = purc_rwstream_new_from_file(file, "r");
-    if (rws && resp_header) {
-        resp_header->ret_code = 200;
-        resp_header->sz_resp = filesize(file);
-        resp_header->mime_type = strdup(get_mime(file));
-        return rws;
-    }
-
-    return NULL;
+    purc_rwstream_t rws = make_response(local, path, resp_header);
+    free(path);
+    return rws;
 }
 
 void pcfetcher_local_cancel_async(struct pcfetcher* fetcher,
@@ -291,5 +659,3 @@ int pcfetcher_local_check_response(struct pcfetcher* fetcher,
     UNUSED_PARAM(timeout_ms);
     return 0;
 }
-
-
@@ -80,6 +80,11 @@ struct purc_document_ops {
     pcdoc_node (*get_child)(purc_document_t doc,
             pcdoc_element_t elem, pcdoc_node_type type, size_t idx);
 
+    // nullable; the cursor-style access to the children
+    pcdoc_node (*first_child)(purc_document_t doc, pcdoc_element_t elem);
+    // null if `first_child` is null
+    pcdoc_node (*next_sibling)(purc_document_t doc, pcdoc_node node);
+
     int (*get_attribute)(purc_document_t doc, pcdoc_element_t elem,
             const char *name, const char **val, size_t *len);
     int (*get_special_attr)(purc_document_t doc, pcdoc_element_t elem,
@@ -140,6 +145,56 @@ extern struct purc_document_ops _pcdoc_void_ops WTF_INTERNAL;
 extern struct purc_document_ops _pcdoc_plain_ops WTF_INTERNAL;
 extern struct purc_document_ops _pcdoc_html_ops WTF_INTERNAL;
 
+/*
+ * The CSS selector engine and the id/class indexes for the documents
+ * whose elements are the elements of the DOM of PurC (pcdom_element_t).
+ */
+struct pcdoc_selector;
+struct pcdoc_elem_index;
+
+/* Compiles a CSS selector; returns NULL and sets the error for a bad one. */
+struct pcdoc_selector *
+pcdoc_selector_new(const char *selector) WTF_INTERNAL;
+
+void
+pcdoc_selector_delete(struct pcdoc_selector *selector) WTF_INTERNAL;
+
+bool
+pcdoc_selector_match(struct pcdoc_selector *selector,
+        pcdoc_element_t elem) WTF_INTERNAL;
+
+/*
+ * Appends the elements matching the selector in the subtree of scope
+ * (including scope itself) to found in the document order; at most
+ * max_found elements if max_found is not zero. The candidates are taken
+ * from the indexes if index is not NULL and the selector allows.
+ */
+int
+pcdoc_selector_select(struct pcdoc_selector *selector,
+        struct pcdoc_elem_index *index, pcdoc_element_t scope,
+        struct pcutils_arrlist *found, size_t max_found) WTF_INTERNAL;
+
+/* Creates the indexes of the elements in the subtree of root. */
+struct pcdoc_elem_index *
+pcdoc_elem_index_new(pcdoc_element_t root) WTF_INTERNAL;
+
+void
+pcdoc_elem_index_delete(struct pcdoc_elem_index *index) WTF_INTERNAL;
+
+/* Adds the element (and its descendants if subtree is true) to the
+   indexes; call this after the element is inserted or its id or class
+   is changed. */
+void
+pcdoc_elem_index_add(struct pcdoc_elem_index *index, pcdoc_element_t elem,
+        bool subtree) WTF_INTERNAL;
+
+/* Removes the element (and its descendants if subtree is true) from the
+   indexes; call this before the element is destroyed or its id or class
+   is changed. */
+void
+pcdoc_elem_index_remove(struct pcdoc_elem_index *index, pcdoc_element_t elem,
+        bool subtree) WTF_INTERNAL;
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -73,6 +73,7 @@ struct pcinst {
     // flags go here
     unsigned int            enable_remote_fetcher:1;
     unsigned int            is_instmgr:1;
+    unsigned int            vcm_tree_walker:1;
 
     char                   *app_name;
     char                   *runner_name;
@@ -95,6 +96,13 @@ struct pcinst {
     struct pcvariant_heap  *org_vrt_heap;
 
     struct pcvarmgr        *variables;
+    /* bumped whenever a name is bound to or unbound from any variable
+       manager of this instance; invalidates the cached resolutions */
+    uint64_t                var_generation;
+
+    /* the constants of the vcm programs prebuilt in the variant heap of
+       this instance, keyed by the identifiers of the programs */
+    struct pchash_table    *vcm_consts;
 
     struct pcrdr_conn      *conn_to_rdr;
     struct renderer_capabilities *rdr_caps;
@@ -123,6 +131,17 @@ pcinst_get_session_variables(const char* name)
 struct pcrdr_msg *pcinst_get_message(void) WTF_INTERNAL;
 void pcinst_put_message(struct pcrdr_msg *msg) WTF_INTERNAL;
 
+/* Returns the file descriptor which becomes readable when a message was
+   moved to the move buffer of the current instance; -1 if no move buffer.
+   If @clear is true, the pending signal will be consumed. */
+int pcinst_move_buffer_event_fd(bool clear) WTF_INTERNAL;
+
+/* Waits for at most @timeout_ms milliseconds (a negative value for ever)
+   until a message is moved to the move buffer of the current instance.
+   Returns the number of the messages in the buffer, 0 on timeout,
+   or -1 on error. */
+ssize_t pcinst_wait_for_moved_messages(int timeout_ms) WTF_INTERNAL;
+
 int
 pcinst_broadcast_event(pcrdr_msg_event_reduce_opt reduce_op,
         purc_variant_t source_uri, purc_variant_t observed,
@@ -66,6 +66,7 @@
 #define MSG_SUB_TYPE_EXITED           "exited"
 #define MSG_SUB_TYPE_PAGE_CLOSED      "pageClosed"
 #define MSG_SUB_TYPE_CONN_LOST        "connLost"
+#define MSG_SUB_TYPE_DOM_ERROR        "domError"
 
 struct pcintr_heap;
 typedef struct pcintr_heap pcintr_heap;
@@ -99,6 +100,19 @@ struct pcintr_cancel {
     struct list_head             node;
 };
 
+struct pcintr_sched_stats {
+    uint64_t              nr_ticks;         // times of scheduling
+    uint64_t              nr_steps;         // steps executed
+    uint64_t              nr_dispatches;    // coroutines visited for events
+    uint64_t              nr_idle_waits;    // times of waiting for events
+    uint64_t              nr_wakeups;       // idle waits broken by new events
+    uint64_t              nr_preemptions;   // quanta used up by coroutines
+
+    // statistics of the last tick
+    size_t                last_ready;       // ready coroutines executed
+    size_t                last_pending;     // coroutines visited for events
+};
+
 struct pcintr_heap {
     // owner instance
     struct pcinst        *owner;
@@ -110,6 +124,29 @@ struct pcintr_heap {
     // key as atom, val as struct pcintr_coroutine
     struct rb_root        coroutines;
 
+    // coroutines in CO_STATE_READY, linked by pcintr_coroutine::ready_ln
+    struct list_head      ready_cos;
+    // coroutines having messages or tasks to dispatch,
+    // linked by pcintr_coroutine::pending_ln
+    struct list_head      pending_cos;
+    struct pcintr_sched_stats sched_stats;
+
+    // coroutines having DOM operations queued for the renderer,
+    // linked by pcintr_coroutine::dom_ops_ln
+    struct list_head      dom_ops_cos;
+    // the DOM operations sent but not acknowledged by the renderer yet
+    size_t                nr_dom_acks;
+    // the max DOM operations queued by a coroutine; 0 for no queue
+    size_t                max_dom_ops;
+
+    // the quantum of a ready coroutine: the max steps and the max time (us)
+    // executed in a row before switching to the next ready coroutine
+    unsigned int          quantum_steps;
+    unsigned int          quantum_usec;
+
+    // the initial value of `$%` shared by all frames until it is increased
+    purc_variant_t        initial_index;
+
     struct list_head      routines;     // struct pcintr_routine
 
     int64_t               next_coroutine_id;
@@ -118,6 +155,8 @@ struct pcintr_heap {
 
     purc_cond_handler    cond_handler;
     unsigned int         keep_alive:1;
+    // scan all coroutines in every tick instead of using the queues
+    unsigned int         polling_schedule:1;
     double               timestamp;
 };
 
@@ -137,6 +176,17 @@ struct pcintr_observer;
 typedef void (*pcintr_on_revoke_observer)(struct pcintr_observer *observer,
         void *data);
 
+struct pcregex;
+
+/* The observers hashed by the message type and the observed value; the
+   observers in a slot are kept in the order of registration. */
+struct pcintr_observer_index {
+    struct list_head           *slots;
+    size_t                      nr_slots;
+    size_t                      nr_observers;
+    uint64_t                    last_seq;
+};
+
 struct pcintr_loaded_var {
     struct rb_node              node;
     char                       *name;
@@ -162,6 +212,8 @@ struct pcintr_exception {
     struct pcdebug_backtrace  *bt;
 };
 
+struct pcintr_var_cache;
+
 struct pcintr_stack {
     struct list_head              frames;
     // the number of stack frames.
@@ -208,12 +260,21 @@ struct pcintr_stack {
     struct list_head              common_observers;
     struct list_head              dynamic_observers;
     struct list_head              native_observers;
+    // the index of the observers above (see observer.c)
+    struct pcintr_observer_index  observer_index;
 
     // async request ids (array)
     purc_variant_t                async_request_ids;
 
     // key: vdom_node  val: pcvarmgr_t
     struct rb_root                scoped_variables;
+
+    // the popped normal frames kept for reuse
+    struct list_head              free_frames;
+    size_t                        nr_free_frames;
+
+    // the caches of the resolution of named variables (see var-mgr.c)
+    struct pcintr_var_cache      *var_caches;
 };
 
 enum pcintr_coroutine_stage {
@@ -263,6 +324,14 @@ struct pcintr_coroutine {
     purc_variant_t              doc_wrotten_len;
 
     struct rb_node              node;     /* heap::coroutines */
+    struct list_head            ready_ln;   /* heap::ready_cos */
+    struct list_head            pending_ln; /* heap::pending_cos */
+
+    /* the DOM operations to send to the renderer in batch */
+    struct list_head            dom_ops;    /* struct pcintr_rdr_dom_op */
+    struct list_head            dom_ops_ln; /* heap::dom_ops_cos */
+    size_t                      nr_dom_ops;
+    double                      dom_ops_since;  /* time of the first one */
 
     struct list_head            children; /* struct pcintr_coroutine_child */
 
@@ -420,6 +489,11 @@ struct pcintr_dynamic_args {
 struct pcintr_observer {
     struct list_head            node;
 
+    // the node in the slot of the observer index
+    struct list_head            index_node;
+    // the sequence number of registration, used to keep the dispatch order
+    uint64_t                    seq;
+
     pcintr_stack_t              stack;
     // the observed variant.
     purc_variant_t observed;
@@ -430,6 +504,12 @@ struct pcintr_observer {
     // the sub type of the message observed (cloned from the `for` attribute; nullable).
     char* sub_type;
 
+    // the sub type pattern compiled at registration (nullable).
+    struct pcregex *sub_type_regex;
+
+    // whether the sub type contains no metacharacters of regular expression.
+    bool sub_type_literal;
+
     pcvdom_element_t scope;
     pcdoc_element_t  edom_element;
 
@@ -551,6 +631,16 @@ pcintr_get_scope_variable(purc_coroutine_t cor, pcvdom_element_t elem,
 purc_variant_t
 pcintr_find_named_var(pcintr_stack_t stack, const char* name);
 
+/* Same as pcintr_find_named_var(), but remembers in the caches of the stack
+ * the scope which resolved the name for the node (e.g., the get_variable
+ * node of VCM), and tries that scope first next time. */
+purc_variant_t
+pcintr_find_named_var_cached(pcintr_stack_t stack, const char* name,
+        const void *node);
+
+void
+pcintr_release_var_caches(pcintr_stack_t stack);
+
 purc_variant_t
 pcintr_get_symbolized_var (pcintr_stack_t stack, unsigned int number,
         char symbol);
@@ -688,6 +778,10 @@ pcintr_coroutine_get_uri(pcintr_coroutine_t co)
 void
 pcintr_schedule(void *ctxt);
 
+/* the scheduler statistics of the current instance; NULL if no heap */
+const struct pcintr_sched_stats *
+pcintr_get_sched_stats(void);
+
 void
 pcintr_coroutine_set_result(pcintr_coroutine_t co, purc_variant_t result);
 
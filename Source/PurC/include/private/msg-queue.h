@@ -44,6 +44,8 @@ struct pcinst_msg_hdr {
     struct list_head        ln;
 };
 
+typedef void (*pcinst_msg_queue_notify_fn)(void *ctxt);
+
 struct pcinst_msg_queue {
     struct purc_rwlock  lock;
     struct list_head    req_msgs;
@@ -53,6 +55,10 @@ struct pcinst_msg_queue {
 
     uint64_t            state;
     size_t              nr_msgs;
+
+    /* called (without lock) after a message was put into the queue */
+    pcinst_msg_queue_notify_fn  notify;
+    void                       *notify_ctxt;
 };
 
 /* Make sure the size of `struct list_head` is two times of sizeof(void *) */
@@ -89,6 +95,10 @@ pcinst_msg_queue_get_event_by_element(struct pcinst_msg_queue *queue,
 size_t
 pcinst_msg_queue_count(struct pcinst_msg_queue *queue);
 
+void
+pcinst_msg_queue_set_notifier(struct pcinst_msg_queue *queue,
+        pcinst_msg_queue_notify_fn notify, void *ctxt);
+
 PCA_EXTERN_C_END
 
 #endif /* not defined PURC_PRIVATE_MSG_QUEUE_H */
@@ -32,6 +32,10 @@
 
 #define PCRDR_TIME_DEF_EXPECTED         5
 
+/* Set to 0 or false to use the text encoding of the messages even if
+   the renderer supports the binary one */
+#define PURC_ENVV_RDR_BINARY_MSG        "PURC_RDR_BINARY_MSG"
+
 /* the capabilities of a renderer */
 struct renderer_capabilities {
     /* the protocol name */
@@ -60,6 +64,10 @@ struct renderer_capabilities {
        0 for not supported, -1 for unlimited */
     long int    plainWindow;
 
+    /* the version of the binary message encoding;
+       0 for not supported */
+    long int    binaryMessage;
+
     /* the session handle */
     uint64_t    session_handle;
     /* the default workspace handle */
@@ -76,6 +84,10 @@ pcrdr_parse_renderer_capabilities(const char *data) WTF_INTERNAL;
 void pcrdr_release_renderer_capabilities(
         struct renderer_capabilities *rdr_caps) WTF_INTERNAL;
 
+/* Returns the name of the operation having the identifier,
+   NULL for an invalid identifier. */
+const char *pcrdr_operation_name(unsigned int id) WTF_INTERNAL;
+
 static inline purc_atom_t
 pcrdr_check_operation(const char *op)
 {
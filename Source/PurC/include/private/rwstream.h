@@ -25,5 +25,35 @@
 #ifndef PURC_PRIVATE_RWSTREAM_H
 #define PURC_PRIVATE_RWSTREAM_H
 
+#include "config.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "purc-rwstream.h"
+
+PCA_EXTERN_C_BEGIN
+
+/*
+ * Gets the read cursor of a memory-backed rwstream (created by
+ * purc_rwstream_new_from_mem() or purc_rwstream_new_buffer()), so that
+ * the caller can decode the content in place and advance the stream by
+ * updating `*here` directly.
+ *
+ * Returns false without setting any error for other kinds of rwstream.
+ */
+bool pcutils_rwstream_get_mem_cursor(purc_rwstream_t rws,
+        uint8_t ***here, uint8_t ***stop) WTF_INTERNAL;
+
+/*
+ * Creates a read-only rwstream on the memory shared with others, e.g.,
+ * the content cached by the local fetcher. The memory is not copied;
+ * `release` will be called with `ctxt` when the rwstream is destroyed.
+ */
+purc_rwstream_t pcutils_rwstream_new_from_shared_mem(const void *mem,
+        size_t sz, void (*release)(void *ctxt), void *ctxt) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
 #endif /* not defined PURC_PRIVATE_RWSTREAM_H */
 
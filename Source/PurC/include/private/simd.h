@@ -0,0 +1,78 @@
+/*
+ * @file simd.h
+ * @date 2022/10/22
+ * @brief The interfaces of the SIMD kernels for scanning strings.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_PRIVATE_SIMD_H
+#define PURC_PRIVATE_SIMD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "purc-utils.h"
+
+/* Use env PURC_SIMD to cap the instruction set used by the kernels:
+   `none`, `sse2`, or `avx2`. */
+#define PURC_ENVV_SIMD          "PURC_SIMD"
+
+enum pcutils_simd_level {
+    PCUTILS_SIMD_NONE = 0,
+    PCUTILS_SIMD_SSE2,
+    PCUTILS_SIMD_AVX2,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/* Returns the level of the kernels in use: the best one supported by
+   the CPU unless capped by env PURC_SIMD. */
+int pcutils_simd_level(void);
+
+/* Changes the level of the kernels in use (for tests and benchmarks);
+   the level is capped to the one supported by the CPU.
+   Returns the level in use. */
+int pcutils_simd_set_level(int level);
+
+/* Returns the length of the longest prefix of str which is made of
+   complete and valid UTF-8 characters without any null byte, and the
+   number of the characters in it via nr_chars. The prefix may stop
+   before an invalid character or a null byte; the caller should check
+   the remaining bytes one by one. */
+size_t pcutils_utf8_valid_prefix(const char *str, size_t len,
+        size_t *nr_chars);
+
+/* Returns the number of the characters in the valid UTF-8 string,
+   i.e., the number of bytes which are not continuation bytes. */
+size_t pcutils_utf8_count_chars(const char *str, size_t len);
+
+/* Returns the offset of the first byte which should be escaped in
+   a JSON string: a control character, `"`, `\`, or `/` if escape_slash
+   is true. Returns len if there is no such byte. */
+size_t pcutils_json_escape_span(const char *str, size_t len,
+        bool escape_slash);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+
+#endif /* PURC_PRIVATE_SIMD_H */
@@ -43,7 +43,6 @@
 
 struct tkz_reader;
 struct tkz_uc {
-    struct list_head list;
     uint32_t character;
     int line;
     int column;
@@ -242,6 +241,11 @@ is_context_variable(uint32_t c)
 }
 
 // tokenizer reader
+/*
+ * The reader decodes memory-backed rwstreams in place and reads other
+ * rwstreams ahead in blocks, so the bytes after the last character returned
+ * may have been taken from the stream already.
+ */
 struct tkz_reader *tkz_reader_new(void);
 
 void tkz_reader_set_rwstream(struct tkz_reader *reader, purc_rwstream_t rws);
@@ -231,6 +231,18 @@ int pcutils_parse_uint64(const char *buf, size_t len, uint64_t *retval);
 int pcutils_parse_double(const char *buf, size_t len, double *retval);
 int pcutils_parse_long_double(const char *buf, size_t len, long double *retval);
 
+/* the size of buffer long enough to hold any formatted number */
+#define PCUTILS_DTOA_BUFSZ      32
+
+/* Formats a finite double in the shortest form which can be read back to
+   the same value, in the layout of `%.17g`. Returns the length. */
+size_t pcutils_dtoa_shortest(double d, char *buf);
+
+/* Formats an integral double (long double) less than max_abs in magnitude
+   as a decimal integer. Returns the length, or 0 if it is not one. */
+size_t pcutils_dtoa_integer(double d, double max_abs, char *buf);
+size_t pcutils_ldtoa_integer(long double ld, long double max_abs, char *buf);
+
 struct pcutils_mystring {
     char *buff;
     size_t nr_bytes;
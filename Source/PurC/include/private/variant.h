@@ -46,6 +46,12 @@ PCA_EXTERN_C_BEGIN
                         t == PURC_VARIANT_TYPE_ARRAY || \
                         t == PURC_VARIANT_TYPE_SET)
 
+/* Set to 0 or false to look up the members of objects in the rbtree only */
+#define PURC_ENVV_VARIANT_OBJECT_INDEX  "PURC_VARIANT_OBJECT_INDEX"
+
+/* Set to 0 or false to look up the elements of sets in the rbtree only */
+#define PURC_ENVV_VARIANT_SET_INDEX     "PURC_VARIANT_SET_INDEX"
+
 #define MAX_RESERVED_VARIANTS   32
 #define DEF_EMBEDDED_LEVELS     64
 #define MAX_EMBEDDED_LEVELS     1024
@@ -201,6 +207,11 @@ struct pcvariant_heap {
     // the statistics of memory usage of variant values
     struct purc_variant_stat stat;
 
+    // whether to index the large objects by the hash of keys
+    bool                obj_index_disabled;
+    // whether to index the large sets by the hash of unique-key fields
+    bool                set_index_disabled;
+
 #if USE(LOOP_BUFFER_FOR_RESERVED)
     // the loop buffer for reserved values.
     purc_variant_t      v_reserved[MAX_RESERVED_VARIANTS];
@@ -241,7 +252,8 @@ struct set_node {
     struct rb_node                       rbnode;
     struct pcutils_array_list_node       alnode;
     purc_variant_t   val;  // actual variant-element
-    char             md5[33];
+    /* the hash of the unique-key fields, not used by the caseless sets */
+    uint64_t         hash;
 };
 
 struct variant_set {
@@ -252,6 +264,13 @@ struct variant_set {
     struct rb_root          elems;  // multiple-variant-elements stored in set
     struct pcutils_array_list al;    // struct set_node
 
+    /* The open-addressing index of the elements by the hash of the unique-key
+       fields; only built when a case-sensitive set grows beyond
+       SET_INDEX_MIN_SIZE elements, the rbtree still keeps the elements
+       in order. */
+    struct set_node       **index;
+    size_t                  sz_index;   // a power of 2
+
     // key: arr_node/obj_node/set_node
     // val: parent
     pcutils_map                     *rev_update_chain;
@@ -264,12 +283,20 @@ struct obj_node {
     struct rb_node   node;
     purc_variant_t   key;
     purc_variant_t   val;
+    /* the hash of the key, only valid when the object is indexed */
+    uint32_t         hash;
 };
 
 struct variant_obj {
     struct rb_root          kvs;  // struct obj_node*
     size_t                  size;
 
+    /* The open-addressing index of the members by the hash of the keys;
+       only built when the object grows beyond OBJ_INDEX_MIN_SIZE members,
+       the rbtree still keeps the members in the order of the keys. */
+    struct obj_node       **index;
+    size_t                  sz_index;   // a power of 2
+
     // key: arr_node/obj_node/set_node
     // val: parent
     pcutils_map                     *rev_update_chain;
@@ -278,13 +305,21 @@ struct variant_obj {
 // internal struct used by variant-arr
 typedef struct variant_arr      *variant_arr_t;
 
+/* The identity of a member of an array in the reverse update chain of the
+   member; only allocated when the array belongs to a set. */
 struct arr_node {
-    struct pcutils_array_list_node       node;
-    purc_variant_t   val;
+    purc_variant_t   arr;
 };
 
 struct variant_arr {
-    struct pcutils_array_list     al;  // struct arr_node*
+    /* the members stored contiguously; grows geometrically */
+    purc_variant_t               *vals;
+    size_t                        nr;
+    size_t                        sz;
+
+    /* the side table of the anchors of the members, in the same order
+       as `vals`; NULL unless the array belongs to a set */
+    struct arr_node             **anchors;
 
     // key: arr_node/obj_node/set_node
     // val: parent
@@ -297,9 +332,52 @@ struct variant_arr {
 
 int pcvariant_array_sort(purc_variant_t value, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud));
+int pcvariant_array_swap(purc_variant_t value, size_t i, size_t j);
 int pcvariant_set_sort(purc_variant_t value, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud));
 
+enum pcvariant_sort_key_type {
+    PCVARIANT_SORT_KEY_NUMBER,
+    PCVARIANT_SORT_KEY_STRING,          // compared by strcmp()
+    PCVARIANT_SORT_KEY_CASELESS,        // compared by pcutils_strcasecmp()
+};
+
+/* The precomputed sort key of a member: `d` for a number key, or `s` for
+   a string key; `s` is owned by the sorter, and a NULL string compares
+   equal to any other string. */
+struct pcvariant_sort_key {
+    double          d;
+    char           *s;
+};
+
+/* Fills the `nr_keys` keys of a member; returns 0 on success, or -1 with
+   the error set to abort sorting. */
+typedef int (*pcvariant_sort_decorate_f)(purc_variant_t val,
+        struct pcvariant_sort_key *keys, void *ud);
+
+/*
+ * Sorts the members of an array or a set by decorate-sort-undecorate:
+ * the keys of every member are computed once by `decorate`, an index
+ * vector is sorted against them by a stable merge sort, and then the
+ * container is permuted in one pass. The members having the same keys
+ * keep their relative order.
+ *
+ * Returns 0 on success, -1 on failure, in which case the container
+ * is unchanged.
+ */
+int pcvariant_sort_by_keys(purc_variant_t value,
+        const enum pcvariant_sort_key_type *types, size_t nr_keys, bool desc,
+        pcvariant_sort_decorate_f decorate, void *ud);
+
+/*
+ * Makes a variant from the strict JSON text in the buffer, without
+ * building the eJSON tree. Returns PURC_VARIANT_INVALID without setting
+ * any error if the text is malformed, or uses any syntax beyond JSON,
+ * e.g., a `$` in a string; the caller falls back to the eJSON parser then.
+ */
+purc_variant_t
+pcvariant_make_from_strict_json(const char *json, size_t len);
+
 int pcvariant_diff(purc_variant_t l, purc_variant_t r);
 int pcvariant_diff_ex(purc_variant_t l, purc_variant_t r,
         enum purc_variant_compare_opt opt);
@@ -391,6 +469,12 @@ pcvariant_is_in_set (purc_variant_t set, purc_variant_t value)
 purc_variant_t
 pcvariant_object_shallow_copy(purc_variant_t obj);
 
+/* Same as purc_variant_object_get_by_ckey(), but does not set any error
+ * if silently is true */
+purc_variant_t
+pcvariant_object_get_by_ckey_ex(purc_variant_t obj, const char* key,
+        bool silently);
+
 bool
 pcvariant_object_clear(purc_variant_t object, bool silently);
 
@@ -428,14 +512,11 @@ pcvariant_md5(char *md5, purc_variant_t val)
     pcvariant_md5_ex(md5, val, salt, caseless, serialize_flags);
 }
 
-// md5 shall be at least 33 bytes long
-void
-pcvariant_md5_by_set(char *md5, purc_variant_t val,
-        purc_variant_t set) WTF_INTERNAL;
-
-int
-pcvariant_diff_by_set(const char *md5l, purc_variant_t l,
-        const char *md5r, purc_variant_t r, purc_variant_t set);
+/* Returns the 64-bit hash of the unique-key fields of the value (or the
+   whole value for a set without the unique key) in the set, consistent with
+   the case-sensitive comparison of the set; not for the caseless sets. */
+uint64_t
+pcvariant_hash_by_set(purc_variant_t val, purc_variant_t set) WTF_INTERNAL;
 
 PCA_EXTERN_C_END
 
@@ -450,66 +531,55 @@ PCA_EXTERN_C_END
 
 // purc_variant_t _arr;
 #define variant_array_get_data(_arr)        \
-    &(((variant_arr_t)_arr->sz_ptr[1])->al)
-
-// purc_variant_t _arr;
-// struct arr_node *_p;
-#define foreach_in_variant_array(_arr, _p)                               \
-    array_list_for_each_entry(variant_array_get_data(_arr),              \
-            _p, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p, *_n;
-#define foreach_in_variant_array_safe(_arr, _p, _n)                      \
-    array_list_for_each_entry_safe(variant_array_get_data(_arr),         \
-            _p, _n, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p;
-#define foreach_in_variant_array_reverse(_arr, _p)                       \
-    array_list_for_each_entry_reverse(variant_array_get_data(_arr),      \
-            _p, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p, *_n;
-#define foreach_in_variant_array_reverse_safe(_arr, _p, _n)              \
-    array_list_for_each_entry_reverse_safe(variant_array_get_data(_arr), \
-            _p, _n, node)
+    ((variant_arr_t)_arr->sz_ptr[1])
 
 #define foreach_value_in_variant_array(_arr, _val, _idx)              \
     do {                                                              \
-        struct arr_node *_p;                                          \
-        foreach_in_variant_array(_arr, _p) {                          \
-            _val = _p->val;                                           \
-            _idx = _p->node.idx;                                      \
+        variant_arr_t _data = variant_array_get_data(_arr);           \
+        size_t _i;                                                    \
+        for (_i = 0; _i < _data->nr; _i++) {                          \
+            _val = _data->vals[_i];                                   \
+            _idx = _i;                                                \
      /* } */                                                          \
  /* } while (0) */
 
-#define foreach_value_in_variant_array_safe(_arr, _val, _idx)      \
-    do {                                                           \
-        struct arr_node *_p, *_n;                                  \
-        foreach_in_variant_array_safe(_arr, _p, _n) {              \
-            _val = _p->val;                                        \
-            _idx = _p->node.idx;                                   \
-     /* } */                                                       \
+/* It is safe to remove the current member in the loop */
+#define foreach_value_in_variant_array_safe(_arr, _val, _idx)         \
+    do {                                                              \
+        variant_arr_t _data = variant_array_get_data(_arr);           \
+        size_t _i, _nr;                                               \
+        for (_i = 0, _nr = _data->nr;                                 \
+                _i < _data->nr;                                       \
+                _i += (_data->nr < _nr) ? 0 : 1, _nr = _data->nr) {   \
+            _val = _data->vals[_i];                                   \
+            _idx = _i;                                                \
+     /* } */                                                          \
  /* } while (0) */
 
 #define foreach_value_in_variant_array_reverse(_arr, _val, _idx)      \
     do {                                                              \
-        struct arr_node *_p;                                          \
-        foreach_in_variant_array_reverse(_arr, _p) {                  \
-            _val = _p->val;                                           \
-            _idx = _p->node.idx;                                      \
+        variant_arr_t _data = variant_array_get_data(_arr);           \
+        size_t _i;                                                    \
+        for (_i = _data->nr; _i-- > 0;) {                             \
+            _val = _data->vals[_i];                                   \
+            _idx = _i;                                                \
      /* } */                                                          \
  /* } while (0) */
 
-#define foreach_value_in_variant_array_reverse_safe(_arr, _val, _idx)   \
-    do {                                                                \
-        struct arr_node *_p, *_n;                                       \
-        foreach_in_variant_array_reverse_safe(_arr, _p, _n) {           \
-            _val = _p->val;                                             \
-            _idx = _p->node.idx;                                        \
-     /* } */                                                            \
+/* It is safe to remove the current member in the loop */
+#define foreach_value_in_variant_array_reverse_safe(_arr, _val, _idx) \
+    do {                                                              \
+        variant_arr_t _data = variant_array_get_data(_arr);           \
+        size_t _i;                                                    \
+        for (_i = _data->nr; _i-- > 0;) {                             \
+            if (_i >= _data->nr) {                                    \
+                if (_data->nr == 0)                                   \
+                    break;                                            \
+                _i = _data->nr - 1;                                   \
+            }                                                         \
+            _val = _data->vals[_i];                                   \
+            _idx = _i;                                                \
+     /* } */                                                          \
  /* } while (0) */
 
 #define foreach_value_in_variant_object(_obj, _val)                 \
@@ -66,12 +66,22 @@ enum pcvcm_node_type {
 #define PCVCM_EV_PROPERTY_VCM_EV          "vcm_ev"
 #define PCVCM_EV_PROPERTY_LAST_VALUE      "last_value"
 
+/* set it to 1 to evaluate the trees by the tree walker instead of the
+   bytecode; read when an instance is initialized */
+#define PURC_ENVV_VCM_TREE_WALKER         "PURC_VCM_TREE_WALKER"
+
+struct pcvcm_program;
+
 struct pcvcm_node {
     struct pctree_node tree_node;
     enum pcvcm_node_type type;
     uint32_t extra;
     uintptr_t attach;
+    /* the bytecode compiled from the tree rooted at this node, if any */
+    struct pcvcm_program *program;
     bool is_closed;
+    /* the times evaluated as the root before being compiled */
+    uint8_t nr_evals;
     union {
         bool        b;
         double      d;
@@ -198,6 +208,11 @@ purc_variant_t pcvcm_eval(struct pcvcm_node *tree, struct pcintr_stack *stack,
 purc_variant_t
 pcvcm_to_expression_variable(struct pcvcm_node *vcm, bool release_vcm);
 
+/* Releases the constants of the programs prebuilt in the instance; called
+   before the variant heap of the instance is cleaned up. */
+struct pcinst;
+void pcvcm_release_consts(struct pcinst *inst);
+
 #define PRINT_VCM_NODE(_node) do {                                        \
     size_t len;                                                           \
     char *s = pcvcm_node_to_string(_node, &len);                          \
@@ -321,6 +321,32 @@ pcvdom_tokenwised_eval_attr(enum pchvml_attr_operator op,
 #define PRINT_VDOM_NODE(_node)      \
     pcvdom_util_node_serialize(_node, pcvdom_util_fprintf, NULL)
 
+/* the version of the binary format of a compiled document */
+#define PCVDOM_BIN_VERSION          1
+#define PCVDOM_BIN_DIGEST_SIZE      16
+
+/*
+ * Writes the document and the vcm trees in it to `out` in the binary format.
+ * `digest` (nullable) identifies the source of the document; it is recorded
+ * in the header and checked when loading.
+ *
+ * Returns 0 on success, -1 if the document can not be serialized or on
+ * write failure.
+ */
+int
+pcvdom_document_dump_bin(struct pcvdom_document *doc,
+        const unsigned char *digest, purc_rwstream_t out);
+
+/*
+ * Rebuilds a document from the buffer filled by pcvdom_document_dump_bin()
+ * without tokenizing. The buffer is not referenced after returning, so it
+ * can be a mapped file. Returns NULL if the buffer is corrupted, or it was
+ * produced by another version of PurC or for another digest.
+ */
+struct pcvdom_document*
+pcvdom_document_load_bin(const void *buf, size_t len,
+        const unsigned char *digest);
+
 PCA_EXTERN_C_END
 
 #endif  /* PURC_PRIVATE_VDOM_H */
@@ -543,6 +543,49 @@ PCA_EXPORT pcdoc_data_node_t
 pcdoc_element_get_child_data_node(purc_document_t doc, pcdoc_element_t elem,
         size_t idx);
 
+/**
+ * Get the first child node of an element.
+ *
+ * @param doc: the document.
+ * @param elem: the element.
+ * @param type: the type of the child node wanted;
+ *      @PCDOC_NODE_VOID for a node of any type.
+ *
+ * Use this function and pcdoc_node_next_sibling() to iterate over
+ * the children instead of getting the children by index, e.g.:
+ *
+ *  pcdoc_node node = pcdoc_element_first_child(doc, elem, PCDOC_NODE_ELEMENT);
+ *  while (node.type != PCDOC_NODE_VOID) {
+ *      ...
+ *      node = pcdoc_node_next_sibling(doc, node, PCDOC_NODE_ELEMENT);
+ *  }
+ *
+ * Returns: the first child node of the type; the node with the type
+ * @PCDOC_NODE_VOID if there is no such one.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT pcdoc_node
+pcdoc_element_first_child(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_node_type type);
+
+/**
+ * Get the next sibling node of a document node.
+ *
+ * @param doc: the document.
+ * @param node: the node.
+ * @param type: the type of the sibling node wanted;
+ *      @PCDOC_NODE_VOID for a node of any type.
+ *
+ * Returns: the next sibling node of the type; the node with the type
+ * @PCDOC_NODE_VOID if there is no such one.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT pcdoc_node
+pcdoc_node_next_sibling(purc_document_t doc, pcdoc_node node,
+        pcdoc_node_type type);
+
 /**
  * Get the parent element of a document node.
  *
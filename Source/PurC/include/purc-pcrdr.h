@@ -181,6 +181,12 @@ enum {
 /* the maximal size of a payload which will be held in memory (40KiB) */
 #define PCRDR_MAX_INMEM_PAYLOAD_SIZE    40960
 
+/* the name of the renderer capability for the binary message encoding */
+#define PCRDR_CAP_BINARY_MESSAGE        "binaryMessage"
+
+/* the version of the binary message encoding */
+#define PCRDR_BIN_MESSAGE_VERSION       1
+
 /* the maximal time to ping client (60 seconds) */
 #define PCRDR_MAX_PING_TIME             60
 
@@ -886,6 +892,42 @@ PCA_EXPORT size_t
 pcrdr_serialize_message_to_buffer(const pcrdr_msg *msg,
         void *buff, size_t sz);
 
+/**
+ * Parse a packet in the binary encoding and make a corresponding message.
+ *
+ * @param packet: the pointer to the packet buffer.
+ * @param sz_packet: the size of the packet.
+ * @param msg: The pointer to a pointer to return the parsed message structure.
+ *
+ * The binary encoding has a fixed-layout header carrying the numeric
+ * fields and the identifier of a well-known operation, followed by
+ * the length-prefixed string fields, and the data. The JSON data is
+ * encoded as a tree of tagged binary values. All numbers are in the
+ * native byte order, because the binary encoding is only used on
+ * local connections.
+ *
+ * Returns: -1 for error; zero means everything is ok.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT int
+pcrdr_parse_packet_bin(const void *packet, size_t sz_packet, pcrdr_msg **msg);
+
+/**
+ * Serialize a message in the binary encoding.
+ *
+ * @param msg: the pointer to the message to serialize.
+ * @param fn: the callback to write bytes.
+ * @param ctxt: the context will be passed to fn.
+ *
+ * Returns: -1 for error; zero means everything is ok.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT int
+pcrdr_serialize_message_bin(const pcrdr_msg *msg, pcrdr_cb_write fn,
+        void *ctxt);
+
 /**
  * Compare two messages.
  *
@@ -1208,6 +1250,23 @@ PCA_EXPORT int
 pcrdr_purcmc_send_text_packet(pcrdr_conn* conn,
         const char *text, size_t txt_len);
 
+/**
+ * Send a binary packet to the PurCMC server.
+ *
+ * @param conn: the pointer to the renderer connection.
+ * @param data: the pointer to the data to send.
+ * @param data_len: the length to send.
+ *
+ * Sends a binary packet to the PurCMC server.
+ *
+ * Returns: -1 for error; zero means everything is ok.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT int
+pcrdr_purcmc_send_bin_packet(pcrdr_conn* conn,
+        const void *data, size_t data_len);
+
 /**@}*/
 
 /**
@@ -1266,8 +1325,10 @@ purc_inst_destroy_move_buffer(void);
  *  0 on error.
  *
  * Note that the owner of the original message will change and the variants
- * in the message will be moved as well. Hence, the subsequent call to
- * `pcrdr_release_message()` in the current thread will do nothing.
+ * in the message will be moved as well. Hence, the message must not be
+ * touched after it is moved, not even by `pcrdr_release_message()`: the
+ * instance taking it may have released it already. Release the message
+ * only if this function fails.
  *
  * Since: 0.1.0
  */
@@ -1319,6 +1380,25 @@ purc_inst_retrieve_message(size_t index);
 PCA_EXPORT pcrdr_msg *
 purc_inst_take_away_message(size_t index);
 
+/**
+ * Take a message away from the move buffer of the current instance,
+ * waiting for the message to arrive if the buffer does not hold it yet.
+ *
+ * @param index: the position of the message to take.
+ * @param timeout_ms: the max time to wait in milliseconds; a negative value
+ *  means to wait until the message arrives.
+ *
+ * Returns: the pointer to the message; @NULL on timeout
+ *  (%PURC_ERROR_TIMEOUT) or error.
+ *
+ * The function returns as soon as the message is moved to the buffer
+ * by another instance, without polling the buffer.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT pcrdr_msg *
+purc_inst_take_away_message_timed(size_t index, int timeout_ms);
+
 
 /**@}*/
 
@@ -1606,6 +1606,82 @@ purc_variant_load_from_json_file(const char* file);
 PCA_EXPORT purc_variant_t
 purc_variant_load_from_json_stream(purc_rwstream_t stream);
 
+typedef struct purc_json_reader purc_json_reader;
+typedef struct purc_json_reader* purc_json_reader_t;
+
+/* Reads the top-level values one by one, e.g., the records of NDJSON. */
+#define PCVRNT_JSON_READER_FLAG_NONE        0x0000
+/* Reads the elements of the top-level arrays one by one. */
+#define PCVRNT_JSON_READER_FLAG_ELEMENTS    0x0001
+
+/**
+ * Creates a reader to load the variants from a JSON stream incrementally.
+ *
+ * @param flags: the flags of the reader, PCVRNT_JSON_READER_FLAG_NONE to
+ *  read the top-level values (separated by white spaces, e.g., the lines
+ *  of NDJSON) one by one, or PCVRNT_JSON_READER_FLAG_ELEMENTS to read
+ *  the elements of the top-level arrays one by one.
+ *
+ * The reader only keeps the bytes of the record being read, so a stream
+ * of any size can be read in the memory bounded by the largest record.
+ *
+ * Returns: The new reader, or %NULL on failure.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT purc_json_reader_t
+purc_json_reader_new(unsigned int flags);
+
+/**
+ * Reads the next record from a stream.
+ *
+ * @param reader: the JSON reader.
+ * @param stream: the stream to read; a reader shall always read the same
+ *  stream, and the stream shall not be read by others meanwhile, because
+ *  the reader keeps the bytes read ahead.
+ *
+ * A record incomplete when the stream has no data now, e.g., a non-blocking
+ * pipe or socket, is kept in the reader, and the next call resumes it.
+ *
+ * Returns: The variant of the next record, or PURC_VARIANT_INVALID
+ *  with the error set: %PURC_ERROR_NOT_READY if a record is incomplete but
+ *  the stream has no data now, %PURC_ERROR_NO_DATA if the stream reaches
+ *  the end, or the error of the parser if a record is malformed. A malformed
+ *  record is skipped, so the next call reads the record after it.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT purc_variant_t
+purc_json_reader_read(purc_json_reader_t reader, purc_rwstream_t stream);
+
+/**
+ * Changes the flags of a JSON reader, keeping the bytes read ahead.
+ *
+ * @param reader: the JSON reader.
+ * @param flags: the new flags of the reader; see purc_json_reader_new().
+ *
+ * The flags can only be changed between the top-level values: not when
+ * a record is incomplete, nor before the end of a top-level array whose
+ * elements are being read one by one.
+ *
+ * Returns: %true on success, or %false with the error set to
+ *  %PURC_ERROR_WRONG_STAGE if the reader is in the middle of a value.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT bool
+purc_json_reader_set_flags(purc_json_reader_t reader, unsigned int flags);
+
+/**
+ * Destroys a JSON reader.
+ *
+ * @param reader: the JSON reader.
+ *
+ * Since: 0.8.0
+ */
+PCA_EXPORT void
+purc_json_reader_delete(purc_json_reader_t reader);
+
 /**
  * Trys to cast a variant value to a 32-bit integer.
  *
@@ -96,6 +96,26 @@ typedef struct purc_instance_extra_info {
      */
     const char      *workspace_layout;
 
+    /**
+     * The max number of steps a ready coroutine executes in a row before
+     * the scheduler switches to the next ready one; 1 for switching after
+     * every step. Zero for the value of the environment variable
+     * `PURC_SCHED_QUANTUM_STEPS` or the default (64).
+     *
+     * Since 0.8.0
+     */
+    unsigned int    sched_quantum_steps;
+
+    /**
+     * The max time in microseconds a ready coroutine executes in a row;
+     * the steps are not interrupted, so the quantum can be exceeded by
+     * the last step. Zero for the value of the environment variable
+     * `PURC_SCHED_QUANTUM_USEC` or the default (1000).
+     *
+     * Since 0.8.0
+     */
+    unsigned int    sched_quantum_usec;
+
 } purc_instance_extra_info;
 
 PCA_EXTERN_C_BEGIN
@@ -265,8 +285,8 @@ typedef void (*cb_free_local_data) (void *key, void *local_data);
  *
  *  - `format-double`: This local data contains the format (should be a
  *     pointer to a static string) which will be used to serilize a variant
- *     of double (number) type. If not defined, use the default format
- *     (`%.17g`).
+ *     of double (number) type. If not defined, use the shortest form which
+ *     reads back to the same double, in the layout of `%.17g`.
  *  - `format-long-double`: This local data contains the format (should be
  *     a pointer to a static string), which will be used to serilize a
  *     variant of long double type. If not defined, use the default format
@@ -357,6 +357,10 @@ static int init_modules(struct pcinst *curr_inst,
         curr_inst->enable_remote_fetcher      =  1;
     }
 
+    const char *env_value = getenv(PURC_ENVV_VCM_TREE_WALKER);
+    curr_inst->vcm_tree_walker = ((env_value != NULL) &&
+            (*env_value == '1' || pcutils_strcasecmp(env_value, "true") == 0));
+
     // call mdule initializers
     for (size_t i = 0; i < PCA_TABLESIZE(_pc_modules); ++i) {
         struct pcmodule *m = _pc_modules[i];
@@ -25,15 +25,29 @@
 #include "keywords.h"
 #include "private/debug.h"
 
+#include <string.h>
+
 struct pchvml_keyword_cfg {
     purc_atom_t                 atom;
     const char                 *keyword;
 };
 
+/* the range of the keywords of a bucket in the configs array, which are
+   sorted by the keyword */
+struct pchvml_keyword_range {
+    size_t                      start;
+    size_t                      end;
+};
+
+static struct pchvml_keyword_range ranges[PURC_ATOM_BUCKETS_NR];
+
 static void
 keywords_bucket_init(struct pchvml_keyword_cfg *cfgs,
         size_t start, size_t end, enum pcatom_bucket bucket)
 {
+    ranges[bucket].start = start;
+    ranges[bucket].end = end;
+
     struct pchvml_keyword_cfg *cfg = cfgs + start;
     for (size_t i=start; i<end; ++i) {
         cfg->atom = purc_atom_from_string_ex(bucket, cfg->keyword);
@@ -60,3 +74,24 @@ purc_atom_t pchvml_keyword_try_string(enum pcatom_bucket bucket,
     return purc_atom_try_string_ex(bucket, keyword);
 }
 
+int pchvml_keyword_enum_of(enum pcatom_bucket bucket, const char *keyword)
+{
+    if (bucket < 0 || bucket >= PURC_ATOM_BUCKETS_NR)
+        return -1;
+
+    size_t low = ranges[bucket].start;
+    size_t high = ranges[bucket].end;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int cmp = strcmp(keyword, keywords[mid].keyword);
+        if (cmp == 0)
+            return (int)mid;
+        else if (cmp < 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    return -1;
+}
+
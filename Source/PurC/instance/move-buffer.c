@@ -27,6 +27,7 @@
 
 #include "purc-pcrdr.h"
 #include "purc-errors.h"
+#include "purc-helpers.h"
 
 /* this feature needs C11 (stdatomic.h) or above */
 #if HAVE(STDATOMIC_H)
@@ -40,6 +41,15 @@
 
 #include <stdatomic.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE(SYS_EVENTFD_H)
+    #include <sys/eventfd.h>
+#endif
 
 #if HAVE(GLIB)
     #include <gmodule.h>
@@ -56,6 +66,11 @@ struct pcinst_move_buffer {
     unsigned int        flags;
     size_t              max_nr_msgs;
     size_t              nr_msgs;
+
+    /* signalled when a message is moved into this buffer;
+       the two are the same when eventfd is available. */
+    int                 fd_event_read;
+    int                 fd_event_write;
 };
 
 /* the header of the struct pcrdr_msg */
@@ -117,6 +132,103 @@ fail_lock:
     return -1;
 }
 
+static int
+mb_create_event_fds(struct pcinst_move_buffer *mb)
+{
+#if HAVE(SYS_EVENTFD_H)
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    mb->fd_event_read = mb->fd_event_write = fd;
+#else
+    int fds[2];
+    if (pipe(fds))
+        return -1;
+
+    for (int i = 0; i < 2; i++) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL, 0) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    mb->fd_event_read = fds[0];
+    mb->fd_event_write = fds[1];
+#endif
+    return 0;
+}
+
+static void
+mb_destroy_event_fds(struct pcinst_move_buffer *mb)
+{
+    if (mb->fd_event_read >= 0)
+        close(mb->fd_event_read);
+    if (mb->fd_event_write >= 0 && mb->fd_event_write != mb->fd_event_read)
+        close(mb->fd_event_write);
+
+    mb->fd_event_read = mb->fd_event_write = -1;
+}
+
+/* wake up the owner of the move buffer which may be waiting for messages */
+static void
+mb_signal_event(struct pcinst_move_buffer *mb)
+{
+    if (mb->fd_event_write >= 0) {
+        uint64_t one = 1;
+        ssize_t n;
+        do {
+            n = write(mb->fd_event_write, &one,
+                    (mb->fd_event_write == mb->fd_event_read) ?
+                    sizeof(one) : 1);
+        } while (n < 0 && errno == EINTR);
+        /* EAGAIN means the event is signalled already */
+    }
+}
+
+static void
+mb_clear_event(int fd)
+{
+    uint64_t buf[8];
+    ssize_t n;
+    do {
+        n = read(fd, buf, sizeof(buf));
+    } while (n > 0 || (n < 0 && errno == EINTR));
+}
+
+/* Waits until the buffer owned by the current instance holds more than
+   @index messages. Returns the number of the messages; 0 on timeout. */
+static size_t
+mb_wait_for_messages(struct pcinst_move_buffer *mb, size_t index,
+        int timeout_ms)
+{
+    struct timespec ts_start;
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    for (;;) {
+        purc_rwlock_reader_lock(&mb->lock);
+        size_t nr = mb->nr_msgs;
+        purc_rwlock_reader_unlock(&mb->lock);
+
+        if (nr > index)
+            return nr;
+
+        int left_ms = -1;
+        if (timeout_ms >= 0) {
+            left_ms = timeout_ms -
+                (int)(purc_get_elapsed_seconds(&ts_start, NULL) * 1000);
+            if (left_ms <= 0)
+                return 0;
+        }
+
+        /* a message moved after the check above has signalled the event */
+        struct pollfd pfd = { mb->fd_event_read, POLLIN, 0 };
+        int r = poll(&pfd, 1, left_ms);
+        if (r > 0)
+            mb_clear_event(mb->fd_event_read);
+        else if (r < 0 && errno != EINTR)
+            return 0;
+    }
+}
+
 pcrdr_msg *
 pcinst_get_message(void)
 {
@@ -203,12 +315,18 @@ purc_inst_create_move_buffer(unsigned int flags, size_t max_msgs)
         goto done;
     }
 
+    mb->fd_event_read = mb->fd_event_write = -1;
     purc_rwlock_init(&mb->lock);
     if (mb->lock.native_impl == NULL) {
         errcode = PURC_ERROR_BAD_SYSTEM_CALL;
         goto done;
     }
 
+    if (mb_create_event_fds(mb)) {
+        errcode = PURC_ERROR_BAD_SYSTEM_CALL;
+        goto done;
+    }
+
     if (pcutils_sorted_array_add(mb_atom2buff_map,
                 (void *)(uintptr_t)atom, mb) < 0) {
         errcode = PURC_ERROR_OUT_OF_MEMORY;
@@ -229,6 +347,7 @@ done:
                 purc_rwlock_clear(&mb->lock);
             }
 
+            mb_destroy_event_fds(mb);
             free(mb);
         }
 
@@ -310,6 +429,7 @@ purc_inst_destroy_move_buffer(void)
 
     pcutils_sorted_array_remove(mb_atom2buff_map, (void *)(uintptr_t)atom);
     purc_rwlock_clear(&mb->lock);
+    mb_destroy_event_fds(mb);
     free(mb);
 
 done:
@@ -397,6 +517,7 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
         mb->nr_msgs++;
         purc_rwlock_writer_unlock(&mb->lock);
 
+        mb_signal_event(mb);
         nr++;
     }
     else {
@@ -434,6 +555,8 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
                 list_add_tail(&hdr->ln, &mb->msgs);
                 mb->nr_msgs++;
                 purc_rwlock_writer_unlock(&mb->lock);
+
+                mb_signal_event(mb);
                 nr++;
             }
         }
@@ -487,6 +610,53 @@ done:
     return errcode;
 }
 
+int
+pcinst_move_buffer_event_fd(bool clear)
+{
+    struct pcinst* inst = pcinst_current();
+    if (inst == NULL)
+        return -1;
+
+    int fd = -1;
+    struct pcinst_move_buffer *mb;
+
+    purc_rwlock_reader_lock(&mb_lock);
+    if (pcutils_sorted_array_find(mb_atom2buff_map,
+                (void *)(uintptr_t)inst->endpoint_atom, (void **)&mb)) {
+        fd = mb->fd_event_read;
+        if (clear && fd >= 0)
+            mb_clear_event(fd);
+    }
+    purc_rwlock_reader_unlock(&mb_lock);
+
+    return fd;
+}
+
+ssize_t
+pcinst_wait_for_moved_messages(int timeout_ms)
+{
+    struct pcinst* inst = pcinst_current();
+    if (inst == NULL) {
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+        return -1;
+    }
+
+    struct pcinst_move_buffer *mb = NULL;
+
+    /* the buffer can only be destroyed by the current instance itself */
+    purc_rwlock_reader_lock(&mb_lock);
+    pcutils_sorted_array_find(mb_atom2buff_map,
+            (void *)(uintptr_t)inst->endpoint_atom, (void **)&mb);
+    purc_rwlock_reader_unlock(&mb_lock);
+
+    if (mb == NULL) {
+        purc_set_error(PURC_ERROR_NOT_EXISTS);
+        return -1;
+    }
+
+    return (ssize_t)mb_wait_for_messages(mb, 0, timeout_ms);
+}
+
 const pcrdr_msg *
 purc_inst_retrieve_message(size_t index)
 {
@@ -592,6 +762,35 @@ done:
     return msg;
 }
 
+pcrdr_msg *
+purc_inst_take_away_message_timed(size_t index, int timeout_ms)
+{
+    struct pcinst* inst = pcinst_current();
+    if (inst == NULL) {
+        purc_set_error(PURC_ERROR_NO_INSTANCE);
+        return NULL;
+    }
+
+    struct pcinst_move_buffer *mb = NULL;
+
+    purc_rwlock_reader_lock(&mb_lock);
+    pcutils_sorted_array_find(mb_atom2buff_map,
+            (void *)(uintptr_t)inst->endpoint_atom, (void **)&mb);
+    purc_rwlock_reader_unlock(&mb_lock);
+
+    if (mb == NULL) {
+        purc_set_error(PURC_ERROR_NOT_EXISTS);
+        return NULL;
+    }
+
+    if (mb_wait_for_messages(mb, index, timeout_ms) == 0) {
+        purc_set_error(PURC_ERROR_TIMEOUT);
+        return NULL;
+    }
+
+    return purc_inst_take_away_message(index);
+}
+
 #else   /* HAVE(STDATOMIC_H) */
 
 #if HAVE(GLIB)
@@ -655,6 +854,21 @@ purc_inst_holding_messages_count(size_t *nr)
     return PURC_ERROR_NOT_SUPPORTED;
 }
 
+int
+pcinst_move_buffer_event_fd(bool clear)
+{
+    UNUSED_PARAM(clear);
+    return -1;
+}
+
+ssize_t
+pcinst_wait_for_moved_messages(int timeout_ms)
+{
+    UNUSED_PARAM(timeout_ms);
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+}
+
 const pcrdr_msg *
 purc_inst_retrieve_message(size_t index)
 {
@@ -671,6 +885,15 @@ purc_inst_take_away_message(size_t index)
     return NULL;
 }
 
+pcrdr_msg *
+purc_inst_take_away_message_timed(size_t index, int timeout_ms)
+{
+    UNUSED_PARAM(index);
+    UNUSED_PARAM(timeout_ms);
+    purc_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return NULL;
+}
+
 #endif  /* !HAVE(STDATOMIC_H) */
 
 struct pcmodule _module_mvbuf = {
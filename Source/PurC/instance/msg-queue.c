@@ -54,6 +54,8 @@ pcinst_msg_queue_create(void)
 
     queue->state = 0;
     queue->nr_msgs = 0;
+    queue->notify = NULL;
+    queue->notify_ctxt = NULL;
     list_head_init(&queue->req_msgs);
     list_head_init(&queue->res_msgs);
     list_head_init(&queue->event_msgs);
@@ -208,6 +210,9 @@ pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
     }
 
     purc_rwlock_writer_unlock(&queue->lock);
+
+    if (queue->notify)
+        queue->notify(queue->notify_ctxt);
     return 0;
 }
 
@@ -257,6 +262,9 @@ pcinst_msg_queue_prepend(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
     }
 
     purc_rwlock_writer_unlock(&queue->lock);
+
+    if (queue->notify)
+        queue->notify(queue->notify_ctxt);
     return 0;
 }
 
@@ -470,3 +478,12 @@ pcinst_msg_queue_count(struct pcinst_msg_queue *queue)
     return nr;
 }
 
+void
+pcinst_msg_queue_set_notifier(struct pcinst_msg_queue *queue,
+        pcinst_msg_queue_notify_fn notify, void *ctxt)
+{
+    purc_rwlock_writer_lock(&queue->lock);
+    queue->notify = notify;
+    queue->notify_ctxt = ctxt;
+    purc_rwlock_writer_unlock(&queue->lock);
+}
@@ -85,8 +85,12 @@ ctxt_destroy(void *ctxt)
 static int
 process_attr_name(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_archetype *ctxt;
     ctxt = (struct ctxt_for_archetype*)frame->ctxt;
     if (ctxt->name != PURC_VARIANT_INVALID) {
@@ -110,8 +114,12 @@ process_attr_name(struct pcintr_stack_frame *frame,
 static int
 process_attr_src(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_archetype *ctxt;
     ctxt = (struct ctxt_for_archetype*)frame->ctxt;
     if (ctxt->src != PURC_VARIANT_INVALID) {
@@ -140,8 +148,12 @@ process_attr_src(struct pcintr_stack_frame *frame,
 static int
 process_attr_param(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_archetype *ctxt;
     ctxt = (struct ctxt_for_archetype*)frame->ctxt;
     if (ctxt->param != PURC_VARIANT_INVALID) {
@@ -170,8 +182,12 @@ process_attr_param(struct pcintr_stack_frame *frame,
 static int
 process_attr_method(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_archetype *ctxt;
     ctxt = (struct ctxt_for_archetype*)frame->ctxt;
     if (ctxt->method != PURC_VARIANT_INVALID) {
@@ -200,8 +216,12 @@ process_attr_method(struct pcintr_stack_frame *frame,
 static int
 process_attr_raw(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     UNUSED_PARAM(frame);
     UNUSED_PARAM(element);
     UNUSED_PARAM(name);
@@ -209,6 +229,14 @@ process_attr_raw(struct pcintr_stack_frame *frame,
     return 0;
 }
 
+static const pcintr_attr_val_f attr_handlers[] = {
+    [PCHVML_KEYWORD_ENUM(HVML, NAME)]   = process_attr_name,
+    [PCHVML_KEYWORD_ENUM(HVML, SRC)]    = process_attr_src,
+    [PCHVML_KEYWORD_ENUM(HVML, PARAM)]  = process_attr_param,
+    [PCHVML_KEYWORD_ENUM(HVML, METHOD)] = process_attr_method,
+    [PCHVML_KEYWORD_ENUM(HVML, RAW)]    = process_attr_raw,
+};
+
 static int
 attr_found_val(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
@@ -216,28 +244,11 @@ attr_found_val(struct pcintr_stack_frame *frame,
         struct pcvdom_attr *attr,
         void *ud)
 {
-    UNUSED_PARAM(attr);
-    UNUSED_PARAM(ud);
-
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, NAME)) == name) {
-        return process_attr_name(frame, element, name, val);
-    }
-
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, SRC)) == name) {
-        return process_attr_src(frame, element, name, val);
-    }
-
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, PARAM)) == name) {
-        return process_attr_param(frame, element, name, val);
-    }
-
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, METHOD)) == name) {
-        return process_attr_method(frame, element, name, val);
-    }
-
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, RAW)) == name) {
-        return process_attr_raw(frame, element, name, val);
-    }
+    pcintr_attr_val_f handler;
+    handler = pcintr_attr_handler(attr_handlers,
+            PCA_TABLESIZE(attr_handlers), attr);
+    if (handler)
+        return handler(frame, element, name, val, attr, ud);
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "vdom attribute '%s' for element <%s>",
@@ -88,8 +88,12 @@ after_pushed(pcintr_stack_t stack, pcvdom_element_t pos)
 
     if (parent) {
         for (int i = 0; i < PURC_SYMBOL_VAR_MAX; i++) {
-            purc_variant_t v = pcintr_get_symbol_var(parent, i);
-            pcintr_set_symbol_var(frame, i, v);
+            // share the same `$!` with the parent
+            purc_variant_t v = (i == PURC_SYMBOL_VAR_EXCLAMATION) ?
+                pcintr_get_exclamation_var(parent) :
+                pcintr_get_symbol_var(parent, i);
+            if (v != PURC_VARIANT_INVALID)
+                pcintr_set_symbol_var(frame, i, v);
         }
     }
 
@@ -258,6 +258,12 @@ on_child_finished(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
         return -1;
 
     PC_ASSERT(ctxt->type != PURC_VARIANT_INVALID);
+    if (frame->error_templates == PURC_VARIANT_INVALID) {
+        frame->error_templates = purc_variant_make_object_0();
+        if (frame->error_templates == PURC_VARIANT_INVALID)
+            return -1;
+    }
+
     int r;
     r = pcintr_bind_template(frame->error_templates,
             ctxt->type, ctxt->contents);
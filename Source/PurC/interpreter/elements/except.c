@@ -267,6 +267,12 @@ on_child_finished(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
     parent_frame = pcintr_stack_frame_get_parent(frame);
 
     PC_ASSERT(ctxt->type != PURC_VARIANT_INVALID);
+    if (parent_frame->except_templates == PURC_VARIANT_INVALID) {
+        parent_frame->except_templates = purc_variant_make_object_0();
+        if (parent_frame->except_templates == PURC_VARIANT_INVALID)
+            return -1;
+    }
+
     int r;
     r = pcintr_bind_template(parent_frame->except_templates,
             ctxt->type, ctxt->contents);
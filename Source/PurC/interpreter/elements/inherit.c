@@ -71,8 +71,12 @@ after_pushed(pcintr_stack_t stack, pcvdom_element_t pos)
     parent_frame = pcintr_stack_frame_get_parent(frame);
     if (parent_frame) {
         for (int i = 0; i < PURC_SYMBOL_VAR_MAX; i++) {
-            purc_variant_t v = pcintr_get_symbol_var(parent_frame, i);
-            pcintr_set_symbol_var(frame, i, v);
+            // share the same `$!` with the parent
+            purc_variant_t v = (i == PURC_SYMBOL_VAR_EXCLAMATION) ?
+                pcintr_get_exclamation_var(parent_frame) :
+                pcintr_get_symbol_var(parent_frame, i);
+            if (v != PURC_VARIANT_INVALID)
+                pcintr_set_symbol_var(frame, i, v);
         }
     }
 
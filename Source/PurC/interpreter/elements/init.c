@@ -555,8 +555,12 @@ post_process(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
 static int
 process_attr_as(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_init *ctxt;
     ctxt = (struct ctxt_for_init*)frame->ctxt;
     if (ctxt->as != PURC_VARIANT_INVALID) {
@@ -580,8 +584,12 @@ process_attr_as(struct pcintr_stack_frame *frame,
 static int
 process_attr_at(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_init *ctxt;
     ctxt = (struct ctxt_for_init*)frame->ctxt;
     if (ctxt->at != PURC_VARIANT_INVALID) {
@@ -605,8 +613,12 @@ process_attr_at(struct pcintr_stack_frame *frame,
 static int
 process_attr_from(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_init *ctxt;
     ctxt = (struct ctxt_for_init*)frame->ctxt;
     if (ctxt->from != PURC_VARIANT_INVALID) {
@@ -644,8 +656,12 @@ process_attr_from(struct pcintr_stack_frame *frame,
 static int
 process_attr_for(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_init *ctxt;
     ctxt = (struct ctxt_for_init*)frame->ctxt;
     if (ctxt->v_for != PURC_VARIANT_INVALID) {
@@ -674,8 +690,12 @@ process_attr_for(struct pcintr_stack_frame *frame,
 static int
 process_attr_with(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_init *ctxt;
     ctxt = (struct ctxt_for_init*)frame->ctxt;
     if (ctxt->with != PURC_VARIANT_INVALID) {
@@ -699,8 +719,12 @@ process_attr_with(struct pcintr_stack_frame *frame,
 static int
 process_attr_against(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_init *ctxt;
     ctxt = (struct ctxt_for_init*)frame->ctxt;
     if (ctxt->against != PURC_VARIANT_INVALID) {
@@ -729,8 +753,12 @@ process_attr_against(struct pcintr_stack_frame *frame,
 static int
 process_attr_via(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_init *ctxt;
     ctxt = (struct ctxt_for_init*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -770,83 +798,167 @@ process_attr_via(struct pcintr_stack_frame *frame,
 }
 
 static int
-attr_found_val(struct pcintr_stack_frame *frame,
+process_attr_uniquely(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
         purc_atom_t name, purc_variant_t val,
-        struct pcvdom_attr *attr,
-        void *ud)
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
     UNUSED_PARAM(ud);
 
-    PC_ASSERT(name);
-    PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
+    struct ctxt_for_init *ctxt;
+    ctxt = (struct ctxt_for_init*)frame->ctxt;
+
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->uniquely = 1;
+    return 0;
+}
+
+static int
+process_attr_casesensitively(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
 
     struct ctxt_for_init *ctxt;
     ctxt = (struct ctxt_for_init*)frame->ctxt;
 
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AS)) == name) {
-        return process_attr_as(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AT)) == name) {
-        return process_attr_at(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, UNIQUELY)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->uniquely = 1;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, CASESENSITIVELY)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->casesensitively= 1;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, CASEINSENSITIVELY)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->casesensitively= 0;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, FROM)) == name) {
-        return process_attr_from(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WITH)) == name) {
-        return process_attr_with(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AGAINST)) == name) {
-        return process_attr_against(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, VIA)) == name) {
-        return process_attr_via(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, FOR)) == name) {
-        return process_attr_for(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, TEMPORARILY)) == name ||
-            pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, TEMP)) == name)
-    {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->temporarily = 1;
-        if (ctxt->async) {
-            purc_log_warn("'asynchronously' is ignored because of 'temporarily'");
-            ctxt->async = 0;
-        }
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ASYNCHRONOUSLY)) == name
-            || pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ASYNC)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->async = 1;
-        if (ctxt->temporarily) {
-            purc_log_warn("'asynchronously' is ignored because of 'temporarily'");
-            ctxt->async = 0;
-        }
-        return 0;
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->casesensitively= 1;
+    return 0;
+}
+
+static int
+process_attr_caseinsensitively(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_init *ctxt;
+    ctxt = (struct ctxt_for_init*)frame->ctxt;
+
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->casesensitively= 0;
+    return 0;
+}
+
+static int
+process_attr_temporarily(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_init *ctxt;
+    ctxt = (struct ctxt_for_init*)frame->ctxt;
+
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->temporarily = 1;
+    if (ctxt->async) {
+        purc_log_warn("'asynchronously' is ignored because of 'temporarily'");
+        ctxt->async = 0;
     }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, SYNCHRONOUSLY)) == name
-            || pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, SYNC)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
+    return 0;
+}
+
+static int
+process_attr_asynchronously(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_init *ctxt;
+    ctxt = (struct ctxt_for_init*)frame->ctxt;
+
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->async = 1;
+    if (ctxt->temporarily) {
+        purc_log_warn("'asynchronously' is ignored because of 'temporarily'");
         ctxt->async = 0;
-        return 0;
     }
+    return 0;
+}
+
+static int
+process_attr_synchronously(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_init *ctxt;
+    ctxt = (struct ctxt_for_init*)frame->ctxt;
+
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->async = 0;
+    return 0;
+}
+
+static const pcintr_attr_val_f attr_handlers[] = {
+    [PCHVML_KEYWORD_ENUM(HVML, AS)]                 = process_attr_as,
+    [PCHVML_KEYWORD_ENUM(HVML, AT)]                 = process_attr_at,
+    [PCHVML_KEYWORD_ENUM(HVML, UNIQUELY)]           = process_attr_uniquely,
+    [PCHVML_KEYWORD_ENUM(HVML, CASESENSITIVELY)]    =
+        process_attr_casesensitively,
+    [PCHVML_KEYWORD_ENUM(HVML, CASEINSENSITIVELY)]  =
+        process_attr_caseinsensitively,
+    [PCHVML_KEYWORD_ENUM(HVML, FROM)]               = process_attr_from,
+    [PCHVML_KEYWORD_ENUM(HVML, WITH)]               = process_attr_with,
+    [PCHVML_KEYWORD_ENUM(HVML, AGAINST)]            = process_attr_against,
+    [PCHVML_KEYWORD_ENUM(HVML, VIA)]                = process_attr_via,
+    [PCHVML_KEYWORD_ENUM(HVML, FOR)]                = process_attr_for,
+    [PCHVML_KEYWORD_ENUM(HVML, TEMPORARILY)]        = process_attr_temporarily,
+    [PCHVML_KEYWORD_ENUM(HVML, TEMP)]               = process_attr_temporarily,
+    [PCHVML_KEYWORD_ENUM(HVML, ASYNCHRONOUSLY)]     =
+        process_attr_asynchronously,
+    [PCHVML_KEYWORD_ENUM(HVML, ASYNC)]              =
+        process_attr_asynchronously,
+    [PCHVML_KEYWORD_ENUM(HVML, SYNCHRONOUSLY)]      =
+        process_attr_synchronously,
+    [PCHVML_KEYWORD_ENUM(HVML, SYNC)]               =
+        process_attr_synchronously,
+};
+
+static int
+attr_found_val(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr,
+        void *ud)
+{
+    PC_ASSERT(name);
+    PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
+
+    pcintr_attr_val_f handler;
+    handler = pcintr_attr_handler(attr_handlers,
+            PCA_TABLESIZE(attr_handlers), attr);
+    if (handler)
+        return handler(frame, element, name, val, attr, ud);
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "unknown vdom attribute '%s' for element <%s>",
@@ -447,8 +447,12 @@ post_process_by_rule(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
 static int
 process_attr_on(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val, pcintr_stack_t stack)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+
+    pcintr_stack_t stack = (pcintr_stack_t) ud;
     struct ctxt_for_iterate *ctxt;
     ctxt = (struct ctxt_for_iterate*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID ||
@@ -472,9 +476,12 @@ process_attr_on(struct pcintr_stack_frame *frame,
 static int
 process_attr_in(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val, pcintr_stack_t stack)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
-    UNUSED_PARAM(stack);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_iterate *ctxt;
     ctxt = (struct ctxt_for_iterate*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID ||
@@ -496,9 +503,11 @@ process_attr_in(struct pcintr_stack_frame *frame,
 static int
 process_attr_onlyif(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val, struct pcvdom_attr *attr)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
     UNUSED_PARAM(val);
+    UNUSED_PARAM(ud);
 
     struct ctxt_for_iterate *ctxt;
     ctxt = (struct ctxt_for_iterate*)frame->ctxt;
@@ -518,9 +527,11 @@ process_attr_onlyif(struct pcintr_stack_frame *frame,
 static int
 process_attr_while(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val, struct pcvdom_attr *attr)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
     UNUSED_PARAM(val);
+    UNUSED_PARAM(ud);
 
     struct ctxt_for_iterate *ctxt;
     ctxt = (struct ctxt_for_iterate*)frame->ctxt;
@@ -538,45 +549,82 @@ process_attr_while(struct pcintr_stack_frame *frame,
 }
 
 static int
-attr_found_val(struct pcintr_stack_frame *frame,
+process_attr_by(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
         purc_atom_t name, purc_variant_t val,
-        struct pcvdom_attr *attr,
-        void *ud)
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(val);
     UNUSED_PARAM(ud);
 
-    pcintr_stack_t stack = (pcintr_stack_t) ud;
     struct ctxt_for_iterate *ctxt;
     ctxt = (struct ctxt_for_iterate*)frame->ctxt;
+    ctxt->rule_attr = attr;
+    return 0;
+}
+
+static int
+process_attr_with(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(val);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_iterate *ctxt;
+    ctxt = (struct ctxt_for_iterate*)frame->ctxt;
+    ctxt->with_attr = attr;
+    return 0;
+}
 
+static int
+process_attr_nosetotail(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(val);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_iterate *ctxt;
+    ctxt = (struct ctxt_for_iterate*)frame->ctxt;
+    ctxt->nosetotail = 1;
+    return 0;
+}
+
+static const pcintr_attr_val_f attr_handlers[] = {
+    [PCHVML_KEYWORD_ENUM(HVML, ON)]         = process_attr_on,
+    [PCHVML_KEYWORD_ENUM(HVML, IN)]         = process_attr_in,
+    [PCHVML_KEYWORD_ENUM(HVML, BY)]         = process_attr_by,
+    [PCHVML_KEYWORD_ENUM(HVML, ONLYIF)]     = process_attr_onlyif,
+    [PCHVML_KEYWORD_ENUM(HVML, WHILE)]      = process_attr_while,
+    [PCHVML_KEYWORD_ENUM(HVML, WITH)]       = process_attr_with,
+    [PCHVML_KEYWORD_ENUM(HVML, NOSETOTAIL)] = process_attr_nosetotail,
+};
+
+static int
+attr_found_val(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr,
+        void *ud)
+{
     PC_ASSERT(name);
     PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
 
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ON)) == name) {
-        return process_attr_on(frame, element, name, val, stack);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, IN)) == name) {
-        return process_attr_in(frame, element, name, val, stack);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, BY)) == name) {
-        ctxt->rule_attr = attr;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ONLYIF)) == name) {
-        return process_attr_onlyif(frame, element, name, val, attr);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WHILE)) == name) {
-        return process_attr_while(frame, element, name, val, attr);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WITH)) == name) {
-        ctxt->with_attr = attr;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, NOSETOTAIL)) == name) {
-        ctxt->nosetotail = 1;
-        return 0;
-    }
+    pcintr_attr_val_f handler;
+    handler = pcintr_attr_handler(attr_handlers,
+            PCA_TABLESIZE(attr_handlers), attr);
+    if (handler)
+        return handler(frame, element, name, val, attr, ud);
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "vdom attribute '%s' for element <%s>",
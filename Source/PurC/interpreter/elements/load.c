@@ -195,8 +195,12 @@ post_process(pcintr_coroutine_t co, struct pcintr_stack_frame *frame)
 static int
 process_attr_on(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_load *ctxt;
     ctxt = (struct ctxt_for_load*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -214,8 +218,12 @@ process_attr_on(struct pcintr_stack_frame *frame,
 static int
 process_attr_from(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_load *ctxt;
     ctxt = (struct ctxt_for_load*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -233,8 +241,12 @@ process_attr_from(struct pcintr_stack_frame *frame,
 static int
 process_attr_with(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_load *ctxt;
     ctxt = (struct ctxt_for_load*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -252,8 +264,12 @@ process_attr_with(struct pcintr_stack_frame *frame,
 static int
 process_attr_within(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_load *ctxt;
     ctxt = (struct ctxt_for_load*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -297,8 +313,12 @@ process_attr_within(struct pcintr_stack_frame *frame,
 static int
 process_attr_via(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_load *ctxt;
     ctxt = (struct ctxt_for_load*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -323,8 +343,12 @@ process_attr_via(struct pcintr_stack_frame *frame,
 static int
 process_attr_as(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_load *ctxt;
     ctxt = (struct ctxt_for_load*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -350,8 +374,12 @@ process_attr_as(struct pcintr_stack_frame *frame,
 static int
 process_attr_at(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_load *ctxt;
     ctxt = (struct ctxt_for_load*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -377,8 +405,12 @@ process_attr_at(struct pcintr_stack_frame *frame,
 static int
 process_attr_onto(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_load *ctxt;
     ctxt = (struct ctxt_for_load*)frame->ctxt;
     if (val == PURC_VARIANT_INVALID) {
@@ -400,56 +432,74 @@ process_attr_onto(struct pcintr_stack_frame *frame,
     return 0;
 }
 
+static int
+process_attr_synchronously(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(val);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_load *ctxt;
+    ctxt = (struct ctxt_for_load*)frame->ctxt;
+
+    ctxt->synchronously = 1;
+    return 0;
+}
+
+static int
+process_attr_asynchronously(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(val);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_load *ctxt;
+    ctxt = (struct ctxt_for_load*)frame->ctxt;
+
+    ctxt->synchronously = 0;
+    return 0;
+}
+
+static const pcintr_attr_val_f attr_handlers[] = {
+    [PCHVML_KEYWORD_ENUM(HVML, ON)]             = process_attr_on,
+    [PCHVML_KEYWORD_ENUM(HVML, FROM)]           = process_attr_from,
+    [PCHVML_KEYWORD_ENUM(HVML, WITH)]           = process_attr_with,
+    [PCHVML_KEYWORD_ENUM(HVML, WITHIN)]         = process_attr_within,
+    [PCHVML_KEYWORD_ENUM(HVML, VIA)]            = process_attr_via,
+    [PCHVML_KEYWORD_ENUM(HVML, AS)]             = process_attr_as,
+    [PCHVML_KEYWORD_ENUM(HVML, AT)]             = process_attr_at,
+    [PCHVML_KEYWORD_ENUM(HVML, ONTO)]           = process_attr_onto,
+    [PCHVML_KEYWORD_ENUM(HVML, SYNCHRONOUSLY)]  = process_attr_synchronously,
+    [PCHVML_KEYWORD_ENUM(HVML, SYNC)]           = process_attr_synchronously,
+    [PCHVML_KEYWORD_ENUM(HVML, ASYNCHRONOUSLY)] = process_attr_asynchronously,
+    [PCHVML_KEYWORD_ENUM(HVML, ASYNC)]          = process_attr_asynchronously,
+};
+
 static int
 attr_found_val(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
         purc_atom_t name, purc_variant_t val,
         struct pcvdom_attr *attr,
-        struct ctxt_for_load *ctxt)
+        void *ud)
 {
     PC_ASSERT(name);
     PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
 
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ON)) == name) {
-        return process_attr_on(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, FROM)) == name) {
-        return process_attr_from(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WITH)) == name) {
-        return process_attr_with(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WITHIN)) == name) {
-        return process_attr_within(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, VIA)) == name) {
-        return process_attr_via(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AS)) == name) {
-        return process_attr_as(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AT)) == name) {
-        return process_attr_at(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ONTO)) == name) {
-        return process_attr_onto(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, SYNCHRONOUSLY)) == name) {
-        ctxt->synchronously = 1;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, SYNC)) == name) {
-        ctxt->synchronously = 1;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ASYNCHRONOUSLY)) == name) {
-        ctxt->synchronously = 0;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ASYNC)) == name) {
-        ctxt->synchronously = 0;
-        return 0;
-    }
+    pcintr_attr_val_f handler;
+    handler = pcintr_attr_handler(attr_handlers,
+            PCA_TABLESIZE(attr_handlers), attr);
+    if (handler)
+        return handler(frame, element, name, val, attr, ud);
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "vdom attribute '%s' for element <%s>",
@@ -465,20 +515,15 @@ attr_found(struct pcintr_stack_frame *frame,
         struct pcvdom_attr *attr,
         void *ud)
 {
-    UNUSED_PARAM(ud);
-
     PC_ASSERT(name);
     PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
 
-    struct ctxt_for_load *ctxt;
-    ctxt = (struct ctxt_for_load*)frame->ctxt;
-
     pcintr_stack_t stack = (pcintr_stack_t) ud;
     purc_variant_t val = pcintr_eval_vdom_attr(stack, attr);
     if (val == PURC_VARIANT_INVALID)
         return -1;
 
-    int r = attr_found_val(frame, element, name, val, attr, ctxt);
+    int r = attr_found_val(frame, element, name, val, attr, ud);
     purc_variant_unref(val);
 
     return r ? -1 : 0;
@@ -189,8 +189,12 @@ regist_variant_listener(pcintr_stack_t stack, purc_variant_t observed,
 static int
 process_attr_on(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_observe *ctxt;
     ctxt = (struct ctxt_for_observe*)frame->ctxt;
     if (ctxt->on != PURC_VARIANT_INVALID) {
@@ -214,8 +218,12 @@ process_attr_on(struct pcintr_stack_frame *frame,
 static int
 process_attr_at(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_observe *ctxt;
     ctxt = (struct ctxt_for_observe*)frame->ctxt;
     if (ctxt->at != PURC_VARIANT_INVALID) {
@@ -239,8 +247,12 @@ process_attr_at(struct pcintr_stack_frame *frame,
 static int
 process_attr_as(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_observe *ctxt;
     ctxt = (struct ctxt_for_observe*)frame->ctxt;
     if (ctxt->as != PURC_VARIANT_INVALID) {
@@ -264,8 +276,12 @@ process_attr_as(struct pcintr_stack_frame *frame,
 static int
 process_attr_with(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_observe *ctxt;
     ctxt = (struct ctxt_for_observe*)frame->ctxt;
     if (ctxt->with != PURC_VARIANT_INVALID) {
@@ -289,8 +305,12 @@ process_attr_with(struct pcintr_stack_frame *frame,
 static int
 process_attr_for(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_observe *ctxt;
     ctxt = (struct ctxt_for_observe*)frame->ctxt;
     if (ctxt->for_var != PURC_VARIANT_INVALID) {
@@ -340,8 +360,12 @@ process_attr_for(struct pcintr_stack_frame *frame,
 static int
 process_attr_against(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_observe *ctxt;
     ctxt = (struct ctxt_for_observe*)frame->ctxt;
     if (ctxt->against != PURC_VARIANT_INVALID) {
@@ -365,8 +389,12 @@ process_attr_against(struct pcintr_stack_frame *frame,
 static int
 process_attr_in(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_observe *ctxt;
     ctxt = (struct ctxt_for_observe*)frame->ctxt;
     if (ctxt->in != PURC_VARIANT_INVALID) {
@@ -387,6 +415,16 @@ process_attr_in(struct pcintr_stack_frame *frame,
     return 0;
 }
 
+static const pcintr_attr_val_f attr_handlers[] = {
+    [PCHVML_KEYWORD_ENUM(HVML, FOR)]     = process_attr_for,
+    [PCHVML_KEYWORD_ENUM(HVML, ON)]      = process_attr_on,
+    [PCHVML_KEYWORD_ENUM(HVML, AT)]      = process_attr_at,
+    [PCHVML_KEYWORD_ENUM(HVML, AS)]      = process_attr_as,
+    [PCHVML_KEYWORD_ENUM(HVML, WITH)]    = process_attr_with,
+    [PCHVML_KEYWORD_ENUM(HVML, AGAINST)] = process_attr_against,
+    [PCHVML_KEYWORD_ENUM(HVML, IN)]      = process_attr_in,
+};
+
 static int
 attr_found_val(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
@@ -394,32 +432,14 @@ attr_found_val(struct pcintr_stack_frame *frame,
         struct pcvdom_attr *attr,
         void *ud)
 {
-    UNUSED_PARAM(ud);
-
     PC_ASSERT(name);
     PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
 
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, FOR)) == name) {
-        return process_attr_for(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ON)) == name) {
-        return process_attr_on(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AT)) == name) {
-        return process_attr_at(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AS)) == name) {
-        return process_attr_as(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WITH)) == name) {
-        return process_attr_with(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AGAINST)) == name) {
-        return process_attr_against(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, IN)) == name) {
-        return process_attr_in(frame, element, name, val);
-    }
+    pcintr_attr_val_f handler;
+    handler = pcintr_attr_handler(attr_handlers,
+            PCA_TABLESIZE(attr_handlers), attr);
+    if (handler)
+        return handler(frame, element, name, val, attr, ud);
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "vdom attribute '%s' for element <%s>",
@@ -105,8 +105,12 @@ ctxt_destroy(void *ctxt)
 static int
 process_attr_on(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_sort *ctxt;
     ctxt = (struct ctxt_for_sort*)frame->ctxt;
     if (ctxt->on != PURC_VARIANT_INVALID) {
@@ -130,8 +134,12 @@ process_attr_on(struct pcintr_stack_frame *frame,
 static int
 process_attr_by(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_sort *ctxt;
     ctxt = (struct ctxt_for_sort*)frame->ctxt;
     if (ctxt->by != PURC_VARIANT_INVALID) {
@@ -155,8 +163,12 @@ process_attr_by(struct pcintr_stack_frame *frame,
 static int
 process_attr_with(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_sort *ctxt;
     ctxt = (struct ctxt_for_sort*)frame->ctxt;
     if (ctxt->with != PURC_VARIANT_INVALID) {
@@ -179,8 +191,12 @@ process_attr_with(struct pcintr_stack_frame *frame,
 static int
 process_attr_against(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_sort *ctxt;
     ctxt = (struct ctxt_for_sort*)frame->ctxt;
     if (ctxt->against != PURC_VARIANT_INVALID) {
@@ -201,56 +217,115 @@ process_attr_against(struct pcintr_stack_frame *frame,
 }
 
 static int
-attr_found_val(struct pcintr_stack_frame *frame,
+process_attr_casesensitively(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
         purc_atom_t name, purc_variant_t val,
-        struct pcvdom_attr *attr,
-        void *ud)
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
     UNUSED_PARAM(ud);
 
-    PC_ASSERT(name);
-    PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
+    struct ctxt_for_sort *ctxt;
+    ctxt = (struct ctxt_for_sort*)frame->ctxt;
+
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->casesensitively= 1;
+    return 0;
+}
+
+static int
+process_attr_caseinsensitively(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
 
     struct ctxt_for_sort *ctxt;
     ctxt = (struct ctxt_for_sort*)frame->ctxt;
 
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ON)) == name) {
-        return process_attr_on(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, BY)) == name) {
-        return process_attr_by(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WITH)) == name) {
-        return process_attr_with(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AGAINST)) == name) {
-        return process_attr_against(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, CASESENSITIVELY)) == name
-            || pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, CASE)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->casesensitively= 1;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, CASEINSENSITIVELY)) == name
-            || pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, CASELESS)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->casesensitively= 0;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ASCENDINGLY)) == name
-            || pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ASC)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->ascendingly= 1;
-        return 0;
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, DESCENDINGLY)) == name
-            || pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, DESC)) == name) {
-        PC_ASSERT(purc_variant_is_undefined(val));
-        ctxt->ascendingly= 0;
-        return 0;
-    }
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->casesensitively= 0;
+    return 0;
+}
+
+static int
+process_attr_ascendingly(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_sort *ctxt;
+    ctxt = (struct ctxt_for_sort*)frame->ctxt;
+
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->ascendingly= 1;
+    return 0;
+}
+
+static int
+process_attr_descendingly(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
+{
+    UNUSED_PARAM(element);
+    UNUSED_PARAM(name);
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
+    struct ctxt_for_sort *ctxt;
+    ctxt = (struct ctxt_for_sort*)frame->ctxt;
+
+    PC_ASSERT(purc_variant_is_undefined(val));
+    ctxt->ascendingly= 0;
+    return 0;
+}
+
+static const pcintr_attr_val_f attr_handlers[] = {
+    [PCHVML_KEYWORD_ENUM(HVML, ON)]                = process_attr_on,
+    [PCHVML_KEYWORD_ENUM(HVML, BY)]                = process_attr_by,
+    [PCHVML_KEYWORD_ENUM(HVML, WITH)]              = process_attr_with,
+    [PCHVML_KEYWORD_ENUM(HVML, AGAINST)]           = process_attr_against,
+    [PCHVML_KEYWORD_ENUM(HVML, CASESENSITIVELY)] =
+        process_attr_casesensitively,
+    [PCHVML_KEYWORD_ENUM(HVML, CASE)] =
+        process_attr_casesensitively,
+    [PCHVML_KEYWORD_ENUM(HVML, CASEINSENSITIVELY)] =
+        process_attr_caseinsensitively,
+    [PCHVML_KEYWORD_ENUM(HVML, CASELESS)] =
+        process_attr_caseinsensitively,
+    [PCHVML_KEYWORD_ENUM(HVML, ASCENDINGLY)]       = process_attr_ascendingly,
+    [PCHVML_KEYWORD_ENUM(HVML, ASC)]               = process_attr_ascendingly,
+    [PCHVML_KEYWORD_ENUM(HVML, DESCENDINGLY)]      = process_attr_descendingly,
+    [PCHVML_KEYWORD_ENUM(HVML, DESC)]              = process_attr_descendingly,
+};
+
+static int
+attr_found_val(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr,
+        void *ud)
+{
+    PC_ASSERT(name);
+    PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
+
+    pcintr_attr_val_f handler;
+    handler = pcintr_attr_handler(attr_handlers,
+            PCA_TABLESIZE(attr_handlers), attr);
+    if (handler)
+        return handler(frame, element, name, val, attr, ud);
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "vdom attribute '%s' for element <%s>",
@@ -259,7 +334,6 @@ attr_found_val(struct pcintr_stack_frame *frame,
     return -1;
 }
 
-
 static int
 attr_found(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
@@ -319,25 +393,6 @@ split_key(const char *key)
     return keys;
 }
 
-static int
-comp_number(double l, double r, bool ascendingly)
-{
-    if (ascendingly) {
-        return (l > r) ? 1 : (l < r ? -1 : 0);
-    }
-    return (l > r) ? -1 : (l < r ? 1 : 0);
-}
-
-static int
-comp_string(const char *l, const char *r, bool ascendingly, bool casesensitively)
-{
-    if (!l || !r) {
-        return 0;
-    }
-    int ret = casesensitively ? strcmp(l, r) : strcasecmp(l, r);
-    return ascendingly ? ret : -ret;
-}
-
 #define UNDEFINED_STR       "undefined"
 
 static char *
@@ -355,68 +410,64 @@ variant_to_string(purc_variant_t v)
     return buf;
 }
 
+/* computes the keys of a member once, instead of on every comparison */
 static int
-comp_raw(purc_variant_t l, purc_variant_t r, bool by_number,
-        bool ascendingly, bool casesensitively)
+sort_decorate(purc_variant_t val, struct pcvariant_sort_key *keys, void *data)
 {
-    if (by_number) {
-        double dl = l ? purc_variant_numberify(l) : 0.0f;
-        double dr = r ? purc_variant_numberify(r) : 0.0f;
-        return comp_number(dl, dr, ascendingly);
-    }
+    struct ctxt_for_sort *ctxt = data;
+    size_t nr_keys = pcutils_arrlist_length(ctxt->keys);
+    for (size_t i = 0; i < nr_keys; i++) {
+        struct sort_key *key = pcutils_arrlist_get_idx(ctxt->keys, i);
+        purc_variant_t v = PURC_VARIANT_INVALID;
+        if (key->key == NULL) {
+            v = val;
+        }
+        else if (purc_variant_is_object(val)) {
+            v = purc_variant_object_get_by_ckey(val, key->key);
+            purc_clr_error();
+        }
 
-    char *buf_l = variant_to_string(l);
-    char *buf_r = variant_to_string(r);
-    int ret = comp_string(buf_l, buf_r, ascendingly, casesensitively);
-    if (buf_l) {
-        free(buf_l);
-    }
-    if (buf_r) {
-        free(buf_r);
+        if (key->by_number) {
+            keys[i].d = v ? purc_variant_numberify(v) : 0.0f;
+            continue;
+        }
+
+        /* a string failed to stringify compares equal to any other */
+        keys[i].s = variant_to_string(v);
+        if (keys[i].s && !ctxt->casesensitively) {
+            for (char *p = keys[i].s; *p; p++) {
+                *p = purc_tolower(*p);
+            }
+        }
     }
-    return ret;
+    return 0;
 }
 
 static int
-comp_by_key(purc_variant_t l, purc_variant_t r, const char *key, bool by_number,
-        bool ascendingly, bool casesensitively)
+sort_by_keys(struct ctxt_for_sort *ctxt, purc_variant_t val)
 {
-    purc_variant_t lv = PURC_VARIANT_INVALID;
-    purc_variant_t rv = PURC_VARIANT_INVALID;
-    if (purc_variant_is_object(l)) {
-        lv = purc_variant_object_get_by_ckey(l, key);
-        purc_clr_error();
+    size_t nr_keys = pcutils_arrlist_length(ctxt->keys);
+    if (nr_keys == 0) {
+        return 0;
     }
 
-    if (purc_variant_is_object(r)) {
-        rv = purc_variant_object_get_by_ckey(r, key);
-        purc_clr_error();
+    enum pcvariant_sort_key_type *types;
+    types = (enum pcvariant_sort_key_type*)malloc(nr_keys * sizeof(*types));
+    if (types == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
     }
 
-    return comp_raw(lv, rv, by_number, ascendingly, casesensitively);
-}
-
-static int
-sort_cmp(purc_variant_t l, purc_variant_t r, void *data)
-{
-    struct ctxt_for_sort *ctxt = data;
-    size_t nr_keys = pcutils_arrlist_length(ctxt->keys);
     for (size_t i = 0; i < nr_keys; i++) {
         struct sort_key *key = pcutils_arrlist_get_idx(ctxt->keys, i);
-        int ret = 0;
-        if (key->key == NULL) {
-            ret = comp_raw(l, r, key->by_number, ctxt->ascendingly,
-                    ctxt->casesensitively);
-        }
-        else {
-            ret = comp_by_key(l, r, key->key, key->by_number,
-                    ctxt->ascendingly, ctxt->casesensitively);
-        }
-        if (ret != 0) {
-            return ret;
-        }
+        types[i] = key->by_number ? PCVARIANT_SORT_KEY_NUMBER :
+            PCVARIANT_SORT_KEY_STRING;
     }
-    return 0;
+
+    int ret = pcvariant_sort_by_keys(val, types, nr_keys, !ctxt->ascendingly,
+            sort_decorate, ctxt);
+    free(types);
+    return ret;
 }
 
 static bool
@@ -485,7 +536,7 @@ sort_array(struct ctxt_for_sort *ctxt, purc_variant_t array,
             }
         }
     }
-    pcvariant_array_sort(array, ctxt, sort_cmp);
+    sort_by_keys(ctxt, array);
 }
 
 
@@ -538,7 +589,7 @@ sort_set(struct ctxt_for_sort *ctxt, purc_variant_t set, purc_variant_t against)
             }
         }
     }
-    pcvariant_set_sort(set, ctxt, sort_cmp);
+    sort_by_keys(ctxt, set);
 }
 
 static int
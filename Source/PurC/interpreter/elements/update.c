@@ -602,8 +602,12 @@ process(pcintr_coroutine_t co, struct pcintr_stack_frame *frame,
 static int
 process_attr_on(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_update *ctxt;
     ctxt = (struct ctxt_for_update*)frame->ctxt;
     if (ctxt->on != PURC_VARIANT_INVALID) {
@@ -627,8 +631,12 @@ process_attr_on(struct pcintr_stack_frame *frame,
 static int
 process_attr_to(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_update *ctxt;
     ctxt = (struct ctxt_for_update*)frame->ctxt;
     if (ctxt->to != PURC_VARIANT_INVALID) {
@@ -665,8 +673,10 @@ static int
 process_attr_with(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
         purc_atom_t name, purc_variant_t val,
-        struct pcvdom_attr *attr)
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_update *ctxt;
     ctxt = (struct ctxt_for_update*)frame->ctxt;
     if (ctxt->with != PURC_VARIANT_INVALID) {
@@ -715,8 +725,12 @@ process_attr_with(struct pcintr_stack_frame *frame,
 static int
 process_attr_from(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_update *ctxt;
     ctxt = (struct ctxt_for_update*)frame->ctxt;
     if (ctxt->from != PURC_VARIANT_INVALID) {
@@ -759,8 +773,12 @@ process_attr_from(struct pcintr_stack_frame *frame,
 static int
 process_attr_at(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
-        purc_atom_t name, purc_variant_t val)
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr, void *ud)
 {
+    UNUSED_PARAM(attr);
+    UNUSED_PARAM(ud);
+
     struct ctxt_for_update *ctxt;
     ctxt = (struct ctxt_for_update*)frame->ctxt;
     if (ctxt->at != PURC_VARIANT_INVALID) {
@@ -781,6 +799,14 @@ process_attr_at(struct pcintr_stack_frame *frame,
     return 0;
 }
 
+static const pcintr_attr_val_f attr_handlers[] = {
+    [PCHVML_KEYWORD_ENUM(HVML, WITH)]   = process_attr_with,
+    [PCHVML_KEYWORD_ENUM(HVML, ON)]     = process_attr_on,
+    [PCHVML_KEYWORD_ENUM(HVML, TO)]     = process_attr_to,
+    [PCHVML_KEYWORD_ENUM(HVML, FROM)]   = process_attr_from,
+    [PCHVML_KEYWORD_ENUM(HVML, AT)]     = process_attr_at,
+};
+
 static int
 attr_found_val(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element,
@@ -788,28 +814,17 @@ attr_found_val(struct pcintr_stack_frame *frame,
         struct pcvdom_attr *attr,
         void *ud)
 {
-    UNUSED_PARAM(ud);
-
     PC_ASSERT(name);
 
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, WITH)) == name) {
-        return process_attr_with(frame, element, name, val, attr);
-    }
-
-    PC_ASSERT(attr->op == PCHVML_ATTRIBUTE_OPERATOR);
+    // only `with` allows the operators other than `=`
+    PC_ASSERT(attr->keyword == PCHVML_KEYWORD_ENUM(HVML, WITH) ||
+            attr->op == PCHVML_ATTRIBUTE_OPERATOR);
 
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, ON)) == name) {
-        return process_attr_on(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, TO)) == name) {
-        return process_attr_to(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, FROM)) == name) {
-        return process_attr_from(frame, element, name, val);
-    }
-    if (pchvml_keyword(PCHVML_KEYWORD_ENUM(HVML, AT)) == name) {
-        return process_attr_at(frame, element, name, val);
-    }
+    pcintr_attr_val_f handler;
+    handler = pcintr_attr_handler(attr_handlers,
+            PCA_TABLESIZE(attr_handlers), attr);
+    if (handler)
+        return handler(frame, element, name, val, attr, ud);
 
     purc_set_error_with_info(PURC_ERROR_NOT_IMPLEMENTED,
             "vdom attribute '%s' for element <%s>",
@@ -28,9 +28,22 @@
 #include "private/map.h"
 #include "private/fetcher.h"
 #include "private/ports.h"
+#include "private/vdom.h"
 #include "../hvml/hvml-gen.h"
 
 #include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* The directory to keep the compiled documents loaded from files; the
+   empty value disables the cache. By default, it is `purc/vdom` under
+   `$XDG_CACHE_HOME` or `$HOME/.cache`. */
+#define PURC_ENVV_VDOM_CACHE_DIR    "PURC_VDOM_CACHE_DIR"
 
 purc_vdom_t
 purc_load_hvml_from_rwstream(purc_rwstream_t stm)
@@ -96,6 +109,7 @@ end:
  */
 static size_t total_orig_size;
 static pcutils_map* md5_vdom_map;
+static char *vdom_cache_dir;
 
 struct vdom_entry {
     time_t expire;
@@ -145,6 +159,31 @@ static void cleanup_loader_once(void)
             (unsigned long long)n);
 #endif
     pcutils_map_destroy(md5_vdom_map);
+    free(vdom_cache_dir);
+}
+
+static char *
+get_vdom_cache_dir(void)
+{
+    const char *env = getenv(PURC_ENVV_VDOM_CACHE_DIR);
+    if (env)
+        return env[0] ? strdup(env) : NULL;
+
+    const char *base = getenv("XDG_CACHE_HOME");
+    const char *sub = "purc/vdom";
+    if (base == NULL || base[0] == 0) {
+        base = getenv("HOME");
+        sub = ".cache/purc/vdom";
+    }
+    if (base == NULL || base[0] == 0)
+        return NULL;
+
+    char *dir = malloc(PATH_MAX);
+    if (dir && snprintf(dir, PATH_MAX, "%s/%s", base, sub) >= PATH_MAX) {
+        free(dir);
+        dir = NULL;
+    }
+    return dir;
 }
 
 int pcintr_init_loader_once(void)
@@ -154,6 +193,8 @@ int pcintr_init_loader_once(void)
     if (md5_vdom_map == NULL)
         goto failed;
 
+    vdom_cache_dir = get_vdom_cache_dir();
+
     if (atexit(cleanup_loader_once))
         goto failed;
 
@@ -162,9 +203,277 @@ int pcintr_init_loader_once(void)
 failed:
     if (md5_vdom_map)
         pcutils_map_destroy(md5_vdom_map);
+    free(vdom_cache_dir);
+    vdom_cache_dir = NULL;
     return -1;
 }
 
+/*
+ * The on-disk cache of the documents loaded from files. The compiled
+ * document is stored in `<md5 of the content>.vdom`, and the digest of the
+ * content of a file is stored in `<md5 of the real path>.idx` together with
+ * the status of the file, so that the file is not read at all if it has
+ * not been changed since it was compiled.
+ */
+struct vdom_file_index {
+    char            magic[8];
+    uint64_t        dev;
+    uint64_t        ino;
+    uint64_t        size;
+    int64_t         mtime_sec;
+    int64_t         mtime_nsec;
+    int64_t         ctime_sec;
+    int64_t         ctime_nsec;
+    unsigned char   digest[MD5_DIGEST_SIZE];
+};
+
+#define VDOM_INDEX_MAGIC    "PURCVIDX"
+
+static void
+make_file_index(struct vdom_file_index *idx, const struct stat *st,
+        const unsigned char *digest)
+{
+    memset(idx, 0, sizeof(*idx));
+    memcpy(idx->magic, VDOM_INDEX_MAGIC, sizeof(idx->magic));
+    idx->dev = st->st_dev;
+    idx->ino = st->st_ino;
+    idx->size = st->st_size;
+    idx->mtime_sec = st->st_mtime;
+    idx->ctime_sec = st->st_ctime;
+#if OS(LINUX)
+    idx->mtime_nsec = st->st_mtim.tv_nsec;
+    idx->ctime_nsec = st->st_ctim.tv_nsec;
+#elif OS(DARWIN)
+    idx->mtime_nsec = st->st_mtimespec.tv_nsec;
+    idx->ctime_nsec = st->st_ctimespec.tv_nsec;
+#endif
+    if (digest)
+        memcpy(idx->digest, digest, MD5_DIGEST_SIZE);
+}
+
+static bool
+make_cache_path(char *path, const unsigned char *md5, const char *suffix)
+{
+    char hex[MD5_DIGEST_SIZE * 2 + 1];
+    pcutils_bin2hex(md5, MD5_DIGEST_SIZE, hex, false);
+    return snprintf(path, PATH_MAX, "%s/%s%s", vdom_cache_dir, hex,
+            suffix) < PATH_MAX;
+}
+
+static bool
+make_index_path(char *path, const char *file)
+{
+    char real[PATH_MAX];
+    unsigned char md5[MD5_DIGEST_SIZE];
+
+    if (realpath(file, real) == NULL)
+        return false;
+
+    pcutils_md5digest(real, md5);
+    return make_cache_path(path, md5, ".idx");
+}
+
+/* gets the digest of the content if the file has not been changed */
+static bool
+read_file_index(const char *idx_path, const struct stat *st,
+        unsigned char *digest)
+{
+    struct vdom_file_index idx, expected;
+    bool found = false;
+
+    int fd = open(idx_path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    if (read(fd, &idx, sizeof(idx)) == (ssize_t)sizeof(idx)) {
+        make_file_index(&expected, st, idx.digest);
+        found = memcmp(&idx, &expected, sizeof(idx)) == 0;
+    }
+    close(fd);
+
+    if (found)
+        memcpy(digest, idx.digest, MD5_DIGEST_SIZE);
+    return found;
+}
+
+static bool
+make_cache_dir(void)
+{
+    char path[PATH_MAX];
+    size_t len = strlen(vdom_cache_dir);
+
+    if (len >= sizeof(path))
+        return false;
+    strcpy(path, vdom_cache_dir);
+
+    for (size_t i = 1; i <= len; i++) {
+        if (path[i] == '/' || path[i] == 0) {
+            char c = path[i];
+            path[i] = 0;
+            if (mkdir(path, 0700) && errno != EEXIST)
+                return false;
+            path[i] = c;
+        }
+    }
+
+    return true;
+}
+
+/* writes to a temporary file and renames it, so that the readers in other
+   processes never see a partially written file */
+static bool
+write_cache_file(const char *path, const void *data, size_t len)
+{
+    static atomic_uint serial;
+    char tmp[PATH_MAX];
+
+    if (snprintf(tmp, sizeof(tmp), "%s.%d-%u", path, (int)getpid(),
+                atomic_fetch_add(&serial, 1)) >= (int)sizeof(tmp))
+        return false;
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == ENOENT && make_cache_dir())
+        fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+        return false;
+
+    const char *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        p += n;
+        len -= n;
+    }
+
+    if (close(fd) || len > 0 || rename(tmp, path)) {
+        unlink(tmp);
+        return false;
+    }
+
+    return true;
+}
+
+static void
+write_file_index(const char *idx_path, const struct stat *st,
+        const unsigned char *digest)
+{
+    struct vdom_file_index idx;
+    make_file_index(&idx, st, digest);
+    write_cache_file(idx_path, &idx, sizeof(idx));
+}
+
+static purc_vdom_t
+load_vdom_from_cache_file(const unsigned char *digest)
+{
+    char path[PATH_MAX];
+    purc_vdom_t vdom = NULL;
+    struct stat st;
+
+    if (!make_cache_path(path, digest, ".vdom"))
+        return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            vdom = pcvdom_document_load_bin(data, st.st_size, digest);
+            munmap(data, st.st_size);
+        }
+    }
+    close(fd);
+
+    if (vdom == NULL) {
+        /* the file is stale or corrupted; it will be overwritten */
+        purc_clr_error();
+    }
+    return vdom;
+}
+
+static void
+store_vdom_to_cache_file(const unsigned char *digest, purc_vdom_t vdom)
+{
+    char path[PATH_MAX];
+    if (!make_cache_path(path, digest, ".vdom"))
+        return;
+
+    purc_rwstream_t out = purc_rwstream_new_buffer(0, 0);
+    if (out == NULL)
+        return;
+
+    if (pcvdom_document_dump_bin(vdom, digest, out) == 0) {
+        size_t len;
+        const void *data = purc_rwstream_get_mem_buffer(out, &len);
+        write_cache_file(path, data, len);
+    }
+    else {
+        purc_clr_error();
+    }
+
+    purc_rwstream_destroy(out);
+}
+
+/* loads the document from the on-disk cache, or compiles the file and
+   stores the result to the cache */
+static purc_vdom_t
+load_vdom_with_cache_file(const char *file)
+{
+    char idx_path[PATH_MAX];
+    unsigned char digest[MD5_DIGEST_SIZE];
+    purc_vdom_t vdom = NULL;
+    struct stat st;
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) || st.st_size == 0) {
+        purc_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+        goto done;
+    }
+
+    bool has_index = make_index_path(idx_path, file);
+    if (has_index && read_file_index(idx_path, &st, digest)) {
+        if ((vdom = load_vdom_from_cache_file(digest)))
+            goto done;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        purc_set_error(PURC_ERROR_BAD_SYSTEM_CALL);
+        goto done;
+    }
+
+    pcutils_md5_ctxt ctxt;
+    pcutils_md5_begin(&ctxt);
+    pcutils_md5_hash(&ctxt, data, st.st_size);
+    pcutils_md5_end(&ctxt, digest);
+
+    /* another file may have the same content */
+    vdom = load_vdom_from_cache_file(digest);
+    if (vdom == NULL) {
+        purc_rwstream_t in = purc_rwstream_new_from_mem(data, st.st_size);
+        if (in) {
+            vdom = purc_load_hvml_from_rwstream(in);
+            purc_rwstream_destroy(in);
+        }
+
+        if (vdom)
+            store_vdom_to_cache_file(digest, vdom);
+    }
+    munmap(data, st.st_size);
+
+    if (vdom && has_index)
+        write_file_index(idx_path, &st, digest);
+
+done:
+    if (fd >= 0)
+        close(fd);
+    return vdom;
+}
+
 static bool
 cache_vdom(unsigned char *md5, unsigned expire_after, size_t length,
         purc_vdom_t vdom)
@@ -259,7 +568,11 @@ purc_load_hvml_from_file(const char* file)
     }
 
     vdom = find_vdom_in_cache(md5);
-    if (vdom == NULL) {
+    if (vdom == NULL && vdom_cache_dir) {
+        if ((vdom = load_vdom_with_cache_file(file)))
+            cache_vdom(md5, 0, length, vdom);
+    }
+    else if (vdom == NULL) {
         purc_rwstream_t in;
         in = purc_rwstream_new_from_file(file, "r");
         if (!in) {
@@ -84,6 +84,16 @@ struct pcintr_event_handler {
     event_match_fn                is_match;
 };
 
+/* The iterator over the observers matching a message; see
+   pcintr_first_matched_observer(). */
+struct pcintr_observer_iterator {
+    struct list_head             *slots[2];
+    struct list_head             *next[2];
+    struct list_head             *list;
+    purc_variant_t                observed;
+    purc_atom_t                   type_atom;
+    const char                   *sub_type;
+};
 
 
 PCA_EXTERN_C_BEGIN
@@ -98,6 +108,22 @@ bool
 pcintr_is_observer_match(struct pcintr_observer *observer,
         purc_variant_t observed, purc_atom_t type_atom, const char *sub_type);
 
+void
+pcintr_destroy_observer_index(pcintr_stack_t stack);
+
+/* Returns the first observer matching the message, in the order of
+   registration, or NULL if there is no such one. Only the observers in
+   the slots of the index which may match the message are checked. */
+struct pcintr_observer *
+pcintr_first_matched_observer(pcintr_stack_t stack, purc_variant_t observed,
+        purc_atom_t type_atom, const char *sub_type,
+        struct pcintr_observer_iterator *it);
+
+/* Returns the next observer matching the message. The current observer
+   can be revoked before calling this function. */
+struct pcintr_observer *
+pcintr_next_matched_observer(struct pcintr_observer_iterator *it);
+
 struct pcintr_stack_frame_normal *
 pcintr_push_stack_frame_normal(pcintr_stack_t stack);
 
@@ -125,6 +151,29 @@ int
 pcintr_vdom_walk_attrs(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element, void *ud, pcintr_attr_f cb);
 
+/* the handler of an attribute with the evaluated value */
+typedef int (*pcintr_attr_val_f)(struct pcintr_stack_frame *frame,
+        struct pcvdom_element *element,
+        purc_atom_t name, purc_variant_t val,
+        struct pcvdom_attr *attr,
+        void *ud);
+
+#ifndef __cplusplus                        /* { */
+/*
+ * Gets the handler of the attribute from a dense table indexed by
+ * PCHVML_KEYWORD_ENUM(HVML, xxx); returns NULL if the attribute is not
+ * a keyword or there is no handler for it.
+ */
+static inline pcintr_attr_val_f
+pcintr_attr_handler(const pcintr_attr_val_f *handlers, size_t nr_handlers,
+        struct pcvdom_attr *attr)
+{
+    if (attr->keyword < 0 || (size_t)attr->keyword >= nr_handlers)
+        return NULL;
+    return handlers[attr->keyword];
+}
+#endif                                    /* } */
+
 bool
 pcintr_is_element_silently(struct pcvdom_element *element);
 
@@ -150,6 +199,7 @@ pcintr_get_question_var(struct pcintr_stack_frame *frame);
 int
 pcintr_set_exclamation_var(struct pcintr_stack_frame *frame,
         purc_variant_t val);
+/* creates the object of `$!` of a normal frame on the first call */
 purc_variant_t
 pcintr_get_exclamation_var(struct pcintr_stack_frame *frame);
 
@@ -333,6 +383,37 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char *property,
         pcrdr_msg_data_type data_type, const char *data, size_t len);
 
+/* the default quantum of a ready coroutine */
+#define PCINTR_DEF_QUANTUM_STEPS    64
+#define PCINTR_DEF_QUANTUM_USEC     1000
+
+/* the max number of the popped frames a coroutine keeps for reuse */
+#define PCINTR_MAX_FREE_FRAMES      32
+
+/* the default max number of the DOM operations queued by a coroutine */
+#define PCINTR_DEF_MAX_DOM_OPS      64
+/* the max time (ms) of a DOM operation staying in the queue */
+#define PCINTR_MAX_DOM_OPS_DELAY    20
+
+/* send the DOM operations queued by the coroutine to the renderer */
+void
+pcintr_rdr_flush_dom_ops(pcintr_coroutine_t co);
+
+/* called after every step: flush the queued DOM operations if the coroutine
+   is not ready to run any more, or the queue is full, or the operations have
+   been queued for too long */
+void
+pcintr_rdr_check_dom_ops(pcintr_coroutine_t co);
+
+/* flush the DOM operations queued by all coroutines, so that they reach
+   the renderer before another request */
+void
+pcintr_rdr_sync_dom_ops(void);
+
+/* drop the DOM operations queued by a coroutine being released */
+void
+pcintr_rdr_drop_dom_ops(pcintr_coroutine_t co);
+
 
 #define pcintr_rdr_dom_append_content(stack, element, content)          \
     pcintr_rdr_send_dom_req_simple_raw(stack, PCDOC_OP_APPEND,          \
@@ -437,6 +518,10 @@ void pcintr_coroutine_set_state_with_location(pcintr_coroutine_t co,
     pcintr_coroutine_set_state_with_location(co, state,\
             __FILE__, __LINE__, __func__)
 
+/* mark the coroutine as having messages or tasks to dispatch */
+void
+pcintr_coroutine_set_pending(pcintr_coroutine_t co);
+
 int
 pcintr_coroutine_clear_tasks(pcintr_coroutine_t co);
 
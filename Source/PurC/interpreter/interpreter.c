@@ -53,6 +53,16 @@
 
 #define EVENT_TIMER_INTRVAL  10
 
+/* set to 1 or true to scan all coroutines in every scheduling tick */
+#define PURC_ENVV_SCHEDULE_POLLING  "PURC_SCHEDULE_POLLING"
+/* the max number of the DOM operations queued by a coroutine;
+   0 for sending every operation and waiting for the response at once */
+#define PURC_ENVV_RDR_DOM_OPS       "PURC_RDR_DOM_OPS"
+/* the max steps and the max time (us) a ready coroutine executes in a row;
+   overridden by the fields of purc_instance_extra_info */
+#define PURC_ENVV_SCHED_QUANTUM_STEPS   "PURC_SCHED_QUANTUM_STEPS"
+#define PURC_ENVV_SCHED_QUANTUM_USEC    "PURC_SCHED_QUANTUM_USEC"
+
 #define EVENT_SEPARATOR      ':'
 
 
@@ -124,6 +134,32 @@ stack_frame_normal_destroy(struct pcintr_stack_frame_normal *frame_normal)
     free(frame_normal);
 }
 
+/* keeps the popped frame for reuse by the next push if the pool is not full */
+static void
+stack_frame_normal_recycle(pcintr_stack_t stack,
+        struct pcintr_stack_frame_normal *frame_normal)
+{
+    if (stack->nr_free_frames >= PCINTR_MAX_FREE_FRAMES) {
+        stack_frame_normal_destroy(frame_normal);
+        return;
+    }
+
+    stack_frame_normal_release(frame_normal);
+    list_add(&frame_normal->frame.node, &stack->free_frames);
+    ++stack->nr_free_frames;
+}
+
+static void
+free_frames_release(pcintr_stack_t stack)
+{
+    struct pcintr_stack_frame *p, *n;
+    list_for_each_entry_safe(p, n, &stack->free_frames, node) {
+        list_del(&p->node);
+        free(container_of(p, struct pcintr_stack_frame_normal, frame));
+    }
+    stack->nr_free_frames = 0;
+}
+
 static int
 doc_init(pcintr_stack_t stack)
 {
@@ -318,11 +354,14 @@ stack_release(pcintr_stack_t stack)
     }
     PC_ASSERT(stack->nr_frames == 0);
 
+    free_frames_release(stack);
     release_scoped_variables(stack);
+    pcintr_release_var_caches(stack);
 
     pcintr_destroy_observer_list(&stack->common_observers);
     pcintr_destroy_observer_list(&stack->dynamic_observers);
     pcintr_destroy_observer_list(&stack->native_observers);
+    pcintr_destroy_observer_index(stack);
 
     if (stack->doc) {
         purc_document_unref(stack->doc);
@@ -362,6 +401,10 @@ coroutine_release(pcintr_coroutine_t co)
         struct pcintr_heap *heap = pcintr_get_heap();
         PC_ASSERT(heap && co->owner == heap);
 
+        list_del_init(&co->ready_ln);
+        list_del_init(&co->pending_ln);
+        pcintr_rdr_drop_dom_ops(co);
+
         stack_release(&co->stack);
         pcvdom_document_unref(co->vdom);
 
@@ -469,6 +512,7 @@ stack_init(pcintr_stack_t stack)
     INIT_LIST_HEAD(&stack->common_observers);
     INIT_LIST_HEAD(&stack->dynamic_observers);
     INIT_LIST_HEAD(&stack->native_observers);
+    INIT_LIST_HEAD(&stack->free_frames);
     stack->scoped_variables = RB_ROOT;
 
     stack->mode = STACK_VDOM_BEFORE_HVML;
@@ -492,6 +536,8 @@ static void _cleanup_instance(struct pcinst* inst)
         coroutine_destroy(co);
     }
 
+    PURC_VARIANT_SAFE_CLEAR(heap->initial_index);
+
     if (heap->move_buff) {
         size_t n = purc_inst_destroy_move_buffer();
         PC_DEBUG("Instance is quiting, %u messages discarded\n", (unsigned)n);
@@ -511,10 +557,21 @@ static void _cleanup_instance(struct pcinst* inst)
 static void
 event_timer_fire(pcintr_timer_t timer, const char* id, void* data);
 
+static unsigned int
+get_quantum(unsigned int value, const char *env_name, unsigned int def_value)
+{
+    if (value == 0) {
+        const char *env_value = getenv(env_name);
+        if (env_value != NULL)
+            value = (unsigned int)strtoul(env_value, NULL, 10);
+    }
+
+    return value ? value : def_value;
+}
+
 static int _init_instance(struct pcinst* inst,
         const purc_instance_extra_info* extra_info)
 {
-    UNUSED_PARAM(extra_info);
     inst->intr_heap = NULL;
 
     struct pcintr_heap *heap = inst->intr_heap;
@@ -543,6 +600,26 @@ static int _init_instance(struct pcinst* inst,
     heap->coroutines = RB_ROOT;
     heap->running_coroutine = NULL;
     heap->next_coroutine_id = 1;
+    list_head_init(&heap->ready_cos);
+    list_head_init(&heap->pending_cos);
+
+    const char *env_value = getenv(PURC_ENVV_SCHEDULE_POLLING);
+    heap->polling_schedule = ((env_value != NULL) &&
+            (*env_value == '1' || pcutils_strcasecmp(env_value, "true") == 0));
+
+    list_head_init(&heap->dom_ops_cos);
+    heap->max_dom_ops = PCINTR_DEF_MAX_DOM_OPS;
+    env_value = getenv(PURC_ENVV_RDR_DOM_OPS);
+    if (env_value != NULL) {
+        heap->max_dom_ops = (size_t)strtoul(env_value, NULL, 10);
+    }
+
+    heap->quantum_steps = get_quantum(
+            extra_info ? extra_info->sched_quantum_steps : 0,
+            PURC_ENVV_SCHED_QUANTUM_STEPS, PCINTR_DEF_QUANTUM_STEPS);
+    heap->quantum_usec = get_quantum(
+            extra_info ? extra_info->sched_quantum_usec : 0,
+            PURC_ENVV_SCHED_QUANTUM_USEC, PCINTR_DEF_QUANTUM_USEC);
 
     heap->event_timer = pcintr_timer_create(NULL, NULL, event_timer_fire, inst);
     if (!heap->event_timer) {
@@ -668,7 +745,7 @@ pop_stack_frame(pcintr_stack_t stack)
         case STACK_FRAME_TYPE_NORMAL:
             frame_normal = container_of(frame,
                     struct pcintr_stack_frame_normal, frame);
-            stack_frame_normal_destroy(frame_normal);
+            stack_frame_normal_recycle(stack, frame_normal);
             break;
         case STACK_FRAME_TYPE_PSEUDO:
             frame_pseudo = container_of(frame,
@@ -706,14 +783,17 @@ set_lessthan_symval(struct pcintr_stack_frame *frame, purc_variant_t val)
 static int
 init_percent_symval(struct pcintr_stack_frame *frame)
 {
-    purc_variant_t idx;
-    idx = purc_variant_make_ulongint(0);
-    if (idx == PURC_VARIANT_INVALID)
-        return -1;
+    // shared by all frames; see pcintr_inc_percent_var()
+    pcintr_heap_t heap = frame->owner->co->owner;
+    if (heap->initial_index == PURC_VARIANT_INVALID) {
+        heap->initial_index = purc_variant_make_ulongint(0);
+        if (heap->initial_index == PURC_VARIANT_INVALID)
+            return -1;
+    }
 
     enum purc_symbol_var symbol = PURC_SYMBOL_VAR_PERCENT_SIGN;
     PURC_VARIANT_SAFE_CLEAR(frame->symbol_vars[symbol]);
-    frame->symbol_vars[symbol] = idx;
+    frame->symbol_vars[symbol] = purc_variant_ref(heap->initial_index);
 
     return 0;
 }
@@ -736,23 +816,6 @@ init_at_symval(struct pcintr_stack_frame *frame)
     return r ? -1 : 0;
 }
 
-static int
-init_exclamation_symval(struct pcintr_stack_frame *frame)
-{
-    purc_variant_t exclamation_var;
-    exclamation_var = purc_variant_make_object(0,
-            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
-
-    if (exclamation_var == PURC_VARIANT_INVALID)
-        return -1;
-
-    int r;
-    r = pcintr_set_exclamation_var(frame, exclamation_var);
-    purc_variant_unref(exclamation_var);
-
-    return r ? -1 : 0;
-}
-
 static int
 init_undefined_symvals(struct pcintr_stack_frame *frame)
 {
@@ -828,9 +891,7 @@ init_symvals_with_vals(struct pcintr_stack_frame *frame)
     if (init_at_symval(frame))
         return -1;
 
-    // $0!
-    if (init_exclamation_symval(frame))
-        return -1;
+    // $0! is created on demand; see pcintr_get_exclamation_var()
 
     return 0;
 }
@@ -841,14 +902,7 @@ init_stack_frame(pcintr_stack_t stack, struct pcintr_stack_frame* frame)
     frame->owner           = stack;
     frame->silently        = 0;
 
-    frame->except_templates = purc_variant_make_object_0();
-    frame->error_templates  = purc_variant_make_object_0();
-
-    if (frame->except_templates == PURC_VARIANT_INVALID ||
-            frame->error_templates == PURC_VARIANT_INVALID)
-    {
-        return -1;
-    }
+    // except_templates and error_templates are created on the first binding
 
     return 0;
 }
@@ -974,11 +1028,22 @@ static struct pcintr_stack_frame_normal*
 stack_frame_normal_create(pcintr_stack_t stack)
 {
     struct pcintr_stack_frame_normal *frame_normal;
-    frame_normal = (struct pcintr_stack_frame_normal*)calloc(1,
-            sizeof(*frame_normal));
-    if (!frame_normal) {
-        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return NULL;
+    if (!list_empty(&stack->free_frames)) {
+        struct list_head *first = stack->free_frames.next;
+        list_del(first);
+        --stack->nr_free_frames;
+
+        frame_normal = container_of(first,
+                struct pcintr_stack_frame_normal, frame.node);
+        memset(frame_normal, 0, sizeof(*frame_normal));
+    }
+    else {
+        frame_normal = (struct pcintr_stack_frame_normal*)calloc(1,
+                sizeof(*frame_normal));
+        if (!frame_normal) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
     }
 
     struct pcintr_stack_frame *frame = &frame_normal->frame;
@@ -1079,64 +1144,31 @@ pcintr_eval_vdom_attr(pcintr_stack_t stack, struct pcvdom_attr *attr)
     return eval_vdom_attr(stack, attr);
 }
 
-struct pcintr_walk_attrs_ud {
-    struct pcintr_stack_frame       *frame;
-    struct pcvdom_element           *element;
-    void                            *ud;
-    pcintr_attr_f                    cb;
-};
-
-static int
-walk_attr(void *key, void *val, void *ud)
-{
-    PC_ASSERT(key);
-    PC_ASSERT(val);
-    PC_ASSERT(ud);
-
-    struct pcintr_walk_attrs_ud *data = (struct pcintr_walk_attrs_ud*)ud;
-
-    struct pcintr_stack_frame *frame = data->frame;
-    PC_ASSERT(frame);
-
-    struct pcvdom_attr *attr = (struct pcvdom_attr*)val;
-    PC_ASSERT(attr->key);
-    PC_ASSERT(attr->key == key);
-
-    struct pcvdom_element *element = data->element;
-    PC_ASSERT(element);
-
-    purc_atom_t atom = PCHVML_KEYWORD_ATOM(HVML, attr->key);
-    // NOTE: we only dispatch those keyworded-attr to caller
-    return data->cb(frame, element, atom, attr, data->ud);
-}
-
 int
 pcintr_vdom_walk_attrs(struct pcintr_stack_frame *frame,
         struct pcvdom_element *element, void *ud, pcintr_attr_f cb)
 {
-    struct pcutils_map *attrs = element->attrs;
+    struct sorted_array *attrs = element->attrs;
     if (!attrs)
         return 0;
 
     PC_ASSERT(frame->pos == element);
 
-    if (frame->attr_vars == PURC_VARIANT_INVALID) {
-        frame->attr_vars = purc_variant_make_object(0,
-                PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
-        if (frame->attr_vars == PURC_VARIANT_INVALID)
-            return -1;
-    }
+    // NOTE: `frame->attr_vars` is created by the elements using it
 
-    struct pcintr_walk_attrs_ud data = {
-        .frame        = frame,
-        .element      = element,
-        .ud           = ud,
-        .cb           = cb,
-    };
+    // NOTE: the atoms of the keywords are resolved when the vDOM is built
+    size_t nr = pcutils_sorted_array_count(attrs);
+    for (size_t i = 0; i < nr; i++) {
+        void *data;
+        pcutils_sorted_array_get(attrs, i, &data);
 
-    int r = pcutils_map_traverse(attrs, &data, walk_attr);
-    if (r)
-        return r;
+        struct pcvdom_attr *attr = (struct pcvdom_attr*)data;
+        PC_ASSERT(attr->key);
+
+        int r = cb(frame, element, attr->atom, attr, ud);
+        if (r)
+            return r;
+    }
 
     return 0;
 }
@@ -1797,6 +1829,12 @@ cmp_by_atom(struct rb_node *node, void *ud)
     return (*atom) - co->cid;
 }
 
+static void
+on_coroutine_msg_queued(void *ctxt)
+{
+    pcintr_coroutine_set_pending((pcintr_coroutine_t)ctxt);
+}
+
 static pcintr_coroutine_t
 coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
         pcrdr_page_type page_type, void *user_data)
@@ -1820,7 +1858,10 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
 
     pcvdom_document_ref(vdom);
     co->vdom = vdom;
-    pcintr_coroutine_set_state(co, CO_STATE_READY);
+    INIT_LIST_HEAD(&co->ready_ln);
+    INIT_LIST_HEAD(&co->pending_ln);
+    INIT_LIST_HEAD(&co->dom_ops);
+    INIT_LIST_HEAD(&co->dom_ops_ln);
     INIT_LIST_HEAD(&co->children);
     INIT_LIST_HEAD(&co->registered_cancels);
     INIT_LIST_HEAD(&co->tasks);
@@ -1876,6 +1917,8 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
     }
 
     stack->vdom = vdom;
+    pcinst_msg_queue_set_notifier(co->mq, on_coroutine_msg_queued, co);
+    pcintr_coroutine_set_state(co, CO_STATE_READY);
     if (heap->cond_handler) {
         heap->cond_handler(PURC_COND_COR_CREATED, co,
                 (void *)(uintptr_t)co->cid);
@@ -2738,6 +2781,20 @@ pcintr_set_exclamation_var(struct pcintr_stack_frame *frame,
 purc_variant_t
 pcintr_get_exclamation_var(struct pcintr_stack_frame *frame)
 {
+    purc_variant_t v;
+    v = pcintr_get_symbol_var(frame, PURC_SYMBOL_VAR_EXCLAMATION);
+    if (frame->type == STACK_FRAME_TYPE_PSEUDO || !purc_variant_is_undefined(v))
+        return v;
+
+    v = purc_variant_make_object_0();
+    if (v == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    int r = pcintr_set_exclamation_var(frame, v);
+    purc_variant_unref(v);
+    if (r)
+        return PURC_VARIANT_INVALID;
+
     return pcintr_get_symbol_var(frame, PURC_SYMBOL_VAR_EXCLAMATION);
 }
 
@@ -2748,6 +2805,18 @@ pcintr_inc_percent_var(struct pcintr_stack_frame *frame)
     v = pcintr_get_symbol_var(frame, PURC_SYMBOL_VAR_PERCENT_SIGN);
     PC_ASSERT(v != PURC_VARIANT_INVALID);
     PC_ASSERT(purc_variant_is_ulongint(v));
+
+    if (v == frame->owner->co->owner->initial_index) {
+        // the shared initial value is never changed
+        v = purc_variant_make_ulongint(1);
+        if (v == PURC_VARIANT_INVALID)
+            return -1;
+
+        int r = pcintr_set_symbol_var(frame, PURC_SYMBOL_VAR_PERCENT_SIGN, v);
+        purc_variant_unref(v);
+        return r ? -1 : 0;
+    }
+
     v->u64 += 1;
 
     return 0;
@@ -3237,6 +3306,22 @@ pcintr_coroutine_set_state_with_location(pcintr_coroutine_t co,
     UNUSED_PARAM(line);
     UNUSED_PARAM(func);
     co->state = state;
+
+    /* keep heap::ready_cos holding exactly the ready coroutines */
+    if (state == CO_STATE_READY) {
+        if (list_empty(&co->ready_ln))
+            list_add_tail(&co->ready_ln, &co->owner->ready_cos);
+    }
+    else if (!list_empty(&co->ready_ln)) {
+        list_del_init(&co->ready_ln);
+    }
+}
+
+void
+pcintr_coroutine_set_pending(pcintr_coroutine_t co)
+{
+    if (list_empty(&co->pending_ln))
+        list_add_tail(&co->pending_ln, &co->owner->pending_cos);
 }
 
 pcdoc_element_t
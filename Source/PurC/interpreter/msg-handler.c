@@ -140,6 +140,8 @@ add_task(pcintr_coroutine_t co, struct pcintr_observer *p,
     }
 
     list_add_tail(&task->ln, &co->tasks);
+    /* the scheduler only visits the coroutines with work to do */
+    pcintr_coroutine_set_pending(co);
 }
 
 static void handle_vdom_event(pcintr_stack_t stack, purc_vdom_t vdom,
@@ -189,13 +191,13 @@ process_coroutine_event(pcintr_coroutine_t co, pcrdr_msg *msg)
     purc_variant_t observed = msg->elementValue;
 
     bool handle = false;
-    struct list_head* list = pcintr_get_observer_list(stack, observed);
-    struct pcintr_observer *p, *n;
-    list_for_each_entry_safe(p, n, list, node) {
-        if (pcintr_is_observer_match(p, observed, msg_type_atom, sub_type_s)) {
-            handle = true;
-            add_task(co, p, msg->data, msg->sourceURI, msg->eventName);
-        }
+    struct pcintr_observer_iterator it;
+    struct pcintr_observer *p = pcintr_first_matched_observer(stack,
+            observed, msg_type_atom, sub_type_s, &it);
+    while (p) {
+        handle = true;
+        add_task(co, p, msg->data, msg->sourceURI, msg->eventName);
+        p = pcintr_next_matched_observer(&it);
     }
 
     if (!handle && purc_variant_is_native(observed)) {
@@ -282,14 +284,9 @@ is_observer_event_handler_match(struct pcintr_event_handler *handler,
     }
 
     purc_variant_t observed = msg->elementValue;
-    struct list_head* list = pcintr_get_observer_list(&co->stack, observed);
-    struct pcintr_observer *p, *n;
-    list_for_each_entry_safe(p, n, list, node) {
-        if (pcintr_is_observer_match(p, observed, msg_type_atom, sub_type_s)) {
-            match = true;
-            break;
-        }
-    }
+    struct pcintr_observer_iterator it;
+    match = (pcintr_first_matched_observer(&co->stack, observed,
+                msg_type_atom, sub_type_s, &it) != NULL);
 
 out:
     if (msg_type) {
@@ -30,9 +30,15 @@
 #include "private/msg-queue.h"
 #include "private/interpreter.h"
 #include "private/regex.h"
+#include "private/utils.h"
 
 #define BUILTIN_VAR_CRTN        PURC_PREDEF_VARNAME_CRTN
 
+#define OBSERVER_INDEX_MIN_SLOTS    16
+
+/* the characters having special meanings in a regular expression */
+#define REGEX_METACHARS         "\\^$.|?*+()[]{}"
+
 static void
 release_observer(struct pcintr_observer *observer)
 {
@@ -41,6 +47,9 @@ release_observer(struct pcintr_observer *observer)
 
     list_del(&observer->node);
 
+    list_del(&observer->index_node);
+    observer->stack->observer_index.nr_observers--;
+
     if (observer->on_revoke) {
         observer->on_revoke(observer, observer->on_revoke_data);
     }
@@ -63,6 +72,10 @@ release_observer(struct pcintr_observer *observer)
 
     free(observer->sub_type);
     observer->sub_type = NULL;
+    if (observer->sub_type_regex) {
+        pcregex_destroy(observer->sub_type_regex);
+        observer->sub_type_regex = NULL;
+    }
 }
 
 
@@ -106,6 +119,160 @@ bool is_variant_match_observe(purc_variant_t observed, purc_variant_t val)
     return false;
 }
 
+/* Whether the observer matches only the values equal to the observed one,
+   i.e., the observer can be found by the hash of the observed value. */
+static bool
+is_observed_keyed(purc_variant_t observed)
+{
+    if (purc_variant_is_native(observed)) {
+        struct purc_native_ops *ops = purc_variant_native_get_ops(observed);
+        return ops == NULL || ops->match_observe == NULL;
+    }
+
+    return true;
+}
+
+/* The values equal to each other (see purc_variant_is_equal_to()) have
+   the same hash value. */
+static size_t
+observed_hash(purc_variant_t observed)
+{
+    enum purc_variant_type type = purc_variant_get_type(observed);
+    const void *ptr;
+
+    switch (type) {
+    case PURC_VARIANT_TYPE_STRING:
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+        ptr = purc_variant_get_string_const(observed);
+        return pcutils_hash_hash((const unsigned char *)ptr,
+                strlen((const char *)ptr));
+
+    case PURC_VARIANT_TYPE_NATIVE:
+        ptr = purc_variant_native_get_entity(observed);
+        return (size_t)(uintptr_t)ptr;
+
+    case PURC_VARIANT_TYPE_DYNAMIC:
+        ptr = purc_variant_dynamic_get_getter(observed);
+        return (size_t)(uintptr_t)ptr;
+
+    default:
+        break;
+    }
+
+    return (size_t)type;
+}
+
+static inline struct list_head *
+observer_index_slot(struct pcintr_observer_index *index,
+        purc_atom_t type_atom, bool keyed, size_t hash)
+{
+    uint64_t h = keyed ? (uint64_t)hash : 0;
+
+    h ^= (uint64_t)type_atom * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return index->slots + (h & (index->nr_slots - 1));
+}
+
+static struct list_head *
+slot_of_observer(struct pcintr_observer_index *index,
+        struct pcintr_observer *observer)
+{
+    bool keyed = is_observed_keyed(observer->observed);
+    return observer_index_slot(index, observer->msg_type_atom, keyed,
+            keyed ? observed_hash(observer->observed) : 0);
+}
+
+/* Doubles the slots. The observers in a new slot all come from the same
+   old slot, so they are still in the order of registration. */
+static void
+grow_observer_index(struct pcintr_observer_index *index)
+{
+    size_t nr_old = index->nr_slots;
+    struct list_head *old = index->slots;
+
+    struct list_head *slots = (struct list_head *)malloc(
+            sizeof(struct list_head) * nr_old * 2);
+    if (slots == NULL) {
+        /* still works with longer chains */
+        return;
+    }
+
+    for (size_t i = 0; i < nr_old * 2; i++) {
+        INIT_LIST_HEAD(slots + i);
+    }
+
+    index->slots = slots;
+    index->nr_slots = nr_old * 2;
+    for (size_t i = 0; i < nr_old; i++) {
+        struct pcintr_observer *p, *n;
+        list_for_each_entry_safe(p, n, old + i, index_node) {
+            list_del(&p->index_node);
+            list_add_tail(&p->index_node, slot_of_observer(index, p));
+        }
+    }
+
+    free(old);
+}
+
+static int
+add_observer_into_index(pcintr_stack_t stack,
+        struct pcintr_observer *observer)
+{
+    struct pcintr_observer_index *index = &stack->observer_index;
+
+    if (index->slots == NULL) {
+        index->slots = (struct list_head *)malloc(
+                sizeof(struct list_head) * OBSERVER_INDEX_MIN_SLOTS);
+        if (index->slots == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+
+        index->nr_slots = OBSERVER_INDEX_MIN_SLOTS;
+        for (size_t i = 0; i < index->nr_slots; i++) {
+            INIT_LIST_HEAD(index->slots + i);
+        }
+    }
+    else if (index->nr_observers >= index->nr_slots) {
+        grow_observer_index(index);
+    }
+
+    observer->seq = ++index->last_seq;
+    list_add_tail(&observer->index_node, slot_of_observer(index, observer));
+    index->nr_observers++;
+    return 0;
+}
+
+void
+pcintr_destroy_observer_index(pcintr_stack_t stack)
+{
+    struct pcintr_observer_index *index = &stack->observer_index;
+
+    free(index->slots);
+    index->slots = NULL;
+    index->nr_slots = 0;
+}
+
+/* The sub type of the observer is a regular expression which is searched
+   (not anchored) in the sub type of the message. A literal one is searched
+   as a substring, and a bad pattern never matches. */
+static bool
+is_sub_type_match(struct pcintr_observer *observer, const char *sub_type)
+{
+    if (observer->sub_type == NULL || sub_type == NULL) {
+        return observer->sub_type == sub_type;
+    }
+
+    if (observer->sub_type_literal) {
+        return strstr(sub_type, observer->sub_type) != NULL;
+    }
+
+    return observer->sub_type_regex &&
+        pcregex_match_ex(observer->sub_type_regex, sub_type, 0, NULL);
+}
+
 
 
 void
@@ -156,16 +323,90 @@ bool
 pcintr_is_observer_match(struct pcintr_observer *observer,
         purc_variant_t observed, purc_atom_t type_atom, const char *sub_type)
 {
-    if ((is_variant_match_observe(observer->observed, observed)) &&
-                (observer->msg_type_atom == type_atom)) {
-        if (observer->sub_type == sub_type ||
-                pcregex_is_match(observer->sub_type, sub_type)) {
-            return true;
-        }
+    if ((observer->msg_type_atom == type_atom) &&
+            is_variant_match_observe(observer->observed, observed)) {
+        return is_sub_type_match(observer, sub_type);
     }
     return false;
 }
 
+static struct pcintr_observer *
+next_matched_observer(struct pcintr_observer_iterator *it)
+{
+    while (true) {
+        struct pcintr_observer *p = NULL;
+        int from = -1;
+
+        /* merge the two slots in the order of registration */
+        for (int i = 0; i < 2; i++) {
+            if (it->slots[i] == NULL || it->next[i] == it->slots[i])
+                continue;
+
+            struct pcintr_observer *q;
+            q = list_entry(it->next[i], struct pcintr_observer, index_node);
+            if (p == NULL || q->seq < p->seq) {
+                p = q;
+                from = i;
+            }
+        }
+
+        if (p == NULL)
+            break;
+
+        it->next[from] = it->next[from]->next;
+        if (p->list == it->list && pcintr_is_observer_match(p,
+                    it->observed, it->type_atom, it->sub_type)) {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+struct pcintr_observer *
+pcintr_first_matched_observer(pcintr_stack_t stack, purc_variant_t observed,
+        purc_atom_t type_atom, const char *sub_type,
+        struct pcintr_observer_iterator *it)
+{
+    struct pcintr_observer_index *index = &stack->observer_index;
+
+    memset(it, 0, sizeof(*it));
+    if (index->slots == NULL) {
+        return NULL;
+    }
+
+    it->list = pcintr_get_observer_list(stack, observed);
+    it->observed = observed;
+    it->type_atom = type_atom;
+    it->sub_type = sub_type;
+
+    /* the observers equal to the observed value, and the ones which
+       match the observed values by their own rules */
+    it->slots[0] = observer_index_slot(index, type_atom, true,
+            observed_hash(observed));
+    it->slots[1] = observer_index_slot(index, type_atom, false, 0);
+    if (it->slots[1] == it->slots[0]) {
+        it->slots[1] = NULL;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (it->slots[i])
+            it->next[i] = it->slots[i]->next;
+    }
+
+    return next_matched_observer(it);
+}
+
+struct pcintr_observer *
+pcintr_next_matched_observer(struct pcintr_observer_iterator *it)
+{
+    if (it->list == NULL) {
+        return NULL;
+    }
+
+    return next_matched_observer(it);
+}
+
 
 
 
@@ -211,6 +452,28 @@ pcintr_register_observer(pcintr_stack_t stack,
     observer->sub_type = sub_type ? strdup(sub_type) : NULL;
     observer->on_revoke = on_revoke;
     observer->on_revoke_data = on_revoke_data;
+
+    if (sub_type) {
+        observer->sub_type_literal =
+            (strpbrk(sub_type, REGEX_METACHARS) == NULL);
+        if (!observer->sub_type_literal) {
+            observer->sub_type_regex = pcregex_new_ex(sub_type,
+                    PCREGEX_OPTIMIZE, 0);
+            if (observer->sub_type_regex == NULL) {
+                /* a bad pattern never matches */
+                purc_clr_error();
+            }
+        }
+    }
+
+    if (add_observer_into_index(stack, observer)) {
+        free(observer->sub_type);
+        PURC_VARIANT_SAFE_CLEAR(observer->observed);
+        if (observer->sub_type_regex)
+            pcregex_destroy(observer->sub_type_regex);
+        free(observer);
+        return NULL;
+    }
     add_observer_into_list(stack, list, observer);
 
     // observe idle
@@ -249,13 +512,11 @@ void
 pcintr_revoke_observer_ex(pcintr_stack_t stack, purc_variant_t observed,
         purc_atom_t msg_type_atom, const char *sub_type)
 {
-    struct list_head* list = pcintr_get_observer_list(stack, observed);
-    struct pcintr_observer *p, *n;
-    list_for_each_entry_safe(p, n, list, node) {
-        if (pcintr_is_observer_match(p, observed, msg_type_atom, sub_type)) {
-            pcintr_revoke_observer(p);
-            break;
-        }
+    struct pcintr_observer_iterator it;
+    struct pcintr_observer *p = pcintr_first_matched_observer(stack,
+            observed, msg_type_atom, sub_type, &it);
+    if (p) {
+        pcintr_revoke_observer(p);
     }
 }
 
@@ -75,6 +75,8 @@ pcrdr_msg *pcintr_rdr_send_request_and_wait_response(struct pcrdr_conn *conn,
         const char *property, pcrdr_msg_data_type data_type,
         purc_variant_t data, size_t data_len)
 {
+    pcintr_rdr_sync_dom_ops();
+
     pcrdr_msg *response_msg = NULL;
     pcrdr_msg *msg = pcrdr_make_request_message(
             target,                             /* target */
@@ -815,6 +817,10 @@ rdr_page_control_load_large_page(struct pcrdr_conn *conn,
     }
 
 writting:
+    /* only the response to the last write is returned */
+    pcrdr_release_message(response_msg);
+    response_msg = NULL;
+
     len_to_write = 0;
     if (len_wrotten + DEF_LEN_ONE_WRITE > len_content) {
         // writeEnd
@@ -947,6 +953,8 @@ pcintr_rdr_page_control_load(pcintr_stack_t stack)
         response_msg = rdr_page_control_load_large_page(inst->conn_to_rdr,
                     target, target_value, data_type,
                     p, sz_content);
+        /* the pieces of the content were sent as static strings */
+        purc_variant_unref(req_data);
     }
     else {
         response_msg = pcintr_rdr_send_request_and_wait_response(
@@ -1098,11 +1106,116 @@ failed:
     return ret;
 }
 
+struct pcintr_rdr_dom_op {
+    struct list_head        ln;
+    pcdoc_operation         op;
+    uint64_t                element;
+    char                   *property;
+    pcrdr_msg_data_type     data_type;
+    purc_variant_t          data;
+};
+
+static void
+release_dom_op(struct pcintr_rdr_dom_op *dom_op)
+{
+    list_del(&dom_op->ln);
+    if (dom_op->property)
+        free(dom_op->property);
+    PURC_VARIANT_SAFE_CLEAR(dom_op->data);
+    free(dom_op);
+}
+
+static inline bool
+is_same_property(const char *a, const char *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    return strcmp(a, b) == 0;
+}
+
+/* takes the ownership of data */
+static bool
+queue_dom_op(pcintr_coroutine_t co, pcdoc_operation op,
+        pcdoc_element_t element, const char *property,
+        pcrdr_msg_data_type data_type, purc_variant_t data)
+{
+    struct pcintr_heap *heap = co->owner;
+    struct pcintr_rdr_dom_op *dom_op;
+    uint64_t handle = (uint64_t)(uintptr_t)element;
+
+    if (property && op == PCDOC_OP_DISPLACE) {
+        // VW: use 'update' operation when displace property
+        op = PCDOC_OP_UPDATE;
+    }
+
+    /* the operation supersedes the last queued one if both displace
+       the content or update the same property of the same element */
+    if ((op == PCDOC_OP_DISPLACE || op == PCDOC_OP_UPDATE) &&
+            !list_empty(&co->dom_ops)) {
+        dom_op = list_last_entry(&co->dom_ops, struct pcintr_rdr_dom_op, ln);
+        if (dom_op->op == op && dom_op->element == handle &&
+                is_same_property(dom_op->property, property)) {
+            PURC_VARIANT_SAFE_CLEAR(dom_op->data);
+            dom_op->data_type = data_type;
+            dom_op->data = data;
+            return true;
+        }
+    }
+
+    dom_op = calloc(1, sizeof(*dom_op));
+    if (dom_op == NULL)
+        goto failed;
+
+    if (property) {
+        dom_op->property = strdup(property);
+        if (dom_op->property == NULL) {
+            free(dom_op);
+            goto failed;
+        }
+    }
+
+    dom_op->op = op;
+    dom_op->element = handle;
+    dom_op->data_type = data_type;
+    dom_op->data = data;
+
+    if (list_empty(&co->dom_ops)) {
+        co->dom_ops_since = pcintr_get_current_time();
+        list_add_tail(&co->dom_ops_ln, &heap->dom_ops_cos);
+    }
+    list_add_tail(&dom_op->ln, &co->dom_ops);
+    co->nr_dom_ops++;
+
+    if (co->nr_dom_ops >= heap->max_dom_ops) {
+        pcintr_rdr_flush_dom_ops(co);
+    }
+    return true;
+
+failed:
+    if (data)
+        purc_variant_unref(data);
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return false;
+}
+
+static inline bool
+is_dom_req_queued(pcintr_stack_t stack)
+{
+    return stack && stack->co->owner->max_dom_ops > 0 &&
+        stack->co->target_page_handle != 0 &&
+        stack->co->stage == CO_STAGE_OBSERVING;
+}
+
 bool
 pcintr_rdr_send_dom_req_simple(pcintr_stack_t stack, pcdoc_operation op,
         pcdoc_element_t element, const char *property,
         pcrdr_msg_data_type data_type, purc_variant_t data)
 {
+    if (is_dom_req_queued(stack)) {
+        return queue_dom_op(stack->co, op, element, property,
+                data_type, data);
+    }
+
     pcrdr_msg *response_msg = pcintr_rdr_send_dom_req(stack, op,
             element, property, data_type, data);
     if (response_msg != NULL) {
@@ -1126,6 +1239,25 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
         data = " ";
         len = 1;
     }
+
+    if (is_dom_req_queued(stack)) {
+        purc_variant_t req_data;
+        if (data_type == PCRDR_MSG_DATA_TYPE_JSON) {
+            req_data = purc_variant_make_from_json_string(data, len);
+        }
+        else {  /* VW: for other data types */
+            req_data = purc_variant_make_string(data, false);
+        }
+
+        if (req_data == PURC_VARIANT_INVALID) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+
+        return queue_dom_op(stack->co, op, element, property,
+                data_type, req_data);
+    }
+
     pcrdr_msg *response_msg = pcintr_rdr_send_dom_req_raw(stack, op,
             element, property, data_type, data, len);
 
@@ -1136,3 +1268,179 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
     return false;
 }
 
+/* posts a `rdrState:domError` event to the coroutine if it is alive */
+static void
+post_dom_error(purc_atom_t cid, unsigned int ret_code, size_t nr_dropped)
+{
+    pcintr_coroutine_t co = pcintr_coroutine_get_by_id(cid);
+    if (co == NULL)
+        return;
+
+    purc_variant_t data = purc_variant_make_object_0();
+    if (data) {
+        purc_variant_t v = purc_variant_make_ulongint(ret_code);
+        if (v) {
+            purc_variant_object_set_by_static_ckey(data, "retCode", v);
+            purc_variant_unref(v);
+        }
+
+        if (nr_dropped > 0) {
+            v = purc_variant_make_ulongint(nr_dropped);
+            if (v) {
+                purc_variant_object_set_by_static_ckey(data, "dropped", v);
+                purc_variant_unref(v);
+            }
+        }
+    }
+
+    purc_variant_t hvml = pcintr_get_coroutine_variable(co,
+            PURC_PREDEF_VARNAME_CRTN);
+    pcintr_coroutine_post_event(cid, PCRDR_MSG_EVENT_REDUCE_OPT_KEEP,
+            hvml, MSG_TYPE_RDR_STATE, MSG_SUB_TYPE_DOM_ERROR,
+            data ? data : PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    PURC_VARIANT_SAFE_CLEAR(data);
+}
+
+static int
+dom_op_response_handler(pcrdr_conn* conn,
+        const char *request_id, int state,
+        void *context, const pcrdr_msg *response_msg)
+{
+    UNUSED_PARAM(conn);
+    UNUSED_PARAM(request_id);
+
+    /* the connection is being freed */
+    if (state == PCRDR_RESPONSE_CANCELLED)
+        return 0;
+
+    struct pcintr_heap *heap = pcintr_get_heap();
+    if (heap && heap->nr_dom_acks > 0)
+        heap->nr_dom_acks--;
+
+    unsigned int ret_code = PCRDR_SC_CALLEE_TIMEOUT;
+    if (state == PCRDR_RESPONSE_RESULT) {
+        ret_code = response_msg->retCode;
+        if (ret_code == PCRDR_SC_OK)
+            return 0;
+    }
+
+    post_dom_error((purc_atom_t)(uintptr_t)context, ret_code, 0);
+    return 0;
+}
+
+void
+pcintr_rdr_flush_dom_ops(pcintr_coroutine_t co)
+{
+    if (list_empty(&co->dom_ops))
+        return;
+
+    struct pcintr_heap *heap = co->owner;
+    struct pcinst *inst = pcinst_current();
+    struct pcrdr_conn *conn = inst->conn_to_rdr;
+
+    /* the renderer or the page has gone */
+    if (conn == NULL || co->target_page_handle == 0) {
+        pcintr_rdr_drop_dom_ops(co);
+        return;
+    }
+
+    /* Pipeline the operations: send them one after another without waiting
+       for the responses; the responses are dispatched by the scheduler. */
+    void *context = (void *)(uintptr_t)co->cid;
+    unsigned int ret_code = PCRDR_SC_OK;
+    size_t nr_dropped = 0;
+    while (!list_empty(&co->dom_ops)) {
+        struct pcintr_rdr_dom_op *dom_op;
+        dom_op = list_first_entry(&co->dom_ops, struct pcintr_rdr_dom_op, ln);
+
+        char elem[LEN_BUFF_LONGLONGINT];
+        snprintf(elem, sizeof(elem), "%llx",
+                (unsigned long long int)dom_op->element);
+
+        pcrdr_msg *msg = pcrdr_make_request_message(
+                PCRDR_MSG_TARGET_DOM,               /* target */
+                co->target_dom_handle,              /* target_value */
+                rdr_ops[dom_op->op],                /* operation */
+                NULL,                               /* request_id */
+                NULL,                               /* source_uri */
+                PCRDR_MSG_ELEMENT_TYPE_HANDLE,      /* element_type */
+                elem,                               /* element */
+                dom_op->property,                   /* property */
+                PCRDR_MSG_DATA_TYPE_VOID,           /* data_type */
+                NULL,                               /* data */
+                0                                   /* data_len */
+                );
+        if (msg == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            ret_code = PCRDR_SC_INSUFFICIENT_STORAGE;
+            break;
+        }
+
+        /* the message takes the ownership of the data */
+        msg->dataType = dom_op->data_type;
+        msg->data = dom_op->data;
+        dom_op->data = PURC_VARIANT_INVALID;
+        release_dom_op(dom_op);
+        co->nr_dom_ops--;
+
+        int ret = pcrdr_send_request(conn, msg, PCRDR_TIME_DEF_EXPECTED,
+                context, dom_op_response_handler);
+        pcrdr_release_message(msg);
+        if (ret < 0) {
+            ret_code = PCRDR_SC_IOERR;
+            nr_dropped++;
+            break;
+        }
+        heap->nr_dom_acks++;
+    }
+
+    /* the operations left if failed to send */
+    nr_dropped += co->nr_dom_ops;
+    pcintr_rdr_drop_dom_ops(co);
+
+    /* Failed to send: the connection will be checked by the scheduler.
+       Tell the coroutine the number of the operations lost, including the
+       one failed to send, by a single `rdrState:domError` event. */
+    if (ret_code != PCRDR_SC_OK)
+        post_dom_error(co->cid, ret_code, nr_dropped);
+}
+
+void
+pcintr_rdr_check_dom_ops(pcintr_coroutine_t co)
+{
+    if (list_empty(&co->dom_ops))
+        return;
+
+    if (co->state != CO_STATE_READY || co->stack.exited ||
+            pcintr_get_current_time() - co->dom_ops_since >=
+            PCINTR_MAX_DOM_OPS_DELAY) {
+        pcintr_rdr_flush_dom_ops(co);
+    }
+}
+
+void
+pcintr_rdr_sync_dom_ops(void)
+{
+    struct pcinst *inst = pcinst_current();
+    struct pcintr_heap *heap = inst ? inst->intr_heap : NULL;
+    if (heap == NULL)
+        return;
+
+    pcintr_coroutine_t co, next;
+    list_for_each_entry_safe(co, next, &heap->dom_ops_cos, dom_ops_ln) {
+        pcintr_rdr_flush_dom_ops(co);
+    }
+}
+
+void
+pcintr_rdr_drop_dom_ops(pcintr_coroutine_t co)
+{
+    while (!list_empty(&co->dom_ops)) {
+        struct pcintr_rdr_dom_op *dom_op;
+        dom_op = list_first_entry(&co->dom_ops, struct pcintr_rdr_dom_op, ln);
+        release_dom_op(dom_op);
+    }
+
+    co->nr_dom_ops = 0;
+    list_del_init(&co->dom_ops_ln);
+}
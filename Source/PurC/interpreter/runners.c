@@ -316,11 +316,10 @@ void pcrun_request_handler(pcrdr_conn* conn, const pcrdr_msg *msg)
 
     const char *request_id;
     request_id = purc_variant_get_string_const(msg->requestId);
-    if (strcmp(request_id, PCRDR_REQUESTID_NORETURN)) {
-        purc_inst_move_message(requester, response);
+    if (strcmp(request_id, PCRDR_REQUESTID_NORETURN) == 0 ||
+            purc_inst_move_message(requester, response) == 0) {
+        pcrdr_release_message(response);
     }
-
-    pcrdr_release_message(response);
 }
 
 pcrdr_msg *pcrun_extra_message_source(pcrdr_conn* conn, void *ctxt)
@@ -361,9 +360,8 @@ pcrun_notify_instmgr(const char* event_name, purc_atom_t inst_crtn_id)
     // move the event message to instance manager
     if (purc_inst_move_message(instmgr, event) == 0) {
         purc_log_error("no instance manager\n");
+        pcrdr_release_message(event);
     }
-
-    pcrdr_release_message(event);
 }
 
 static void create_instance(struct instmgr_info *mgr_info,
@@ -622,15 +620,14 @@ void pcrun_instmgr_handle_message(void *ctxt)
 {
     struct instmgr_info *info = ctxt;
 
-    size_t n;
-    int ret = purc_inst_holding_messages_count(&n);
-    if (ret) {
-        purc_log_error("Failed to check messages in move buffer: %d\n", ret);
+    // wait 1ms at most to take a breath; wake up once a message arrives
+    ssize_t n = pcinst_wait_for_moved_messages(1);
+    if (n < 0) {
+        purc_log_error("Failed to check messages in move buffer: %d\n",
+                purc_get_last_error());
         return;
     }
     else if (n == 0) {
-        // sleep 1ms to take a breath
-        pcutils_usleep(1000);
         return;
     }
 
@@ -685,10 +682,10 @@ void pcrun_instmgr_handle_message(void *ctxt)
 
         const char *request_id;
         request_id = purc_variant_get_string_const(msg->requestId);
-        if (strcmp(request_id, PCRDR_REQUESTID_NORETURN)) {
-            purc_inst_move_message(requester, response);
+        if (strcmp(request_id, PCRDR_REQUESTID_NORETURN) == 0 ||
+                purc_inst_move_message(requester, response) == 0) {
+            pcrdr_release_message(response);
         }
-        pcrdr_release_message(response);
     }
     else if (msg->type == PCRDR_MSG_TYPE_EVENT) {
         const char *event_name;
@@ -725,8 +722,9 @@ void pcrun_instmgr_handle_message(void *ctxt)
                             NULL,
                             PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
 
-                    purc_inst_move_message(info->rid_main, request_msg);
-                    pcrdr_release_message(request_msg);
+                    if (purc_inst_move_message(info->rid_main,
+                                request_msg) == 0)
+                        pcrdr_release_message(request_msg);
                 }
             }
         }
@@ -857,8 +855,8 @@ purc_inst_create_or_get(const char *app_name, const char *runner_name,
     request->dataType = PCRDR_MSG_DATA_TYPE_JSON;
     request->data = data;
     size_t n = purc_inst_move_message(atom, request);
-    pcrdr_release_message(request);
     if (n == 0) {
+        pcrdr_release_message(request);
         purc_log_warn("Failed to send request message\n");
         return 0;
     }
@@ -996,8 +994,8 @@ purc_inst_schedule_vdom(purc_atom_t inst, purc_vdom_t vdom,
 
     purc_variant_t request_id = purc_variant_ref(request_msg->requestId);
     size_t n = purc_inst_move_message(inst, request_msg);
-    pcrdr_release_message(request_msg);
     if (n == 0) {
+        pcrdr_release_message(request_msg);
         purc_log_warn("Failed to send request message\n");
         return 0;
     }
@@ -1052,8 +1050,8 @@ purc_inst_ask_to_shutdown(purc_atom_t inst)
 
     purc_variant_t request_id = purc_variant_ref(request_msg->requestId);
     size_t n = purc_inst_move_message(inst, request_msg);
-    pcrdr_release_message(request_msg);
     if (n == 0) {
+        pcrdr_release_message(request_msg);
         purc_log_warn("Failed to send request message\n");
         return PCRDR_SC_OK;
     }
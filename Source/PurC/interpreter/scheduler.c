@@ -38,6 +38,8 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <poll.h>
+#include <time.h>
 
 #include <sys/time.h>
 
@@ -99,11 +101,12 @@ handle_rdr_conn_lost(struct pcinst *inst)
     // pcrdr_disconnect(inst->conn_to_rdr);
     pcrdr_free_connection(inst->conn_to_rdr);
     inst->conn_to_rdr = NULL;
+    heap->nr_dom_acks = 0;
 }
 
 
-void
-pcintr_check_after_execution_full(struct pcinst *inst, pcintr_coroutine_t co)
+static void
+check_after_execution(struct pcinst *inst, pcintr_coroutine_t co)
 {
     bool one_run = false;
     pcintr_stack_t stack = &co->stack;
@@ -289,42 +292,114 @@ pcintr_check_after_execution_full(struct pcinst *inst, pcintr_coroutine_t co)
     }
 }
 
-static void
-execute_one_step_for_ready_co(struct pcinst *inst, pcintr_coroutine_t co)
+void
+pcintr_check_after_execution_full(struct pcinst *inst, pcintr_coroutine_t co)
 {
-    UNUSED_PARAM(inst);
-    UNUSED_PARAM(co);
+    check_after_execution(inst, co);
+
+    /* a step or yield boundary */
+    pcintr_rdr_check_dom_ops(co);
+}
+
+static uint64_t
+get_monotonic_usec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// execute the steps of a ready coroutine until it is not ready any more
+// (blocked, yielded, or exited) or it uses up its quantum
+// return the number of steps executed
+static size_t
+execute_steps_for_ready_co(struct pcinst *inst, pcintr_coroutine_t co)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    uint64_t deadline = 0;
+    size_t nr_steps = 0;
 
     pcintr_set_current_co(co);
 
-    pcintr_coroutine_set_state(co, CO_STATE_RUNNING);
-    pcintr_execute_one_step_for_ready_co(co);
-    pcintr_check_after_execution_full(inst, co);
+    while (1) {
+        pcintr_coroutine_set_state(co, CO_STATE_RUNNING);
+        pcintr_execute_one_step_for_ready_co(co);
+        pcintr_check_after_execution_full(inst, co);
+        nr_steps++;
+
+        if (co->state != CO_STATE_READY)
+            break;
+
+        if (nr_steps >= heap->quantum_steps) {
+            heap->sched_stats.nr_preemptions++;
+            break;
+        }
+
+        // only read the clock when the coroutine keeps ready after a step;
+        // the quantum is counted from the end of its first step
+        uint64_t now = get_monotonic_usec();
+        if (deadline == 0) {
+            deadline = now + heap->quantum_usec;
+        }
+        else if (now >= deadline) {
+            heap->sched_stats.nr_preemptions++;
+            break;
+        }
+    }
 
     pcintr_set_current_co(NULL);
+    return nr_steps;
 }
 
-// execute one step for all ready coroutines of the inst
+// execute a quantum for all ready coroutines of the inst
 // return whether busy
 static bool
 execute_one_step(struct pcinst *inst)
 {
     struct pcintr_heap *heap = inst->intr_heap;
-    struct rb_root *coroutines = &heap->coroutines;
-    struct rb_node *p, *n;
-    struct rb_node *first = pcutils_rbtree_first(coroutines);
-    bool busy = false;
-    pcutils_rbtree_for_each_safe(first, p, n) {
-        pcintr_coroutine_t co = container_of(p, struct pcintr_coroutine,
-                node);
+    size_t nr_executed = 0;
+    size_t nr_steps = 0;
+
+    if (heap->polling_schedule) {
+        struct rb_root *coroutines = &heap->coroutines;
+        struct rb_node *p, *n;
+        struct rb_node *first = pcutils_rbtree_first(coroutines);
+        pcutils_rbtree_for_each_safe(first, p, n) {
+            pcintr_coroutine_t co = container_of(p, struct pcintr_coroutine,
+                    node);
+            if (co->state != CO_STATE_READY) {
+                continue;
+            }
+
+            nr_steps += execute_steps_for_ready_co(inst, co);
+            nr_executed++;
+        }
+        goto out;
+    }
+
+    // take over the ready queue; the coroutines becoming ready again
+    // will be queued to heap->ready_cos for the next tick, so every ready
+    // coroutine gets a quantum in turn
+    struct list_head ready_cos;
+    list_head_init(&ready_cos);
+    list_splice_init(&heap->ready_cos, &ready_cos);
+
+    while (!list_empty(&ready_cos)) {
+        pcintr_coroutine_t co = list_first_entry(&ready_cos,
+                struct pcintr_coroutine, ready_ln);
+        list_del_init(&co->ready_ln);
         if (co->state != CO_STATE_READY) {
             continue;
         }
 
-        execute_one_step_for_ready_co(inst, co);
-        busy = true;
+        nr_steps += execute_steps_for_ready_co(inst, co);
+        nr_executed++;
     }
-    return busy;
+
+out:
+    heap->sched_stats.last_ready = nr_executed;
+    heap->sched_stats.nr_steps += nr_steps;
+    return nr_executed > 0;
 }
 
 
@@ -344,6 +419,13 @@ check_and_dispatch_event_from_conn(struct pcinst *inst)
 
         pcrdr_wait_and_dispatch_message(conn, 0);
 
+        /* consume the acknowledgements to the pipelined DOM operations */
+        struct pcintr_heap *heap = inst->intr_heap;
+        while (heap->nr_dom_acks > 0) {
+            if (pcrdr_wait_and_dispatch_message(conn, 0))
+                break;
+        }
+
         int err = purc_get_last_error();
         if (err == PCRDR_ERROR_IO || err == PCRDR_ERROR_PEER_CLOSED) {
             handle_rdr_conn_lost(inst);
@@ -457,6 +539,12 @@ out:
     return busy;
 }
 
+static inline bool
+has_pending_event(pcintr_coroutine_t co)
+{
+    return !list_empty(&co->tasks) || pcinst_msg_queue_count(co->mq) > 0;
+}
+
 static bool
 dispatch_event(struct pcinst *inst)
 {
@@ -466,27 +554,130 @@ dispatch_event(struct pcinst *inst)
     check_and_dispatch_event_from_conn(inst);
 
     bool co_is_busy = false;
+    size_t nr_visited = 0;
     struct pcintr_heap *heap = inst->intr_heap;
-    struct rb_root *coroutines = &heap->coroutines;
-    struct rb_node *p, *n;
-    struct rb_node *first = pcutils_rbtree_first(coroutines);
-    pcutils_rbtree_for_each_safe(first, p, n) {
-        pcintr_coroutine_t co;
-        co = container_of(p, struct pcintr_coroutine, node);
+
+    if (heap->polling_schedule) {
+        struct rb_root *coroutines = &heap->coroutines;
+        struct rb_node *p, *n;
+        struct rb_node *first = pcutils_rbtree_first(coroutines);
+        pcutils_rbtree_for_each_safe(first, p, n) {
+            pcintr_coroutine_t co;
+            co = container_of(p, struct pcintr_coroutine, node);
+            co_is_busy = handle_coroutine_event(co);
+            nr_visited++;
+
+            if (co->stack.exited && co->stack.last_msg_read) {
+                pcintr_run_exiting_co(co);
+            }
+
+            if (co_is_busy) {
+                is_busy = true;
+            }
+        }
+        goto out;
+    }
+
+    // only visit the coroutines which have messages or tasks
+    struct list_head pending_cos;
+    list_head_init(&pending_cos);
+    list_splice_init(&heap->pending_cos, &pending_cos);
+
+    while (!list_empty(&pending_cos)) {
+        pcintr_coroutine_t co = list_first_entry(&pending_cos,
+                struct pcintr_coroutine, pending_ln);
+        list_del_init(&co->pending_ln);
+
         co_is_busy = handle_coroutine_event(co);
+        nr_visited++;
+
+        if (co_is_busy) {
+            is_busy = true;
+        }
 
         if (co->stack.exited && co->stack.last_msg_read) {
+            /* the coroutine will be destroyed */
             pcintr_run_exiting_co(co);
+            continue;
         }
 
-        if (co_is_busy) {
-            is_busy = true;
+        if (has_pending_event(co)) {
+            pcintr_coroutine_set_pending(co);
         }
     }
 
+out:
+    heap->sched_stats.last_pending = nr_visited;
+    heap->sched_stats.nr_dispatches += nr_visited;
     return is_busy;
 }
 
+/* wait for at most `usec` microseconds until a message arrives */
+static void
+wait_for_events(struct pcinst *inst, unsigned long usec)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    struct pollfd fds[2];
+    nfds_t nfds = 0;
+
+    int fd = pcinst_move_buffer_event_fd(false);
+    if (fd >= 0) {
+        fds[nfds].fd = fd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+
+    struct pcrdr_conn *conn = inst->conn_to_rdr;
+    if (conn) {
+        purc_rdrprot_t prot = pcrdr_conn_protocol(conn);
+        int conn_fd = pcrdr_conn_socket_fd(conn);
+        if ((prot == PURC_RDRPROT_PURCMC || prot == PURC_RDRPROT_HIBUS) &&
+                conn_fd >= 0) {
+            fds[nfds].fd = conn_fd;
+            fds[nfds].events = POLLIN;
+            nfds++;
+        }
+    }
+
+    heap->sched_stats.nr_idle_waits++;
+    if (nfds == 0) {
+        pcutils_usleep(usec);
+        return;
+    }
+
+    if (poll(fds, nfds, (int)(usec / 1000)) > 0) {
+        heap->sched_stats.nr_wakeups++;
+        if (fd >= 0 && (fds[0].revents & POLLIN)) {
+            pcinst_move_buffer_event_fd(true);
+        }
+    }
+}
+
+/* whether there are messages left in the move buffer of the instance */
+static bool
+has_moved_messages(struct pcinst *inst)
+{
+    size_t n = 0;
+
+    /* the messages in the move buffer are fetched through the connection */
+    if (inst->conn_to_rdr == NULL)
+        return false;
+
+    if (purc_inst_holding_messages_count(&n)) {
+        purc_clr_error();
+        return false;
+    }
+
+    return n > 0;
+}
+
+const struct pcintr_sched_stats *
+pcintr_get_sched_stats(void)
+{
+    struct pcintr_heap *heap = pcintr_get_heap();
+    return heap ? &heap->sched_stats : NULL;
+}
+
 void
 pcintr_schedule(void *ctxt)
 {
@@ -501,6 +692,7 @@ pcintr_schedule(void *ctxt)
         goto out_sleep;
     }
 
+    heap->sched_stats.nr_ticks++;
 
     // 1. exec one step for all ready coroutines and
     // return whether step is busy
@@ -515,6 +707,12 @@ pcintr_schedule(void *ctxt)
         goto out;
     }
 
+    // 4. there are still coroutines or moved messages to handle
+    if (!heap->polling_schedule && (!list_empty(&heap->ready_cos) ||
+                has_moved_messages(inst))) {
+        goto out;
+    }
+
     // 5. broadcast idle event
     double now = pcintr_get_current_time();
     if (now - IDLE_EVENT_TIMEOUT > heap->timestamp) {
@@ -522,6 +720,14 @@ pcintr_schedule(void *ctxt)
         pcintr_update_timestamp(inst);
     }
 
+    if (heap->polling_schedule) {
+        goto out_sleep;
+    }
+
+    // 6. wait until a new message arrives or timeout
+    wait_for_events(inst, SCHEDULE_SLEEP);
+    goto out;
+
 out_sleep:
     pcutils_usleep(SCHEDULE_SLEEP);
 
@@ -191,9 +191,18 @@ static bool mgr_change_handler(purc_variant_t source, pcvar_op_t msg_type,
     return true;
 }
 
+static inline void bump_var_generation(void)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst)
+        inst->var_generation++;
+}
+
 static bool mgr_handler(purc_variant_t source, pcvar_op_t msg_type,
         void* ctxt, size_t nr_args, purc_variant_t* argv)
 {
+    bump_var_generation();
+
     switch (msg_type) {
     case PCVAR_OPERATION_GROW:
         return mgr_grow_handler(source, msg_type, ctxt, nr_args, argv);
@@ -266,6 +275,7 @@ int pcvarmgr_destroy(pcvarmgr_t mgr)
         }
         purc_variant_unref(mgr->object);
         free(mgr);
+        bump_var_generation();
     }
     return 0;
 }
@@ -359,156 +369,280 @@ bool pcvarmgr_dispatch_except(pcvarmgr_t mgr, const char* name,
     return true;
 }
 
-static purc_variant_t
-_find_named_scope_var_in_vdom(purc_coroutine_t cor,
-        pcvdom_element_t elem, const char* name, pcvarmgr_t* mgr)
+purc_variant_t
+purc_get_runner_variable(const char* name)
 {
-    if (!elem || !name) {
-        PC_ASSERT(name); // FIXME: still recoverable???
-        purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
+    if (!name) {
         return PURC_VARIANT_INVALID;
     }
 
-    purc_variant_t v;
-
-again:
+    pcvarmgr_t varmgr = pcinst_get_variables();
+    if (varmgr == NULL) {
+        return PURC_VARIANT_INVALID;
+    }
 
-    v = pcintr_get_scope_variable(cor, elem, name);
+    purc_variant_t v = pcvarmgr_get(varmgr, name);
     if (v) {
-        if (mgr) {
-            *mgr = pcintr_get_scope_variables(cor, elem);
-        }
         return v;
     }
-
-    elem = pcvdom_element_parent(elem);
-    if (elem)
-        goto again;
-
     purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
     return PURC_VARIANT_INVALID;
 }
 
-static purc_variant_t
-_find_named_scope_var(purc_coroutine_t cor,
-        struct pcintr_stack_frame *frame, const char* name, pcvarmgr_t* mgr)
-{
-    if (frame->scope)
-        return _find_named_scope_var_in_vdom(cor, frame->scope, name, mgr);
-
-    pcvdom_element_t elem = frame->pos;
+/* the number of the caches in a stack; must be a power of 2 */
+#define NR_VAR_CACHES           128
 
-    if (!elem || !name) {
-        PC_ASSERT(name); // FIXME: still recoverable???
-        purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
-        return PURC_VARIANT_INVALID;
-    }
-
-    purc_variant_t v;
+/*
+ * The caches live in the stack of a coroutine, so they are used by only one
+ * thread and never thrashed by the other coroutines evaluating the same
+ * vDOM. A cache is taken by the hash of the node getting the variable; the
+ * node which takes a cache last owns it.
+ */
+struct pcintr_var_cache {
+    /* the node owning this cache; used only as the key */
+    const void                 *node;
+    /* the generation of the variables when the name was resolved */
+    uint64_t                    generation;
+    char                       *name;
+
+    /* the manager which holds the variable, NULL if not resolved */
+    pcvarmgr_t                  mgr;
+    /* whether the manager belongs to the last one of the scopes */
+    bool                        in_scope;
+
+    /* the scopes walked through to reach the manager */
+    pcvdom_element_t           *scopes;
+    size_t                      nr_scopes;
+    size_t                      sz_scopes;
+};
 
-again:
+/*
+ * Walks the scopes of a frame: the positions of the frame and its parent
+ * frames, until a frame with an explicit scope is met; then that element
+ * and its ancestors in the vDOM.
+ */
+struct scope_walker {
+    /* NULL when walking through the ancestors in the vDOM */
+    struct pcintr_stack_frame  *frame;
+    pcvdom_element_t            elem;
+};
 
-    v = pcintr_get_scope_variable(cor, elem, name);
-    if (v) {
-        if (mgr) {
-            *mgr = pcintr_get_scope_variables(cor, elem);
-        }
-        return v;
+static pcvdom_element_t
+scope_walker_enter(struct scope_walker *walker,
+        struct pcintr_stack_frame *frame)
+{
+    if (frame->scope) {
+        walker->frame = NULL;
+        walker->elem = frame->scope;
+    }
+    else {
+        walker->frame = frame;
+        walker->elem = frame->pos;
     }
+    return walker->elem;
+}
 
-    frame = pcintr_stack_frame_get_parent(frame);
-    if (frame) {
-        if (frame->scope)
-            return _find_named_scope_var_in_vdom(cor, frame->scope, name, mgr);
+static pcvdom_element_t
+scope_walker_next(struct scope_walker *walker)
+{
+    if (walker->frame == NULL) {
+        /* pcvdom_element_parent() sets an error for the root */
+        walker->elem = (pcvdom_element_t)pcvdom_node_parent(
+                pcvdom_ele_cast_to_node(walker->elem));
+        return walker->elem;
+    }
 
-        elem = frame->pos;
-        if (elem)
-            goto again;
+    struct pcintr_stack_frame *parent;
+    parent = pcintr_stack_frame_get_parent(walker->frame);
+    if (parent == NULL) {
+        walker->elem = NULL;
+        return NULL;
     }
 
-    purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
-    return PURC_VARIANT_INVALID;
+    return scope_walker_enter(walker, parent);
+}
+
+static inline purc_variant_t
+get_var_silently(pcvarmgr_t mgr, const char *name)
+{
+    return pcvariant_object_get_by_ckey_ex(mgr->object, name, true);
 }
 
 static purc_variant_t
-find_cor_level_var(purc_coroutine_t cor, const char* name)
+find_named_temp_var(struct pcintr_stack_frame *frame, const char *name)
 {
-    PC_ASSERT(name);
-    if (!cor) {
-        purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
-        return PURC_VARIANT_INVALID;
-    }
+    for (; frame; frame = pcintr_stack_frame_get_parent(frame)) {
+        // not pcintr_get_exclamation_var(): do not create `$!` here
+        purc_variant_t tmp;
+        tmp = pcintr_get_symbol_var(frame, PURC_SYMBOL_VAR_EXCLAMATION);
+        if (tmp == PURC_VARIANT_INVALID || !purc_variant_is_object(tmp))
+            continue;
 
-    purc_variant_t v = purc_coroutine_get_variable(cor, name);
-    if (v) {
-        return v;
+        purc_variant_t v = pcvariant_object_get_by_ckey_ex(tmp, name, true);
+        if (v)
+            return v;
     }
-    purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
+
     return PURC_VARIANT_INVALID;
 }
 
-purc_variant_t
-purc_get_runner_variable(const char* name)
+static bool
+cache_add_scope(struct pcintr_var_cache *cache, pcvdom_element_t elem)
 {
-    if (!name) {
-        return PURC_VARIANT_INVALID;
+    if (cache->nr_scopes == cache->sz_scopes) {
+        size_t sz = cache->sz_scopes ? cache->sz_scopes * 2 : 8;
+        pcvdom_element_t *scopes = (pcvdom_element_t *)realloc(cache->scopes,
+                sizeof(pcvdom_element_t) * sz);
+        if (!scopes)
+            return false;
+
+        cache->scopes = scopes;
+        cache->sz_scopes = sz;
     }
 
-    pcvarmgr_t varmgr = pcinst_get_variables();
-    if (varmgr == NULL) {
-        return PURC_VARIANT_INVALID;
+    cache->scopes[cache->nr_scopes++] = elem;
+    return true;
+}
+
+/*
+ * Resolves the name in the scopes of the frame, then at the coroutine level
+ * and the runner level, without setting any error. Records where the name
+ * was found in the cache if it is not NULL.
+ */
+static purc_variant_t
+find_named_var(pcintr_stack_t stack, struct pcintr_stack_frame *frame,
+        const char *name, struct pcintr_var_cache *cache)
+{
+    purc_coroutine_t cor = stack->co;
+    purc_variant_t v = PURC_VARIANT_INVALID;
+    pcvarmgr_t mgr;
+    bool cacheable = (cache != NULL);
+
+    if (cache) {
+        cache->mgr = NULL;
+        cache->in_scope = false;
+        cache->nr_scopes = 0;
+    }
+
+    struct scope_walker walker;
+    pcvdom_element_t elem = scope_walker_enter(&walker, frame);
+    for (; elem; elem = scope_walker_next(&walker)) {
+        if (cacheable && !cache_add_scope(cache, elem))
+            cacheable = false;
+
+        mgr = pcintr_get_scope_variables(cor, elem);
+        if (mgr && (v = get_var_silently(mgr, name))) {
+            if (cacheable) {
+                cache->mgr = mgr;
+                cache->in_scope = true;
+            }
+            return v;
+        }
     }
 
-    purc_variant_t v = pcvarmgr_get(varmgr, name);
-    if (v) {
-        return v;
+    if (cor && cor->vdom) {
+        mgr = pcintr_get_coroutine_variables(cor);
+        if ((v = get_var_silently(mgr, name)))
+            goto found;
     }
-    purc_set_error_with_info(PCVARIANT_ERROR_NOT_FOUND, "name:%s", name);
+
+    mgr = pcinst_get_variables();
+    if (mgr && (v = get_var_silently(mgr, name)))
+        goto found;
+
     return PURC_VARIANT_INVALID;
+
+found:
+    if (cacheable)
+        cache->mgr = mgr;
+    return v;
 }
 
-static inline purc_variant_t
-find_inst_var(const char *name)
+/* Checks whether the frame walks through the same scopes as recorded */
+static bool
+cache_match_scopes(struct pcintr_var_cache *cache,
+        struct pcintr_stack_frame *frame)
 {
-    return purc_get_runner_variable(name);
+    struct scope_walker walker;
+    pcvdom_element_t elem = scope_walker_enter(&walker, frame);
+    for (size_t i = 0; i < cache->nr_scopes; i++) {
+        if (elem != cache->scopes[i])
+            return false;
+        elem = scope_walker_next(&walker);
+    }
+
+    /* the name was found after all the scopes were walked through */
+    return cache->in_scope || elem == NULL;
 }
 
 static purc_variant_t
-_find_named_temp_var(struct pcintr_stack_frame *frame, const char *name)
+find_named_var_in_cache(struct pcintr_stack_frame *frame, const char *name,
+        struct pcintr_var_cache *cache)
 {
-    struct pcintr_stack_frame *p = frame;
-
-again:
+    struct pcinst *inst = pcinst_current();
 
-    if (p == NULL) {
-        purc_set_error(PURC_ERROR_ENTITY_NOT_FOUND);
+    if (cache->mgr == NULL ||
+            cache->generation != inst->var_generation ||
+            strcmp(cache->name, name) ||
+            !cache_match_scopes(cache, frame))
         return PURC_VARIANT_INVALID;
-    }
 
-    do {
-        purc_variant_t tmp;
-        tmp = pcintr_get_exclamation_var(p);
-        if (tmp == PURC_VARIANT_INVALID)
-            break;
+    return get_var_silently(cache->mgr, name);
+}
 
-        if (purc_variant_is_object(tmp) == false)
-            break;
+static struct pcintr_var_cache *
+get_var_cache(pcintr_stack_t stack, const void *node)
+{
+    if (stack->var_caches == NULL) {
+        stack->var_caches = (struct pcintr_var_cache *)calloc(NR_VAR_CACHES,
+                sizeof(struct pcintr_var_cache));
+        if (stack->var_caches == NULL)
+            return NULL;
+    }
 
-        purc_variant_t v;
-        v = purc_variant_object_get_by_ckey(tmp, name);
-        if (v == PURC_VARIANT_INVALID)
-            break;
+    /* the nodes are allocated on the heap: skip the aligned bits */
+    uintptr_t h = (uintptr_t)node;
+    h = (h >> 4) ^ (h >> 11);
 
-        return v;
-    } while (0);
+    struct pcintr_var_cache *c = stack->var_caches + (h & (NR_VAR_CACHES - 1));
+    if (c->node != node) {
+        c->node = node;
+        c->mgr = NULL;
+    }
+    return c;
+}
 
-    p = pcintr_stack_frame_get_parent(p);
+static struct pcintr_var_cache *
+prepare_var_cache(struct pcintr_var_cache *c, const char *name)
+{
+    if (c->name == NULL || strcmp(c->name, name)) {
+        free(c->name);
+        c->name = strdup(name);
+        if (c->name == NULL) {
+            c->mgr = NULL;
+            return NULL;
+        }
+    }
 
-    goto again;
+    return c;
+}
+
+void
+pcintr_release_var_caches(pcintr_stack_t stack)
+{
+    if (stack->var_caches) {
+        for (size_t i = 0; i < NR_VAR_CACHES; i++) {
+            free(stack->var_caches[i].name);
+            free(stack->var_caches[i].scopes);
+        }
+        free(stack->var_caches);
+        stack->var_caches = NULL;
+    }
 }
 
 purc_variant_t
-pcintr_find_named_var(pcintr_stack_t stack, const char* name)
+pcintr_find_named_var_cached(pcintr_stack_t stack, const char* name,
+        const void *node)
 {
     if (!stack || !name) {
         PC_ASSERT(0); // FIXME: still recoverable???
@@ -518,27 +652,33 @@ pcintr_find_named_var(pcintr_stack_t stack, const char* name)
     struct pcintr_stack_frame* frame = pcintr_stack_get_bottom_frame(stack);
     PC_ASSERT(frame);
 
+    /* the temporary variables change too often to be cached */
     purc_variant_t v;
-    v = _find_named_temp_var(frame, name);
+    v = find_named_temp_var(frame, name);
     if (v) {
         purc_clr_error();
         return v;
     }
 
-    v = _find_named_scope_var(stack->co, frame, name, NULL);
-    if (v) {
-        purc_clr_error();
-        return v;
-    }
+    struct pcintr_var_cache *c = NULL;
+    if (node) {
+        c = get_var_cache(stack, node);
+        if (c) {
+            v = find_named_var_in_cache(frame, name, c);
+            if (v) {
+                purc_clr_error();
+                return v;
+            }
 
-    v = find_cor_level_var(stack->co, name);
-    if (v) {
-        purc_clr_error();
-        return v;
+            c = prepare_var_cache(c, name);
+        }
     }
 
-    v = find_inst_var(name);
+    v = find_named_var(stack, frame, name, c);
     if (v) {
+        if (c) {
+            c->generation = pcinst_current()->var_generation;
+        }
         purc_clr_error();
         return v;
     }
@@ -547,6 +687,12 @@ pcintr_find_named_var(pcintr_stack_t stack, const char* name)
     return PURC_VARIANT_INVALID;
 }
 
+purc_variant_t
+pcintr_find_named_var(pcintr_stack_t stack, const char* name)
+{
+    return pcintr_find_named_var_cached(stack, name, NULL);
+}
+
 enum purc_symbol_var _to_symbol(char symbol)
 {
     switch (symbol) {
@@ -592,7 +738,11 @@ pcintr_get_symbolized_var (pcintr_stack_t stack, unsigned int number,
         return PURC_VARIANT_INVALID;
     }
 
-    purc_variant_t v = pcintr_get_symbol_var(frame, symbol_var);
+    purc_variant_t v;
+    if (symbol_var == PURC_SYMBOL_VAR_EXCLAMATION)
+        v = pcintr_get_exclamation_var(frame);
+    else
+        v = pcintr_get_symbol_var(frame, symbol_var);
     PC_ASSERT(v != PURC_VARIANT_INVALID);
     if (v != PURC_VARIANT_INVALID) {
         purc_clr_error();
@@ -658,7 +808,7 @@ again:
 
     do {
         purc_variant_t tmp;
-        tmp = pcintr_get_exclamation_var(p);
+        tmp = pcintr_get_symbol_var(p, PURC_SYMBOL_VAR_EXCLAMATION);
         if (tmp == PURC_VARIANT_INVALID)
             break;
 
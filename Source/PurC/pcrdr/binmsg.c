@@ -0,0 +1,598 @@
+/*
+ * binmsg.c -- The implementation of the binary encoding of
+ *      the PurCMC messages.
+ *
+ * Copyright (c) 2022 FMSoft (http://www.fmsoft.cn)
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "private/pcrdr.h"
+#include "private/instance.h"
+#include "private/variant.h"
+#include "private/debug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+/*
+ * The layout of a message in the binary encoding:
+ *
+ *  - the fixed-layout header (struct bin_header);
+ *  - the string fields: the name of the operation (only if the operation
+ *    is not a well-known one) or the event, the request identifier,
+ *    the source URI, the element, and the property. Every field is
+ *    a uint32_t length followed by the bytes; FIELD_ABSENT stands for
+ *    a null field;
+ *  - the data: a tree of tagged values for JSON, or a length-prefixed
+ *    string for the other data types.
+ */
+#define BIN_MAGIC           0x42434D50  /* "PMCB" */
+
+/* the operation is given by name */
+#define OP_NAMED            0xFFFF
+
+#define FIELD_ABSENT        0xFFFFFFFF
+
+struct bin_header {
+    uint32_t    magic;
+    uint8_t     version;
+    uint8_t     type;
+    uint8_t     target;
+    uint8_t     element_type;
+    uint8_t     data_type;
+    uint8_t     reduce_opt;
+    uint16_t    op_id;
+    uint32_t    ret_code;
+    uint64_t    target_value;
+    uint64_t    result_value;
+};
+
+/* the tags of the binary values */
+enum {
+    BIN_VT_NULL = 0,
+    BIN_VT_UNDEFINED,
+    BIN_VT_FALSE,
+    BIN_VT_TRUE,
+    BIN_VT_NUMBER,
+    BIN_VT_LONGINT,
+    BIN_VT_ULONGINT,
+    BIN_VT_LONGDOUBLE,
+    BIN_VT_STRING,
+    BIN_VT_BSEQUENCE,
+    BIN_VT_OBJECT,
+    BIN_VT_ARRAY,
+};
+
+static void write_field(pcrdr_cb_write fn, void *ctxt,
+        const char *str, size_t len)
+{
+    uint32_t u32;
+
+    if (str == NULL) {
+        u32 = FIELD_ABSENT;
+        fn(ctxt, &u32, sizeof(u32));
+    }
+    else {
+        u32 = (uint32_t)len;
+        fn(ctxt, &u32, sizeof(u32));
+        if (len > 0)
+            fn(ctxt, str, len);
+    }
+}
+
+static void write_string_field(pcrdr_cb_write fn, void *ctxt,
+        purc_variant_t v)
+{
+    const char *str = NULL;
+    size_t len = 0;
+
+    if (v)
+        str = purc_variant_get_string_const_ex(v, &len);
+    write_field(fn, ctxt, str, len);
+}
+
+static int write_value(pcrdr_cb_write fn, void *ctxt,
+        purc_variant_t v, int level)
+{
+    uint8_t tag;
+    uint32_t u32;
+    const char *str;
+    size_t len;
+
+    if (level > MAX_EMBEDDED_LEVELS)
+        return PCRDR_ERROR_TOO_LARGE;
+
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_UNDEFINED:
+        tag = BIN_VT_UNDEFINED;
+        fn(ctxt, &tag, sizeof(tag));
+        break;
+
+    case PURC_VARIANT_TYPE_BOOLEAN:
+        tag = v->b ? BIN_VT_TRUE : BIN_VT_FALSE;
+        fn(ctxt, &tag, sizeof(tag));
+        break;
+
+    case PURC_VARIANT_TYPE_NUMBER:
+        tag = BIN_VT_NUMBER;
+        fn(ctxt, &tag, sizeof(tag));
+        fn(ctxt, &v->d, sizeof(v->d));
+        break;
+
+    case PURC_VARIANT_TYPE_LONGINT:
+        tag = BIN_VT_LONGINT;
+        fn(ctxt, &tag, sizeof(tag));
+        fn(ctxt, &v->i64, sizeof(v->i64));
+        break;
+
+    case PURC_VARIANT_TYPE_ULONGINT:
+        tag = BIN_VT_ULONGINT;
+        fn(ctxt, &tag, sizeof(tag));
+        fn(ctxt, &v->u64, sizeof(v->u64));
+        break;
+
+    case PURC_VARIANT_TYPE_LONGDOUBLE:
+        tag = BIN_VT_LONGDOUBLE;
+        fn(ctxt, &tag, sizeof(tag));
+        fn(ctxt, &v->ld, sizeof(v->ld));
+        break;
+
+    case PURC_VARIANT_TYPE_STRING:
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+    case PURC_VARIANT_TYPE_EXCEPTION:
+        if (v->type == PURC_VARIANT_TYPE_STRING) {
+            str = purc_variant_get_string_const_ex(v, &len);
+        }
+        else {
+            str = (v->type == PURC_VARIANT_TYPE_ATOMSTRING) ?
+                purc_variant_get_atom_string_const(v) :
+                purc_variant_get_exception_string_const(v);
+            len = str ? strlen(str) : 0;
+        }
+
+        tag = BIN_VT_STRING;
+        fn(ctxt, &tag, sizeof(tag));
+        write_field(fn, ctxt, str ? str : "", len);
+        break;
+
+    case PURC_VARIANT_TYPE_BSEQUENCE: {
+        const unsigned char *bytes = purc_variant_get_bytes_const(v, &len);
+
+        tag = BIN_VT_BSEQUENCE;
+        fn(ctxt, &tag, sizeof(tag));
+        u32 = (uint32_t)len;
+        fn(ctxt, &u32, sizeof(u32));
+        if (len > 0)
+            fn(ctxt, bytes, len);
+        break;
+    }
+
+    case PURC_VARIANT_TYPE_OBJECT: {
+        purc_variant_t key, val;
+        int errcode = 0;
+
+        purc_variant_object_size(v, &len);
+        tag = BIN_VT_OBJECT;
+        fn(ctxt, &tag, sizeof(tag));
+        u32 = (uint32_t)len;
+        fn(ctxt, &u32, sizeof(u32));
+
+        foreach_key_value_in_variant_object(v, key, val)
+            write_string_field(fn, ctxt, key);
+            if ((errcode = write_value(fn, ctxt, val, level + 1)))
+                break;
+        end_foreach;
+
+        if (errcode)
+            return errcode;
+        break;
+    }
+
+    /* like the plain JSON, sets and tuples are encoded as arrays */
+    case PURC_VARIANT_TYPE_ARRAY:
+    case PURC_VARIANT_TYPE_SET:
+    case PURC_VARIANT_TYPE_TUPLE:
+        purc_variant_linear_container_size(v, &len);
+        tag = BIN_VT_ARRAY;
+        fn(ctxt, &tag, sizeof(tag));
+        u32 = (uint32_t)len;
+        fn(ctxt, &u32, sizeof(u32));
+
+        for (size_t i = 0; i < len; i++) {
+            int errcode = write_value(fn, ctxt,
+                    purc_variant_linear_container_get(v, i), level + 1);
+            if (errcode)
+                return errcode;
+        }
+        break;
+
+    default:
+        /* null, dynamic, and native values */
+        tag = BIN_VT_NULL;
+        fn(ctxt, &tag, sizeof(tag));
+        break;
+    }
+
+    return 0;
+}
+
+int pcrdr_serialize_message_bin(const pcrdr_msg *msg, pcrdr_cb_write fn,
+        void *ctxt)
+{
+    struct bin_header header;
+    purc_variant_t name = PURC_VARIANT_INVALID;
+    int errcode = 0;
+
+    if (msg->type != PCRDR_MSG_TYPE_REQUEST &&
+            msg->type != PCRDR_MSG_TYPE_RESPONSE &&
+            msg->type != PCRDR_MSG_TYPE_EVENT) {
+        errcode = PCRDR_ERROR_BAD_MESSAGE;
+        goto failed;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = BIN_MAGIC;
+    header.version = PCRDR_BIN_MESSAGE_VERSION;
+    header.type = msg->type;
+    header.target = msg->target;
+    header.element_type = msg->elementType;
+    header.data_type = msg->dataType;
+    header.reduce_opt = msg->reduceOpt;
+    header.op_id = OP_NAMED;
+    header.ret_code = msg->retCode;
+    header.target_value = msg->targetValue;
+    header.result_value = msg->resultValue;
+
+    if (msg->type == PCRDR_MSG_TYPE_REQUEST) {
+        const char *op = purc_variant_get_string_const(msg->operation);
+        purc_atom_t op_atom = op ? pcrdr_try_operation_atom(op) : 0;
+        unsigned int op_id;
+
+        if (op_atom && pcrdr_operation_from_atom(op_atom, &op_id))
+            header.op_id = (uint16_t)op_id;
+        else
+            name = msg->operation;
+    }
+    else if (msg->type == PCRDR_MSG_TYPE_EVENT) {
+        name = msg->eventName;
+    }
+
+    fn(ctxt, &header, sizeof(header));
+    write_string_field(fn, ctxt, name);
+    write_string_field(fn, ctxt, msg->requestId);
+    write_string_field(fn, ctxt, msg->sourceURI);
+    write_string_field(fn, ctxt,
+            (msg->elementType != PCRDR_MSG_ELEMENT_TYPE_VOID) ?
+            msg->elementValue : PURC_VARIANT_INVALID);
+    write_string_field(fn, ctxt, msg->property);
+
+    if (msg->dataType == PCRDR_MSG_DATA_TYPE_VOID) {
+        // do nothing
+    }
+    else if (msg->dataType == PCRDR_MSG_DATA_TYPE_JSON) {
+        if (msg->data) {
+            errcode = write_value(fn, ctxt, msg->data, 0);
+        }
+        else {
+            uint8_t tag = BIN_VT_NULL;
+            fn(ctxt, &tag, sizeof(tag));
+        }
+    }
+    else {  /* for other text types */
+        const char *text = NULL;
+        size_t text_len = 0;
+
+        if (msg->data)
+            text = purc_variant_get_string_const_ex(msg->data, &text_len);
+        if (text && msg->textLen > 0)   /* override by textLen */
+            text_len = msg->textLen;
+        write_field(fn, ctxt, text ? text : "", text_len);
+    }
+
+    if (errcode == 0)
+        return 0;
+
+failed:
+    purc_set_error(errcode);
+    return -1;
+}
+
+struct bin_reader {
+    const unsigned char *p;
+    const unsigned char *end;
+};
+
+static inline bool read_bytes(struct bin_reader *rd, void *buf, size_t sz)
+{
+    if ((size_t)(rd->end - rd->p) < sz)
+        return false;
+
+    memcpy(buf, rd->p, sz);
+    rd->p += sz;
+    return true;
+}
+
+/* returns false for a bad field; *str is NULL for an absent field */
+static bool read_field(struct bin_reader *rd, const char **str, size_t *len)
+{
+    uint32_t u32;
+
+    if (!read_bytes(rd, &u32, sizeof(u32)))
+        return false;
+
+    if (u32 == FIELD_ABSENT) {
+        *str = NULL;
+        *len = 0;
+        return true;
+    }
+
+    if ((size_t)(rd->end - rd->p) < u32)
+        return false;
+
+    *str = (const char *)rd->p;
+    *len = u32;
+    rd->p += u32;
+    return true;
+}
+
+static bool read_string_field(struct bin_reader *rd, purc_variant_t *v)
+{
+    const char *str;
+    size_t len;
+
+    if (!read_field(rd, &str, &len))
+        return false;
+
+    if (str) {
+        *v = purc_variant_make_string_ex(str, len, true);
+        if (*v == PURC_VARIANT_INVALID)
+            return false;
+    }
+
+    return true;
+}
+
+static purc_variant_t read_value(struct bin_reader *rd, int level)
+{
+    purc_variant_t v = PURC_VARIANT_INVALID;
+    uint8_t tag;
+    uint32_t u32;
+
+    if (level > MAX_EMBEDDED_LEVELS || !read_bytes(rd, &tag, sizeof(tag)))
+        return PURC_VARIANT_INVALID;
+
+    switch (tag) {
+    case BIN_VT_NULL:
+        v = purc_variant_make_null();
+        break;
+
+    case BIN_VT_UNDEFINED:
+        v = purc_variant_make_undefined();
+        break;
+
+    case BIN_VT_FALSE:
+    case BIN_VT_TRUE:
+        v = purc_variant_make_boolean(tag == BIN_VT_TRUE);
+        break;
+
+    case BIN_VT_NUMBER: {
+        double d;
+        if (read_bytes(rd, &d, sizeof(d)))
+            v = purc_variant_make_number(d);
+        break;
+    }
+
+    case BIN_VT_LONGINT: {
+        int64_t i64;
+        if (read_bytes(rd, &i64, sizeof(i64)))
+            v = purc_variant_make_longint(i64);
+        break;
+    }
+
+    case BIN_VT_ULONGINT: {
+        uint64_t u64;
+        if (read_bytes(rd, &u64, sizeof(u64)))
+            v = purc_variant_make_ulongint(u64);
+        break;
+    }
+
+    case BIN_VT_LONGDOUBLE: {
+        long double ld;
+        if (read_bytes(rd, &ld, sizeof(ld)))
+            v = purc_variant_make_longdouble(ld);
+        break;
+    }
+
+    case BIN_VT_STRING: {
+        const char *str;
+        size_t len;
+        if (read_field(rd, &str, &len) && str)
+            v = purc_variant_make_string_ex(str, len, true);
+        break;
+    }
+
+    case BIN_VT_BSEQUENCE:
+        if (!read_bytes(rd, &u32, sizeof(u32)) ||
+                (size_t)(rd->end - rd->p) < u32)
+            break;
+
+        if (u32 > 0)
+            v = purc_variant_make_byte_sequence(rd->p, u32);
+        else
+            v = purc_variant_make_byte_sequence_empty();
+        rd->p += u32;
+        break;
+
+    case BIN_VT_OBJECT:
+        if (!read_bytes(rd, &u32, sizeof(u32)))
+            break;
+
+        v = purc_variant_make_object_0();
+        for (uint32_t i = 0; v && i < u32; i++) {
+            purc_variant_t key = PURC_VARIANT_INVALID, val;
+
+            if (!read_string_field(rd, &key) || key == PURC_VARIANT_INVALID) {
+                purc_variant_unref(v);
+                v = PURC_VARIANT_INVALID;
+                break;
+            }
+
+            val = read_value(rd, level + 1);
+            if (val == PURC_VARIANT_INVALID ||
+                    !purc_variant_object_set(v, key, val)) {
+                purc_variant_unref(v);
+                v = PURC_VARIANT_INVALID;
+            }
+
+            purc_variant_unref(key);
+            if (val)
+                purc_variant_unref(val);
+        }
+        break;
+
+    case BIN_VT_ARRAY:
+        if (!read_bytes(rd, &u32, sizeof(u32)))
+            break;
+
+        v = purc_variant_make_array_0();
+        for (uint32_t i = 0; v && i < u32; i++) {
+            purc_variant_t val = read_value(rd, level + 1);
+
+            if (val == PURC_VARIANT_INVALID ||
+                    !purc_variant_array_append(v, val)) {
+                purc_variant_unref(v);
+                v = PURC_VARIANT_INVALID;
+            }
+
+            if (val)
+                purc_variant_unref(val);
+        }
+        break;
+
+    default:
+        PC_DEBUG("Bad tag of binary value: %d\n", tag);
+        break;
+    }
+
+    return v;
+}
+
+int pcrdr_parse_packet_bin(const void *packet, size_t sz_packet,
+        pcrdr_msg **msg_out)
+{
+    struct bin_reader rd = { packet, (const unsigned char *)packet + sz_packet };
+    struct bin_header header;
+    purc_variant_t name = PURC_VARIANT_INVALID;
+    pcrdr_msg *msg;
+
+    if ((msg = pcinst_get_message()) == NULL) {
+        purc_set_error(PCRDR_ERROR_NOMEM);
+        return -1;
+    }
+
+    if (!read_bytes(&rd, &header, sizeof(header)) ||
+            header.magic != BIN_MAGIC ||
+            header.version != PCRDR_BIN_MESSAGE_VERSION ||
+            header.type < PCRDR_MSG_TYPE_REQUEST ||
+            header.type > PCRDR_MSG_TYPE_EVENT ||
+            header.target >= PCRDR_MSG_TARGET_NR ||
+            header.element_type >= PCRDR_MSG_ELEMENT_TYPE_NR ||
+            header.data_type >= PCRDR_MSG_DATA_TYPE_NR) {
+        goto failed;
+    }
+
+    msg->type = header.type;
+    msg->target = header.target;
+    msg->elementType = header.element_type;
+    msg->dataType = header.data_type;
+    msg->reduceOpt = header.reduce_opt;
+    msg->retCode = header.ret_code;
+    msg->targetValue = header.target_value;
+    msg->resultValue = header.result_value;
+
+    if (!read_string_field(&rd, &name))
+        goto failed;
+
+    if (msg->type == PCRDR_MSG_TYPE_REQUEST) {
+        if (header.op_id != OP_NAMED) {
+            const char *op = pcrdr_operation_name(header.op_id);
+            if (op == NULL)
+                goto failed;
+            msg->operation = purc_variant_make_string_static(op, false);
+        }
+        else {
+            msg->operation = name;
+            name = PURC_VARIANT_INVALID;
+        }
+
+        if (msg->operation == PURC_VARIANT_INVALID)
+            goto failed;
+    }
+    else if (msg->type == PCRDR_MSG_TYPE_EVENT) {
+        if (name == PURC_VARIANT_INVALID)
+            goto failed;
+        msg->eventName = name;
+        name = PURC_VARIANT_INVALID;
+    }
+
+    if (!read_string_field(&rd, &msg->requestId) ||
+            !read_string_field(&rd, &msg->sourceURI) ||
+            !read_string_field(&rd, &msg->elementValue) ||
+            !read_string_field(&rd, &msg->property)) {
+        goto failed;
+    }
+
+    if (msg->dataType == PCRDR_MSG_DATA_TYPE_VOID) {
+        // do nothing
+    }
+    else if (msg->dataType == PCRDR_MSG_DATA_TYPE_JSON) {
+        msg->data = read_value(&rd, 0);
+        if (msg->data == PURC_VARIANT_INVALID)
+            goto failed;
+    }
+    else {  /* for other text types */
+        const char *text;
+        size_t text_len;
+
+        if (!read_field(&rd, &text, &text_len) || text == NULL)
+            goto failed;
+
+        msg->data = purc_variant_make_string_ex(text, text_len, true);
+        if (msg->data == PURC_VARIANT_INVALID)
+            goto failed;
+        msg->__data_len = text_len;
+    }
+
+    if (rd.p != rd.end)
+        goto failed;
+
+    *msg_out = msg;
+    return 0;
+
+failed:
+    if (name)
+        purc_variant_unref(name);
+    pcrdr_release_message(msg);
+
+    purc_set_error(PCRDR_ERROR_BAD_MESSAGE);
+    return -1;
+}
+
@@ -39,6 +39,156 @@
 #include <errno.h>
 #include <assert.h>
 
+#define MIN_SZ_PENDING_INDEX    16
+
+static inline struct list_head *
+pending_bucket(pcrdr_conn *conn, const char *request_id)
+{
+    size_t hash = pcutils_hash_hash((const unsigned char *)request_id,
+            strlen(request_id));
+    return conn->pending_index + (hash & (conn->sz_pending_index - 1));
+}
+
+static int
+grow_pending_index(pcrdr_conn *conn)
+{
+    size_t sz = conn->sz_pending_index ?
+        conn->sz_pending_index * 2 : MIN_SZ_PENDING_INDEX;
+    struct list_head *index = malloc(sizeof(*index) * sz);
+    if (index == NULL)
+        return -1;
+
+    for (size_t i = 0; i < sz; i++)
+        list_head_init(&index[i]);
+
+    free(conn->pending_index);
+    conn->pending_index = index;
+    conn->sz_pending_index = sz;
+
+    /* rehash all pending requests */
+    struct pending_request *pr;
+    list_for_each_entry(pr, &conn->pending_requests, list) {
+        list_add_tail(&pr->hash_ln, pending_bucket(conn,
+                    purc_variant_get_string_const(pr->request_id)));
+    }
+
+    return 0;
+}
+
+static inline void
+set_timeout_slot(pcrdr_conn *conn, size_t idx, struct pending_request *pr)
+{
+    conn->pending_timeouts[idx] = pr;
+    pr->heap_idx = idx;
+}
+
+static void
+sift_up_timeout(pcrdr_conn *conn, size_t idx)
+{
+    struct pending_request *pr = conn->pending_timeouts[idx];
+
+    while (idx > 0) {
+        size_t parent = (idx - 1) / 2;
+        if (conn->pending_timeouts[parent]->time_expected <= pr->time_expected)
+            break;
+        set_timeout_slot(conn, idx, conn->pending_timeouts[parent]);
+        idx = parent;
+    }
+
+    set_timeout_slot(conn, idx, pr);
+}
+
+static void
+sift_down_timeout(pcrdr_conn *conn, size_t idx)
+{
+    size_t nr = conn->nr_pending_requests;
+    struct pending_request *pr = conn->pending_timeouts[idx];
+
+    while (true) {
+        size_t child = idx * 2 + 1;
+        if (child >= nr)
+            break;
+        if (child + 1 < nr && conn->pending_timeouts[child + 1]->time_expected
+                < conn->pending_timeouts[child]->time_expected)
+            child++;
+        if (pr->time_expected <= conn->pending_timeouts[child]->time_expected)
+            break;
+        set_timeout_slot(conn, idx, conn->pending_timeouts[child]);
+        idx = child;
+    }
+
+    set_timeout_slot(conn, idx, pr);
+}
+
+/* Puts a pending request to the queue (at the head if `first` is true),
+   the hash index, and the timeout heap. */
+static int
+add_pending_request(pcrdr_conn *conn, struct pending_request *pr, bool first)
+{
+    if (conn->nr_pending_requests >= conn->sz_pending_timeouts) {
+        size_t sz = conn->sz_pending_timeouts ?
+            conn->sz_pending_timeouts * 2 : MIN_SZ_PENDING_INDEX;
+        struct pending_request **heap = realloc(conn->pending_timeouts,
+                sizeof(*heap) * sz);
+        if (heap == NULL)
+            goto failed;
+        conn->pending_timeouts = heap;
+        conn->sz_pending_timeouts = sz;
+    }
+
+    if (conn->nr_pending_requests >= conn->sz_pending_index &&
+            grow_pending_index(conn))
+        goto failed;
+
+    if (first)
+        list_add(&pr->list, &conn->pending_requests);
+    else
+        list_add_tail(&pr->list, &conn->pending_requests);
+    list_add_tail(&pr->hash_ln, pending_bucket(conn,
+                purc_variant_get_string_const(pr->request_id)));
+
+    conn->pending_timeouts[conn->nr_pending_requests] = pr;
+    sift_up_timeout(conn, conn->nr_pending_requests++);
+    return 0;
+
+failed:
+    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return -1;
+}
+
+static void
+remove_pending_request(pcrdr_conn *conn, struct pending_request *pr)
+{
+    list_del(&pr->list);
+    list_del(&pr->hash_ln);
+
+    size_t idx = pr->heap_idx;
+    size_t last = --conn->nr_pending_requests;
+    if (idx != last) {
+        struct pending_request *moved = conn->pending_timeouts[last];
+        set_timeout_slot(conn, idx, moved);
+        sift_down_timeout(conn, idx);
+        sift_up_timeout(conn, moved->heap_idx);
+    }
+}
+
+static struct pending_request *
+find_pending_request(pcrdr_conn *conn, const char *request_id)
+{
+    if (conn->nr_pending_requests == 0)
+        return NULL;
+
+    struct pending_request *pr;
+    struct list_head *bucket = pending_bucket(conn, request_id);
+    list_for_each_entry(pr, bucket, hash_ln) {
+        if (strcmp(purc_variant_get_string_const(pr->request_id),
+                    request_id) == 0)
+            return pr;
+    }
+
+    return NULL;
+}
+
 pcrdr_extra_message_source
 pcrdr_conn_get_extra_message_source(pcrdr_conn* conn, void **ctxt)
 {
@@ -151,13 +301,7 @@ int pcrdr_conn_set_poll_timeout(pcrdr_conn* conn, int timeout_ms)
 
 size_t pcrdr_conn_pending_requests_count(pcrdr_conn* conn)
 {
-    size_t n = 0;
-    struct pending_request *pr;
-    list_for_each_entry(pr, &conn->pending_requests, list) {
-        n++;
-    }
-
-    return n;
+    return conn->nr_pending_requests;
 }
 
 int pcrdr_free_connection(pcrdr_conn* conn)
@@ -175,11 +319,13 @@ int pcrdr_free_connection(pcrdr_conn* conn)
                     purc_variant_get_string_const(pr->request_id),
                     PCRDR_RESPONSE_CANCELLED, pr->context, NULL);
         }
-        list_del(&pr->list);
+        remove_pending_request(conn, pr);
         purc_variant_unref(pr->request_id);
         free(pr);
     }
 
+    free(conn->pending_index);
+    free(conn->pending_timeouts);
     free(conn);
 
     return 0;
@@ -244,7 +390,12 @@ pcrdr_set_handler_for_response_from_extra_source(pcrdr_conn* conn,
         pr->time_expected = purc_get_monotoic_time() + 3600;
     else
         pr->time_expected = purc_get_monotoic_time() + seconds_expected;
-    list_add_tail(&pr->list, &conn->pending_requests);
+
+    if (add_pending_request(conn, pr, false)) {
+        purc_variant_unref(pr->request_id);
+        free(pr);
+        return -1;
+    }
 
     return 0;
 }
@@ -283,59 +434,52 @@ variant_strcmp(purc_variant_t a, purc_variant_t b)
 static int
 handle_response_message(pcrdr_conn* conn, const pcrdr_msg *msg)
 {
-    int retval = -1;
-
-    if (!list_empty(&conn->pending_requests)) {
-        struct pending_request *pr;
-        pr = list_first_entry(&conn->pending_requests,
-                struct pending_request, list);
-
-        if (variant_strcmp(msg->requestId, pr->request_id) == 0) {
-            const char *request_id =
-                purc_variant_get_string_const(msg->requestId);
-            if (pr->response_handler && pr->response_handler(conn,
-                        request_id,
-                        PCRDR_RESPONSE_RESULT, pr->context, msg) < 0) {
-                purc_log_warn("response handler for %s returned failure\n",
-                        request_id);
-            }
-
-            retval = 0;
-            list_del(&pr->list);
-            purc_variant_unref(pr->request_id);
-            free(pr);
-        }
-        else {
-            purc_log_error("response not matched the first pending request\n");
-            purc_set_error(PCRDR_ERROR_UNEXPECTED);
-        }
+    const char *request_id = purc_variant_get_string_const(msg->requestId);
+    if (request_id == NULL) {
+        purc_set_error(PCRDR_ERROR_BAD_MESSAGE);
+        return -1;
     }
-    else {
-        purc_log_error("no pending request?\n");
+
+    /* the responses may arrive in any order */
+    struct pending_request *pr = find_pending_request(conn, request_id);
+    if (pr == NULL) {
+        purc_log_error("no pending request for the response: %s\n",
+                request_id);
         purc_set_error(PCRDR_ERROR_UNEXPECTED);
+        return -1;
     }
 
-    return retval;
+    remove_pending_request(conn, pr);
+    if (pr->response_handler && pr->response_handler(conn, request_id,
+                PCRDR_RESPONSE_RESULT, pr->context, msg) < 0) {
+        purc_log_warn("response handler for %s returned failure\n",
+                request_id);
+    }
+
+    purc_variant_unref(pr->request_id);
+    free(pr);
+    return 0;
 }
 
 static int
 check_timeout_requests(pcrdr_conn *conn)
 {
-    struct pending_request *pr, *n;
     time_t now = purc_get_monotoic_time();
 
-    list_for_each_entry_safe(pr, n, &conn->pending_requests, list) {
-        if (now >= pr->time_expected) {
-            if (pr->response_handler) {
-                pr->response_handler(conn,
-                    purc_variant_get_string_const(pr->request_id),
-                        PCRDR_RESPONSE_TIMEOUT, pr->context, NULL);
-            }
+    while (conn->nr_pending_requests > 0) {
+        struct pending_request *pr = conn->pending_timeouts[0];
+        if (now < pr->time_expected)
+            break;
 
-            list_del(&pr->list);
-            purc_variant_unref(pr->request_id);
-            free(pr);
+        remove_pending_request(conn, pr);
+        if (pr->response_handler) {
+            pr->response_handler(conn,
+                purc_variant_get_string_const(pr->request_id),
+                    PCRDR_RESPONSE_TIMEOUT, pr->context, NULL);
         }
+
+        purc_variant_unref(pr->request_id);
+        free(pr);
     }
 
     return 0;
@@ -510,7 +654,11 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
         pr->time_expected = purc_get_monotoic_time() + 3600;
     else
         pr->time_expected = purc_get_monotoic_time() + seconds_expected;
-    list_add(&pr->list, &conn->pending_requests);
+    if (add_pending_request(conn, pr, true)) {
+        purc_variant_unref(pr->request_id);
+        free(pr);
+        return -1;
+    }
 
     while (*response_msg == NULL) {
         pcrdr_msg *msg;
@@ -560,7 +708,7 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
     }
 
     if (*response_msg == NULL) {
-        list_del(&pr->list);
+        remove_pending_request(conn, pr);
         purc_variant_unref(pr->request_id);
         free(pr);
     }
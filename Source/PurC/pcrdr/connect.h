@@ -33,7 +33,9 @@
 #include "private/list.h"
 
 struct pending_request {
-    struct list_head        list;
+    struct list_head        list;       /* pcrdr_conn::pending_requests */
+    struct list_head        hash_ln;    /* a bucket of pending_index */
+    size_t                  heap_idx;   /* index in pending_timeouts */
 
     purc_variant_t          request_id;
     pcrdr_response_handler  response_handler;
@@ -66,6 +68,15 @@ struct pcrdr_conn {
 
     /* the pending requests queue */
     struct list_head pending_requests;
+    size_t nr_pending_requests;
+
+    /* the pending requests hashed by the request identifiers */
+    struct list_head *pending_index;
+    size_t sz_pending_index;
+
+    /* the min-heap of the pending requests ordered by the expected time */
+    struct pending_request **pending_timeouts;
+    size_t sz_pending_timeouts;
 
     /* operations */
     int (*wait_message) (pcrdr_conn* conn, int timeout_ms);
@@ -1082,26 +1082,26 @@ static void on_load(struct pcrdr_prot_data *prot_data,
 static void on_write_begin(struct pcrdr_prot_data *prot_data,
         const pcrdr_msg *msg, unsigned int op_id, struct result_info *result)
 {
-    void **domdocs = NULL;
+    void **domdocs;
 
     UNUSED_PARAM(op_id);
-    if (find_domdoc_ptr(prot_data, msg, result) == NULL) {
+    if ((domdocs = find_domdoc_ptr(prot_data, msg, result)) == NULL) {
         return;
     }
 
     *domdocs = domdocs;
 
     result->retCode = PCRDR_SC_OK;
-    result->resultValue = msg->targetValue;
+    result->resultValue = (uint64_t)(uintptr_t)domdocs;
 }
 
 static void on_write_more(struct pcrdr_prot_data *prot_data,
         const pcrdr_msg *msg, unsigned int op_id, struct result_info *result)
 {
-    void **domdocs = NULL;
+    void **domdocs;
 
     UNUSED_PARAM(op_id);
-    if (find_domdoc_ptr(prot_data, msg, result) == NULL) {
+    if ((domdocs = find_domdoc_ptr(prot_data, msg, result)) == NULL) {
         return;
     }
 
@@ -1114,16 +1114,16 @@ static void on_write_more(struct pcrdr_prot_data *prot_data,
     *domdocs = domdocs;
 
     result->retCode = PCRDR_SC_OK;
-    result->resultValue = msg->targetValue;
+    result->resultValue = (uint64_t)(uintptr_t)domdocs;
 }
 
 static void on_write_end(struct pcrdr_prot_data *prot_data,
         const pcrdr_msg *msg, unsigned int op_id, struct result_info *result)
 {
-    void **domdocs = NULL;
+    void **domdocs;
 
     UNUSED_PARAM(op_id);
-    if (find_domdoc_ptr(prot_data, msg, result) == NULL) {
+    if ((domdocs = find_domdoc_ptr(prot_data, msg, result)) == NULL) {
         return;
     }
 
@@ -1136,7 +1136,7 @@ static void on_write_end(struct pcrdr_prot_data *prot_data,
     *domdocs = domdocs;
 
     result->retCode = PCRDR_SC_OK;
-    result->resultValue = msg->targetValue;
+    result->resultValue = (uint64_t)(uintptr_t)domdocs;
 }
 
 static void on_operate_dom(struct pcrdr_prot_data *prot_data,
@@ -1266,8 +1266,13 @@ pcrdr_parse_renderer_capabilities(const char *data)
                 rdr_caps->windowLevel = 0;
             }
 #endif
-            PC_WARN("Unknown renderer capability: %s\n", cap);
-            break;
+            if (pcutils_strcasecmp(cap, PCRDR_CAP_BINARY_MESSAGE) == 0) {
+                rdr_caps->binaryMessage = strtol(value, NULL, 10);
+            }
+            else {
+                PC_WARN("Unknown renderer capability: %s\n", cap);
+                break;
+            }
         }
 
         line_no++;
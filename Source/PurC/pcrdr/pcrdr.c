@@ -106,6 +106,14 @@ const char *pcrdr_operation_from_atom(purc_atom_t op_atom, unsigned int *id)
     return NULL;
 }
 
+const char *pcrdr_operation_name(unsigned int id)
+{
+    if (id < PCA_TABLESIZE(pcrdr_opatoms))
+        return pcrdr_opatoms[id].op;
+
+    return NULL;
+}
+
 purc_atom_t pcrdr_try_operation_atom(const char *op)
 {
     return purc_atom_try_string_ex(ATOM_BUCKET_RDROP, op);
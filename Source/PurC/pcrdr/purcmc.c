@@ -27,6 +27,7 @@
 #include "private/list.h"
 #include "private/debug.h"
 #include "private/utils.h"
+#include "private/pcrdr.h"
 #include "purc-utils.h"
 #include "connect.h"
 
@@ -69,6 +70,26 @@ static inline int conn_write (int fd, const void *data, ssize_t sz)
     return PCRDR_ERROR_IO;
 }
 
+struct pcrdr_prot_data {
+    /* the buffer reused to serialize the messages to send */
+    char   *send_buf;
+    size_t  sz_send_buf;
+    size_t  len_send;
+    bool    send_overflow;
+
+    /* the buffer reused to read the packets */
+    char   *recv_buf;
+    size_t  sz_recv_buf;
+
+    /* use the binary encoding of the messages */
+    bool    binary;
+};
+
+static int read_packet_to_buffer (pcrdr_conn* conn,
+        char **buf, size_t *sz_buf, size_t *sz_packet, int *op);
+static int send_packet (pcrdr_conn* conn, int op,
+        const char* data, size_t len);
+
 static int my_wait_message (pcrdr_conn* conn, int timeout_ms)
 {
     fd_set rfds;
@@ -88,13 +109,14 @@ static int my_wait_message (pcrdr_conn* conn, int timeout_ms)
 
 static pcrdr_msg *my_read_message (pcrdr_conn* conn)
 {
-    void* packet;
+    struct pcrdr_prot_data *prot_data = conn->prot_data;
     size_t data_len;
     pcrdr_msg* msg = NULL;
-    int err_code = 0, retval;
+    int err_code, op, retval;
 
-    retval = pcrdr_purcmc_read_packet_alloc (conn, &packet, &data_len);
-    if (retval) {
+    err_code = read_packet_to_buffer (conn, &prot_data->recv_buf,
+            &prot_data->sz_recv_buf, &data_len, &op);
+    if (err_code) {
         PC_DEBUG ("Failed to read packet\n");
         goto done;
     }
@@ -104,8 +126,11 @@ static pcrdr_msg *my_read_message (pcrdr_conn* conn)
         goto done;
     }
 
-    retval = pcrdr_parse_packet (packet, data_len, &msg);
-    free (packet);
+    /* the encoding of the message is told by the type of the frame */
+    if (op == US_OPCODE_BIN)
+        retval = pcrdr_parse_packet_bin (prot_data->recv_buf, data_len, &msg);
+    else
+        retval = pcrdr_parse_packet (prot_data->recv_buf, data_len, &msg);
 
     if (retval < 0) {
         err_code = PCRDR_ERROR_BAD_MESSAGE;
@@ -125,34 +150,70 @@ done:
     return msg;
 }
 
-static int my_send_message (pcrdr_conn* conn, pcrdr_msg *msg)
+static ssize_t write_to_send_buf (void *ctxt, const void *buf, size_t count)
 {
-    int retv = -1;
-    purc_rwstream_t buffer = NULL;
+    struct pcrdr_prot_data *prot_data = ctxt;
+
+    if (prot_data->len_send + count > prot_data->sz_send_buf) {
+        if (prot_data->len_send + count > PCRDR_MAX_INMEM_PAYLOAD_SIZE) {
+            prot_data->send_overflow = true;
+            return 0;
+        }
 
-    buffer = purc_rwstream_new_buffer (PCRDR_MIN_PACKET_BUFF_SIZE,
-            PCRDR_MAX_INMEM_PAYLOAD_SIZE);
+        size_t sz = prot_data->sz_send_buf ?
+            prot_data->sz_send_buf : PCRDR_DEF_PACKET_BUFF_SIZE;
+        while (sz < prot_data->len_send + count)
+            sz <<= 1;
+        if (sz > PCRDR_MAX_INMEM_PAYLOAD_SIZE)
+            sz = PCRDR_MAX_INMEM_PAYLOAD_SIZE;
 
-    if (pcrdr_serialize_message (msg,
-                (pcrdr_cb_write)purc_rwstream_write, buffer) < 0) {
-        goto done;
+        char *new_buf = realloc (prot_data->send_buf, sz);
+        if (new_buf == NULL) {
+            prot_data->send_overflow = true;
+            return 0;
+        }
+
+        prot_data->send_buf = new_buf;
+        prot_data->sz_send_buf = sz;
     }
 
-    size_t packet_len;
-    const char * packet = purc_rwstream_get_mem_buffer (buffer, &packet_len);
+    memcpy (prot_data->send_buf + prot_data->len_send, buf, count);
+    prot_data->len_send += count;
+    return count;
+}
 
-    if (pcrdr_purcmc_send_text_packet (conn, packet, packet_len) < 0) {
-        goto done;
+static int my_send_message (pcrdr_conn* conn, pcrdr_msg *msg)
+{
+    struct pcrdr_prot_data *prot_data = conn->prot_data;
+    int retv;
+
+    prot_data->len_send = 0;
+    prot_data->send_overflow = false;
+
+    if (prot_data->binary)
+        retv = pcrdr_serialize_message_bin (msg, write_to_send_buf, prot_data);
+    else
+        retv = pcrdr_serialize_message (msg, write_to_send_buf, prot_data);
+    if (retv) {
+        /* the text encoder returns an error code */
+        if (retv > 0)
+            purc_set_error (retv);
+        return -1;
     }
 
-    retv = 0;
+    if (prot_data->send_overflow) {
+        purc_set_error (PCRDR_ERROR_TOO_LARGE);
+        return -1;
+    }
 
-done:
-    if (buffer) {
-        purc_rwstream_destroy(buffer);
+    retv = send_packet (conn, prot_data->binary ? US_OPCODE_BIN : US_OPCODE_TEXT,
+            prot_data->send_buf, prot_data->len_send);
+    if (retv) {
+        purc_set_error (retv);
+        return -1;
     }
 
-    return retv;
+    return 0;
 }
 
 static int my_ping_peer (pcrdr_conn* conn)
@@ -210,6 +271,13 @@ static int my_disconnect (pcrdr_conn* conn)
 
     close (conn->fd);
 
+    if (conn->prot_data) {
+        free (conn->prot_data->send_buf);
+        free (conn->prot_data->recv_buf);
+        free (conn->prot_data);
+        conn->prot_data = NULL;
+    }
+
     return err_code;
 }
 
@@ -234,10 +302,21 @@ static int purcmc_connect_via_unix_socket (const char* path_to_socket,
         return -1;
     }
 
+    if (((*conn)->prot_data =
+                calloc (1, sizeof (struct pcrdr_prot_data))) == NULL) {
+        free (*conn);
+        *conn = NULL;
+        purc_set_error(PCRDR_ERROR_NOMEM);
+        return -1;
+    }
+
     /* create a Unix domain stream socket */
     if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0) {
         PC_DEBUG ("Failed to call `socket` in %s: %s\n", __func__,
                 strerror (errno));
+        free ((*conn)->prot_data);
+        free (*conn);
+        *conn = NULL;
         purc_set_error(PCRDR_ERROR_IO);
         return -1;
     }
@@ -309,6 +388,7 @@ error:
 
     if ((*conn)->own_host_name)
        free((*conn)->own_host_name);
+    free((*conn)->prot_data);
     free(*conn);
     *conn = NULL;
 
@@ -450,138 +530,124 @@ done:
     return err_code;
 }
 
-int pcrdr_purcmc_read_packet_alloc (pcrdr_conn* conn, void **packet, size_t *sz_packet)
+/* Reads a packet into the buffer which grows if need be, and returns
+   the opcode of the packet via op. sz_packet is zero for a packet without
+   any data, e.g., a PING packet. For a text packet, a null byte is appended
+   and counted in sz_packet. Returns zero or an error code. */
+static int read_packet_to_buffer (pcrdr_conn* conn,
+        char **buf, size_t *sz_buf, size_t *sz_packet, int *op)
 {
-    char* packet_buf = NULL;
-    int err_code = 0;
-
-    if (conn->type == CT_UNIX_SOCKET) {
-        USFrameHeader header;
+    USFrameHeader header;
+    unsigned int total_len, left, offset;
 
-        if (conn_read (conn->fd, &header, sizeof (USFrameHeader))) {
-            PC_DEBUG ("Failed to read frame header from Unix socket\n");
-            err_code = PCRDR_ERROR_IO;
-            goto done;
-        }
+    if (conn->type == CT_WEB_SOCKET) {
+        /* TODO */
+        return PCRDR_ERROR_NOT_IMPLEMENTED;
+    }
+    else if (conn->type != CT_UNIX_SOCKET) {
+        return PCRDR_ERROR_INVALID_VALUE;
+    }
 
-        if (header.op == US_OPCODE_PONG) {
-            // TODO
-            *packet = NULL;
-            *sz_packet = 0;
-            return 0;
-        }
-        else if (header.op == US_OPCODE_PING) {
-            header.op = US_OPCODE_PONG;
-            header.sz_payload = 0;
-            if (conn_write (conn->fd, &header, sizeof (USFrameHeader))) {
-                err_code = PCRDR_ERROR_IO;
-                goto done;
-            }
+    if (conn_read (conn->fd, &header, sizeof (USFrameHeader))) {
+        PC_DEBUG ("Failed to read frame header from Unix socket\n");
+        return PCRDR_ERROR_IO;
+    }
 
-            *packet = NULL;
-            *sz_packet = 0;
-            return 0;
-        }
-        else if (header.op == US_OPCODE_CLOSE) {
-            PC_INFO ("Peer closed\n");
-            err_code = PCRDR_ERROR_PEER_CLOSED;
-            goto done;
+    *op = header.op;
+    *sz_packet = 0;
+    if (header.op == US_OPCODE_PONG) {
+        // TODO
+        return 0;
+    }
+    else if (header.op == US_OPCODE_PING) {
+        header.op = US_OPCODE_PONG;
+        header.sz_payload = 0;
+        if (conn_write (conn->fd, &header, sizeof (USFrameHeader))) {
+            return PCRDR_ERROR_IO;
         }
-        else if (header.op == US_OPCODE_TEXT ||
-                header.op == US_OPCODE_BIN) {
-            unsigned int total_len, left;
-            unsigned int offset;
-            int is_text;
-
-            if (header.fragmented > PCRDR_MAX_INMEM_PAYLOAD_SIZE) {
-                err_code = PCRDR_ERROR_TOO_LARGE;
-                goto done;
-            }
-
-            if (header.op == US_OPCODE_TEXT) {
-                is_text = 1;
-            }
-            else {
-                is_text = 0;
-            }
-
-            if (header.fragmented > header.sz_payload) {
-                total_len = header.fragmented;
-                offset = header.sz_payload;
-                left = total_len - header.sz_payload;
-            }
-            else {
-                total_len = header.sz_payload;
-                offset = header.sz_payload;
-                left = 0;
-            }
+        return 0;
+    }
+    else if (header.op == US_OPCODE_CLOSE) {
+        PC_INFO ("Peer closed\n");
+        return PCRDR_ERROR_PEER_CLOSED;
+    }
+    else if (header.op != US_OPCODE_TEXT && header.op != US_OPCODE_BIN) {
+        PC_DEBUG ("Bad packet op code: %d\n", header.op);
+        return PCRDR_ERROR_PROTOCOL;
+    }
 
-            if ((packet_buf = malloc (total_len + 1)) == NULL) {
-                err_code = PCRDR_ERROR_NOMEM;
-                goto done;
-            }
+    if (header.fragmented > header.sz_payload) {
+        total_len = header.fragmented;
+    }
+    else {
+        total_len = header.sz_payload;
+    }
+    offset = header.sz_payload;
+    left = total_len - header.sz_payload;
 
-            if (conn_read (conn->fd, packet_buf, header.sz_payload)) {
-                PC_DEBUG ("Failed to read packet from Unix socket\n");
-                err_code = PCRDR_ERROR_IO;
-                goto done;
-            }
+    if (total_len > PCRDR_MAX_INMEM_PAYLOAD_SIZE) {
+        return PCRDR_ERROR_TOO_LARGE;
+    }
 
-            while (left > 0) {
-                if (conn_read (conn->fd, &header, sizeof (USFrameHeader))) {
-                    PC_DEBUG ("Failed to read frame header from Unix socket\n");
-                    err_code = PCRDR_ERROR_IO;
-                    goto done;
-                }
+    if (*buf == NULL || *sz_buf < total_len + 1) {
+        char *new_buf = realloc (*buf, total_len + 1);
+        if (new_buf == NULL) {
+            return PCRDR_ERROR_NOMEM;
+        }
 
-                if (header.op != US_OPCODE_CONTINUATION &&
-                        header.op != US_OPCODE_END) {
-                    PC_DEBUG ("Not a continuation frame\n");
-                    err_code = PCRDR_ERROR_PROTOCOL;
-                    goto done;
-                }
+        *buf = new_buf;
+        *sz_buf = total_len + 1;
+    }
 
-                if (conn_read (conn->fd, packet_buf + offset, header.sz_payload)) {
-                    PC_DEBUG ("Failed to read packet from Unix socket\n");
-                    err_code = PCRDR_ERROR_IO;
-                    goto done;
-                }
+    if (conn_read (conn->fd, *buf, header.sz_payload)) {
+        PC_DEBUG ("Failed to read packet from Unix socket\n");
+        return PCRDR_ERROR_IO;
+    }
 
-                left -= header.sz_payload;
-                offset += header.sz_payload;
-                if (header.op == US_OPCODE_END) {
-                    break;
-                }
-            }
+    while (left > 0) {
+        if (conn_read (conn->fd, &header, sizeof (USFrameHeader))) {
+            PC_DEBUG ("Failed to read frame header from Unix socket\n");
+            return PCRDR_ERROR_IO;
+        }
 
-            if (is_text) {
-                ((char *)packet_buf) [offset] = '\0';
-                *sz_packet = offset + 1;
-            }
-            else {
-                *sz_packet = offset;
-            }
+        if ((header.op != US_OPCODE_CONTINUATION &&
+                    header.op != US_OPCODE_END) ||
+                header.sz_payload > left) {
+            PC_DEBUG ("Not a continuation frame\n");
+            return PCRDR_ERROR_PROTOCOL;
+        }
 
-            goto done;
+        if (conn_read (conn->fd, *buf + offset, header.sz_payload)) {
+            PC_DEBUG ("Failed to read packet from Unix socket\n");
+            return PCRDR_ERROR_IO;
         }
-        else {
-            PC_DEBUG ("Bad packet op code: %d\n", header.op);
-            err_code = PCRDR_ERROR_PROTOCOL;
-            goto done;
+
+        left -= header.sz_payload;
+        offset += header.sz_payload;
+        if (header.op == US_OPCODE_END) {
+            break;
         }
     }
-    else if (conn->type == CT_WEB_SOCKET) {
-        /* TODO */
-        err_code = PCRDR_ERROR_NOT_IMPLEMENTED;
-        goto done;
+
+    if (*op == US_OPCODE_TEXT) {
+        (*buf) [offset] = '\0';
+        *sz_packet = offset + 1;
     }
     else {
-        assert (0);
-        err_code = PCRDR_ERROR_INVALID_VALUE;
-        goto done;
+        *sz_packet = offset;
     }
 
-done:
+    return 0;
+}
+
+int pcrdr_purcmc_read_packet_alloc (pcrdr_conn* conn, void **packet, size_t *sz_packet)
+{
+    char* packet_buf = NULL;
+    size_t sz_buf = 0;
+    int err_code, op;
+
+    err_code = read_packet_to_buffer (conn, &packet_buf, &sz_buf,
+            sz_packet, &op);
     if (err_code) {
         if (packet_buf)
             free (packet_buf);
@@ -591,11 +657,16 @@ done:
         return -1;
     }
 
+    if (*sz_packet == 0 && packet_buf) {
+        free (packet_buf);
+        packet_buf = NULL;
+    }
+
     *packet = packet_buf;
     return 0;
 }
 
-int pcrdr_purcmc_send_text_packet (pcrdr_conn* conn, const char* text, size_t len)
+static int send_packet (pcrdr_conn* conn, int op, const char* data, size_t len)
 {
     int retv = 0;
 
@@ -607,7 +678,7 @@ int pcrdr_purcmc_send_text_packet (pcrdr_conn* conn, const char* text, size_t le
 
             do {
                 if (left == len) {
-                    header.op = US_OPCODE_TEXT;
+                    header.op = op;
                     header.fragmented = len;
                     header.sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
                     left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
@@ -626,18 +697,18 @@ int pcrdr_purcmc_send_text_packet (pcrdr_conn* conn, const char* text, size_t le
                 }
 
                 if (conn_write (conn->fd, &header, sizeof (USFrameHeader)) == 0) {
-                    retv = conn_write (conn->fd, text, header.sz_payload);
-                    text += header.sz_payload;
+                    retv = conn_write (conn->fd, data, header.sz_payload);
+                    data += header.sz_payload;
                 }
 
             } while (left > 0 && retv == 0);
         }
         else {
-            header.op = US_OPCODE_TEXT;
+            header.op = op;
             header.fragmented = 0;
             header.sz_payload = len;
             if (conn_write (conn->fd, &header, sizeof (USFrameHeader)) == 0)
-                retv = conn_write (conn->fd, text, len);
+                retv = conn_write (conn->fd, data, len);
         }
     }
     else if (conn->type == CT_WEB_SOCKET) {
@@ -650,6 +721,43 @@ int pcrdr_purcmc_send_text_packet (pcrdr_conn* conn, const char* text, size_t le
     return retv;
 }
 
+int pcrdr_purcmc_send_text_packet (pcrdr_conn* conn, const char* text, size_t len)
+{
+    return send_packet (conn, US_OPCODE_TEXT, text, len);
+}
+
+int pcrdr_purcmc_send_bin_packet (pcrdr_conn* conn, const void* data, size_t len)
+{
+    return send_packet (conn, US_OPCODE_BIN, data, len);
+}
+
+/* Uses the binary encoding if the renderer supports it, unless disabled
+   by env PURC_RDR_BINARY_MSG. */
+static bool use_binary_message (const pcrdr_msg *msg)
+{
+    const char *env_value = getenv (PURC_ENVV_RDR_BINARY_MSG);
+    if (env_value && (*env_value == '0' ||
+                pcutils_strcasecmp (env_value, "false") == 0)) {
+        return false;
+    }
+
+    if (msg->type != PCRDR_MSG_TYPE_RESPONSE || msg->retCode != PCRDR_SC_OK ||
+            msg->dataType == PCRDR_MSG_DATA_TYPE_VOID) {
+        return false;
+    }
+
+    struct renderer_capabilities *rdr_caps;
+    rdr_caps = pcrdr_parse_renderer_capabilities (
+            purc_variant_get_string_const (msg->data));
+    if (rdr_caps == NULL) {
+        return false;
+    }
+
+    bool binary = (rdr_caps->binaryMessage >= PCRDR_BIN_MESSAGE_VERSION);
+    pcrdr_release_renderer_capabilities (rdr_caps);
+    return binary;
+}
+
 #define SCHEMA_UNIX_SOCKET  "unix://"
 
 pcrdr_msg *pcrdr_purcmc_connect(const char* renderer_uri,
@@ -670,15 +778,27 @@ pcrdr_msg *pcrdr_purcmc_connect(const char* renderer_uri,
     }
 
     /* read the initial response from the server */
-    char buff[PCRDR_DEF_PACKET_BUFF_SIZE];
-    size_t len = sizeof(buff);
+    struct pcrdr_prot_data *prot_data = (*conn)->prot_data;
+    size_t len;
+    int err_code, op;
 
-    if (pcrdr_purcmc_read_packet(*conn, buff, &len) < 0)
+    err_code = read_packet_to_buffer(*conn, &prot_data->recv_buf,
+            &prot_data->sz_recv_buf, &len, &op);
+    if (err_code) {
+        purc_set_error(err_code);
         goto failed;
+    }
+
+    if (op != US_OPCODE_TEXT) {
+        purc_set_error(PCRDR_ERROR_PROTOCOL);
+        goto failed;
+    }
 
-    if (pcrdr_parse_packet(buff, len, &msg) < 0)
+    if (pcrdr_parse_packet(prot_data->recv_buf, len, &msg) < 0)
         goto failed;
 
+    /* the capabilities of the renderer decide the encoding of messages */
+    prot_data->binary = use_binary_message(msg);
     return msg;
 
 failed:
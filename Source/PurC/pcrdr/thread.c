@@ -26,6 +26,7 @@
 #include "config.h"
 #include "purc-pcrdr.h"
 #include "private/pcrdr.h"
+#include "private/instance.h"
 #include "private/sorted-array.h"
 #include "private/debug.h"
 #include "private/utils.h"
@@ -47,26 +48,15 @@ struct pcrdr_prot_data {
 
 static int my_wait_message(pcrdr_conn* conn, int timeout_ms)
 {
-    size_t count = 0;
     UNUSED_PARAM(conn);
 
-    if (purc_inst_holding_messages_count(&count))
+    /* returns as soon as the renderer thread moves a message to us */
+    ssize_t count = pcinst_wait_for_moved_messages(timeout_ms);
+    if (count < 0)
         return -1;
 
-    if (count == 0) {
-        if (timeout_ms > 1000) {
-            pcutils_sleep(timeout_ms / 1000);
-        }
-
-        if (timeout_ms > 0) {
-            unsigned int ms = timeout_ms % 1000;
-            if (ms) {
-                pcutils_usleep(ms * 1000);
-            }
-        }
-
+    if (count == 0)
         return 0;
-    }
 
     // it's time to read a fake response message.
     return 1;
@@ -164,22 +154,11 @@ pcrdr_msg *pcrdr_thread_connect(const char* renderer_uri,
     list_head_init (&(*conn)->pending_requests);
 
     /* read the initial response message from the rendere thread */
-    int left_ms = PCRDR_DEF_TIME_EXPECTED * 1000;
-    while (left_ms > 0) {
-        if (my_wait_message(*conn, 10) == 0)
-            left_ms -= 10;
-        else
-            break;
-    }
-
-    if (left_ms <= 0) {
-        err_code = PCRDR_ERROR_TIMEOUT;
-        goto failed;
-    }
-
-    msg = purc_inst_take_away_message(0);
+    msg = purc_inst_take_away_message_timed(0,
+            PCRDR_DEF_TIME_EXPECTED * 1000);
     if (msg == NULL) {
-        err_code = PCRDR_ERROR_UNEXPECTED;
+        err_code = (purc_get_last_error() == PURC_ERROR_TIMEOUT) ?
+            PCRDR_ERROR_TIMEOUT : PCRDR_ERROR_UNEXPECTED;
         goto failed;
     }
 
@@ -0,0 +1,435 @@
+/*
+ * @file dtoa.c
+ * @date 2022/10/21
+ * @brief The helpers to format floating-point numbers in the shortest
+ *      decimal form which can be read back to the same value.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The digits are generated by the Grisu2 algorithm of Florian Loitsch
+ * ("Printing Floating-Point Numbers Quickly and Accurately with Integers",
+ * PLDI 2010), which always gives digits reading back to the same value,
+ * and the shortest ones for the most values.
+ */
+
+#include "config.h"
+#include "private/utils.h"
+
+#include <string.h>
+
+#define DP_SIGNIFICAND_SIZE     52
+#define DP_EXPONENT_BIAS        (0x3FF + DP_SIGNIFICAND_SIZE)
+#define DP_MIN_EXPONENT         (-DP_EXPONENT_BIAS)
+#define DP_EXPONENT_MASK        UINT64_C(0x7FF0000000000000)
+#define DP_SIGNIFICAND_MASK     UINT64_C(0x000FFFFFFFFFFFFF)
+#define DP_HIDDEN_BIT           UINT64_C(0x0010000000000000)
+
+/* the number of significant digits of `%.17g` */
+#define DTOA_PRECISION          17
+
+/* the floating-point number without the sign: f * 2^e */
+struct diy_fp {
+    uint64_t f;
+    int e;
+};
+
+/* the normalized 10^k for k = -348, -340, ..., 340 */
+static const uint64_t cached_powers_f[] = {
+    UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76),
+    UINT64_C(0x8b16fb203055ac76), UINT64_C(0xcf42894a5dce35ea),
+    UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+    UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f),
+    UINT64_C(0xbe5691ef416bd60c), UINT64_C(0x8dd01fad907ffc3c),
+    UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+    UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d),
+    UINT64_C(0x823c12795db6ce57), UINT64_C(0xc21094364dfb5637),
+    UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+    UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5),
+    UINT64_C(0xb23867fb2a35b28e), UINT64_C(0x84c8d4dfd2c63f3b),
+    UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+    UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6),
+    UINT64_C(0xf3e2f893dec3f126), UINT64_C(0xb5b5ada8aaff80b8),
+    UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+    UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd),
+    UINT64_C(0xa6dfbd9fb8e5b88f), UINT64_C(0xf8a95fcf88747d94),
+    UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+    UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac),
+    UINT64_C(0xe45c10c42a2b3b06), UINT64_C(0xaa242499697392d3),
+    UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+    UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c),
+    UINT64_C(0x9c40000000000000), UINT64_C(0xe8d4a51000000000),
+    UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+    UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70),
+    UINT64_C(0xd5d238a4abe98068), UINT64_C(0x9f4f2726179a2245),
+    UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+    UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a),
+    UINT64_C(0x924d692ca61be758), UINT64_C(0xda01ee641a708dea),
+    UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+    UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2),
+    UINT64_C(0xc83553c5c8965d3d), UINT64_C(0x952ab45cfa97a0b3),
+    UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+    UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece),
+    UINT64_C(0x88fcf317f22241e2), UINT64_C(0xcc20ce9bd35c78a5),
+    UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+    UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c),
+    UINT64_C(0xbb764c4ca7a44410), UINT64_C(0x8bab8eefb6409c1a),
+    UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+    UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429),
+    UINT64_C(0x80444b5e7aa7cf85), UINT64_C(0xbf21e44003acdd2d),
+    UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+    UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9),
+    UINT64_C(0xaf87023b9bf0ee6b)};
+
+static const int16_t cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066};
+
+static const uint32_t pow10_u32[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+    1000000000
+};
+
+static const uint64_t pow10_u64[] = {
+    UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000),
+    UINT64_C(10000), UINT64_C(100000), UINT64_C(1000000),
+    UINT64_C(10000000), UINT64_C(100000000), UINT64_C(1000000000),
+    UINT64_C(10000000000), UINT64_C(100000000000),
+    UINT64_C(1000000000000), UINT64_C(10000000000000),
+    UINT64_C(100000000000000), UINT64_C(1000000000000000),
+    UINT64_C(10000000000000000), UINT64_C(100000000000000000),
+    UINT64_C(1000000000000000000), UINT64_C(10000000000000000000)
+};
+
+static inline struct diy_fp diy_fp_make(uint64_t f, int e)
+{
+    struct diy_fp fp = { f, e };
+    return fp;
+}
+
+static inline struct diy_fp diy_fp_multiply(struct diy_fp a, struct diy_fp b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t p = (__uint128_t)a.f * b.f;
+    uint64_t h = (uint64_t)(p >> 64);
+    uint64_t l = (uint64_t)p;
+    if (l & (UINT64_C(1) << 63))    /* round */
+        h++;
+    return diy_fp_make(h, a.e + b.e + 64);
+#else
+    const uint64_t M32 = UINT64_C(0xFFFFFFFF);
+    uint64_t a_h = a.f >> 32, a_l = a.f & M32;
+    uint64_t b_h = b.f >> 32, b_l = b.f & M32;
+    uint64_t ac = a_h * b_h, bc = a_l * b_h, ad = a_h * b_l, bd = a_l * b_l;
+    uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+    tmp += UINT64_C(1) << 31;       /* round */
+    return diy_fp_make(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32),
+            a.e + b.e + 64);
+#endif
+}
+
+static inline struct diy_fp diy_fp_normalize(struct diy_fp fp)
+{
+#if defined(__GNUC__)
+    int s = __builtin_clzll(fp.f);
+    fp.f <<= s;
+    fp.e -= s;
+#else
+    while (!(fp.f & (UINT64_C(1) << 63))) {
+        fp.f <<= 1;
+        fp.e--;
+    }
+#endif
+    return fp;
+}
+
+static inline struct diy_fp diy_fp_from_double(double d)
+{
+    union {
+        double d;
+        uint64_t u;
+    } u = { d };
+    struct diy_fp fp;
+
+    int biased_e = (int)((u.u & DP_EXPONENT_MASK) >> DP_SIGNIFICAND_SIZE);
+    uint64_t significand = u.u & DP_SIGNIFICAND_MASK;
+    if (biased_e != 0) {
+        fp.f = significand + DP_HIDDEN_BIT;
+        fp.e = biased_e - DP_EXPONENT_BIAS;
+    }
+    else {
+        fp.f = significand;
+        fp.e = DP_MIN_EXPONENT + 1;
+    }
+
+    return fp;
+}
+
+/* the boundaries m- and m+ of v, normalized to the same exponent */
+static void normalized_boundaries(struct diy_fp v,
+        struct diy_fp *minus, struct diy_fp *plus)
+{
+    struct diy_fp pl = diy_fp_make((v.f << 1) + 1, v.e - 1);
+    while (!(pl.f & (DP_HIDDEN_BIT << 1))) {
+        pl.f <<= 1;
+        pl.e--;
+    }
+    pl.f <<= 64 - DP_SIGNIFICAND_SIZE - 2;
+    pl.e -= 64 - DP_SIGNIFICAND_SIZE - 2;
+
+    struct diy_fp mi = (v.f == DP_HIDDEN_BIT) ?
+        diy_fp_make((v.f << 2) - 1, v.e - 2) :
+        diy_fp_make((v.f << 1) - 1, v.e - 1);
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+
+    *plus = pl;
+    *minus = mi;
+}
+
+/* the cached power c = 10^-k so that the exponent of w * c is in [-60, -32] */
+static inline struct diy_fp cached_power(int e, int *k)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ik = (int)dk;
+    if (dk - ik > 0.0)
+        ik++;
+
+    unsigned index = (unsigned)((ik >> 3) + 1);
+    *k = -(-348 + (int)index * 8);
+    return diy_fp_make(cached_powers_f[index], cached_powers_e[index]);
+}
+
+static inline unsigned count_digits_u32(uint32_t n)
+{
+    unsigned i = 1;
+    while (i < PCA_TABLESIZE(pow10_u32) && n >= pow10_u32[i])
+        i++;
+    return i;
+}
+
+static inline void grisu_round(char *buf, int len, uint64_t delta,
+        uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+            (rest + ten_kappa < wp_w ||
+             wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int digit_gen(struct diy_fp w, struct diy_fp mp, uint64_t delta,
+        char *buf, int *k)
+{
+    struct diy_fp one = diy_fp_make(UINT64_C(1) << -mp.e, mp.e);
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+    uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = (int)count_digits_u32(p1);
+    int len = 0;
+
+    while (kappa > 0) {
+        uint32_t d = p1 / pow10_u32[kappa - 1];
+        p1 %= pow10_u32[kappa - 1];
+        if (d || len)
+            buf[len++] = (char)('0' + d);
+        kappa--;
+
+        uint64_t tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *k += kappa;
+            grisu_round(buf, len, delta, tmp,
+                    (uint64_t)pow10_u32[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || len)
+            buf[len++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            int index = -kappa;
+            grisu_round(buf, len, delta, p2, one.f,
+                    wp_w * (index < (int)PCA_TABLESIZE(pow10_u64) ?
+                        pow10_u64[index] : 0));
+            return len;
+        }
+    }
+}
+
+/* generates the digits of v (positive) and the exponent: v = digits * 10^k */
+static int grisu2(double v, char *buf, int *k)
+{
+    struct diy_fp fp = diy_fp_from_double(v);
+    struct diy_fp w_m, w_p;
+
+    normalized_boundaries(fp, &w_m, &w_p);
+
+    struct diy_fp c_mk = cached_power(w_p.e, k);
+    struct diy_fp w = diy_fp_multiply(diy_fp_normalize(fp), c_mk);
+    w_p = diy_fp_multiply(w_p, c_mk);
+    w_m = diy_fp_multiply(w_m, c_mk);
+    w_m.f++;
+    w_p.f--;
+    return digit_gen(w, w_p, w_p.f - w_m.f, buf, k);
+}
+
+static inline char *write_exponent(char *p, int x)
+{
+    *p++ = 'e';
+    if (x < 0) {
+        *p++ = '-';
+        x = -x;
+    }
+    else {
+        *p++ = '+';
+    }
+
+    /* at least two digits, like printf() */
+    if (x >= 100) {
+        *p++ = (char)('0' + x / 100);
+        x %= 100;
+    }
+    *p++ = (char)('0' + x / 10);
+    *p++ = (char)('0' + x % 10);
+    return p;
+}
+
+size_t pcutils_dtoa_shortest(double d, char *buf)
+{
+    char *p = buf;
+    char digits[DTOA_PRECISION + 8];
+    int len, k;
+
+    if (signbit(d)) {
+        *p++ = '-';
+        d = -d;
+    }
+
+    if (d == 0) {
+        *p++ = '0';
+        *p = 0;
+        return p - buf;
+    }
+
+    len = grisu2(d, digits, &k);
+
+    /* the exponent of the first digit; follow the style of `%.17g` */
+    int x = len + k - 1;
+    if (x < -4 || x >= DTOA_PRECISION) {
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, len - 1);
+            p += len - 1;
+        }
+        p = write_exponent(p, x);
+    }
+    else if (k >= 0) {
+        memcpy(p, digits, len);
+        p += len;
+        memset(p, '0', k);
+        p += k;
+    }
+    else if (x >= 0) {
+        memcpy(p, digits, x + 1);
+        p += x + 1;
+        *p++ = '.';
+        memcpy(p, digits + x + 1, len - x - 1);
+        p += len - x - 1;
+    }
+    else {
+        *p++ = '0';
+        *p++ = '.';
+        memset(p, '0', -x - 1);
+        p += -x - 1;
+        memcpy(p, digits, len);
+        p += len;
+    }
+
+    *p = 0;
+    return p - buf;
+}
+
+static size_t u64toa(uint64_t u, bool neg, char *buf)
+{
+    char tmp[24];
+    char *q = tmp + sizeof(tmp);
+    char *p = buf;
+
+    do {
+        *--q = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+
+    if (neg)
+        *p++ = '-';
+    size_t n = tmp + sizeof(tmp) - q;
+    memcpy(p, q, n);
+    p += n;
+    *p = 0;
+    return p - buf;
+}
+
+size_t pcutils_dtoa_integer(double d, double max_abs, char *buf)
+{
+    /* 2^63: the integral part fits in int64_t */
+    if (max_abs > 9223372036854775808.0)
+        max_abs = 9223372036854775808.0;
+
+    if (!(d > -max_abs && d < max_abs))
+        return 0;
+
+    int64_t i = (int64_t)d;
+    if ((double)i != d)
+        return 0;
+
+    bool neg = signbit(d);
+    return u64toa(neg ? -(uint64_t)i : (uint64_t)i, neg, buf);
+}
+
+size_t pcutils_ldtoa_integer(long double ld, long double max_abs, char *buf)
+{
+    if (max_abs > 9223372036854775808.0L)
+        max_abs = 9223372036854775808.0L;
+
+    if (!(ld > -max_abs && ld < max_abs))
+        return 0;
+
+    int64_t i = (int64_t)ld;
+    if ((long double)i != ld)
+        return 0;
+
+    bool neg = signbit(ld);
+    return u64toa(neg ? -(uint64_t)i : (uint64_t)i, neg, buf);
+}
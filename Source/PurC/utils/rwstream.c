@@ -28,6 +28,7 @@
 #include "purc-utils.h"
 #include "private/errors.h"
 #include "private/instance.h"
+#include "private/rwstream.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -106,6 +107,13 @@ struct mem_rwstream
     uint8_t* stop;
 };
 
+struct shared_mem_rwstream
+{
+    struct mem_rwstream mem;
+    void (*release) (void *ctxt);
+    void *ctxt;
+};
+
 struct buffer_rwstream
 {
     purc_rwstream rwstream;
@@ -163,6 +171,20 @@ static rwstream_funcs mem_funcs = {
     mem_get_mem_buffer
 };
 
+static ssize_t shared_mem_write (purc_rwstream_t rws, const void* buf,
+        size_t count);
+static int shared_mem_destroy (purc_rwstream_t rws);
+
+static rwstream_funcs shared_mem_funcs = {
+    mem_seek,
+    mem_tell,
+    mem_read,
+    shared_mem_write,
+    mem_flush,
+    shared_mem_destroy,
+    mem_get_mem_buffer
+};
+
 static off_t buffer_seek (purc_rwstream_t rws, off_t offset, int whence);
 static off_t buffer_tell (purc_rwstream_t rws);
 static ssize_t buffer_read (purc_rwstream_t rws, void* buf, size_t count);
@@ -255,6 +277,26 @@ purc_rwstream_t purc_rwstream_new_from_mem (void* mem, size_t sz)
     return (purc_rwstream_t)rws;
 }
 
+purc_rwstream_t pcutils_rwstream_new_from_shared_mem (const void* mem,
+        size_t sz, void (*release) (void *ctxt), void *ctxt)
+{
+    struct shared_mem_rwstream* rws = (struct shared_mem_rwstream*) calloc(
+            1, sizeof(struct shared_mem_rwstream));
+    if (rws == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    rws->mem.rwstream.funcs = &shared_mem_funcs;
+    rws->mem.base = (uint8_t *)mem;
+    rws->mem.here = rws->mem.base;
+    rws->mem.stop = rws->mem.base + sz;
+    rws->release = release;
+    rws->ctxt = ctxt;
+
+    return (purc_rwstream_t)rws;
+}
+
 purc_rwstream_t purc_rwstream_new_from_file (const char* file, const char* mode)
 {
     FILE* fp = fopen(file, mode);
@@ -651,6 +693,25 @@ void* purc_rwstream_get_mem_buffer_ex (purc_rwstream_t rws,
     return rws->funcs->get_mem_buffer(rws, sz_content, sz_buffer, res_buff);
 }
 
+bool pcutils_rwstream_get_mem_cursor(purc_rwstream_t rws,
+        uint8_t ***here, uint8_t ***stop)
+{
+    if (rws->funcs == &mem_funcs || rws->funcs == &shared_mem_funcs) {
+        struct mem_rwstream* mem = (struct mem_rwstream *)rws;
+        *here = &mem->here;
+        *stop = &mem->stop;
+        return true;
+    }
+    else if (rws->funcs == &buffer_funcs) {
+        struct buffer_rwstream* buffer = (struct buffer_rwstream *)rws;
+        *here = &buffer->here;
+        *stop = &buffer->stop;
+        return true;
+    }
+
+    return false;
+}
+
 /* stdio rwstream functions */
 static off_t stdio_seek (purc_rwstream_t rws, off_t offset, int whence)
 {
@@ -801,6 +862,27 @@ static void* mem_get_mem_buffer (purc_rwstream_t rws,
     return mem->base;
 }
 
+/* shared memory rwstream functions */
+static ssize_t shared_mem_write (purc_rwstream_t rws, const void* buf,
+        size_t count)
+{
+    UNUSED_PARAM(rws);
+    UNUSED_PARAM(buf);
+    UNUSED_PARAM(count);
+    pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+}
+
+static int shared_mem_destroy (purc_rwstream_t rws)
+{
+    struct shared_mem_rwstream* shared = (struct shared_mem_rwstream *)rws;
+    if (shared->release) {
+        shared->release(shared->ctxt);
+    }
+    free(rws);
+    return 0;
+}
+
 /* buffer rwstream functions */
 static int buffer_extend (struct buffer_rwstream* buffer, size_t size)
 {
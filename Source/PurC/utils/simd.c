@@ -0,0 +1,608 @@
+/*
+ * @file simd.c
+ * @date 2022/10/22
+ * @brief The SIMD kernels for validating UTF-8 strings, counting the
+ *      characters, and finding the bytes to escape in JSON strings.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The kernels are selected at runtime by the instruction sets supported
+ * by the CPU. The AVX2 UTF-8 validator follows the lookup algorithm of
+ * John Keiser and Daniel Lemire ("Validating UTF-8 In Less Than One
+ * Instruction Per Byte", Software: Practice and Experience, 2021).
+ * The SSE2 one only skips the blocks of ASCII characters, because SSE2
+ * has no byte shuffle to look up the tables.
+ *
+ * Whenever a block is found to be invalid or contain a null byte, the
+ * characters in it are checked one by one, so the results are always
+ * the same as the ones of the scalar code.
+ */
+
+#include "config.h"
+#include "private/simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#if (CPU(X86_64) || CPU(X86)) && COMPILER(GCC_COMPATIBLE)
+#define SIMD_X86        1
+#include <immintrin.h>
+#define TARGET_SSE2     __attribute__((target("sse2")))
+#define TARGET_AVX2     __attribute__((target("avx2")))
+#else
+#define SIMD_X86        0
+#endif
+
+static int supported_level(void)
+{
+#if SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return PCUTILS_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return PCUTILS_SIMD_SSE2;
+#endif
+    return PCUTILS_SIMD_NONE;
+}
+
+/* -1 for not detected yet; a race only detects the level twice */
+static int simd_level = -1;
+
+int pcutils_simd_level(void)
+{
+    if (UNLIKELY(simd_level < 0)) {
+        int level = supported_level();
+        const char *env = getenv(PURC_ENVV_SIMD);
+
+        if (env) {
+            if (strcasecmp(env, "none") == 0 || strcmp(env, "0") == 0)
+                level = PCUTILS_SIMD_NONE;
+            else if (strcasecmp(env, "sse2") == 0 &&
+                    level > PCUTILS_SIMD_SSE2)
+                level = PCUTILS_SIMD_SSE2;
+        }
+
+        simd_level = level;
+    }
+
+    return simd_level;
+}
+
+int pcutils_simd_set_level(int level)
+{
+    int supported = supported_level();
+
+    if (level < PCUTILS_SIMD_NONE)
+        level = PCUTILS_SIMD_NONE;
+    simd_level = (level < supported) ? level : supported;
+    return simd_level;
+}
+
+static inline bool is_continuation(uint8_t c)
+{
+    return (c & 0xC0) == 0x80;
+}
+
+/* Returns the length of the valid character at p, or 0 if it is invalid
+   or a null byte; the same rules as fast_validate_len() in utf8.c. */
+static inline size_t validate_char(const uint8_t *p, size_t left)
+{
+    uint8_t c = p[0];
+
+    if (c < 0x80)
+        return c ? 1 : 0;
+
+    if (c < 0xC2)
+        return 0;
+
+    if (c < 0xE0) {
+        if (left < 2 || !is_continuation(p[1]))
+            return 0;
+        return 2;
+    }
+
+    if (c < 0xF0) {
+        if (left < 3)
+            return 0;
+        if (c == 0xE0) {
+            if ((p[1] & 0xE0) != 0xA0)
+                return 0;
+        }
+        else if (c == 0xED) {
+            if ((p[1] & 0xE0) != 0x80)
+                return 0;
+        }
+        else if (!is_continuation(p[1])) {
+            return 0;
+        }
+
+        if (!is_continuation(p[2]))
+            return 0;
+        return 3;
+    }
+
+    if (c < 0xF5) {
+        if (left < 4)
+            return 0;
+        if (c == 0xF0) {
+            if (!is_continuation(p[1]) || (p[1] & 0x30) == 0)
+                return 0;
+        }
+        else if (c == 0xF4) {
+            if ((p[1] & 0xF0) != 0x80)
+                return 0;
+        }
+        else if (!is_continuation(p[1])) {
+            return 0;
+        }
+
+        if (!is_continuation(p[2]) || !is_continuation(p[3]))
+            return 0;
+        return 4;
+    }
+
+    return 0;
+}
+
+/* Moves the end of the validated bytes back to the start of the last
+   character if the character is not complete. */
+static size_t char_boundary(const uint8_t *str, size_t end, size_t *nr_chars)
+{
+    size_t lead;
+    size_t len;
+
+    if (end == 0)
+        return 0;
+
+    lead = end - 1;
+    while (lead > 0 && end - lead < 4 && is_continuation(str[lead]))
+        lead--;
+
+    if (str[lead] < 0x80)
+        len = 1;
+    else if (str[lead] < 0xE0)
+        len = 2;
+    else if (str[lead] < 0xF0)
+        len = 3;
+    else
+        len = 4;
+
+    if (lead + len == end)
+        return end;
+
+    (*nr_chars)--;
+    return lead;
+}
+
+/* Validates the whole blocks from pos; returns the position of the first
+   block not validated, which may be in the middle of a character. */
+typedef size_t (*utf8_blocks_fn)(const uint8_t *str, size_t pos, size_t len,
+        size_t *nr_chars);
+
+static size_t
+valid_prefix(const uint8_t *str, size_t len, size_t *nr_chars,
+        utf8_blocks_fn blocks, size_t sz_block)
+{
+    size_t pos = 0, n = 0;
+
+    while (pos < len) {
+        pos = blocks(str, pos, len, &n);
+        pos = char_boundary(str, pos, &n);
+
+        /* check the characters in the next block one by one */
+        size_t stop = pos + sz_block;
+        if (stop > len)
+            stop = len;
+        while (pos < stop) {
+            size_t sz = validate_char(str + pos, len - pos);
+            if (sz == 0)
+                goto done;
+            pos += sz;
+            n++;
+        }
+    }
+
+done:
+    *nr_chars = n;
+    return pos;
+}
+
+#if SIMD_X86
+
+TARGET_SSE2 static size_t
+utf8_blocks_sse2(const uint8_t *str, size_t pos, size_t len,
+        size_t *nr_chars)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    while (len - pos >= 16) {
+        __m128i input = _mm_loadu_si128((const __m128i *)(str + pos));
+        if (_mm_movemask_epi8(input) ||
+                _mm_movemask_epi8(_mm_cmpeq_epi8(input, zero)))
+            break;
+
+        *nr_chars += 16;
+        pos += 16;
+    }
+
+    return pos;
+}
+
+/* the error bits of the two-byte sequences */
+#define TOO_SHORT       (1 << 0)    /* 11______ 0_______, 11______ 11______ */
+#define TOO_LONG        (1 << 1)    /* 0_______ 10______ */
+#define OVERLONG_3      (1 << 2)    /* 11100000 100_____ */
+#define TOO_LARGE       (1 << 3)    /* 11110100 1001____, 11110101+ 1_______ */
+#define SURROGATE       (1 << 4)    /* 11101101 101_____ */
+#define OVERLONG_2      (1 << 5)    /* 1100000_ 10______ */
+#define TOO_LARGE_1000  (1 << 6)    /* 11110101+ 1000____ */
+#define OVERLONG_4      (1 << 6)    /* 11110000 1000____ */
+#define TWO_CONTS       (1 << 7)    /* 10______ 10______ */
+#define CARRY           (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+#define TABLE16(...)    _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+TARGET_AVX2 static inline __m256i
+prev_bytes(__m256i input, __m256i prev_input, const int n)
+{
+    __m256i shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+    switch (n) {
+    case 1:
+        return _mm256_alignr_epi8(input, shifted, 15);
+    case 2:
+        return _mm256_alignr_epi8(input, shifted, 14);
+    default:
+        return _mm256_alignr_epi8(input, shifted, 13);
+    }
+}
+
+TARGET_AVX2 static inline __m256i high_nibbles(__m256i v)
+{
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+TARGET_AVX2 static inline __m256i
+check_special_cases(__m256i input, __m256i prev1)
+{
+    const __m256i byte_1_high_table = TABLE16(
+        /* 0_______ ________ */
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        /* 10______ ________ */
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        /* 1100____ ________ */
+        TOO_SHORT | OVERLONG_2,
+        /* 1101____ ________ */
+        TOO_SHORT,
+        /* 1110____ ________ */
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        /* 1111____ ________ */
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m256i byte_1_low_table = TABLE16(
+        /* ____0000 ________ */
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        /* ____0001 ________ */
+        CARRY | OVERLONG_2,
+        /* ____001_ ________ */
+        CARRY,
+        CARRY,
+        /* ____0100 ________ */
+        CARRY | TOO_LARGE,
+        /* ____0101 ________ */
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        /* ____011_ ________ */
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        /* ____1___ ________ */
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        /* ____1101 ________ */
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m256i byte_2_high_table = TABLE16(
+        /* ________ 0_______ */
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        /* ________ 1000____ */
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 |
+            OVERLONG_4,
+        /* ________ 1001____ */
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        /* ________ 101_____ */
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        /* ________ 11______ */
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table,
+            high_nibbles(prev1));
+    __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table,
+            _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+    __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table,
+            high_nibbles(input));
+    return _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low),
+            byte_2_high);
+}
+
+TARGET_AVX2 static inline __m256i
+check_multibyte_lengths(__m256i input, __m256i prev_input, __m256i sc)
+{
+    __m256i prev2 = prev_bytes(input, prev_input, 2);
+    __m256i prev3 = prev_bytes(input, prev_input, 3);
+
+    /* only 111_____ in prev2 and 1111____ in prev3 will be >= 0x80 */
+    __m256i is_third_byte = _mm256_subs_epu8(prev2,
+            _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i is_fourth_byte = _mm256_subs_epu8(prev3,
+            _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must23_80 = _mm256_and_si256(
+            _mm256_or_si256(is_third_byte, is_fourth_byte),
+            _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must23_80, sc);
+}
+
+/* non-zero if the last character in the block is not complete */
+TARGET_AVX2 static inline __m256i is_incomplete(__m256i input)
+{
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm256_subs_epu8(input, max_value);
+}
+
+TARGET_AVX2 static size_t
+utf8_blocks_avx2(const uint8_t *str, size_t pos, size_t len,
+        size_t *nr_chars)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max_continuation = _mm256_set1_epi8((char)0xBF);
+
+    /* pos is always at the start of a character */
+    __m256i prev_input = zero;
+    __m256i prev_incomplete = zero;
+
+    while (len - pos >= 32) {
+        __m256i input = _mm256_loadu_si256((const __m256i *)(str + pos));
+        __m256i error;
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(input, zero)))
+            break;
+
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = prev_incomplete;
+        }
+        else {
+            __m256i prev1 = prev_bytes(input, prev_input, 1);
+            __m256i sc = check_special_cases(input, prev1);
+            error = check_multibyte_lengths(input, prev_input, sc);
+            prev_incomplete = is_incomplete(input);
+        }
+
+        if (!_mm256_testz_si256(error, error))
+            break;
+
+        /* the bytes other than 10______ start the characters */
+        unsigned leads = (unsigned)_mm256_movemask_epi8(
+                _mm256_cmpgt_epi8(input, max_continuation));
+        *nr_chars += __builtin_popcount(leads);
+
+        prev_input = input;
+        pos += 32;
+    }
+
+    return pos;
+}
+
+#endif /* SIMD_X86 */
+
+size_t pcutils_utf8_valid_prefix(const char *str, size_t len,
+        size_t *nr_chars)
+{
+    switch (pcutils_simd_level()) {
+#if SIMD_X86
+    case PCUTILS_SIMD_AVX2:
+        return valid_prefix((const uint8_t *)str, len, nr_chars,
+                utf8_blocks_avx2, 32);
+    case PCUTILS_SIMD_SSE2:
+        return valid_prefix((const uint8_t *)str, len, nr_chars,
+                utf8_blocks_sse2, 16);
+#endif
+    default:
+        break;
+    }
+
+    *nr_chars = 0;
+    return 0;
+}
+
+static size_t count_chars_scalar(const uint8_t *str, size_t len)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        n += !is_continuation(str[i]);
+    }
+    return n;
+}
+
+#if SIMD_X86
+
+TARGET_SSE2 static size_t count_chars_sse2(const uint8_t *str, size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max_continuation = _mm_set1_epi8((char)0xBF);
+    size_t n = 0, i = 0;
+
+    while (len - i >= 16) {
+        /* up to 255 blocks before the byte counters overflow */
+        __m128i counts = zero;
+        for (int k = 0; k < 255 && len - i >= 16; k++, i += 16) {
+            __m128i input = _mm_loadu_si128((const __m128i *)(str + i));
+            counts = _mm_sub_epi8(counts,
+                    _mm_cmpgt_epi8(input, max_continuation));
+        }
+
+        __m128i sums = _mm_sad_epu8(counts, zero);
+        n += (size_t)_mm_cvtsi128_si32(sums) +
+            (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+
+    return n + count_chars_scalar(str + i, len - i);
+}
+
+TARGET_AVX2 static size_t count_chars_avx2(const uint8_t *str, size_t len)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max_continuation = _mm256_set1_epi8((char)0xBF);
+    size_t n = 0, i = 0;
+
+    while (len - i >= 32) {
+        __m256i counts = zero;
+        for (int k = 0; k < 255 && len - i >= 32; k++, i += 32) {
+            __m256i input = _mm256_loadu_si256((const __m256i *)(str + i));
+            counts = _mm256_sub_epi8(counts,
+                    _mm256_cmpgt_epi8(input, max_continuation));
+        }
+
+        __m256i sums = _mm256_sad_epu8(counts, zero);
+        __m128i sums128 = _mm_add_epi64(_mm256_castsi256_si128(sums),
+                _mm256_extracti128_si256(sums, 1));
+        n += (size_t)_mm_cvtsi128_si32(sums128) +
+            (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums128, 8));
+    }
+
+    return n + count_chars_scalar(str + i, len - i);
+}
+
+#endif /* SIMD_X86 */
+
+size_t pcutils_utf8_count_chars(const char *str, size_t len)
+{
+    switch (pcutils_simd_level()) {
+#if SIMD_X86
+    case PCUTILS_SIMD_AVX2:
+        return count_chars_avx2((const uint8_t *)str, len);
+    case PCUTILS_SIMD_SSE2:
+        return count_chars_sse2((const uint8_t *)str, len);
+#endif
+    default:
+        break;
+    }
+
+    return count_chars_scalar((const uint8_t *)str, len);
+}
+
+static inline bool need_escape(uint8_t c, bool escape_slash)
+{
+    return c < 0x20 || c == '"' || c == '\\' || (escape_slash && c == '/');
+}
+
+static size_t
+json_escape_span_scalar(const uint8_t *str, size_t len, bool escape_slash)
+{
+    size_t i;
+    for (i = 0; i < len; i++) {
+        if (need_escape(str[i], escape_slash))
+            break;
+    }
+    return i;
+}
+
+#if SIMD_X86
+
+TARGET_SSE2 static size_t
+json_escape_span_sse2(const uint8_t *str, size_t len, bool escape_slash)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max_control = _mm_set1_epi8(0x1F);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i slash = escape_slash ? _mm_set1_epi8('/') : quote;
+    size_t i = 0;
+
+    while (len - i >= 16) {
+        __m128i input = _mm_loadu_si128((const __m128i *)(str + i));
+        __m128i found = _mm_cmpeq_epi8(_mm_subs_epu8(input, max_control),
+                zero);
+        found = _mm_or_si128(found, _mm_cmpeq_epi8(input, quote));
+        found = _mm_or_si128(found, _mm_cmpeq_epi8(input, backslash));
+        found = _mm_or_si128(found, _mm_cmpeq_epi8(input, slash));
+
+        int mask = _mm_movemask_epi8(found);
+        if (mask)
+            return i + __builtin_ctz(mask);
+        i += 16;
+    }
+
+    return i + json_escape_span_scalar(str + i, len - i, escape_slash);
+}
+
+TARGET_AVX2 static size_t
+json_escape_span_avx2(const uint8_t *str, size_t len, bool escape_slash)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max_control = _mm256_set1_epi8(0x1F);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i slash = escape_slash ? _mm256_set1_epi8('/') : quote;
+    size_t i = 0;
+
+    while (len - i >= 32) {
+        __m256i input = _mm256_loadu_si256((const __m256i *)(str + i));
+        __m256i found = _mm256_cmpeq_epi8(
+                _mm256_subs_epu8(input, max_control), zero);
+        found = _mm256_or_si256(found, _mm256_cmpeq_epi8(input, quote));
+        found = _mm256_or_si256(found, _mm256_cmpeq_epi8(input, backslash));
+        found = _mm256_or_si256(found, _mm256_cmpeq_epi8(input, slash));
+
+        unsigned mask = (unsigned)_mm256_movemask_epi8(found);
+        if (mask)
+            return i + __builtin_ctz(mask);
+        i += 32;
+    }
+
+    return i + json_escape_span_scalar(str + i, len - i, escape_slash);
+}
+
+#endif /* SIMD_X86 */
+
+size_t pcutils_json_escape_span(const char *str, size_t len,
+        bool escape_slash)
+{
+    switch (pcutils_simd_level()) {
+#if SIMD_X86
+    case PCUTILS_SIMD_AVX2:
+        return json_escape_span_avx2((const uint8_t *)str, len,
+                escape_slash);
+    case PCUTILS_SIMD_SSE2:
+        return json_escape_span_sse2((const uint8_t *)str, len,
+                escape_slash);
+#endif
+    default:
+        break;
+    }
+
+    return json_escape_span_scalar((const uint8_t *)str, len, escape_slash);
+}
@@ -34,6 +34,7 @@
 
 #include "private/utf8.h"
 #include "private/utils.h"
+#include "private/simd.h"
 
 #include <string.h>
 #include <assert.h>
@@ -46,77 +47,6 @@ do {                                                        \
 
 /* see IETF RFC 3629 Section 4 */
 
-static const char *
-fast_validate(const char *str, size_t *nr_chars)
-{
-    size_t n = 0;
-    const char *p;
-
-    for (p = str; *p; p++) {
-        if (*(uint8_t *)p < 128) {
-            n++;
-        }
-        else {
-            const char *last;
-
-            last = p;
-            if (*(uint8_t *)p < 0xe0) /* 110xxxxx */
-            {
-                if (UNLIKELY (*(uint8_t *)p < 0xc2))
-                    goto error;
-            }
-            else {
-                if (*(uint8_t *)p < 0xf0) /* 1110xxxx */
-                {
-                    switch (*(uint8_t *)p++ & 0x0f) {
-                    case 0:
-                        VALIDATE_BYTE(0xe0, 0xa0); /* 0xa0 ... 0xbf */
-                        break;
-                    case 0x0d:
-                        VALIDATE_BYTE(0xe0, 0x80); /* 0x80 ... 0x9f */
-                        break;
-                    default:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                    }
-                }
-                else if (*(uint8_t *)p < 0xf5) /* 11110xxx excluding out-of-range */
-                {
-                    switch (*(uint8_t *)p++ & 0x07) {
-                    case 0:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                        if (UNLIKELY((*(uint8_t *)p & 0x30) == 0))
-                            goto error;
-                        break;
-                    case 4:
-                        VALIDATE_BYTE(0xf0, 0x80); /* 0x80 ... 0x8f */
-                        break;
-                    default:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                    }
-                    p++;
-                    VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                }
-                else
-                    goto error;
-            }
-
-            p++;
-            VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-
-            n++;
-            continue;
-error:
-            if (nr_chars)
-                *nr_chars = n;
-            return last;
-        }
-    }
-
-    if (nr_chars)
-        *nr_chars = n;
-    return p;
-}
-
 static const char *
 fast_validate_len(const char *str, ssize_t max_len, size_t *nr_chars)
 {
@@ -204,8 +134,13 @@ bool pcutils_string_check_utf8_len(const char* str, size_t max_len,
         size_t *nr_chars, const char **end)
 {
     const char *p;
+    size_t n, m;
 
-    p = fast_validate_len(str, max_len, nr_chars);
+    /* skip the valid prefix with the SIMD kernel first */
+    p = str + pcutils_utf8_valid_prefix(str, max_len, &n);
+    p = fast_validate_len(p, max_len - (p - str), &m);
+    if (nr_chars)
+        *nr_chars = n + m;
 
     if (end)
         *end = p;
@@ -219,20 +154,10 @@ bool pcutils_string_check_utf8_len(const char* str, size_t max_len,
 bool pcutils_string_check_utf8(const char *str, ssize_t max_len,
         size_t *nr_chars, const char **end)
 {
-    const char *p;
-
-    if (max_len >= 0)
-        return pcutils_string_check_utf8_len(str, max_len, nr_chars, end);
-
-    p = fast_validate(str, nr_chars);
+    if (max_len < 0)
+        max_len = strlen(str);
 
-    if (end)
-        *end = p;
-
-    if (*p != '\0')
-        return false;
-    else
-        return true;
+    return pcutils_string_check_utf8_len(str, max_len, nr_chars, end);
 }
 
 static const char utf8_skip_data[256] = {
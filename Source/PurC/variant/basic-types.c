@@ -32,6 +32,7 @@
 #include "private/tls.h"
 #include "private/variant.h"
 #include "private/utf8.h"
+#include "private/simd.h"
 
 #include "variant-internals.h"
 
@@ -319,7 +320,7 @@ purc_variant_t purc_variant_make_string_static(const char* str_utf8,
         }
     }
     else {
-        nr_chars = pcutils_string_utf8_chars(str_utf8, -1);
+        nr_chars = pcutils_utf8_count_chars(str_utf8, strlen(str_utf8));
     }
 
     value = pcvariant_get(PURC_VARIANT_TYPE_STRING);
@@ -441,7 +442,7 @@ purc_variant_make_atom_string (const char* str_utf8, bool check_encoding)
     }
     else {
         // XXX: the string must be enconded in UTF-8 correctly.
-        nr_chars = pcutils_string_utf8_chars(str_utf8, -1);
+        nr_chars = pcutils_utf8_count_chars(str_utf8, strlen(str_utf8));
     }
 
     purc_atom_t atom = purc_atom_from_string(str_utf8);
@@ -484,7 +485,7 @@ purc_variant_make_atom_string_static(const char* str_utf8,
     }
     else {
         // XXX: the string must be enconded in UTF-8 correctly.
-        nr_chars = pcutils_string_utf8_chars(str_utf8, -1);
+        nr_chars = pcutils_utf8_count_chars(str_utf8, strlen(str_utf8));
     }
 
     purc_atom_t atom = purc_atom_from_static_string(str_utf8);
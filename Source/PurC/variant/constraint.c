@@ -74,6 +74,7 @@ struct reverse_checker {
     pcutils_map           *input;     // key/val: variant old /variant new
     pcutils_map           *cache;     // as above
     pcutils_map           *output;    // as above
+    pcutils_map           *probed;    // key: set, val: set_node probed
 };
 
 static purc_variant_t
@@ -225,6 +226,49 @@ rebuild_ex(purc_variant_t val, pcutils_map *cache)
     }
 }
 
+/*
+ * Checks the uniqueness of a set after one of its elements changed by
+ * probing the set with the new version of the element only, instead of
+ * rebuilding the whole set. Returns 1 if the whole set has to be rebuilt:
+ * the ancestors of the set need its new version, another element of the
+ * set changed as well, or the probing found a conflict.
+ */
+static int
+probe_set(purc_variant_t set, struct set_node *node,
+        struct reverse_checker *checker)
+{
+    if (pcvar_container_belongs_to_set(set))
+        return 1;
+
+    if (pcutils_map_find(checker->cache, set))
+        return 1;
+
+    struct pcutils_map_entry *entry;
+    entry = pcutils_map_find(checker->probed, set);
+    if (entry && (struct set_node*)entry->val != node)
+        return 1;
+
+    purc_variant_t _new = rebuild_ex(node->val, checker->cache);
+    if (_new == PURC_VARIANT_INVALID)
+        return -1;
+
+    int r = pcvar_set_probe_change(set, node, _new);
+    PURC_VARIANT_SAFE_CLEAR(_new);
+    if (r) {
+        /* let the rebuilding report the conflict */
+        purc_clr_error();
+        return 1;
+    }
+
+    if (entry == NULL) {
+        r = pcutils_map_insert(checker->probed, set, node);
+        if (r)
+            return -1;
+    }
+
+    return 0;
+}
+
 static int
 reverse_check_chain(pcutils_map *chain, struct reverse_checker *checker)
 {
@@ -244,6 +288,18 @@ reverse_check_chain(pcutils_map *chain, struct reverse_checker *checker)
             purc_variant_t parent;
             parent = (purc_variant_t)entry->val;
 
+            if (purc_variant_is_set(parent)) {
+                struct set_node *node = (struct set_node*)entry->key;
+                r = probe_set(parent, node, checker);
+                if (r < 0)
+                    break;
+                if (r == 0) {
+                    pcutils_map_it_next(&it);
+                    continue;
+                }
+                r = 0;
+            }
+
             // rebuild _new value for edge parent
             purc_variant_t _new = rebuild_ex(parent, checker->cache);
             if (_new == PURC_VARIANT_INVALID) {
@@ -379,6 +435,8 @@ pcvar_reverse_check(purc_variant_t _old, purc_variant_t _new)
             copy_val, free_val, comp_key, threads);
     checker.output = pcutils_map_create(copy_key, free_key,
             copy_val, free_val, comp_key, threads);
+    checker.probed = pcutils_map_create(copy_key, free_key,
+            NULL, NULL, comp_key, threads);
 
     int r = -1;
     do {
@@ -388,6 +446,8 @@ pcvar_reverse_check(purc_variant_t _old, purc_variant_t _new)
             break;
         if (checker.output == NULL)
             break;
+        if (checker.probed == NULL)
+            break;
 
         r = pcutils_map_insert(checker.input, _old, _new);
         if (r)
@@ -400,6 +460,8 @@ pcvar_reverse_check(purc_variant_t _old, purc_variant_t _new)
         r = reverse_check(&checker);
     } while (0);
 
+    if (checker.probed)
+        pcutils_map_destroy(checker.probed);
     if (checker.output)
         pcutils_map_destroy(checker.output);
     if (checker.cache)
@@ -0,0 +1,378 @@
+/*
+ * @file json-reader.c
+ * @date 2022/12/14
+ * @brief Reading the variants from a JSON stream record by record.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "purc-variant.h"
+#include "purc-errors.h"
+#include "private/errors.h"
+#include "private/ejson.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the least room to read the stream into */
+#define MIN_READ_SIZE   4096
+
+/* what is expected out of a record when reading the elements of arrays */
+enum reader_state {
+    RS_TOP,                 // a top-level value, or `[`
+    RS_FIRST_ELEMENT,       // the first element, or `]`
+    RS_ELEMENT,             // an element after `,`
+    RS_SEPARATOR,           // `,` or `]` after an element
+};
+
+enum record_kind {
+    RK_NONE,                // not in a record
+    RK_CONTAINER,           // an object or an array
+    RK_STRING,
+    RK_SCALAR,              // a number or a keyword, ends at a delimiter
+};
+
+struct purc_json_reader {
+    unsigned int        flags;
+    enum reader_state   state;
+
+    char               *buf;
+    size_t              sz;         // the size of the buffer
+    size_t              len;        // the bytes in the buffer
+    size_t              pos;        // the bytes scanned
+
+    /* the record being scanned */
+    enum record_kind    kind;
+    size_t              start;
+    size_t              depth;
+    bool                in_string;
+    bool                escaped;
+};
+
+purc_json_reader_t
+purc_json_reader_new(unsigned int flags)
+{
+    purc_json_reader_t reader = calloc(1, sizeof(*reader));
+    if (reader == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    reader->flags = flags;
+    reader->state = RS_TOP;
+    return reader;
+}
+
+void
+purc_json_reader_delete(purc_json_reader_t reader)
+{
+    if (reader) {
+        free(reader->buf);
+        free(reader);
+    }
+}
+
+static inline bool is_json_ws(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline bool ends_scalar(char c)
+{
+    return is_json_ws(c) || c == ',' || c == ']' || c == '}' ||
+        c == '[' || c == '{' || c == '"';
+}
+
+/*
+ * Handles the bytes out of a record. Returns 1 if a record starts at the
+ * current position, 0 if the byte is consumed, or -1 if the byte is
+ * unexpected (and consumed).
+ */
+static int
+scan_between_records(purc_json_reader_t reader, char c)
+{
+    if (is_json_ws(c)) {
+        reader->pos++;
+        return 0;
+    }
+
+    if (reader->flags & PCVRNT_JSON_READER_FLAG_ELEMENTS) {
+        switch (reader->state) {
+        case RS_TOP:
+            if (c == '[') {
+                reader->state = RS_FIRST_ELEMENT;
+                reader->pos++;
+                return 0;
+            }
+            break;
+
+        case RS_FIRST_ELEMENT:
+        case RS_ELEMENT:
+            /* an empty array, or a trailing comma like eJSON */
+            if (c == ']') {
+                reader->state = RS_TOP;
+                reader->pos++;
+                return 0;
+            }
+            break;
+
+        case RS_SEPARATOR:
+            reader->pos++;
+            if (c == ',') {
+                reader->state = RS_ELEMENT;
+                return 0;
+            }
+            else if (c == ']') {
+                reader->state = RS_TOP;
+                return 0;
+            }
+
+            reader->state = RS_TOP;
+            return -1;
+        }
+    }
+
+    if (c == ',' || c == ':' || c == ']' || c == '}') {
+        reader->pos++;
+        return -1;
+    }
+
+    return 1;
+}
+
+/*
+ * Scans the buffered bytes for the end of the next record.
+ * Returns 1 and the end of the record if a record is complete,
+ * 0 if more bytes are needed, or -1 if an unexpected byte is skipped.
+ */
+static int
+scan_record(purc_json_reader_t reader, size_t *end)
+{
+    const char *buf = reader->buf;
+
+    while (reader->pos < reader->len) {
+        char c = buf[reader->pos];
+
+        if (reader->kind == RK_NONE) {
+            int ret = scan_between_records(reader, c);
+            if (ret <= 0) {
+                if (ret < 0)
+                    return -1;
+                continue;
+            }
+
+            reader->start = reader->pos;
+            reader->depth = 0;
+            reader->in_string = false;
+            reader->escaped = false;
+            if (c == '{' || c == '[') {
+                reader->kind = RK_CONTAINER;
+            }
+            else if (c == '"') {
+                reader->kind = RK_STRING;
+                reader->in_string = true;
+                reader->pos++;
+                continue;
+            }
+            else {
+                reader->kind = RK_SCALAR;
+            }
+        }
+
+        if (reader->in_string) {
+            /* skip the plain characters in one go */
+            while (reader->pos < reader->len) {
+                c = buf[reader->pos];
+                if (reader->escaped)
+                    reader->escaped = false;
+                else if (c == '\\')
+                    reader->escaped = true;
+                else if (c == '"')
+                    break;
+                reader->pos++;
+            }
+
+            if (reader->pos == reader->len)
+                break;
+
+            reader->in_string = false;
+            reader->pos++;
+            if (reader->kind == RK_STRING) {
+                *end = reader->pos;
+                return 1;
+            }
+            continue;
+        }
+
+        if (reader->kind == RK_SCALAR) {
+            if (ends_scalar(c)) {
+                *end = reader->pos;
+                return 1;
+            }
+            reader->pos++;
+            continue;
+        }
+
+        reader->pos++;
+        switch (c) {
+        case '"':
+            reader->in_string = true;
+            break;
+
+        case '{':
+        case '[':
+            reader->depth++;
+            break;
+
+        case '}':
+        case ']':
+            if (--reader->depth == 0) {
+                *end = reader->pos;
+                return 1;
+            }
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/* makes the variant from the record ends at `end`, and consumes it */
+static purc_variant_t
+make_record(purc_json_reader_t reader, size_t end)
+{
+    const char *json = reader->buf + reader->start;
+    size_t len = end - reader->start;
+
+    reader->kind = RK_NONE;
+    reader->pos = end;
+    if (reader->state != RS_TOP)
+        reader->state = RS_SEPARATOR;
+
+    /* tries the strict JSON parser first, then the eJSON parser */
+    purc_clr_error();
+    purc_variant_t value = purc_variant_make_from_json_string(json, len);
+    if (value == PURC_VARIANT_INVALID &&
+            purc_get_last_error() == PURC_ERROR_OK)
+        pcinst_set_error(PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+
+    return value;
+}
+
+/* Reads more bytes from the stream; keeps the record being scanned. */
+static ssize_t
+fill_buffer(purc_json_reader_t reader, purc_rwstream_t stream)
+{
+    size_t keep = (reader->kind == RK_NONE) ? reader->pos : reader->start;
+    if (keep > 0) {
+        memmove(reader->buf, reader->buf + keep, reader->len - keep);
+        reader->len -= keep;
+        reader->pos -= keep;
+        reader->start -= (reader->kind == RK_NONE) ? 0 : keep;
+    }
+
+    if (reader->sz - reader->len < MIN_READ_SIZE) {
+        size_t sz = reader->sz ? reader->sz * 2 : MIN_READ_SIZE * 2;
+        char *buf = realloc(reader->buf, sz);
+        if (buf == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+
+        reader->buf = buf;
+        reader->sz = sz;
+    }
+
+    ssize_t n = purc_rwstream_read(stream, reader->buf + reader->len,
+            reader->sz - reader->len);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            pcinst_set_error(PURC_ERROR_NOT_READY);
+        return -1;
+    }
+
+    reader->len += n;
+    return n;
+}
+
+bool
+purc_json_reader_set_flags(purc_json_reader_t reader, unsigned int flags)
+{
+    /* the end of the array after the last element may be read ahead */
+    if (reader->kind == RK_NONE && reader->state == RS_SEPARATOR) {
+        size_t pos = reader->pos;
+        while (pos < reader->len && is_json_ws(reader->buf[pos]))
+            pos++;
+
+        if (pos < reader->len && reader->buf[pos] == ']') {
+            reader->pos = pos + 1;
+            reader->state = RS_TOP;
+        }
+    }
+
+    if (reader->kind != RK_NONE || reader->state != RS_TOP) {
+        pcinst_set_error(PURC_ERROR_WRONG_STAGE);
+        return false;
+    }
+
+    reader->flags = flags;
+    return true;
+}
+
+purc_variant_t
+purc_json_reader_read(purc_json_reader_t reader, purc_rwstream_t stream)
+{
+    if (reader == NULL || stream == NULL) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    for (;;) {
+        size_t end;
+        int ret = scan_record(reader, &end);
+        if (ret > 0)
+            return make_record(reader, end);
+        else if (ret < 0) {
+            pcinst_set_error(PCEJSON_ERROR_UNEXPECTED_CHARACTER);
+            return PURC_VARIANT_INVALID;
+        }
+
+        ssize_t n = fill_buffer(reader, stream);
+        if (n > 0)
+            continue;
+        else if (n < 0)
+            return PURC_VARIANT_INVALID;
+
+        /* the end of the stream */
+        if (reader->kind == RK_SCALAR)
+            return make_record(reader, reader->len);
+
+        reader->state = RS_TOP;
+        if (reader->kind != RK_NONE) {
+            reader->kind = RK_NONE;
+            reader->pos = reader->len;
+            pcinst_set_error(PURC_ERROR_INCOMPLETED);
+            return PURC_VARIANT_INVALID;
+        }
+
+        pcinst_set_error(PURC_ERROR_NO_DATA);
+        return PURC_VARIANT_INVALID;
+    }
+}
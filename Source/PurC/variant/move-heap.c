@@ -419,7 +419,7 @@ move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
 
             move_keys_in_cloned_container(ctxt, retv);
 
-            _p->val = retv;
+            variant_array_get_data(arr)->vals[idx] = retv;
             pcutils_arrlist_append(ctxt->vrts_to_unref, v);
         }
 
@@ -616,7 +616,7 @@ move_or_clone_immutable_descendants_in_array(struct travel_context *ctxt,
         }
 
         if (retv != v) {
-            _p->val = retv;
+            variant_array_get_data(arr)->vals[idx] = retv;
             if (!(v->flags & PCVARIANT_FLAG_NOFREE))
                 pcutils_arrlist_append(ctxt->vrts_to_unref, v);
         }
@@ -846,7 +846,7 @@ static purc_variant_t move_array_descendants_out(purc_variant_t arr)
             break;
         }
 
-        _p->val = retv;
+        variant_array_get_data(arr)->vals[idx] = retv;
 
     } end_foreach;
 
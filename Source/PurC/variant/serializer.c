@@ -46,6 +46,8 @@
 #include "private/instance.h"
 #include "private/errors.h"
 #include "private/debug.h"
+#include "private/utils.h"
+#include "private/simd.h"
 
 #include "variant/variant-internals.h"
 
@@ -104,8 +106,14 @@ serialize_string(purc_rwstream_t rws, const char* str,
     size_t pos = 0, start_offset = 0;
     unsigned char c;
     char buff[3];
+    bool escape_slash = !(flags & PCVARIANT_SERIALIZE_OPT_NOSLASHESCAPE);
+
+    while (pos < len) {
+        /* skip the bytes which need not to be escaped */
+        pos += pcutils_json_escape_span(str + pos, len - pos, escape_slash);
+        if (pos == len)
+            break;
 
-    while (len--) {
         c = str[pos];
         switch (c) {
         case '\b':
@@ -431,19 +439,20 @@ serialize_number(purc_rwstream_t rws, double d, size_t *len_expected)
         }
     }
     else {
-        double test;
-
         /* try to format the double without decimals */
-        size = snprintf(buf, sizeof(buf), "%.0f", d);
-        if (size < 0 || size >= (int)sizeof(buf)) {
-            pcinst_set_error(PURC_ERROR_TOO_SMALL_BUFF);
-            return -1;
-        }
-
-        /* Check whether the original double can be recovered */
-        if ((sscanf(buf, "%lg", &test) != 1) || !equal_doubles(test, d)) {
-            /* If not, return 0 and call serialize_double */
-            return 0;
+        size = (int)pcutils_dtoa_integer(d, INFINITY, buf);
+        if (size == 0) {
+            /* If not integral, or too long to be written without the
+               exponent, return 0 and call serialize_double */
+            if (fabs(d) < 9223372036854775808.0 || fabs(d) >= 1e126)
+                return 0;
+
+            /* any double beyond int64_t is integral */
+            size = snprintf(buf, sizeof(buf), "%.0f", d);
+            if (size < 0 || size >= (int)sizeof(buf)) {
+                pcinst_set_error(PURC_ERROR_TOO_SMALL_BUFF);
+                return -1;
+            }
         }
     }
 
@@ -467,11 +476,17 @@ serialize_double(purc_rwstream_t rws, double d, int flags,
         format = std_format;
     }
 
-    size = snprintf(buf, sizeof(buf), format, d);
-    // although unlikely, snprintf might fail
-    if (UNLIKELY(size < 0)) {
-        pcinst_set_error(PURC_ERROR_OUTPUT);
-        return -1;
+    if (format == std_format) {
+        /* the shortest digits which read back to the same double */
+        size = (int)pcutils_dtoa_shortest(d, buf);
+    }
+    else {
+        size = snprintf(buf, sizeof(buf), format, d);
+        // although unlikely, snprintf might fail
+        if (UNLIKELY(size < 0)) {
+            pcinst_set_error(PURC_ERROR_OUTPUT);
+            return -1;
+        }
     }
 
     p = strchr(buf, ',');
@@ -547,7 +562,12 @@ serialize_long_double(purc_rwstream_t rws, long double ld, int flags,
             format = std_format;
         }
 
-        size = snprintf(buf, sizeof(buf) - 2, format, ld);
+        /* `%.17Lg` gives the integers less than 1e17 without decimals */
+        size = 0;
+        if (format == std_format)
+            size = (int)pcutils_ldtoa_integer(ld, 1e17L, buf);
+        if (size == 0)
+            size = snprintf(buf, sizeof(buf) - 2, format, ld);
         if (UNLIKELY(size < 0)) {
             pcinst_set_error(PURC_ERROR_OUTPUT);
             return -1;
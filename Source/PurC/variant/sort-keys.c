@@ -0,0 +1,245 @@
+/*
+ * @file sort-keys.c
+ * @date 2022/12/05
+ * @brief Sorting the members of a container against precomputed keys.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "private/variant.h"
+#include "private/errors.h"
+#include "variant-internals.h"
+#include "purc-errors.h"
+#include "purc-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct sort_keys {
+    const enum pcvariant_sort_key_type *types;
+    size_t                              nr_keys;
+    bool                                desc;
+
+    /* nr_keys keys per member, in the original order of the members */
+    struct pcvariant_sort_key          *keys;
+};
+
+static int
+compare_members(const struct sort_keys *sk, size_t l, size_t r)
+{
+    const struct pcvariant_sort_key *kl = sk->keys + l * sk->nr_keys;
+    const struct pcvariant_sort_key *kr = sk->keys + r * sk->nr_keys;
+
+    for (size_t i = 0; i < sk->nr_keys; i++) {
+        int ret;
+
+        if (sk->types[i] == PCVARIANT_SORT_KEY_NUMBER) {
+            ret = (kl[i].d > kr[i].d) ? 1 : (kl[i].d < kr[i].d ? -1 : 0);
+        }
+        else if (kl[i].s == NULL || kr[i].s == NULL) {
+            ret = 0;
+        }
+        else if (sk->types[i] == PCVARIANT_SORT_KEY_CASELESS) {
+            ret = pcutils_strcasecmp(kl[i].s, kr[i].s);
+        }
+        else {
+            ret = strcmp(kl[i].s, kr[i].s);
+        }
+
+        if (ret != 0)
+            return sk->desc ? -ret : ret;
+    }
+
+    return 0;
+}
+
+/* bottom-up merge sort of the indexes; stable, needs an auxiliary vector
+   of the same size */
+static size_t *
+merge_sort(const struct sort_keys *sk, size_t *idx, size_t *aux, size_t nr)
+{
+    size_t *from = idx, *to = aux;
+
+    for (size_t width = 1; width < nr; width *= 2) {
+        for (size_t lo = 0; lo < nr; lo += width * 2) {
+            size_t mid = lo + width < nr ? lo + width : nr;
+            size_t hi = mid + width < nr ? mid + width : nr;
+            size_t i = lo, j = mid, k = lo;
+
+            /* skip the merging if the runs are already in order */
+            if (mid == hi ||
+                    compare_members(sk, from[mid - 1], from[mid]) <= 0) {
+                memcpy(to + lo, from + lo, (hi - lo) * sizeof(*from));
+                continue;
+            }
+
+            while (i < mid && j < hi) {
+                if (compare_members(sk, from[j], from[i]) < 0)
+                    to[k++] = from[j++];
+                else
+                    to[k++] = from[i++];
+            }
+            while (i < mid)
+                to[k++] = from[i++];
+            while (j < hi)
+                to[k++] = from[j++];
+        }
+
+        size_t *tmp = from;
+        from = to;
+        to = tmp;
+    }
+
+    return from;
+}
+
+static purc_variant_t
+get_member(purc_variant_t value, size_t i)
+{
+    if (value->type == PURC_VARIANT_TYPE_ARRAY) {
+        variant_arr_t data = pcvar_arr_get_data(value);
+        return data->vals[i];
+    }
+
+    variant_set_t data = pcvar_set_get_data(value);
+    struct set_node *node;
+    node = container_of(data->al.nodes[i], struct set_node, alnode);
+    return node->val;
+}
+
+static int
+permute_array(purc_variant_t arr, const size_t *order)
+{
+    variant_arr_t data = pcvar_arr_get_data(arr);
+
+    purc_variant_t *vals = malloc(data->nr * sizeof(*vals));
+    if (vals == NULL)
+        goto failed;
+
+    for (size_t i = 0; i < data->nr; i++)
+        vals[i] = data->vals[order[i]];
+
+    if (data->anchors) {
+        // the anchors shall move along with the values
+        struct arr_node **anchors;
+        anchors = malloc(data->nr * sizeof(*anchors));
+        if (anchors == NULL) {
+            free(vals);
+            goto failed;
+        }
+
+        for (size_t i = 0; i < data->nr; i++)
+            anchors[i] = data->anchors[order[i]];
+        memcpy(data->anchors, anchors, data->nr * sizeof(*anchors));
+        free(anchors);
+    }
+
+    memcpy(data->vals, vals, data->nr * sizeof(*vals));
+    free(vals);
+    return 0;
+
+failed:
+    pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+    return -1;
+}
+
+static int
+permute_set(purc_variant_t set, const size_t *order)
+{
+    variant_set_t data = pcvar_set_get_data(set);
+    struct pcutils_array_list *al = &data->al;
+
+    struct pcutils_array_list_node **nodes;
+    nodes = malloc(al->nr * sizeof(*nodes));
+    if (nodes == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    for (size_t i = 0; i < al->nr; i++)
+        nodes[i] = al->nodes[order[i]];
+
+    for (size_t i = 0; i < al->nr; i++) {
+        al->nodes[i] = nodes[i];
+        nodes[i]->idx = i;
+    }
+    free(nodes);
+    return 0;
+}
+
+int pcvariant_sort_by_keys(purc_variant_t value,
+        const enum pcvariant_sort_key_type *types, size_t nr_keys, bool desc,
+        pcvariant_sort_decorate_f decorate, void *ud)
+{
+    size_t nr;
+    if (value == PURC_VARIANT_INVALID || nr_keys == 0 || decorate == NULL) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+    else if (value->type == PURC_VARIANT_TYPE_ARRAY) {
+        nr = pcvar_arr_get_data(value)->nr;
+    }
+    else if (value->type == PURC_VARIANT_TYPE_SET) {
+        nr = pcvar_set_get_data(value)->al.nr;
+    }
+    else {
+        pcinst_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return -1;
+    }
+
+    if (nr < 2)
+        return 0;
+
+    int ret = -1;
+    const size_t *order;
+    struct sort_keys sk = {
+        .types = types,
+        .nr_keys = nr_keys,
+        .desc = desc,
+    };
+
+    size_t *idx = malloc(nr * 2 * sizeof(*idx));
+    sk.keys = calloc(nr * nr_keys, sizeof(*sk.keys));
+    if (idx == NULL || sk.keys == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto out;
+    }
+
+    for (size_t i = 0; i < nr; i++) {
+        if (decorate(get_member(value, i), sk.keys + i * nr_keys, ud))
+            goto out;
+        idx[i] = i;
+    }
+
+    order = merge_sort(&sk, idx, idx + nr, nr);
+    if (value->type == PURC_VARIANT_TYPE_ARRAY)
+        ret = permute_array(value, order);
+    else
+        ret = permute_set(value, order);
+
+out:
+    if (sk.keys) {
+        /* the keys of a member partly decorated are freed as well */
+        for (size_t i = 0; i < nr * nr_keys; i++)
+            free(sk.keys[i].s);
+        free(sk.keys);
+    }
+    free(idx);
+    return ret;
+}
@@ -0,0 +1,453 @@
+/*
+ * @file strict-json.c
+ * @date 2022/12/12
+ * @brief Making variants directly from strict JSON text.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "private/variant.h"
+#include "private/ejson.h"
+#include "variant-internals.h"
+#include "purc-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* the eJSON parser fails with the deeper containers */
+#define MAX_DEPTH       PCEJSON_DEFAULT_DEPTH
+
+/* the length of the longest number converted in the local buffer */
+#define LEN_NUMBER_BUF  64
+
+struct json_reader {
+    const char     *p;
+    const char     *end;
+
+    /* the scratch buffer for the strings having escape sequences */
+    char           *buf;
+    size_t          len;
+    size_t          sz;
+};
+
+struct json_container {
+    purc_variant_t  value;      // an array or an object
+    purc_variant_t  key;        // the key of the member being parsed
+};
+
+static inline bool is_json_ws(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline bool is_json_delimiter(const struct json_reader *rd)
+{
+    return rd->p == rd->end || is_json_ws(*rd->p) ||
+        *rd->p == ',' || *rd->p == ']' || *rd->p == '}';
+}
+
+static inline void skip_ws(struct json_reader *rd)
+{
+    while (rd->p < rd->end && is_json_ws(*rd->p))
+        rd->p++;
+}
+
+static bool buf_append(struct json_reader *rd, const char *bytes, size_t n)
+{
+    if (rd->len + n > rd->sz) {
+        size_t sz = rd->sz ? rd->sz * 2 : 256;
+        while (sz < rd->len + n)
+            sz *= 2;
+
+        char *buf = realloc(rd->buf, sz);
+        if (buf == NULL)
+            return false;
+        rd->buf = buf;
+        rd->sz = sz;
+    }
+
+    memcpy(rd->buf + rd->len, bytes, n);
+    rd->len += n;
+    return true;
+}
+
+static inline bool is_hex_digit(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+        (c >= 'A' && c <= 'F');
+}
+
+/* The bytes which end a run of plain characters in a string: `$` starts
+   an eJSON expression and a raw control character is not valid JSON. */
+static inline bool is_special_in_string(unsigned char c)
+{
+    return c == '"' || c == '\\' || c == '$' || c < 0x20;
+}
+
+/*
+ * Reads a string; the reader points to the opening quotation mark.
+ *
+ * The escape sequences are handled in the same way as the eJSON parser:
+ * `\"`, `\\` and `\/` are replaced by the escaped characters, while
+ * `\b`, `\f`, `\n`, `\r`, `\t` and `\uXXXX` are kept as they are.
+ */
+static purc_variant_t read_string(struct json_reader *rd)
+{
+    const char *start = ++rd->p;
+    bool non_ascii = false;
+
+    while (rd->p < rd->end && !is_special_in_string(*rd->p)) {
+        if ((unsigned char)*rd->p >= 0x80)
+            non_ascii = true;
+        rd->p++;
+    }
+
+    const char *str = start;
+    size_t len = rd->p - start;
+    if (rd->p < rd->end && *rd->p == '\\') {
+        rd->len = 0;
+        for (;;) {
+            if (!buf_append(rd, start, rd->p - start))
+                return PURC_VARIANT_INVALID;
+
+            if (rd->p == rd->end || *rd->p != '\\')
+                break;
+
+            const char *esc = rd->p;
+            if (esc + 1 == rd->end)
+                return PURC_VARIANT_INVALID;
+
+            switch (esc[1]) {
+            case '"':
+            case '\\':
+            case '/':
+                if (!buf_append(rd, esc + 1, 1))
+                    return PURC_VARIANT_INVALID;
+                rd->p += 2;
+                break;
+
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                if (!buf_append(rd, esc, 2))
+                    return PURC_VARIANT_INVALID;
+                rd->p += 2;
+                break;
+
+            case 'u':
+                if (rd->end - esc < 6 || !is_hex_digit(esc[2]) ||
+                        !is_hex_digit(esc[3]) || !is_hex_digit(esc[4]) ||
+                        !is_hex_digit(esc[5]))
+                    return PURC_VARIANT_INVALID;
+                if (!buf_append(rd, esc, 6))
+                    return PURC_VARIANT_INVALID;
+                rd->p += 6;
+                break;
+
+            default:
+                return PURC_VARIANT_INVALID;
+            }
+
+            start = rd->p;
+            while (rd->p < rd->end && !is_special_in_string(*rd->p)) {
+                if ((unsigned char)*rd->p >= 0x80)
+                    non_ascii = true;
+                rd->p++;
+            }
+        }
+
+        str = rd->buf;
+        len = rd->len;
+    }
+
+    if (rd->p == rd->end || *rd->p != '"')
+        return PURC_VARIANT_INVALID;
+    rd->p++;
+
+    if (non_ascii && !pcutils_string_check_utf8_len(str, len, NULL, NULL))
+        return PURC_VARIANT_INVALID;
+
+    return purc_variant_make_string_ex(str, len, false);
+}
+
+static purc_variant_t read_number(struct json_reader *rd)
+{
+    const char *start = rd->p;
+    bool negative = false;
+
+    if (*rd->p == '-') {
+        negative = true;
+        rd->p++;
+    }
+
+    if (rd->p == rd->end)
+        return PURC_VARIANT_INVALID;
+
+    /* no leading zeros */
+    if (*rd->p == '0') {
+        rd->p++;
+    }
+    else if (*rd->p >= '1' && *rd->p <= '9') {
+        while (rd->p < rd->end && *rd->p >= '0' && *rd->p <= '9')
+            rd->p++;
+    }
+    else {
+        return PURC_VARIANT_INVALID;
+    }
+
+    size_t nr_int_digits = rd->p - start - (negative ? 1 : 0);
+    bool integer = true;
+
+    if (rd->p < rd->end && *rd->p == '.') {
+        integer = false;
+        rd->p++;
+        if (rd->p == rd->end || *rd->p < '0' || *rd->p > '9')
+            return PURC_VARIANT_INVALID;
+        while (rd->p < rd->end && *rd->p >= '0' && *rd->p <= '9')
+            rd->p++;
+    }
+
+    if (rd->p < rd->end && (*rd->p == 'e' || *rd->p == 'E')) {
+        integer = false;
+        rd->p++;
+        if (rd->p < rd->end && (*rd->p == '+' || *rd->p == '-'))
+            rd->p++;
+        if (rd->p == rd->end || *rd->p < '0' || *rd->p > '9')
+            return PURC_VARIANT_INVALID;
+        while (rd->p < rd->end && *rd->p >= '0' && *rd->p <= '9')
+            rd->p++;
+    }
+
+    /* the suffixes of eJSON, like `L` and `UL`, are not here */
+    if (!is_json_delimiter(rd))
+        return PURC_VARIANT_INVALID;
+
+    double d;
+    if (integer && nr_int_digits <= 15) {
+        /* exact in a double; the same as strtod() */
+        int64_t i = 0;
+        for (const char *p = start + (negative ? 1 : 0); p < rd->p; p++)
+            i = i * 10 + (*p - '0');
+        d = negative ? -(double)i : (double)i;
+    }
+    else {
+        size_t len = rd->p - start;
+        char local[LEN_NUMBER_BUF];
+        char *tmp = local;
+        if (len >= sizeof(local)) {
+            tmp = malloc(len + 1);
+            if (tmp == NULL)
+                return PURC_VARIANT_INVALID;
+        }
+
+        memcpy(tmp, start, len);
+        tmp[len] = '\0';
+        d = strtod(tmp, NULL);
+        if (tmp != local)
+            free(tmp);
+    }
+
+    return purc_variant_make_number(d);
+}
+
+static purc_variant_t read_literal(struct json_reader *rd)
+{
+    static const struct {
+        const char *literal;
+        size_t      len;
+    } literals[] = {
+        { "true",   4 },
+        { "false",  5 },
+        { "null",   4 },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(literals); i++) {
+        size_t len = literals[i].len;
+        if ((size_t)(rd->end - rd->p) >= len &&
+                memcmp(rd->p, literals[i].literal, len) == 0) {
+            rd->p += len;
+            if (!is_json_delimiter(rd))
+                return PURC_VARIANT_INVALID;
+
+            if (i == 2)
+                return purc_variant_make_null();
+            return purc_variant_make_boolean(i == 0);
+        }
+    }
+
+    return PURC_VARIANT_INVALID;
+}
+
+/* reads `"key" :` of a member of an object */
+static purc_variant_t read_key(struct json_reader *rd)
+{
+    skip_ws(rd);
+    if (rd->p == rd->end || *rd->p != '"')
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t key = read_string(rd);
+    if (key == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    skip_ws(rd);
+    if (rd->p == rd->end || *rd->p != ':') {
+        purc_variant_unref(key);
+        return PURC_VARIANT_INVALID;
+    }
+
+    rd->p++;
+    return key;
+}
+
+/* Adds the value to the container; the reference of value is consumed.
+   No listener can be on the new container, so the member is added without
+   firing the events or building the reverse update chain. */
+static bool add_member(struct json_container *c, purc_variant_t value)
+{
+    int ret;
+    if (c->key) {
+        ret = pcvar_obj_set(c->value, c->key, value);
+        purc_variant_unref(c->key);
+        c->key = PURC_VARIANT_INVALID;
+    }
+    else {
+        ret = pcvar_arr_append(c->value, value);
+    }
+
+    purc_variant_unref(value);
+    return ret == 0;
+}
+
+purc_variant_t
+pcvariant_make_from_strict_json(const char *json, size_t len)
+{
+    struct json_reader rd = { json, json + len, NULL, 0, 0 };
+    struct json_container stack[MAX_DEPTH];
+    int top = -1;
+    purc_variant_t value = PURC_VARIANT_INVALID;
+
+    /* skip the byte order mark like the eJSON parser */
+    if (len >= 3 && memcmp(json, "\xEF\xBB\xBF", 3) == 0)
+        rd.p += 3;
+
+    for (;;) {
+        skip_ws(&rd);
+        if (rd.p == rd.end)
+            goto failed;
+
+        char c = *rd.p;
+        if (c == '{' || c == '[') {
+            if (top + 1 == MAX_DEPTH)
+                goto failed;
+
+            value = (c == '{') ? pcvar_make_obj() : pcvar_make_arr();
+            if (value == PURC_VARIANT_INVALID)
+                goto failed;
+
+            rd.p++;
+            skip_ws(&rd);
+            if (rd.p < rd.end && *rd.p == (c == '{' ? '}' : ']')) {
+                /* an empty container is a value */
+                rd.p++;
+            }
+            else {
+                top++;
+                stack[top].value = value;
+                stack[top].key = PURC_VARIANT_INVALID;
+                value = PURC_VARIANT_INVALID;
+
+                if (c == '{' &&
+                        (stack[top].key = read_key(&rd)) ==
+                        PURC_VARIANT_INVALID)
+                    goto failed;
+
+                /* the first member */
+                continue;
+            }
+        }
+        else if (c == '"') {
+            value = read_string(&rd);
+        }
+        else if (c == '-' || (c >= '0' && c <= '9')) {
+            value = read_number(&rd);
+        }
+        else {
+            value = read_literal(&rd);
+        }
+
+        if (value == PURC_VARIANT_INVALID)
+            goto failed;
+
+        /* add the value to the containers, and close them if they end */
+        for (;;) {
+            if (top < 0)
+                goto done;
+
+            struct json_container *curr = stack + top;
+            bool ok = add_member(curr, value);
+            value = PURC_VARIANT_INVALID;
+            if (!ok)
+                goto failed;
+
+            skip_ws(&rd);
+            if (rd.p == rd.end)
+                goto failed;
+
+            bool is_object = (curr->value->type == PURC_VARIANT_TYPE_OBJECT);
+            if (*rd.p == ',') {
+                rd.p++;
+                if (is_object &&
+                        (curr->key = read_key(&rd)) == PURC_VARIANT_INVALID)
+                    goto failed;
+                break;
+            }
+            else if (*rd.p == (is_object ? '}' : ']')) {
+                rd.p++;
+                value = curr->value;
+                top--;
+            }
+            else {
+                goto failed;
+            }
+        }
+    }
+
+done:
+    skip_ws(&rd);
+    if (rd.p != rd.end)
+        goto failed;
+
+    free(rd.buf);
+    return value;
+
+failed:
+    if (value)
+        purc_variant_unref(value);
+
+    for (; top >= 0; top--) {
+        if (stack[top].key)
+            purc_variant_unref(stack[top].key);
+        purc_variant_unref(stack[top].value);
+    }
+
+    free(rd.buf);
+    return PURC_VARIANT_INVALID;
+}
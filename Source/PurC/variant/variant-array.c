@@ -36,11 +36,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* the minimal capacity of the storage once the first member is added */
+#define ARR_MIN_SIZE            4
+
 static size_t
 variant_arr_length(variant_arr_t data)
 {
-    struct pcutils_array_list *al = &data->al;
-    return pcutils_array_list_length(al);
+    return data->nr;
 }
 
 static inline bool
@@ -129,102 +131,242 @@ pcvar_arr_get_data(purc_variant_t arr)
     return (variant_arr_t)arr->sz_ptr[1];
 }
 
-static void
-break_rev_update_chain(purc_variant_t arr, struct arr_node *node)
+static int
+arr_reserve(variant_arr_t data, size_t capacity)
 {
-    struct pcvar_rev_update_edge edge = {
-        .parent        = arr,
-        .arr_me        = node,
-    };
+    if (capacity <= data->sz)
+        return 0;
 
-    pcvar_break_edge_to_parent(node->val, &edge);
-    pcvar_break_rue_downward(node->val);
+    size_t sz = data->sz ? data->sz : ARR_MIN_SIZE;
+    while (sz < capacity) {
+        if (sz > SIZE_MAX / 2 / sizeof(purc_variant_t)) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+        sz *= 2;
+    }
+
+    purc_variant_t *vals;
+    vals = (purc_variant_t*)realloc(data->vals, sz * sizeof(*vals));
+    if (!vals) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+    data->vals = vals;
+
+    if (data->anchors) {
+        struct arr_node **anchors;
+        anchors = (struct arr_node**)realloc(data->anchors,
+                sz * sizeof(*anchors));
+        if (!anchors) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+        data->anchors = anchors;
+    }
+
+    data->sz = sz;
+    return 0;
 }
 
 static void
-arr_node_release(purc_variant_t arr, struct arr_node *node)
+arr_shrink(variant_arr_t data)
 {
-    if (!node)
+    if (data->sz <= ARR_MIN_SIZE * 4 || data->nr > data->sz / 4)
         return;
 
-    break_rev_update_chain(arr, node);
-
-    if (node->node.idx != (size_t)-1) {
-        variant_arr_t data = pcvar_arr_get_data(arr);
-        PC_ASSERT(data);
+    // the storage of the anchors may stay larger than sz on failure
+    size_t sz = data->sz / 2;
+    purc_variant_t *vals;
+    vals = (purc_variant_t*)realloc(data->vals, sz * sizeof(*vals));
+    if (!vals)
+        return;
+    data->vals = vals;
+
+    if (data->anchors) {
+        struct arr_node **anchors;
+        anchors = (struct arr_node**)realloc(data->anchors,
+                sz * sizeof(*anchors));
+        if (anchors)
+            data->anchors = anchors;
+    }
 
-        struct pcutils_array_list *al = &data->al;
-        PC_ASSERT(al);
+    data->sz = sz;
+}
 
-        struct pcutils_array_list_node *p;
-        int r = pcutils_array_list_remove(al, node->node.idx, &p);
-        PC_ASSERT(r == 0);
-        PC_ASSERT(&node->node == p);
-        PC_ASSERT(node->node.idx == (size_t)-1);
+static struct arr_node*
+arr_anchor_create(purc_variant_t arr)
+{
+    struct arr_node *anchor;
+    anchor = (struct arr_node*)malloc(sizeof(*anchor));
+    if (!anchor) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
     }
 
-    PURC_VARIANT_SAFE_CLEAR(node->val);
+    anchor->arr = arr;
+    return anchor;
 }
 
 static void
-arr_node_destroy(purc_variant_t arr, struct arr_node *node)
+arr_anchors_destroy(variant_arr_t data)
 {
-    if (!node)
+    if (!data->anchors)
         return;
 
-    arr_node_release(arr, node);
-    free(node);
+    for (size_t i = 0; i < data->nr; i++) {
+        free(data->anchors[i]);
+    }
+
+    free(data->anchors);
+    data->anchors = NULL;
 }
 
-static purc_variant_t
-variant_arr_make_pos(variant_arr_t data, size_t idx)
+/* creates the side table of the anchors once the array joins a set */
+static int
+arr_anchors_create(purc_variant_t arr)
 {
-    size_t len = variant_arr_length(data);
-    if (idx > len)
-        idx = len;
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    if (data->anchors)
+        return 0;
 
-    return purc_variant_make_longint(idx);
-}
+    if (arr_reserve(data, ARR_MIN_SIZE))
+        return -1;
 
-static struct arr_node*
-arr_node_create(purc_variant_t val)
-{
-    struct arr_node *node;
-    node = (struct arr_node*)calloc(1, sizeof(*node));
-    if (!node) {
+    data->anchors = (struct arr_node**)calloc(data->sz,
+            sizeof(*data->anchors));
+    if (!data->anchors) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return NULL;
+        return -1;
     }
 
-    node->node.idx = (size_t)-1;
+    for (size_t i = 0; i < data->nr; i++) {
+        data->anchors[i] = arr_anchor_create(arr);
+        if (!data->anchors[i]) {
+            arr_anchors_destroy(data);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+break_rev_update_chain(purc_variant_t arr, size_t idx, purc_variant_t val)
+{
+    variant_arr_t data = pcvar_arr_get_data(arr);
 
-    node->val = val;
-    purc_variant_ref(val);
+    if (data->anchors) {
+        struct pcvar_rev_update_edge edge = {
+            .parent        = arr,
+            .arr_me        = data->anchors[idx],
+        };
+
+        pcvar_break_edge_to_parent(val, &edge);
+    }
 
-    return node;
+    pcvar_break_rue_downward(val);
 }
 
 static int
-build_rev_update_chain(purc_variant_t arr, struct arr_node *node)
+build_rev_update_chain(purc_variant_t arr, size_t idx, purc_variant_t val)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
 
+    if (arr_anchors_create(arr))
+        return -1;
+
     int r;
+    variant_arr_t data = pcvar_arr_get_data(arr);
 
     struct pcvar_rev_update_edge edge = {
         .parent        = arr,
-        .arr_me        = node,
+        .arr_me        = data->anchors[idx],
     };
 
-    r = pcvar_build_edge_to_parent(node->val, &edge);
+    r = pcvar_build_edge_to_parent(val, &edge);
     if (r == 0) {
-        r = pcvar_build_rue_downward(node->val);
+        r = pcvar_build_rue_downward(val);
     }
 
     return r ? -1 : 0;
 }
 
+/* Stores the value at idx and moves the following members backward,
+   the value is referenced. */
+static int
+arr_insert_at(purc_variant_t arr, size_t idx, purc_variant_t val)
+{
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    PC_ASSERT(idx <= data->nr);
+
+    if (arr_reserve(data, data->nr + 1))
+        return -1;
+
+    size_t nr_moved = data->nr - idx;
+    if (data->anchors) {
+        struct arr_node *anchor = arr_anchor_create(arr);
+        if (!anchor)
+            return -1;
+
+        memmove(data->anchors + idx + 1, data->anchors + idx,
+                nr_moved * sizeof(*data->anchors));
+        data->anchors[idx] = anchor;
+    }
+
+    memmove(data->vals + idx + 1, data->vals + idx,
+            nr_moved * sizeof(*data->vals));
+    data->vals[idx] = purc_variant_ref(val);
+    data->nr++;
+
+    return 0;
+}
+
+/* Takes the member at idx out and moves the following members forward,
+   the caller owns the returned value. */
+static purc_variant_t
+arr_take_at(variant_arr_t data, size_t idx)
+{
+    PC_ASSERT(idx < data->nr);
+
+    purc_variant_t val = data->vals[idx];
+    size_t nr_moved = data->nr - idx - 1;
+
+    memmove(data->vals + idx, data->vals + idx + 1,
+            nr_moved * sizeof(*data->vals));
+
+    if (data->anchors) {
+        free(data->anchors[idx]);
+        memmove(data->anchors + idx, data->anchors + idx + 1,
+                nr_moved * sizeof(*data->anchors));
+    }
+
+    data->nr--;
+    arr_shrink(data);
+
+    return val;
+}
+
+static void
+arr_release_at(purc_variant_t arr, size_t idx)
+{
+    variant_arr_t data = pcvar_arr_get_data(arr);
+
+    break_rev_update_chain(arr, idx, data->vals[idx]);
+    purc_variant_unref(arr_take_at(data, idx));
+}
+
+static purc_variant_t
+variant_arr_make_pos(variant_arr_t data, size_t idx)
+{
+    size_t len = variant_arr_length(data);
+    if (idx > len)
+        idx = len;
+
+    return purc_variant_make_longint(idx);
+}
+
 static int
 check_grow(purc_variant_t arr, size_t idx, purc_variant_t val)
 {
@@ -278,10 +420,7 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx > nr)
         idx = nr;
 
@@ -289,8 +428,6 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
     if (pos == PURC_VARIANT_INVALID)
         return -1;
 
-    struct arr_node *node = NULL;
-
     do {
         if (check) {
             if (!grow(arr, pos, val, check))
@@ -300,23 +437,14 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
                 break;
         }
 
-        node = arr_node_create(val);
-        if (!node)
-            break;
-
-        int r;
-        PC_ASSERT(node->node.idx == (size_t)-1);
-        r = pcutils_array_list_insert_before(al, idx, &node->node);
-        if (r) {
-            PC_ASSERT(node->node.idx == (size_t)-1);
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        if (arr_insert_at(arr, idx, val))
             break;
-        }
-        PC_ASSERT(node->node.idx != (size_t)-1);
 
         if (check) {
-            if (build_rev_update_chain(arr, node))
+            if (build_rev_update_chain(arr, idx, val)) {
+                arr_release_at(arr, idx);
                 break;
+            }
 
             pcvar_adjust_set_by_descendant(arr);
             grown(arr, pos, val, check);
@@ -327,7 +455,6 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
         return 0;
     } while (0);
 
-    arr_node_destroy(arr, node);
     purc_variant_unref(pos);
 
     return -1;
@@ -340,9 +467,11 @@ refresh_extra(purc_variant_t arr)
     variant_arr_t data = pcvar_arr_get_data(arr);
     if (data) {
         extra += sizeof(*data);
-        struct pcutils_array_list *al = &data->al;
-        extra += al->sz * sizeof(*al->nodes);
-        extra += al->nr * sizeof(struct arr_node);
+        extra += data->sz * sizeof(*data->vals);
+        if (data->anchors) {
+            extra += data->sz * sizeof(*data->anchors);
+            extra += data->nr * sizeof(struct arr_node);
+        }
     }
     pcvariant_stat_set_extra_size(arr, extra);
 }
@@ -352,8 +481,7 @@ variant_arr_append(purc_variant_t arr, purc_variant_t val,
         bool check)
 {
     variant_arr_t data = pcvar_arr_get_data(arr);
-    struct pcutils_array_list *al = &data->al;
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     int r = variant_arr_insert_before(arr, nr, val, check);
     refresh_extra(arr);
     return r ? -1 : 0;
@@ -369,19 +497,14 @@ variant_arr_prepend(purc_variant_t arr, purc_variant_t val,
 static purc_variant_t
 variant_arr_get(variant_arr_t data, size_t idx)
 {
-    struct pcutils_array_list *al = &data->al;
-    struct pcutils_array_list_node *p;
-    p = pcutils_array_list_get(al, idx);
-    if (p == NULL)
+    if (idx >= data->nr)
         return PURC_VARIANT_INVALID;
 
-    struct arr_node *node;
-    node = (struct arr_node*)container_of(p, struct arr_node, node);
-    return node->val;
+    return data->vals[idx];
 }
 
 static int
-check_change(purc_variant_t arr, struct arr_node *node, purc_variant_t val)
+check_change(purc_variant_t arr, size_t idx, purc_variant_t val)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
@@ -396,10 +519,10 @@ check_change(purc_variant_t arr, struct arr_node *node, purc_variant_t val)
         size_t i;
         purc_variant_t v;
         foreach_value_in_variant_array(arr, v, i) {
-            if (i == node->node.idx) {
+            if (i == idx) {
                 found = true;
             }
-            r = pcvar_arr_append(_new, i == node->node.idx ? val : v);
+            r = pcvar_arr_append(_new, i == idx ? val : v);
             if (r)
                 break;
         } end_foreach;
@@ -429,23 +552,15 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx >= nr) {
         purc_set_error(PURC_ERROR_OVERFLOW);
         return -1;
     }
 
-    struct pcutils_array_list_node *p;
-    p = pcutils_array_list_get(al, idx);
-    PC_ASSERT(p);
-
-    struct arr_node *old_node;
-    old_node = (struct arr_node*)container_of(p, struct arr_node, node);
-    PC_ASSERT(old_node->val != PURC_VARIANT_INVALID);
-    if (old_node->val == val) {
+    purc_variant_t old = data->vals[idx];
+    PC_ASSERT(old != PURC_VARIANT_INVALID);
+    if (old == val) {
         // NOTE: keep refc intact
         return 0;
     }
@@ -455,28 +570,22 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
         return -1;
 
     do {
-        purc_variant_t old = old_node->val;
-
         if (check) {
             if (!change(arr, pos, old, val, check))
                 break;
 
-            if (check_change(arr, old_node, val))
+            if (check_change(arr, idx, val))
                 break;
 
-            old_node->val = val;
-
-            if (build_rev_update_chain(arr, old_node)) {
-                break_rev_update_chain(arr, old_node);
-                old_node->val = old;
+            if (build_rev_update_chain(arr, idx, val)) {
+                break_rev_update_chain(arr, idx, val);
                 break;
             }
 
-            old_node->val = old;
-            break_rev_update_chain(arr, old_node);
+            break_rev_update_chain(arr, idx, old);
         }
 
-        old_node->val = purc_variant_ref(val);
+        data->vals[idx] = purc_variant_ref(val);
 
         if (check) {
             pcvar_adjust_set_by_descendant(arr);
@@ -496,7 +605,7 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
 }
 
 static int
-check_shrink(purc_variant_t arr, struct arr_node *node)
+check_shrink(purc_variant_t arr, size_t idx)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
@@ -511,7 +620,7 @@ check_shrink(purc_variant_t arr, struct arr_node *node)
         size_t i;
         purc_variant_t v;
         foreach_value_in_variant_array(arr, v, i) {
-            if (i == node->node.idx) {
+            if (i == idx) {
                 PC_ASSERT(!found);
                 found = true;
                 continue;
@@ -546,10 +655,7 @@ variant_arr_remove(purc_variant_t arr, size_t idx,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx >= nr) {
         // FIXME: failure or success???
         return 0;
@@ -559,38 +665,28 @@ variant_arr_remove(purc_variant_t arr, size_t idx,
     if (pos == PURC_VARIANT_INVALID)
         return -1;
 
-    struct pcutils_array_list_node *p, *n;
-    p = pcutils_array_list_get(al, idx);
-    PC_ASSERT(p);
-
-    struct arr_node *node;
-    node = (struct arr_node*)container_of(p, struct arr_node, node);
-    PC_ASSERT(node->val);
+    purc_variant_t val = data->vals[idx];
+    PC_ASSERT(val);
 
     do {
         if (check) {
-            if (!shrink(arr, pos, node->val, check))
+            if (!shrink(arr, pos, val, check))
                 break;
 
-            if (check_shrink(arr, node))
+            if (check_shrink(arr, idx))
                 break;
-
-            break_rev_update_chain(arr, node);
         }
 
-        PC_ASSERT(node->node.idx != (size_t)-1);
-        int r = pcutils_array_list_remove(al, idx, &n);
-        PC_ASSERT(r == 0);
-        PC_ASSERT(&node->node == n);
-        PC_ASSERT(node->node.idx == (size_t)-1);
+        break_rev_update_chain(arr, idx, val);
+        val = arr_take_at(data, idx);
 
         if (check) {
             pcvar_adjust_set_by_descendant(arr);
 
-            shrunk(arr, pos, node->val, check);
+            shrunk(arr, pos, val, check);
         }
 
-        arr_node_destroy(arr, node);
+        purc_variant_unref(val);
         purc_variant_unref(pos);
 
         return 0;
@@ -608,13 +704,13 @@ array_release (purc_variant_t arr)
     if (!data)
         return;
 
-    struct pcutils_array_list *al = &data->al;
-    struct arr_node *p, *n;
-    array_list_for_each_entry_reverse_safe(al, p, n, node) {
-        arr_node_destroy(arr, p);
-    };
+    for (size_t i = data->nr; i > 0; i--) {
+        break_rev_update_chain(arr, i - 1, data->vals[i - 1]);
+        purc_variant_unref(data->vals[i - 1]);
+    }
 
-    pcutils_array_list_reset(al);
+    arr_anchors_destroy(data);
+    free(data->vals);
 
     if (data->rev_update_chain) {
         pcvar_destroy_rev_update_chain(data->rev_update_chain);
@@ -640,28 +736,18 @@ make_array(size_t sz)
         var->flags         = PCVARIANT_FLAG_EXTRA_SIZE;
         var->refc          = 1;
 
-        size_t initial_size = ARRAY_LIST_DEFAULT_SIZE;
-        if (sz>initial_size)
-            initial_size = sz;
-
         variant_arr_t data = (variant_arr_t)calloc(1, sizeof(*data));
         if (!data) {
             pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
             break;
         }
 
-        struct pcutils_array_list *al;
-        al = &data->al;
-        pcutils_array_list_init(al);
-        if (pcutils_array_list_expand(al, initial_size)) {
-            pcutils_array_list_reset(al);
-            free(data);
-            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            break;
-        }
-
         var->sz_ptr[1]     = (uintptr_t)data;
 
+        // the storage is allocated on the first append if sz is zero
+        if (sz > 0 && arr_reserve(data, sz))
+            break;
+
         refresh_extra(var);
 
         return var;
@@ -868,16 +954,36 @@ struct arr_user_data {
     void *ud;
 };
 
+/* the items being sorted are either the values or struct arr_sort_item */
+struct arr_sort_item {
+    purc_variant_t      val;
+    struct arr_node    *anchor;
+};
+
+#if OS(HURD) || OS(LINUX)
+static int
+sort_cmp(const void *l, const void *r, void *ud)
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD) || OS(WINDOWS)
 static int
-sort_cmp(struct pcutils_array_list_node *l, struct pcutils_array_list_node *r,
-        void *ud)
+sort_cmp(void *ud, const void *l, const void *r)
+#else
+#error Unsupported operating system.
+#endif
 {
-    struct arr_node *l_n, *r_n;
-    l_n = container_of(l, struct arr_node, node);
-    r_n = container_of(r, struct arr_node, node);
-
     struct arr_user_data *d = (struct arr_user_data*)ud;
-    return d->cmp(l_n->val, r_n->val, d->ud);
+    return d->cmp(*(purc_variant_t*)l, *(purc_variant_t*)r, d->ud);
+}
+
+static void
+sort_items(void *items, size_t nr, size_t size, struct arr_user_data *d)
+{
+#if OS(HURD) || OS(LINUX)
+    qsort_r(items, nr, size, sort_cmp, d);
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD)
+    qsort_r(items, nr, size, d, sort_cmp);
+#elif OS(WINDOWS)
+    qsort_s(items, nr, size, sort_cmp, d);
+#endif
 }
 
 static int vrtcmp(purc_variant_t l, purc_variant_t r, void *ud)
@@ -911,7 +1017,56 @@ int pcvariant_array_sort(purc_variant_t arr, void *ud,
         d.cmp = vrtcmp;
     }
 
-    pcutils_array_list_sort(&data->al, &d, sort_cmp);
+    if (data->nr < 2)
+        return 0;
+
+    if (data->anchors == NULL) {
+        sort_items(data->vals, data->nr, sizeof(*data->vals), &d);
+        return 0;
+    }
+
+    // the anchors shall move along with the values
+    struct arr_sort_item *items;
+    items = (struct arr_sort_item*)malloc(data->nr * sizeof(*items));
+    if (!items) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    for (size_t i = 0; i < data->nr; i++) {
+        items[i].val = data->vals[i];
+        items[i].anchor = data->anchors[i];
+    }
+
+    sort_items(items, data->nr, sizeof(*items), &d);
+
+    for (size_t i = 0; i < data->nr; i++) {
+        data->vals[i] = items[i].val;
+        data->anchors[i] = items[i].anchor;
+    }
+    free(items);
+
+    return 0;
+}
+
+int pcvariant_array_swap(purc_variant_t arr, size_t i, size_t j)
+{
+    if (!arr || arr->type != PURC_VARIANT_TYPE_ARRAY)
+        return -1;
+
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    if (i >= data->nr || j >= data->nr)
+        return -1;
+
+    purc_variant_t val = data->vals[i];
+    data->vals[i] = data->vals[j];
+    data->vals[j] = val;
+
+    if (data->anchors) {
+        struct arr_node *anchor = data->anchors[i];
+        data->anchors[i] = data->anchors[j];
+        data->anchors[j] = anchor;
+    }
 
     return 0;
 }
@@ -961,15 +1116,13 @@ pcvar_array_break_rue_downward(purc_variant_t arr)
     if (!data)
         return;
 
-    struct arr_node *p;
-    foreach_in_variant_array(arr, p) {
-        struct pcvar_rev_update_edge edge = {
-            .parent         = arr,
-            .arr_me         = p,
-        };
-        pcvar_break_edge_to_parent(p->val, &edge);
-        pcvar_break_rue_downward(p->val);
+    for (size_t i = 0; i < data->nr; i++) {
+        break_rev_update_chain(arr, i, data->vals[i]);
     }
+
+    // no member refers to the anchors any longer
+    arr_anchors_destroy(data);
+    refresh_extra(arr);
 }
 
 void
@@ -996,16 +1149,20 @@ pcvar_array_build_rue_downward(purc_variant_t arr)
     if (!data)
         return 0;
 
-    struct arr_node *p;
-    foreach_in_variant_array(arr, p) {
+    if (arr_anchors_create(arr))
+        return -1;
+    refresh_extra(arr);
+
+    for (size_t i = 0; i < data->nr; i++) {
+        purc_variant_t val = data->vals[i];
         struct pcvar_rev_update_edge edge = {
             .parent         = arr,
-            .arr_me         = p,
+            .arr_me         = data->anchors[i],
         };
-        int r = pcvar_build_edge_to_parent(p->val, &edge);
+        int r = pcvar_build_edge_to_parent(val, &edge);
         if (r)
             return -1;
-        r = pcvar_build_rue_downward(p->val);
+        r = pcvar_build_rue_downward(val);
         if (r)
             return -1;
     }
@@ -1040,66 +1197,16 @@ pcvar_array_build_edge_to_parent(purc_variant_t arr,
     return r ? -1 : 0;
 }
 
-static struct pcutils_array_list_node*
-next_node(struct pcutils_array_list *al, struct pcutils_array_list_node *node)
-{
-    if (!node)
-        return NULL;
-    size_t count = pcutils_array_list_length(al);
-    size_t idx = node->idx + 1;
-    if (idx >= count)
-        return NULL;
-
-    return pcutils_array_list_get(al, idx);
-}
-
-static struct pcutils_array_list_node*
-prev_node(struct pcutils_array_list *al, struct pcutils_array_list_node *node)
-{
-    if (!node)
-        return NULL;
-    if (node->idx == 0)
-        return NULL;
-
-    size_t count = pcutils_array_list_length(al);
-    size_t idx = node->idx - 1;
-    if (idx >= count)
-        return NULL;
-
-    return pcutils_array_list_get(al, idx);
-}
-
 static void
-it_refresh(struct arr_iterator *it,
-        struct pcutils_array_list *al,
-        struct pcutils_array_list_node *curr)
+it_refresh(struct arr_iterator *it, size_t idx)
 {
-    struct pcutils_array_list_node *next  = NULL;
-    struct pcutils_array_list_node *prev  = NULL;
-    if (curr) {
-        next  = next_node(al, curr);
-        prev  = prev_node(al, curr);
-    }
-
-    if (curr) {
-        it->curr = container_of(curr, struct arr_node, node);
-    }
-    else {
-        it->curr = NULL;
-    }
-
-    if (next) {
-        it->next = container_of(next, struct arr_node, node);
+    variant_arr_t data = pcvar_arr_get_data(it->arr);
+    if (idx < data->nr) {
+        it->idx = idx;
+        it->curr = data->vals[idx];
     }
     else {
-        it->next = NULL;
-    }
-
-    if (prev) {
-        it->prev = container_of(prev, struct arr_node, node);
-    }
-    else {
-        it->prev = NULL;
+        it->curr = PURC_VARIANT_INVALID;
     }
 }
 
@@ -1112,17 +1219,7 @@ pcvar_arr_it_first(purc_variant_t arr)
     if (arr == PURC_VARIANT_INVALID)
         return it;
 
-    variant_arr_t data = pcvar_arr_get_data(arr);
-    size_t count = variant_arr_length(data);
-    if (count == 0)
-        return it;
-
-    struct pcutils_array_list *al = &data->al;
-
-    struct pcutils_array_list_node *first;
-    first = pcutils_array_list_get_first(al);
-
-    it_refresh(&it, al, first);
+    it_refresh(&it, 0);
 
     return it;
 }
@@ -1141,12 +1238,7 @@ pcvar_arr_it_last(purc_variant_t arr)
     if (count == 0)
         return it;
 
-    struct pcutils_array_list *al = &data->al;
-
-    struct pcutils_array_list_node *last;
-    last = pcutils_array_list_get_last(al);
-
-    it_refresh(&it, al, last);
+    it_refresh(&it, count - 1);
 
     return it;
 }
@@ -1154,45 +1246,22 @@ pcvar_arr_it_last(purc_variant_t arr)
 void
 pcvar_arr_it_next(struct arr_iterator *it)
 {
-    if (it->curr == NULL)
+    if (it->curr == PURC_VARIANT_INVALID)
         return;
 
-    if (it->next) {
-        variant_arr_t data = pcvar_arr_get_data(it->arr);
-        struct pcutils_array_list *al = &data->al;
-
-        struct pcutils_array_list_node *next;
-        next = &it->next->node;
-
-        it_refresh(it, al, next);
-    }
-    else {
-        it->curr = NULL;
-        it->next = NULL;
-        it->prev = NULL;
-    }
+    it_refresh(it, it->idx + 1);
 }
 
 void
 pcvar_arr_it_prev(struct arr_iterator *it)
 {
-    if (it->curr == NULL)
+    if (it->curr == PURC_VARIANT_INVALID)
         return;
 
-    if (it->prev) {
-        variant_arr_t data = pcvar_arr_get_data(it->arr);
-        struct pcutils_array_list *al = &data->al;
-
-        struct pcutils_array_list_node *prev;
-        prev = &it->prev->node;
-
-        it_refresh(it, al, prev);
-    }
-    else {
-        it->curr = NULL;
-        it->next = NULL;
-        it->prev = NULL;
+    if (it->idx == 0) {
+        it->curr = PURC_VARIANT_INVALID;
+        return;
     }
-}
-
 
+    it_refresh(it, it->idx - 1);
+}
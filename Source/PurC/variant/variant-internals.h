@@ -178,9 +178,8 @@ pcvar_obj_it_prev(struct obj_iterator *it);
 struct arr_iterator {
     purc_variant_t                arr;
 
-    struct arr_node              *curr;
-    struct arr_node              *next;
-    struct arr_node              *prev;
+    size_t                        idx;
+    purc_variant_t                curr;   // PURC_VARIANT_INVALID at the end
 };
 
 struct arr_iterator
@@ -267,6 +266,12 @@ pcvar_make_set(variant_set_t data);
 int
 pcvar_set_add(purc_variant_t set, purc_variant_t val);
 
+// checks whether the element `node` of the set can be changed to `val`
+// without duplicating another element, by probing the set for `val` only
+int
+pcvar_set_probe_change(purc_variant_t set, struct set_node *node,
+        purc_variant_t val);
+
 int
 pcvar_readjust_set(purc_variant_t set, struct set_node *node);
 
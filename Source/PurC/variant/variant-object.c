@@ -27,6 +27,8 @@
 #include "private/variant.h"
 #include "private/errors.h"
 #include "purc-errors.h"
+#include "private/hashtable.h"
+#include "private/instance.h"
 #include "variant-internals.h"
 
 
@@ -36,7 +38,13 @@
 #include <string.h>
 
 #define OBJ_EXTRA_SIZE(data) (sizeof(*data) + \
-        (data->size) * sizeof(struct obj_node))
+        (data->size) * sizeof(struct obj_node) + \
+        (data->sz_index) * sizeof(struct obj_node *))
+
+/* The objects with more members than this are indexed by the hash of keys;
+   looking up a small object in the rbtree costs only a few strcmp() */
+#define OBJ_INDEX_MIN_SIZE      8
+#define OBJ_INDEX_MIN_SLOTS     32
 
 static inline bool
 grow(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
@@ -127,6 +135,159 @@ pcvar_obj_get_data(purc_variant_t obj)
     return data;
 }
 
+static inline uint32_t
+obj_key_hash(const char *key)
+{
+    return (uint32_t)pchash_default_char_hash(key);
+}
+
+static inline bool
+obj_index_disabled(void)
+{
+    struct pcinst *inst = pcinst_current();
+    return inst && inst->variant_heap && inst->variant_heap->obj_index_disabled;
+}
+
+static void
+obj_index_put(struct obj_node **index, size_t sz_index, struct obj_node *node)
+{
+    size_t mask = sz_index - 1;
+    size_t i = node->hash & mask;
+    while (index[i])
+        i = (i + 1) & mask;
+    index[i] = node;
+}
+
+static void
+obj_index_drop(variant_obj_t data)
+{
+    free(data->index);
+    data->index = NULL;
+    data->sz_index = 0;
+}
+
+static int
+obj_index_rebuild(variant_obj_t data, size_t sz_index)
+{
+    struct obj_node **index;
+    index = (struct obj_node **)calloc(sz_index, sizeof(*index));
+    if (!index)
+        return -1;
+
+    /* the hashes are only kept up to date while the object is indexed */
+    bool rehash = (data->index == NULL);
+    struct rb_node *p = pcutils_rbtree_first(&data->kvs);
+    for (; p; p = pcutils_rbtree_next(p)) {
+        struct obj_node *node = container_of(p, struct obj_node, node);
+        if (rehash)
+            node->hash = obj_key_hash(purc_variant_get_string_const(node->key));
+        obj_index_put(index, sz_index, node);
+    }
+
+    free(data->index);
+    data->index = index;
+    data->sz_index = sz_index;
+    return 0;
+}
+
+/* Returns the power of two slots to index the members at half load */
+static size_t
+obj_index_slots(size_t nr_members)
+{
+    size_t sz_index = OBJ_INDEX_MIN_SLOTS;
+    while (sz_index < nr_members * 2)
+        sz_index <<= 1;
+    return sz_index;
+}
+
+/* Called after the node has been linked into the rbtree */
+static void
+obj_index_add(variant_obj_t data, struct obj_node *node)
+{
+    if (data->index == NULL) {
+        /* without the index, the lookups fall back to the rbtree; the
+           object may have grown large after the index was dropped */
+        if (data->size > OBJ_INDEX_MIN_SIZE && !obj_index_disabled())
+            obj_index_rebuild(data, obj_index_slots(data->size));
+        return;
+    }
+
+    node->hash = obj_key_hash(purc_variant_get_string_const(node->key));
+    if (data->size * 2 > data->sz_index) {
+        if (obj_index_rebuild(data, data->sz_index * 2))
+            obj_index_drop(data);
+        return;
+    }
+
+    obj_index_put(data->index, data->sz_index, node);
+}
+
+/* Removes the node with backward shifting, so no tombstone is needed */
+static void
+obj_index_remove(variant_obj_t data, struct obj_node *node)
+{
+    if (data->index == NULL)
+        return;
+
+    struct obj_node **index = data->index;
+    size_t mask = data->sz_index - 1;
+    size_t i = node->hash & mask;
+    while (index[i] != node) {
+        if (index[i] == NULL)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (index[j] == NULL)
+            break;
+
+        /* leave the entry if its home slot is cyclically in (i, j] */
+        size_t k = index[j]->hash & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        index[i] = index[j];
+        i = j;
+    }
+
+    index[i] = NULL;
+}
+
+static struct obj_node *
+obj_find(variant_obj_t data, const char *key)
+{
+    if (data->index) {
+        uint32_t hash = obj_key_hash(key);
+        size_t mask = data->sz_index - 1;
+        size_t i = hash & mask;
+        for (; data->index[i]; i = (i + 1) & mask) {
+            struct obj_node *node = data->index[i];
+            if (node->hash == hash &&
+                    strcmp(purc_variant_get_string_const(node->key),
+                        key) == 0)
+                return node;
+        }
+        return NULL;
+    }
+
+    struct rb_node *p = data->kvs.rb_node;
+    while (p) {
+        struct obj_node *node = container_of(p, struct obj_node, node);
+        int ret = strcmp(key, purc_variant_get_string_const(node->key));
+        if (ret < 0)
+            p = p->rb_left;
+        else if (ret > 0)
+            p = p->rb_right;
+        else
+            return node;
+    }
+
+    return NULL;
+}
+
 static purc_variant_t v_object_new_with_capacity(void)
 {
     purc_variant_t var = pcvariant_get(PVT(_OBJECT));
@@ -184,6 +345,7 @@ obj_node_release(purc_variant_t obj, struct obj_node *node)
     struct rb_root *root = &data->kvs;
     if (&node->node == root->rb_node || node->node.rb_parent) {
         --data->size;
+        obj_index_remove(data, node);
         pcutils_rbtree_erase(&node->node, root);
         node->node.rb_parent = NULL;
     }
@@ -296,28 +458,8 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
 {
     variant_obj_t data = pcvar_obj_get_data(obj);
     struct rb_root *root = &data->kvs;
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sk = purc_variant_get_string_const(node->key);
-        int ret = strcmp(key, sk);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
-    }
-
-    if (!entry) {
+    struct obj_node *node = obj_find(data, key);
+    if (!node) {
         if (silently)
             return 0;
 
@@ -325,8 +467,7 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
         return -1;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
+    struct rb_node *entry = &node->node;
     purc_variant_t k = node->key;
     purc_variant_t v = node->val;
 
@@ -343,6 +484,7 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
 
         --data->size;
         PC_ASSERT(entry == root->rb_node || entry->rb_parent);
+        obj_index_remove(data, node);
         pcutils_rbtree_erase(entry, root);
         entry->rb_parent = NULL;
 
@@ -477,7 +619,14 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
     struct rb_node **pnode = &root->rb_node;
     struct rb_node *parent = NULL;
     struct rb_node *entry = NULL;
-    while (*pnode) {
+    if (data->index) {
+        struct obj_node *found = obj_find(data, sk);
+        if (found)
+            entry = &found->node;
+    }
+
+    /* the rbtree is still walked to find where to link a new member */
+    while (!entry && *pnode) {
         struct obj_node *node;
         node = container_of(*pnode, struct obj_node, node);
         const char *sko = purc_variant_get_string_const(node->key);
@@ -515,6 +664,7 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
             pcutils_rbtree_insert_color(entry, root);
 
             ++data->size;
+            obj_index_add(data, node);
 
             if (check) {
                 if (build_rev_update_chain(obj, node))
@@ -753,6 +903,7 @@ void pcvariant_object_release (purc_variant_t value)
     variant_obj_t data = pcvar_obj_get_data(value);
 
     struct rb_root *root = &data->kvs;
+    obj_index_drop(data);
 
     struct rb_node *p, *n;
     pcutils_rbtree_for_each_safe(pcutils_rbtree_first(root), p, n) {
@@ -797,48 +948,32 @@ int pcvariant_object_compare (purc_variant_t lv, purc_variant_t rv)
 */
 
 purc_variant_t
-purc_variant_object_get_by_ckey(purc_variant_t obj, const char* key)
+pcvariant_object_get_by_ckey_ex(purc_variant_t obj, const char* key,
+        bool silently)
 {
-    PCVARIANT_CHECK_FAIL_RET((obj && obj->type==PVT(_OBJECT) &&
-        obj->sz_ptr[1] && key),
-        PURC_VARIANT_INVALID);
-
-    variant_obj_t data = pcvar_obj_get_data(obj);
-    struct rb_root *root = &data->kvs;
-
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sk = purc_variant_get_string_const(node->key);
-
-        int ret = strcmp(key, sk);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
+    if (!(obj && obj->type==PVT(_OBJECT) && obj->sz_ptr[1] && key)) {
+        if (!silently)
+            pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
     }
 
-    if (!entry) {
-        pcinst_set_error(PCVARIANT_ERROR_NOT_FOUND);
+    struct obj_node *node = obj_find(pcvar_obj_get_data(obj), key);
+    if (!node) {
+        if (!silently)
+            pcinst_set_error(PCVARIANT_ERROR_NOT_FOUND);
 
         return PURC_VARIANT_INVALID;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
     return node->val;
 }
 
+purc_variant_t
+purc_variant_object_get_by_ckey(purc_variant_t obj, const char* key)
+{
+    return pcvariant_object_get_by_ckey_ex(obj, key, false);
+}
+
 bool purc_variant_object_set (purc_variant_t obj,
     purc_variant_t key, purc_variant_t value)
 {
@@ -28,6 +28,7 @@
 #include "private/variant.h"
 #include "private/list.h"
 #include "private/hashtable.h"
+#include "private/instance.h"
 #include "private/errors.h"
 #include "private/stringbuilder.h"
 #include "purc-errors.h"
@@ -39,6 +40,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* The case-sensitive sets with more elements than this are indexed by the
+   hash of the unique-key fields */
+#define SET_INDEX_MIN_SIZE      8
+#define SET_INDEX_MIN_SLOTS     32
+
 static bool
 grow(purc_variant_t set, purc_variant_t value,
         bool check)
@@ -140,6 +146,7 @@ variant_set_get_extra_size(variant_set_t data)
 
     extra += sz_record * count;
     extra += sizeof(struct set_node*)*(data->al.nr);
+    extra += sizeof(struct set_node*)*(data->sz_index);
 
     return extra;
 }
@@ -358,6 +365,7 @@ struct element_rb_node {
     struct rb_node     **pnode;
     struct rb_node      *parent;
     struct rb_node      *entry;
+    uint64_t             hash;
 };
 
 static int
@@ -435,6 +443,148 @@ _compare(purc_variant_t _new, purc_variant_t _old,
     return _compare_by_unique_keys(_new, _old, data);
 }
 
+static inline uint64_t
+elem_hash(purc_variant_t set, variant_set_t data, purc_variant_t kvs)
+{
+    /* the caseless comparison folds the characters in the way of the
+       locale, the caseless sets are therefore not hashed */
+    if (data->caseless)
+        return 0;
+
+    return pcvariant_hash_by_set(kvs, set);
+}
+
+static inline bool
+set_index_disabled(void)
+{
+    struct pcinst *inst = pcinst_current();
+    return inst && inst->variant_heap && inst->variant_heap->set_index_disabled;
+}
+
+static void
+set_index_put(struct set_node **index, size_t sz_index, struct set_node *node)
+{
+    size_t mask = sz_index - 1;
+    size_t i = node->hash & mask;
+    while (index[i])
+        i = (i + 1) & mask;
+    index[i] = node;
+}
+
+static void
+set_index_drop(variant_set_t data)
+{
+    free(data->index);
+    data->index = NULL;
+    data->sz_index = 0;
+}
+
+static int
+set_index_rebuild(variant_set_t data, size_t sz_index)
+{
+    struct set_node **index;
+    index = (struct set_node **)calloc(sz_index, sizeof(*index));
+    if (!index)
+        return -1;
+
+    struct rb_node *p = pcutils_rbtree_first(&data->elems);
+    for (; p; p = pcutils_rbtree_next(p)) {
+        struct set_node *node = container_of(p, struct set_node, rbnode);
+        set_index_put(index, sz_index, node);
+    }
+
+    free(data->index);
+    data->index = index;
+    data->sz_index = sz_index;
+    return 0;
+}
+
+/* Called after the node has been linked into the rbtree */
+static void
+set_index_add(variant_set_t data, struct set_node *node)
+{
+    size_t count = pcutils_array_list_length(&data->al);
+
+    if (data->index == NULL) {
+        /* without the index, the lookups fall back to the rbtree */
+        if (count > SET_INDEX_MIN_SIZE && !data->caseless &&
+                !set_index_disabled())
+            set_index_rebuild(data, SET_INDEX_MIN_SLOTS);
+        return;
+    }
+
+    if (count * 2 > data->sz_index) {
+        if (set_index_rebuild(data, data->sz_index * 2))
+            set_index_drop(data);
+        return;
+    }
+
+    set_index_put(data->index, data->sz_index, node);
+}
+
+/* Builds the index for the elements already linked into the rbtree */
+static void
+set_index_build(variant_set_t data)
+{
+    size_t count = pcutils_array_list_length(&data->al);
+    if (count <= SET_INDEX_MIN_SIZE || data->caseless || set_index_disabled())
+        return;
+
+    size_t sz_index = SET_INDEX_MIN_SLOTS;
+    while (count * 2 > sz_index)
+        sz_index *= 2;
+    set_index_rebuild(data, sz_index);
+}
+
+/* Removes the node with backward shifting, so no tombstone is needed */
+static void
+set_index_remove(variant_set_t data, struct set_node *node)
+{
+    if (data->index == NULL)
+        return;
+
+    struct set_node **index = data->index;
+    size_t mask = data->sz_index - 1;
+    size_t i = node->hash & mask;
+    while (index[i] != node) {
+        if (index[i] == NULL)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (index[j] == NULL)
+            break;
+
+        /* leave the entry if its home slot is cyclically in (i, j] */
+        size_t k = index[j]->hash & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        index[i] = index[j];
+        i = j;
+    }
+
+    index[i] = NULL;
+}
+
+static struct set_node *
+set_index_find(variant_set_t data, purc_variant_t kvs, uint64_t hash)
+{
+    size_t mask = data->sz_index - 1;
+    size_t i = hash & mask;
+    for (; data->index[i]; i = (i + 1) & mask) {
+        struct set_node *node = data->index[i];
+        /* the different hashes reject the elements without stringifying */
+        if (node->hash == hash && _compare(kvs, node->val, data) == 0)
+            return node;
+    }
+
+    return NULL;
+}
+
 static void
 find_element_rb_node(struct element_rb_node *node,
         purc_variant_t set, purc_variant_t kvs)
@@ -444,9 +594,19 @@ find_element_rb_node(struct element_rb_node *node,
     struct rb_node **pnode = &root->rb_node;
     struct rb_node *parent = NULL;
     struct rb_node *entry = NULL;
-    char md5[33];
-    pcvariant_md5_by_set(md5, kvs, set);
 
+    node->hash = elem_hash(set, data, kvs);
+    if (data->index) {
+        struct set_node *found = set_index_find(data, kvs, node->hash);
+        if (found) {
+            node->pnode  = NULL;
+            node->parent = NULL;
+            node->entry  = &found->rbnode;
+            return;
+        }
+    }
+
+    /* still walk down the rbtree to locate where to insert */
     while (*pnode) {
         struct set_node *on;
         on = container_of(*pnode, struct set_node, rbnode);
@@ -454,9 +614,6 @@ find_element_rb_node(struct element_rb_node *node,
         if (0) {
             diff = variant_set_compare_by_set_keys(set, kvs, on->val);
         }
-        else if (0) {
-            diff = pcvariant_diff_by_set(md5, kvs, on->md5, on->val, set);
-        }
         else {
             diff = _compare(kvs, on->val, data);
         }
@@ -483,6 +640,10 @@ find_element_rb_node(struct element_rb_node *node,
 static struct set_node*
 find_element(purc_variant_t set, purc_variant_t kvs)
 {
+    variant_set_t data = pcvar_set_get_data(set);
+    if (data->index)
+        return set_index_find(data, kvs, elem_hash(set, data, kvs));
+
     struct element_rb_node node;
     find_element_rb_node(&node, set, kvs);
 
@@ -574,6 +735,7 @@ elem_node_remove(purc_variant_t set, struct set_node *node)
     PC_ASSERT(data);
 
     pcutils_rbtree_erase(&node->rbnode, &data->elems);
+    set_index_remove(data, node);
 
     int r;
     struct pcutils_array_list_node *old;
@@ -652,6 +814,7 @@ static void
 variant_set_release(purc_variant_t set, variant_set_t data)
 {
     variant_set_release_elems(set, data);
+    set_index_drop(data);
 
     if (data->rev_update_chain) {
         pcvar_destroy_rev_update_chain(data->rev_update_chain);
@@ -704,7 +867,8 @@ variant_set_create_kvs_n(variant_set_t set, purc_variant_t v1, va_list ap)
 }
 
 static struct set_node*
-variant_set_create_elem_node(purc_variant_t set, purc_variant_t val)
+variant_set_create_elem_node(purc_variant_t set, purc_variant_t val,
+        uint64_t hash)
 {
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
@@ -715,8 +879,7 @@ variant_set_create_elem_node(purc_variant_t set, purc_variant_t val)
         return NULL;
     }
 
-    pcvariant_md5_by_set(_new->md5, val, set);
-
+    _new->hash = hash;
     _new->alnode.idx = (size_t)-1;
     _new->val = val;
     purc_variant_ref(val);
@@ -724,48 +887,65 @@ variant_set_create_elem_node(purc_variant_t set, purc_variant_t val)
     return _new;
 }
 
-static int
-check_shrink(purc_variant_t set, struct set_node *node)
+/* Makes a copy of the set without the element `skip` for checking the
+   constraints of the ancestors; the elements are linked in the order of
+   the rbtree of the set, so they are neither compared nor hashed again. */
+static purc_variant_t
+clone_for_check(purc_variant_t set, struct set_node *skip)
 {
-    if (!pcvar_container_belongs_to_set(set))
-        return 0;
-
-    purc_variant_t _new = pcvar_set_clone_struct(set);
+    variant_set_t data = pcvar_set_get_data(set);
+    purc_variant_t _new = pcvar_make_set(data);
     if (_new == PURC_VARIANT_INVALID)
-        return -1;
+        return PURC_VARIANT_INVALID;
 
-    int r = 0;
-    do {
-        bool found = false;
-        purc_variant_t v;
-        foreach_value_in_variant_set(set, v) {
-            if (node->val == v) {
-                PC_ASSERT(!found);
-                found = true;
-                continue;
-            }
-            r = pcvar_set_add(_new, v);
-            if (r)
-                break;
-        } end_foreach;
+    variant_set_t new_data = pcvar_set_get_data(_new);
+    struct rb_node *last = NULL;
+    struct rb_node *p = pcutils_rbtree_first(&data->elems);
+    for (; p; p = pcutils_rbtree_next(p)) {
+        struct set_node *node = container_of(p, struct set_node, rbnode);
+        if (node == skip)
+            continue;
 
-        if (r)
-            break;
+        struct set_node *_node;
+        _node = variant_set_create_elem_node(_new, node->val, node->hash);
+        if (!_node)
+            goto failed;
 
-        if (!found)
-            break;
+        if (pcutils_array_list_append(&new_data->al, &_node->alnode)) {
+            elem_node_destroy(_new, _node);
+            goto failed;
+        }
 
-        r = pcvar_reverse_check(set, _new);
-        if (r)
-            break;
+        /* the greatest node never has a right child */
+        struct rb_node **pnode;
+        pnode = last ? &last->rb_right : &new_data->elems.rb_node;
+        pcutils_rbtree_link_node(&_node->rbnode, last, pnode);
+        pcutils_rbtree_insert_color(&_node->rbnode, &new_data->elems);
+        last = &_node->rbnode;
+    }
+
+    set_index_build(new_data);
+    return _new;
 
-        PURC_VARIANT_SAFE_CLEAR(_new);
+failed:
+    purc_variant_unref(_new);
+    return PURC_VARIANT_INVALID;
+}
 
+static int
+check_shrink(purc_variant_t set, struct set_node *node)
+{
+    if (!pcvar_container_belongs_to_set(set))
         return 0;
-    } while (0);
 
+    purc_variant_t _new = clone_for_check(set, node);
+    if (_new == PURC_VARIANT_INVALID)
+        return -1;
+
+    int r = pcvar_reverse_check(set, _new);
     PURC_VARIANT_SAFE_CLEAR(_new);
-    return -1;
+
+    return r ? -1 : 0;
 }
 
 static int
@@ -805,43 +985,21 @@ check_grow(purc_variant_t set, purc_variant_t val)
     if (!pcvar_container_belongs_to_set(set))
         return 0;
 
-    purc_variant_t _new = pcvar_set_clone_struct(set);
+    purc_variant_t _new = clone_for_check(set, NULL);
     if (_new == PURC_VARIANT_INVALID)
         return -1;
 
-    int r = 0;
-    do {
-        purc_variant_t v;
-        foreach_value_in_variant_set(set, v) {
-            r = pcvar_set_add(_new, v);
-            if (r)
-                break;
-        } end_foreach;
-
-        if (r)
-            break;
-
-        r = pcvar_set_add(_new, val);
-        if (r)
-            break;
-
+    int r = pcvar_set_add(_new, val);
+    if (r == 0)
         r = pcvar_reverse_check(set, _new);
-        if (r)
-            break;
-
-        PURC_VARIANT_SAFE_CLEAR(_new);
-
-        return 0;
-    } while (0);
-
     PURC_VARIANT_SAFE_CLEAR(_new);
-    return -1;
+
+    return r ? -1 : 0;
 }
 
 static int
 insert(purc_variant_t set, variant_set_t data,
-        purc_variant_t val,
-        struct rb_node *parent, struct rb_node **pnode,
+        purc_variant_t val, struct element_rb_node *rbn,
         bool check)
 {
     struct set_node *node = NULL;
@@ -855,7 +1013,7 @@ insert(purc_variant_t set, variant_set_t data,
                 break;
         }
 
-        node = variant_set_create_elem_node(set, val);
+        node = variant_set_create_elem_node(set, val, rbn->hash);
         if (!node)
             break;
 
@@ -870,8 +1028,9 @@ insert(purc_variant_t set, variant_set_t data,
 
         struct rb_node *entry = &node->rbnode;
 
-        pcutils_rbtree_link_node(entry, parent, pnode);
+        pcutils_rbtree_link_node(entry, rbn->parent, rbn->pnode);
         pcutils_rbtree_insert_color(entry, &data->elems);
+        set_index_add(data, node);
 
         if (check) {
             if (!elem_node_setup_constraints(set, node))
@@ -905,7 +1064,7 @@ pcvar_set_add(purc_variant_t set, purc_variant_t val)
     }
 
     bool check = false;
-    return insert(set, data, val, rbn.parent, rbn.pnode, check);
+    return insert(set, data, val, &rbn, check);
 }
 
 static int
@@ -914,44 +1073,16 @@ check_change(purc_variant_t set, struct set_node *node, purc_variant_t val)
     if (!pcvar_container_belongs_to_set(set))
         return 0;
 
-    purc_variant_t _new = pcvar_set_clone_struct(set);
+    purc_variant_t _new = clone_for_check(set, node);
     if (_new == PURC_VARIANT_INVALID)
         return -1;
 
-    int r = 0;
-    do {
-        bool found = false;
-        purc_variant_t v;
-        foreach_value_in_variant_set(set, v) {
-            if (node->val == v) {
-                PC_ASSERT(!found);
-                found = true;
-                r = pcvar_set_add(_new, val);
-            }
-            else {
-                r = pcvar_set_add(_new, v);
-            }
-            if (r)
-                break;
-        } end_foreach;
-
-        if (r)
-            break;
-
-        if (!found)
-            break;
-
+    int r = pcvar_set_add(_new, val);
+    if (r == 0)
         r = pcvar_reverse_check(set, _new);
-        if (r)
-            break;
-
-        PURC_VARIANT_SAFE_CLEAR(_new);
-
-        return 0;
-    } while (0);
-
     PURC_VARIANT_SAFE_CLEAR(_new);
-    return -1;
+
+    return r ? -1 : 0;
 }
 
 static int
@@ -963,7 +1094,7 @@ insert_or_replace(purc_variant_t set,
     find_element_rb_node(&rbn, set, val);
 
     if (!rbn.entry) {
-        int r = insert(set, data, val, rbn.parent, rbn.pnode, check);
+        int r = insert(set, data, val, &rbn, check);
 
         return r ? -1 : 0;
     }
@@ -2083,6 +2214,22 @@ pcvar_adjust_set_by_edge(purc_variant_t set,
     PC_ASSERT(0);
 }
 
+int
+pcvar_set_probe_change(purc_variant_t set, struct set_node *node,
+        purc_variant_t val)
+{
+    PC_ASSERT(set != PURC_VARIANT_INVALID);
+    PC_ASSERT(purc_variant_is_set(set));
+
+    struct set_node *found = find_element(set, val);
+    if (found && found != node) {
+        purc_set_error(PURC_ERROR_DUPLICATED);
+        return -1;
+    }
+
+    return 0;
+}
+
 int
 pcvar_readjust_set(purc_variant_t set, struct set_node *node)
 {
@@ -2090,7 +2237,9 @@ pcvar_readjust_set(purc_variant_t set, struct set_node *node)
     PC_ASSERT(purc_variant_is_set(set));
     variant_set_t data = pcvar_set_get_data(set);
 
+    /* the unique-key fields of the element changed, so does the hash */
     pcutils_rbtree_erase(&node->rbnode, &data->elems);
+    set_index_remove(data, node);
 
     struct element_rb_node rbn;
     find_element_rb_node(&rbn, set, node->val);
@@ -2100,6 +2249,9 @@ pcvar_readjust_set(purc_variant_t set, struct set_node *node)
 
     pcutils_rbtree_link_node(entry, rbn.parent, rbn.pnode);
     pcutils_rbtree_insert_color(entry, &data->elems);
+    node->hash = rbn.hash;
+    if (data->index)
+        set_index_put(data->index, data->sz_index, node);
 
     return 0;
 }
@@ -31,7 +31,9 @@
 #include "private/debug.h"
 #include "private/dvobjs.h"
 #include "private/utils.h"
+#include "private/rwstream.h"
 #include "variant-internals.h"
+#include "purc-helpers.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -143,6 +145,8 @@ static void _cleanup_instance(struct pcinst *inst)
         inst->variables = NULL;
     }
 
+    pcvcm_release_consts(inst);
+
     if (heap == NULL)
         return;
 
@@ -227,6 +231,18 @@ static int _init_instance(struct pcinst *curr_inst,
     stat->nr_reserved = 0;
     stat->nr_max_reserved = MAX_RESERVED_VARIANTS;
 
+    const char *env_value = getenv(PURC_ENVV_VARIANT_OBJECT_INDEX);
+    if (env_value && (*env_value == '0' ||
+                pcutils_strcasecmp(env_value, "false") == 0)) {
+        inst->variant_heap->obj_index_disabled = true;
+    }
+
+    env_value = getenv(PURC_ENVV_VARIANT_SET_INDEX);
+    if (env_value && (*env_value == '0' ||
+                pcutils_strcasecmp(env_value, "false") == 0)) {
+        inst->variant_heap->set_index_disabled = true;
+    }
+
 #if !USE(LOOP_BUFFER_FOR_RESERVED)
     INIT_LIST_HEAD(&inst->variant_heap->v_reserved);
 #endif
@@ -1607,12 +1623,9 @@ int purc_variant_compare_ex (purc_variant_t v1,
     return compare;
 }
 
-purc_variant_t purc_variant_load_from_json_stream(purc_rwstream_t stream)
+/* parses the stream by the eJSON parser, without trying the strict one */
+static purc_variant_t load_from_ejson_stream(purc_rwstream_t stream)
 {
-    if (stream  == NULL) {
-        return PURC_VARIANT_INVALID;
-    }
-
     purc_variant_t value = PURC_VARIANT_INVALID;
     struct pcvcm_node* root = NULL;
     struct pcejson* parser = NULL;
@@ -1630,14 +1643,38 @@ ret:
     return value;
 }
 
+purc_variant_t purc_variant_load_from_json_stream(purc_rwstream_t stream)
+{
+    if (stream  == NULL) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    /* try the strict JSON parser first if the contents are in memory */
+    uint8_t **here, **stop;
+    if (pcutils_rwstream_get_mem_cursor(stream, &here, &stop)) {
+        purc_variant_t value = pcvariant_make_from_strict_json(
+                (const char *)*here, *stop - *here);
+        if (value) {
+            *here = *stop;
+            return value;
+        }
+    }
+
+    return load_from_ejson_stream(stream);
+}
+
 purc_variant_t purc_variant_make_from_json_string(const char* json, size_t sz)
 {
-    purc_variant_t value;
+    purc_variant_t value = pcvariant_make_from_strict_json(json, sz);
+    if (value)
+        return value;
+
     purc_rwstream_t rwstream = purc_rwstream_new_from_mem((void*)json, sz);
     if (rwstream == NULL)
         return PURC_VARIANT_INVALID;
 
-    value = purc_variant_load_from_json_stream(rwstream);
+    /* the strict parser has failed on the same bytes */
+    value = load_from_ejson_stream(rwstream);
     purc_rwstream_destroy(rwstream);
 
     return value;
@@ -1645,13 +1682,14 @@ purc_variant_t purc_variant_make_from_json_string(const char* json, size_t sz)
 
 purc_variant_t purc_variant_load_from_json_file(const char* file)
 {
-    purc_variant_t value;
-    purc_rwstream_t rwstream = purc_rwstream_new_from_file(file, "r");
-    if (rwstream == NULL)
+    size_t sz;
+    char *json = purc_load_file_contents(file, &sz);
+    if (json == NULL)
         return PURC_VARIANT_INVALID;
 
-    value = purc_variant_load_from_json_stream(rwstream);
-    purc_rwstream_destroy(rwstream);
+    /* parse the contents in memory instead of reading the file by bytes */
+    purc_variant_t value = purc_variant_make_from_json_string(json, sz);
+    free(json);
 
     return value;
 }
@@ -2331,7 +2369,9 @@ variant_stringify(struct stringify_arg *arg, purc_variant_t value)
             arg->cb(arg, &value->d, sizeof(double));
         }
         else {
-            snprintf(buf, sizeof(buf), "%g", value->d);
+            /* `%g` gives the integers less than 1e6 without decimals */
+            if (pcutils_dtoa_integer(value->d, 1e6, buf) == 0)
+                snprintf(buf, sizeof(buf), "%g", value->d);
             arg->cb(arg, buf, 0);
         }
         break;
@@ -2360,7 +2400,8 @@ variant_stringify(struct stringify_arg *arg, purc_variant_t value)
             arg->cb(arg, &value->ld, sizeof(long double));
         }
         else {
-            snprintf(buf, sizeof(buf), "%Lg", value->ld);
+            if (pcutils_ldtoa_integer(value->ld, 1e6L, buf) == 0)
+                snprintf(buf, sizeof(buf), "%Lg", value->ld);
             arg->cb(arg, buf, 0);
         }
         break;
@@ -2901,23 +2942,10 @@ cmp_by_arr(purc_variant_t l, purc_variant_t r,
     PC_ASSERT(ld);
     PC_ASSERT(rd);
 
-    struct pcutils_array_list *la = &ld->al;
-    struct pcutils_array_list *ra = &rd->al;
-
-    struct pcutils_array_list_node *lnode = pcutils_array_list_get_first(la);
-    struct pcutils_array_list_node *rnode = pcutils_array_list_get_first(ra);
-
-    for (;
-        lnode && rnode;
-        lnode = pcutils_array_list_get(la, lnode->idx + 1),
-        rnode = pcutils_array_list_get(ra, rnode->idx + 1))
-    {
-        struct arr_node *lo, *ro;
-        lo = container_of(lnode, struct arr_node, node);
-        ro = container_of(rnode, struct arr_node, node);
-
-        purc_variant_t lv = lo->val;
-        purc_variant_t rv = ro->val;
+    size_t i;
+    for (i = 0; i < ld->nr && i < rd->nr; i++) {
+        purc_variant_t lv = ld->vals[i];
+        purc_variant_t rv = rd->vals[i];
         PC_ASSERT(lv != PURC_VARIANT_INVALID);
         PC_ASSERT(rv != PURC_VARIANT_INVALID);
 
@@ -2926,9 +2954,9 @@ cmp_by_arr(purc_variant_t l, purc_variant_t r,
             return diff;
     }
 
-    if (lnode)
+    if (i < ld->nr)
         return 1;
-    else if (rnode)
+    else if (i < rd->nr)
         return -1;
     else
         return 0;
@@ -3246,7 +3274,9 @@ stringify(char *buf, size_t len, purc_variant_t v)
             break;
 
         case PURC_VARIANT_TYPE_NUMBER:
-            nr = snprintf(buf, len, "%g", v->d);
+            nr = pcutils_dtoa_integer(v->d, 1e6, buf);
+            if (nr == 0)
+                nr = snprintf(buf, len, "%g", v->d);
             break;
 
         case PURC_VARIANT_TYPE_LONGINT:
@@ -3258,7 +3288,9 @@ stringify(char *buf, size_t len, purc_variant_t v)
             break;
 
         case PURC_VARIANT_TYPE_LONGDOUBLE:
-            nr = snprintf(buf, len, "%Lg", v->ld);
+            nr = pcutils_ldtoa_integer(v->ld, 1e6L, buf);
+            if (nr == 0)
+                nr = snprintf(buf, len, "%Lg", v->ld);
             break;
 
         case PURC_VARIANT_TYPE_ATOMSTRING:
@@ -3608,108 +3640,155 @@ void pcvariant_md5_ex(char *md5, purc_variant_t val, const char *salt,
     pcutils_bin2hex(md5_digest, MD5_DIGEST_SIZE, md5, uppercase);
 }
 
-void
-pcvariant_md5_by_set(char *md5, purc_variant_t val, purc_variant_t set)
-{
-    PC_ASSERT(md5);
-    PC_ASSERT(val != PURC_VARIANT_INVALID);
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
+/* The incremental 64-bit hash (the rounds and the avalanche of xxHash64)
+   of the stringified variants used by sets */
+#define HASH64_PRIME_1      0x9E3779B185EBCA87ULL
+#define HASH64_PRIME_2      0xC2B2AE3D27D4EB4FULL
+#define HASH64_PRIME_3      0x165667B19E3779F9ULL
 
-    variant_set_t data = pcvar_set_get_data(set);
-    PC_ASSERT(data);
+struct hash64_ctxt {
+    uint64_t        acc;
+    uint64_t        tail;       // the pending bytes, packed
+    size_t          nr_tail;
+    size_t          len;
+    bool            stopped;    // a null character met
+};
 
-    if (data->unique_key == NULL) {
-        pcvariant_md5(md5, val);
-        return;
-    }
+static inline uint64_t
+hash64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * HASH64_PRIME_2;
+    acc = (acc << 31) | (acc >> 33);
+    return acc * HASH64_PRIME_1;
+}
+
+static inline uint64_t
+hash64_avalanche(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= HASH64_PRIME_2;
+    h ^= h >> 29;
+    h *= HASH64_PRIME_3;
+    h ^= h >> 32;
+    return h;
+}
 
-    purc_variant_t undefined = purc_variant_make_undefined();
-    PC_ASSERT(undefined);
+static void
+hash64_update(struct hash64_ctxt *ctxt, const void *src, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)src;
 
-    if (val->type != PVT(_OBJECT)) {
-        pcvariant_md5(md5, undefined);
-        purc_variant_unref(undefined);
+    /* the strings are compared by strcmp(), so stop at the null character
+       like it to hash the equal strings to the same value */
+    if (ctxt->stopped)
         return;
+    const unsigned char *nul = memchr(p, 0, len);
+    if (nul) {
+        len = nul - p;
+        ctxt->stopped = true;
+    }
+
+    ctxt->len += len;
+    while (ctxt->nr_tail && len) {
+        ctxt->tail |= (uint64_t)*p++ << (ctxt->nr_tail * 8);
+        len--;
+        if (++ctxt->nr_tail == sizeof(uint64_t)) {
+            ctxt->acc = hash64_round(ctxt->acc, ctxt->tail);
+            ctxt->tail = 0;
+            ctxt->nr_tail = 0;
+        }
     }
 
-    pcutils_md5_ctxt ud;
-
-    pcutils_md5_begin(&ud);
-
-    struct stringify_arg arg;
-    arg.cb    = do_stringify_md5;
-    arg.arg   = &ud;
-    arg.flags = 0;
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        ctxt->acc = hash64_round(ctxt->acc, word);
+        p += sizeof(word);
+    }
 
-    for (size_t i=0; i<data->nr_keynames; ++i) {
-        purc_variant_t v;
-        v = purc_variant_object_get_by_ckey(val, data->keynames[i]);
-        if (v == PURC_VARIANT_INVALID) {
-            v = undefined;
+    if (len) {
+        /* nr_tail is 0 here */
+        ctxt->tail = *p++;
+        ctxt->nr_tail = 1;
+        while (--len) {
+            ctxt->tail |= (uint64_t)*p++ << (ctxt->nr_tail * 8);
+            ctxt->nr_tail++;
         }
-        stringify_kv(&arg, data->keynames[i], v);
     }
+}
 
-    unsigned char md5_digest[MD5_DIGEST_SIZE];
-    pcutils_md5_end(&ud, md5_digest);
+static uint64_t
+hash64_final(struct hash64_ctxt *ctxt)
+{
+    uint64_t acc = ctxt->acc;
+    if (ctxt->nr_tail)
+        acc = hash64_round(acc, ctxt->tail);
+    return hash64_avalanche(acc ^ (uint64_t)ctxt->len);
+}
 
-    bool uppercase = true;
-    pcutils_bin2hex(md5_digest, MD5_DIGEST_SIZE, md5, uppercase);
+static void
+do_stringify_hash(struct stringify_arg *arg, const void *src, size_t len)
+{
+    struct hash64_ctxt *ctxt = (struct hash64_ctxt*)(arg->arg);
+
+    if (len == 0)
+        len = strlen(src);
 
-    purc_variant_unref(undefined);
+    hash64_update(ctxt, src, len);
 }
 
-int
-pcvariant_diff_by_set(const char *md5l, purc_variant_t l,
-        const char *md5r, purc_variant_t r, purc_variant_t set)
+/* Hashes the value as purc_variant_compare_ex() compares it with the option
+   PCVARIANT_COMPARE_OPT_CASE, that is, by the stringified value */
+static uint64_t
+hash_stringified(purc_variant_t val)
 {
-    // TODO: https://gitlab.fmsoft.cn/hvml/hvml-docs/-/blob/master/zh/hvml-spec-v1.0-zh.md#21610-%E9%9B%86%E5%90%88%E5%8F%98%E9%87%8F
+    struct hash64_ctxt ctxt = { .acc = HASH64_PRIME_3 };
 
-    PC_ASSERT(md5l);
-    PC_ASSERT(l != PURC_VARIANT_INVALID);
-    PC_ASSERT(md5r);
-    PC_ASSERT(r != PURC_VARIANT_INVALID);
+    struct stringify_arg arg;
+    arg.cb    = do_stringify_hash;
+    arg.arg   = &ctxt;
+    arg.flags = 0;
 
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
+    variant_stringify(&arg, val);
 
-    int diff;
+    return hash64_final(&ctxt);
+}
+
+uint64_t
+pcvariant_hash_by_set(purc_variant_t val, purc_variant_t set)
+{
+    PC_ASSERT(val != PURC_VARIANT_INVALID);
+    PC_ASSERT(set != PURC_VARIANT_INVALID);
 
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
+    PC_ASSERT(!data->caseless);
 
-    if (data->unique_key == NULL) {
-        return pcvariant_diff(l, r);
-    }
-
-    diff = strcmp(md5l, md5r);
-    if (diff)
-        return diff;
-
-    purc_variant_t undefined = purc_variant_make_undefined();
-    PC_ASSERT(undefined);
+    if (data->unique_key == NULL)
+        return hash_stringified(val);
 
+    uint64_t hash = HASH64_PRIME_1;
     for (size_t i=0; i<data->nr_keynames; ++i) {
-        purc_variant_t vl = PURC_VARIANT_INVALID;
-        purc_variant_t vr = PURC_VARIANT_INVALID;
-
-        if (l->type == PVT(_OBJECT))
-            vl = purc_variant_object_get_by_ckey(l, data->keynames[i]);
-        if (r->type == PVT(_OBJECT))
-            vr = purc_variant_object_get_by_ckey(r, data->keynames[i]);
-
-        if (vl == PURC_VARIANT_INVALID)
-            vl = undefined;
-        if (vr == PURC_VARIANT_INVALID)
-            vr = undefined;
+        purc_variant_t v = PURC_VARIANT_INVALID;
+        if (val->type == PVT(_OBJECT)) {
+            v = purc_variant_object_get_by_ckey(val, data->keynames[i]);
+            if (v == PURC_VARIANT_INVALID)
+                purc_clr_error();
+        }
 
-        diff = pcvariant_diff(vl, vr);
-        if (diff)
-            break;
+        uint64_t h;
+        if (v == PURC_VARIANT_INVALID) {
+            struct hash64_ctxt ctxt = { .acc = HASH64_PRIME_3 };
+            hash64_update(&ctxt, "undefined", sizeof("undefined") - 1);
+            h = hash64_final(&ctxt);
+        }
+        else {
+            h = hash_stringified(v);
+        }
+        hash = hash64_round(hash, h);
     }
 
-    purc_variant_unref(undefined);
-
-    return diff;
+    return hash64_avalanche(hash);
 }
 
 bool pcvariant_is_scalar(purc_variant_t v)
@@ -0,0 +1,735 @@
+/*
+ * @file vcm-bytecode.c
+ * @brief The compiler and the executor of vcm bytecode.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "purc-utils.h"
+#include "purc-errors.h"
+#include "purc-variant.h"
+#include "private/errors.h"
+#include "private/instance.h"
+#include "private/hashtable.h"
+#include "private/vcm.h"
+
+#include "vcm-internal.h"
+
+/*
+ * The program is executed by a stack machine. Every node of the tree is
+ * lowered to the instructions evaluating its children (which push their
+ * results), followed by one instruction which pops the operands and pushes
+ * the result of the node.
+ *
+ * A program only refers to the nodes of the tree and holds no variant: the
+ * tree belongs to the vDOM, which may be shared by the instances on other
+ * threads and outlive the instance which compiled it, while a variant
+ * belongs to the heap of one instance. So the constants of a program are
+ * made once by every instance executing it and kept in the table of the
+ * instance, keyed by the identifier of the program; a program is never
+ * changed after compiled.
+ */
+enum vcm_opcode {
+    VCM_OP_PUSH_CONST,          /* arg: index of the constant */
+    VCM_OP_PUSH_RAW_CONST,      /* the same; strings and byte sequences, which
+                                   are not finished */
+    VCM_OP_MAKE_OBJECT,         /* arg: number of key/value pairs */
+    VCM_OP_MAKE_ARRAY,          /* arg: number of members */
+    VCM_OP_CONCAT_STRING,       /* arg: number of pieces */
+    VCM_OP_GET_VARIABLE,        /* the name is on the stack */
+    VCM_OP_GET_STATIC_VARIABLE, /* the name is the string of the child */
+    VCM_OP_GET_ELEMENT,
+    VCM_OP_CHECK_CALLER,        /* arg: where to go if not callable */
+    VCM_OP_CALL_GETTER,         /* arg: number of parameters */
+    VCM_OP_CALL_SETTER,         /* arg: number of parameters */
+    VCM_OP_POP,
+    VCM_OP_AND,                 /* arg: where to go if the top is false */
+    VCM_OP_OR,                  /* arg: where to go if the top is true */
+    VCM_OP_END_CJSONEE,
+};
+
+struct vcm_inst {
+    enum vcm_opcode op;
+    uint32_t arg;
+    struct pcvcm_node *node;
+};
+
+struct pcvcm_program {
+    /* never reused, unlike the address of a program destroyed */
+    uintptr_t id;
+    size_t nr_consts;
+
+    struct vcm_inst *insts;
+    size_t nr_insts;
+    size_t sz_insts;
+
+    /* the depth of the stack needed to execute the program */
+    size_t max_depth;
+    size_t depth;
+};
+
+/* the stack on the C stack used for most programs */
+#define NR_LOCAL_STACK_SLOTS        32
+
+/* the table of constants is emptied when the programs in it reach this
+   number; the entries of the programs destroyed are never looked up again */
+#define MAX_PROGRAMS_WITH_CONSTS    4096
+
+static uintptr_t last_program_id;
+
+struct vcm_consts {
+    size_t nr_consts;
+    purc_variant_t consts[];
+};
+
+static bool
+grow_array(void **array, size_t *sz, size_t sz_elem, size_t nr_needed)
+{
+    if (nr_needed <= *sz) {
+        return true;
+    }
+
+    size_t new_sz = *sz ? *sz * 2 : 16;
+    while (new_sz < nr_needed) {
+        new_sz *= 2;
+    }
+
+    void *p = realloc(*array, new_sz * sz_elem);
+    if (!p) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    *array = p;
+    *sz = new_sz;
+    return true;
+}
+
+static ssize_t
+emit(struct pcvcm_program *prog, enum vcm_opcode op, uint32_t arg,
+        struct pcvcm_node *node, int nr_popped, int nr_pushed)
+{
+    if (!grow_array((void **)&prog->insts, &prog->sz_insts,
+                sizeof(struct vcm_inst), prog->nr_insts + 1)) {
+        return -1;
+    }
+
+    struct vcm_inst *inst = prog->insts + prog->nr_insts;
+    inst->op = op;
+    inst->arg = arg;
+    inst->node = node;
+
+    prog->depth = prog->depth - nr_popped + nr_pushed;
+    if (prog->depth > prog->max_depth) {
+        prog->max_depth = prog->depth;
+    }
+    return prog->nr_insts++;
+}
+
+static bool compile_node(struct pcvcm_program *prog, struct pcvcm_node *node);
+
+static bool
+compile_children(struct pcvcm_program *prog, struct pcvcm_node *child,
+        size_t *nr_children)
+{
+    size_t n = 0;
+    while (child) {
+        if (!compile_node(prog, child)) {
+            return false;
+        }
+        n++;
+        child = NEXT_CHILD(child);
+    }
+
+    *nr_children = n;
+    return true;
+}
+
+static bool
+compile_object(struct pcvcm_program *prog, struct pcvcm_node *node)
+{
+    size_t nr_pairs = 0;
+    struct pcvcm_node *k_node = FIRST_CHILD(node);
+    struct pcvcm_node *v_node = NEXT_CHILD(k_node);
+
+    /* a key without value is ignored by the tree walker as well */
+    while (k_node && v_node) {
+        if (!compile_node(prog, k_node) || !compile_node(prog, v_node)) {
+            return false;
+        }
+        nr_pairs++;
+
+        k_node = NEXT_CHILD(v_node);
+        v_node = NEXT_CHILD(k_node);
+    }
+
+    return emit(prog, VCM_OP_MAKE_OBJECT, nr_pairs, node,
+            nr_pairs * 2, 1) >= 0;
+}
+
+static bool
+compile_get_variable(struct pcvcm_program *prog, struct pcvcm_node *node)
+{
+    struct pcvcm_node *name_node = FIRST_CHILD(node);
+    if (!name_node) {
+        return false;
+    }
+
+    if (name_node->type == PCVCM_NODE_TYPE_STRING && name_node->sz_ptr[1]
+            && ((const char *)name_node->sz_ptr[1])[0]) {
+        return emit(prog, VCM_OP_GET_STATIC_VARIABLE, 0, node, 0, 1) >= 0;
+    }
+
+    if (!compile_node(prog, name_node)) {
+        return false;
+    }
+    return emit(prog, VCM_OP_GET_VARIABLE, 0, node, 1, 1) >= 0;
+}
+
+static bool
+compile_get_element(struct pcvcm_program *prog, struct pcvcm_node *node)
+{
+    struct pcvcm_node *caller_node = FIRST_CHILD(node);
+    struct pcvcm_node *param_node = NEXT_CHILD(caller_node);
+    if (!caller_node || !param_node) {
+        return false;
+    }
+
+    if (!compile_node(prog, caller_node) || !compile_node(prog, param_node)) {
+        return false;
+    }
+    return emit(prog, VCM_OP_GET_ELEMENT, 0, node, 2, 1) >= 0;
+}
+
+static bool
+compile_call_method(struct pcvcm_program *prog, struct pcvcm_node *node,
+        enum vcm_opcode op)
+{
+    struct pcvcm_node *caller_node = FIRST_CHILD(node);
+    if (!caller_node || !compile_node(prog, caller_node)) {
+        return false;
+    }
+
+    /* the parameters are not evaluated if the caller is not callable */
+    ssize_t check = emit(prog, VCM_OP_CHECK_CALLER, 0, node, 0, 0);
+    if (check < 0) {
+        return false;
+    }
+
+    size_t nr_params;
+    if (!compile_children(prog, NEXT_CHILD(caller_node), &nr_params)) {
+        return false;
+    }
+
+    if (emit(prog, op, nr_params, node, nr_params + 1, 1) < 0) {
+        return false;
+    }
+
+    prog->insts[check].arg = prog->nr_insts;
+    return true;
+}
+
+static bool is_cjsonee_op_node(struct pcvcm_node *node)
+{
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_CJSONEE_OP_AND:
+    case PCVCM_NODE_TYPE_CJSONEE_OP_OR:
+    case PCVCM_NODE_TYPE_CJSONEE_OP_SEMICOLON:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool
+compile_cjsonee(struct pcvcm_program *prog, struct pcvcm_node *node)
+{
+    struct pcvcm_node *curr_node = FIRST_CHILD(node);
+
+    /* leave the malformed ones to the tree walker to report the error */
+    if (!curr_node || is_cjsonee_op_node(curr_node)
+            || !compile_node(prog, curr_node)) {
+        return false;
+    }
+
+    struct pcvcm_node *op_node;
+    while ((op_node = NEXT_CHILD(curr_node))) {
+        if (!is_cjsonee_op_node(op_node)) {
+            return false;
+        }
+
+        curr_node = NEXT_CHILD(op_node);
+        if (!curr_node) {
+            if (op_node->type == PCVCM_NODE_TYPE_CJSONEE_OP_SEMICOLON) {
+                break;
+            }
+            return false;
+        }
+        if (is_cjsonee_op_node(curr_node)) {
+            return false;
+        }
+
+        ssize_t jump = -1;
+        switch (op_node->type) {
+        case PCVCM_NODE_TYPE_CJSONEE_OP_SEMICOLON:
+            if (emit(prog, VCM_OP_POP, 0, op_node, 1, 0) < 0) {
+                return false;
+            }
+            break;
+
+        case PCVCM_NODE_TYPE_CJSONEE_OP_AND:
+            jump = emit(prog, VCM_OP_AND, 0, op_node, 1, 0);
+            break;
+
+        case PCVCM_NODE_TYPE_CJSONEE_OP_OR:
+            jump = emit(prog, VCM_OP_OR, 0, op_node, 1, 0);
+            break;
+
+        default:
+            return false;
+        }
+
+        if (op_node->type != PCVCM_NODE_TYPE_CJSONEE_OP_SEMICOLON
+                && jump < 0) {
+            return false;
+        }
+
+        if (!compile_node(prog, curr_node)) {
+            return false;
+        }
+
+        if (jump >= 0) {
+            prog->insts[jump].arg = prog->nr_insts;
+        }
+    }
+
+    return emit(prog, VCM_OP_END_CJSONEE, 0, node, 1, 1) >= 0;
+}
+
+static bool
+compile_node(struct pcvcm_program *prog, struct pcvcm_node *node)
+{
+    size_t n;
+
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_UNDEFINED:
+    case PCVCM_NODE_TYPE_NULL:
+    case PCVCM_NODE_TYPE_BOOLEAN:
+    case PCVCM_NODE_TYPE_NUMBER:
+    case PCVCM_NODE_TYPE_LONG_INT:
+    case PCVCM_NODE_TYPE_ULONG_INT:
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+        return emit(prog, VCM_OP_PUSH_CONST, prog->nr_consts++,
+                node, 0, 1) >= 0;
+
+    /* like the tree walker, strings and byte sequences are not finished */
+    case PCVCM_NODE_TYPE_STRING:
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE:
+        return emit(prog, VCM_OP_PUSH_RAW_CONST, prog->nr_consts++,
+                node, 0, 1) >= 0;
+
+    case PCVCM_NODE_TYPE_OBJECT:
+        return compile_object(prog, node);
+
+    case PCVCM_NODE_TYPE_ARRAY:
+        return compile_children(prog, FIRST_CHILD(node), &n) &&
+            emit(prog, VCM_OP_MAKE_ARRAY, n, node, n, 1) >= 0;
+
+    case PCVCM_NODE_TYPE_FUNC_CONCAT_STRING:
+        return compile_children(prog, FIRST_CHILD(node), &n) &&
+            emit(prog, VCM_OP_CONCAT_STRING, n, node, n, 1) >= 0;
+
+    case PCVCM_NODE_TYPE_FUNC_GET_VARIABLE:
+        return compile_get_variable(prog, node);
+
+    case PCVCM_NODE_TYPE_FUNC_GET_ELEMENT:
+        return compile_get_element(prog, node);
+
+    case PCVCM_NODE_TYPE_FUNC_CALL_GETTER:
+        return compile_call_method(prog, node, VCM_OP_CALL_GETTER);
+
+    case PCVCM_NODE_TYPE_FUNC_CALL_SETTER:
+        return compile_call_method(prog, node, VCM_OP_CALL_SETTER);
+
+    case PCVCM_NODE_TYPE_CJSONEE:
+        return compile_cjsonee(prog, node);
+
+    default:
+        return false;
+    }
+}
+
+struct pcvcm_program *pcvcm_program_compile(struct pcvcm_node *tree)
+{
+    struct pcvcm_program *prog = (struct pcvcm_program *)calloc(1,
+            sizeof(*prog));
+    if (!prog) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    if (!compile_node(prog, tree)) {
+        pcvcm_program_destroy(prog);
+        return NULL;
+    }
+
+    PC_ASSERT(prog->depth == 1);
+    prog->id = __atomic_add_fetch(&last_program_id, 1, __ATOMIC_RELAXED);
+    return prog;
+}
+
+void pcvcm_program_destroy(struct pcvcm_program *prog)
+{
+    if (prog) {
+        free(prog->insts);
+        free(prog);
+    }
+}
+
+static purc_variant_t
+make_const(struct pcvcm_node *node)
+{
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_UNDEFINED:
+        return purc_variant_make_undefined();
+
+    case PCVCM_NODE_TYPE_NULL:
+        return purc_variant_make_null();
+
+    case PCVCM_NODE_TYPE_BOOLEAN:
+        return purc_variant_make_boolean(node->b);
+
+    case PCVCM_NODE_TYPE_NUMBER:
+        return purc_variant_make_number(node->d);
+
+    case PCVCM_NODE_TYPE_LONG_INT:
+        return purc_variant_make_longint(node->i64);
+
+    case PCVCM_NODE_TYPE_ULONG_INT:
+        return purc_variant_make_ulongint(node->u64);
+
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+        return purc_variant_make_longdouble(node->ld);
+
+    case PCVCM_NODE_TYPE_STRING:
+        return purc_variant_make_string((char*)node->sz_ptr[1], false);
+
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE:
+        return (node->sz_ptr[0] > 0) ?
+            purc_variant_make_byte_sequence((void*)node->sz_ptr[1],
+                    node->sz_ptr[0]) :
+            purc_variant_make_byte_sequence_empty();
+
+    default:
+        PC_ASSERT(0);
+        return PURC_VARIANT_INVALID;
+    }
+}
+
+static void
+free_consts(struct vcm_consts *consts)
+{
+    for (size_t i = 0; i < consts->nr_consts; i++) {
+        if (consts->consts[i]) {
+            purc_variant_unref(consts->consts[i]);
+        }
+    }
+    free(consts);
+}
+
+static void
+free_consts_entry(struct pchash_entry *entry)
+{
+    free_consts((struct vcm_consts *)pchash_entry_v(entry));
+}
+
+static struct vcm_consts *
+build_consts(struct pcvcm_program *prog)
+{
+    struct vcm_consts *consts = (struct vcm_consts *)calloc(1,
+            sizeof(*consts) + sizeof(purc_variant_t) * prog->nr_consts);
+    if (!consts) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    consts->nr_consts = prog->nr_consts;
+    for (size_t i = 0; i < prog->nr_insts; i++) {
+        const struct vcm_inst *inst = prog->insts + i;
+        if (inst->op != VCM_OP_PUSH_CONST && inst->op != VCM_OP_PUSH_RAW_CONST)
+            continue;
+
+        consts->consts[inst->arg] = make_const(inst->node);
+        if (consts->consts[inst->arg] == PURC_VARIANT_INVALID) {
+            free_consts(consts);
+            return NULL;
+        }
+    }
+
+    return consts;
+}
+
+/*
+ * Returns the constants of the program prebuilt in the current instance, or
+ * NULL if they should be made on every execution: there is no instance, or
+ * the variants are made in a move heap instead of the heap of the instance.
+ */
+static struct vcm_consts *
+get_consts(struct pcvcm_program *prog)
+{
+    struct pcinst *inst = pcinst_current();
+    if (inst == NULL || prog->nr_consts == 0 ||
+            inst->variant_heap != inst->org_vrt_heap) {
+        return NULL;
+    }
+
+    void *key = (void *)prog->id;
+    void *val;
+    if (inst->vcm_consts) {
+        if (pchash_table_lookup_ex(inst->vcm_consts, key, &val)) {
+            return (struct vcm_consts *)val;
+        }
+
+        if (inst->vcm_consts->count >= MAX_PROGRAMS_WITH_CONSTS) {
+            pcvcm_release_consts(inst);
+        }
+    }
+
+    if (inst->vcm_consts == NULL) {
+        inst->vcm_consts = pchash_kptr_table_new(64, free_consts_entry);
+        if (inst->vcm_consts == NULL) {
+            return NULL;
+        }
+    }
+
+    struct vcm_consts *consts = build_consts(prog);
+    if (consts && pchash_table_insert(inst->vcm_consts, key, consts)) {
+        free_consts(consts);
+        consts = NULL;
+    }
+    return consts;
+}
+
+void pcvcm_release_consts(struct pcinst *inst)
+{
+    if (inst->vcm_consts) {
+        pchash_table_free(inst->vcm_consts);
+        inst->vcm_consts = NULL;
+    }
+}
+
+static purc_variant_t
+make_object(purc_variant_t *kvs, size_t nr_pairs)
+{
+    purc_variant_t object = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (object == PURC_VARIANT_INVALID) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    for (size_t i = 0; i < nr_pairs; i++) {
+        if (!purc_variant_object_set(object, kvs[i * 2], kvs[i * 2 + 1])) {
+            purc_variant_unref(object);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+    return object;
+}
+
+static purc_variant_t
+make_array(purc_variant_t *members, size_t nr_members)
+{
+    purc_variant_t array = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (array == PURC_VARIANT_INVALID) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    for (size_t i = 0; i < nr_members; i++) {
+        if (!purc_variant_array_append(array, members[i])) {
+            purc_variant_unref(array);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+    return array;
+}
+
+static purc_variant_t
+concat_string(purc_variant_t *pieces, size_t nr_pieces)
+{
+    purc_rwstream_t rws = pcvcm_concat_string_begin();
+    if (!rws) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    for (size_t i = 0; i < nr_pieces; i++) {
+        pcvcm_concat_string_append(rws, pieces[i]);
+    }
+    return pcvcm_concat_string_end(rws);
+}
+
+static inline void
+pop_values(purc_variant_t *stack, size_t *top, size_t n)
+{
+    while (n--) {
+        purc_variant_unref(stack[--(*top)]);
+    }
+}
+
+purc_variant_t pcvcm_program_execute(struct pcvcm_program *prog,
+        struct pcvcm_node_op *ops, bool silently)
+{
+    purc_variant_t local_stack[NR_LOCAL_STACK_SLOTS];
+    purc_variant_t *stack = local_stack;
+    if (prog->max_depth > NR_LOCAL_STACK_SLOTS) {
+        stack = (purc_variant_t *)malloc(
+                sizeof(purc_variant_t) * prog->max_depth);
+        if (!stack) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    struct vcm_consts *consts = get_consts(prog);
+    size_t top = 0;
+    size_t pc = 0;
+    purc_variant_t ret;
+    while (pc < prog->nr_insts) {
+        const struct vcm_inst *inst = prog->insts + pc++;
+        size_t n = inst->arg;
+
+        switch (inst->op) {
+        case VCM_OP_PUSH_RAW_CONST:
+            ret = consts ? purc_variant_ref(consts->consts[n]) :
+                make_const(inst->node);
+            if (ret == PURC_VARIANT_INVALID) {
+                pop_values(stack, &top, top);
+                goto out;
+            }
+            stack[top++] = ret;
+            continue;
+
+        case VCM_OP_PUSH_CONST:
+            ret = consts ? purc_variant_ref(consts->consts[n]) :
+                make_const(inst->node);
+            break;
+
+        case VCM_OP_MAKE_OBJECT:
+            ret = make_object(stack + top - n * 2, n);
+            pop_values(stack, &top, n * 2);
+            break;
+
+        case VCM_OP_MAKE_ARRAY:
+            ret = make_array(stack + top - n, n);
+            pop_values(stack, &top, n);
+            break;
+
+        case VCM_OP_CONCAT_STRING:
+            ret = concat_string(stack + top - n, n);
+            pop_values(stack, &top, n);
+            break;
+
+        case VCM_OP_GET_VARIABLE:
+            ret = pcvcm_find_variable_by_name_var(ops, inst->node,
+                    stack[top - 1]);
+            pop_values(stack, &top, 1);
+            break;
+
+        case VCM_OP_GET_STATIC_VARIABLE:
+            ret = pcvcm_find_variable(ops, inst->node,
+                    (const char *)FIRST_CHILD(inst->node)->sz_ptr[1]);
+            break;
+
+        case VCM_OP_GET_ELEMENT:
+            ret = pcvcm_get_element(inst->node, stack[top - 2],
+                    stack[top - 1], silently);
+            pop_values(stack, &top, 2);
+            break;
+
+        case VCM_OP_CHECK_CALLER:
+            if (pcvcm_is_callable(stack[top - 1])) {
+                continue;
+            }
+            pop_values(stack, &top, 1);
+            pc = n;
+            ret = PURC_VARIANT_INVALID;
+            break;
+
+        case VCM_OP_CALL_GETTER:
+        case VCM_OP_CALL_SETTER:
+            ret = pcvcm_call_method(inst->node, stack[top - n - 1],
+                    n, n ? stack + top - n : NULL,
+                    inst->op == VCM_OP_CALL_GETTER ?
+                        GETTER_METHOD : SETTER_METHOD,
+                    silently);
+            pop_values(stack, &top, n + 1);
+            break;
+
+        case VCM_OP_POP:
+            pop_values(stack, &top, 1);
+            continue;
+
+        case VCM_OP_AND:
+            if (!purc_variant_booleanize(stack[top - 1])) {
+                pc = n;
+            }
+            else {
+                pop_values(stack, &top, 1);
+            }
+            continue;
+
+        case VCM_OP_OR:
+            if (purc_variant_booleanize(stack[top - 1])) {
+                pc = n;
+            }
+            else {
+                pop_values(stack, &top, 1);
+            }
+            continue;
+
+        case VCM_OP_END_CJSONEE:
+            pcvcm_node_finish(inst->node, stack[top - 1], silently);
+            continue;
+
+        default:
+            PC_ASSERT(0);
+            ret = PURC_VARIANT_INVALID;
+            break;
+        }
+
+        ret = pcvcm_node_finish(inst->node, ret, silently);
+        if (ret == PURC_VARIANT_INVALID) {
+            pop_values(stack, &top, top);
+            goto out;
+        }
+        stack[top++] = ret;
+    }
+
+    PC_ASSERT(top == 1);
+    ret = stack[0];
+
+out:
+    if (stack != local_stack) {
+        free(stack);
+    }
+    return ret;
+}
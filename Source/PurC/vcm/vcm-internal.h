@@ -0,0 +1,124 @@
+/**
+ * @file vcm-internal.h
+ * @brief The internal interfaces shared by the vcm tree walker and
+ *      the vcm bytecode.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PURC_VCM_VCM_INTERNAL_H
+#define PURC_VCM_VCM_INTERNAL_H
+
+#include "config.h"
+#include "purc-rwstream.h"
+#include "private/vcm.h"
+
+#define TREE_NODE(node)              ((struct pctree_node*)(node))
+#define VCM_NODE(node)               ((struct pcvcm_node*)(node))
+#define FIRST_CHILD(node)            \
+    (VCM_NODE(pctree_node_child(TREE_NODE(node))))
+#define NEXT_CHILD(node)             \
+    ((node) ? VCM_NODE(pctree_node_next(TREE_NODE(node))) : NULL)
+#define PARENT_NODE(node)            \
+    (VCM_NODE(pctree_node_parent(TREE_NODE(node))))
+#define CHILDREN_NUMBER(node)        \
+    (pctree_node_children_number(TREE_NODE(node)))
+#define APPEND_CHILD(parent, child)  \
+    pctree_node_append_child(TREE_NODE(parent), TREE_NODE(child))
+
+struct pcintr_stack;
+
+struct pcvcm_node_op {
+    cb_find_var find_var;
+    void *find_var_ctxt;
+    /* set when evaluating in a coroutine; named variables are then
+       resolved through the caches of the stack, keyed by the
+       get_variable node */
+    struct pcintr_stack *stack;
+};
+
+enum method_type {
+    GETTER_METHOD,
+    SETTER_METHOD
+};
+
+PCA_EXTERN_C_BEGIN
+
+/*
+ * The last step of evaluating any node: turns a failure into `undefined`
+ * when evaluating silently, and records the result in node->attach.
+ */
+purc_variant_t
+pcvcm_node_finish(struct pcvcm_node *node, purc_variant_t ret,
+        bool silently) WTF_INTERNAL;
+
+/* The node is the get_variable node, which keys the resolution cache */
+purc_variant_t
+pcvcm_find_variable(struct pcvcm_node_op *ops, struct pcvcm_node *node,
+        const char *name) WTF_INTERNAL;
+
+purc_variant_t
+pcvcm_find_variable_by_name_var(struct pcvcm_node_op *ops,
+        struct pcvcm_node *node, purc_variant_t name_var) WTF_INTERNAL;
+
+/* The caller and the parameter are borrowed */
+purc_variant_t
+pcvcm_get_element(struct pcvcm_node *node, purc_variant_t caller_var,
+        purc_variant_t param_var, bool silently) WTF_INTERNAL;
+
+bool
+pcvcm_is_callable(purc_variant_t caller_var) WTF_INTERNAL;
+
+/* The caller and the parameters are borrowed */
+purc_variant_t
+pcvcm_call_method(struct pcvcm_node *node, purc_variant_t caller_var,
+        size_t nr_params, purc_variant_t *params, enum method_type type,
+        bool silently) WTF_INTERNAL;
+
+purc_rwstream_t
+pcvcm_concat_string_begin(void) WTF_INTERNAL;
+
+void
+pcvcm_concat_string_append(purc_rwstream_t rws, purc_variant_t v) WTF_INTERNAL;
+
+/* Destroys the rwstream */
+purc_variant_t
+pcvcm_concat_string_end(purc_rwstream_t rws) WTF_INTERNAL;
+
+/*
+ * The bytecode: a tree is lowered once into a flat program, then executed
+ * by a small stack machine. A program holds no variant and is never changed
+ * after compiled, so it can be shared by the instances using the tree; the
+ * constants are prebuilt by every instance in its own heap.
+ * Returns NULL without any error if the tree has a shape the compiler does
+ * not handle; the tree walker is used for such trees.
+ */
+struct pcvcm_program *
+pcvcm_program_compile(struct pcvcm_node *tree) WTF_INTERNAL;
+
+purc_variant_t
+pcvcm_program_execute(struct pcvcm_program *program,
+        struct pcvcm_node_op *ops, bool silently) WTF_INTERNAL;
+
+void
+pcvcm_program_destroy(struct pcvcm_program *program) WTF_INTERNAL;
+
+PCA_EXTERN_C_END
+
+#endif /* PURC_VCM_VCM_INTERNAL_H */
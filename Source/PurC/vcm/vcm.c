@@ -36,26 +36,19 @@
 #include "private/stack.h"
 #include "private/interpreter.h"
 #include "private/utils.h"
+#include "private/instance.h"
 
-#define TREE_NODE(node)              ((struct pctree_node*)(node))
-#define VCM_NODE(node)               ((struct pcvcm_node*)(node))
-#define FIRST_CHILD(node)            \
-    (VCM_NODE(pctree_node_child(TREE_NODE(node))))
-#define NEXT_CHILD(node)             \
-    ((node) ? VCM_NODE(pctree_node_next(TREE_NODE(node))) : NULL)
-#define PARENT_NODE(node)            \
-    (VCM_NODE(pctree_node_parent(TREE_NODE(node))))
-#define CHILDREN_NUMBER(node)        \
-    (pctree_node_children_number(TREE_NODE(node)))
-#define APPEND_CHILD(parent, child)  \
-    pctree_node_append_child(TREE_NODE(parent), TREE_NODE(child))
-
+#include "vcm-internal.h"
 
 #define MIN_BUF_SIZE         32
 #define MAX_BUF_SIZE         SIZE_MAX
 
 #define PURC_ENVV_VCM_LOG_ENABLE    "PURC_VCM_LOG_ENABLE"
 
+/* a tree is compiled to bytecode when evaluated for this many times */
+#define VCM_COMPILE_THRESHOLD       2
+#define VCM_NOT_COMPILABLE          UINT8_MAX
+
 typedef
 void (*pcvcm_node_handle)(purc_rwstream_t rws, struct pcvcm_node *node,
         bool ignore_string_quoted);
@@ -68,11 +61,6 @@ static
 void pcvcm_node_serialize_to_rwstream(purc_rwstream_t rws,
         struct pcvcm_node *node, bool ignore_string_quoted);
 
-struct pcvcm_node_op {
-    cb_find_var find_var;
-    void *find_var_ctxt;
-};
-
 // expression variable
 struct pcvcm_ev {
     struct pcvcm_node *vcm;
@@ -915,6 +903,9 @@ static void pcvcm_node_destroy_callback(struct pctree_node *n,  void *data)
 {
     UNUSED_PARAM(data);
     struct pcvcm_node *node = VCM_NODE(n);
+    if (node->program) {
+        pcvcm_program_destroy(node->program);
+    }
     if ((node->type == PCVCM_NODE_TYPE_STRING
                 || node->type == PCVCM_NODE_TYPE_BYTE_SEQUENCE
         ) && node->sz_ptr[1]) {
@@ -1059,33 +1050,25 @@ out_unref_array:
     return PURC_VARIANT_INVALID;
 }
 
-purc_variant_t pcvcm_node_concat_string_to_variant(struct pcvcm_node *node,
-       struct pcvcm_node_op *ops, bool silently)
+purc_rwstream_t pcvcm_concat_string_begin(void)
 {
-    purc_rwstream_t rws = purc_rwstream_new_buffer(MIN_BUF_SIZE, MAX_BUF_SIZE);
-    if (!rws) {
-        return PURC_VARIANT_INVALID;
+    return purc_rwstream_new_buffer(MIN_BUF_SIZE, MAX_BUF_SIZE);
+}
+
+void pcvcm_concat_string_append(purc_rwstream_t rws, purc_variant_t v)
+{
+    // FIXME: stringify or serialize
+    char *buf = NULL;
+    int total = purc_variant_stringify_alloc(&buf, v);
+    if (total) {
+        purc_rwstream_write(rws, buf, total);
     }
+    free(buf);
+}
 
+purc_variant_t pcvcm_concat_string_end(purc_rwstream_t rws)
+{
     purc_variant_t ret_var = PURC_VARIANT_INVALID;
-    struct pcvcm_node *child = FIRST_CHILD(node);
-    while (child) {
-        purc_variant_t v = pcvcm_node_to_variant(child, ops, silently);
-        if (v == PURC_VARIANT_INVALID) {
-            goto out_destroy_rws;
-        }
-
-        // FIXME: stringify or serialize
-        char *buf = NULL;
-        int total = purc_variant_stringify_alloc(&buf, v);
-        if (total) {
-            purc_rwstream_write(rws, buf, total);
-        }
-        free(buf);
-        purc_variant_unref(v);
-
-        child = NEXT_CHILD(child);
-    }
 
     // do not forget tailing-null-terminator
     purc_rwstream_write(rws, "", 1);
@@ -1111,11 +1094,82 @@ purc_variant_t pcvcm_node_concat_string_to_variant(struct pcvcm_node *node,
         }
     }
 
-out_destroy_rws:
     purc_rwstream_destroy(rws);
     return ret_var;
 }
 
+static
+purc_variant_t pcvcm_node_concat_string_to_variant(struct pcvcm_node *node,
+       struct pcvcm_node_op *ops, bool silently)
+{
+    purc_rwstream_t rws = pcvcm_concat_string_begin();
+    if (!rws) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    struct pcvcm_node *child = FIRST_CHILD(node);
+    while (child) {
+        purc_variant_t v = pcvcm_node_to_variant(child, ops, silently);
+        if (v == PURC_VARIANT_INVALID) {
+            purc_rwstream_destroy(rws);
+            return PURC_VARIANT_INVALID;
+        }
+
+        pcvcm_concat_string_append(rws, v);
+        purc_variant_unref(v);
+
+        child = NEXT_CHILD(child);
+    }
+
+    return pcvcm_concat_string_end(rws);
+}
+
+static bool is_plain_var_name(const char *name)
+{
+    /* see find_stack_var() for the symbolized and anchor variables */
+    if (purc_isdigit(name[0]) || name[0] == '#')
+        return false;
+    if (name[1] == 0 && purc_ispunct(name[0]))
+        return false;
+    return true;
+}
+
+purc_variant_t pcvcm_find_variable(struct pcvcm_node_op *ops,
+        struct pcvcm_node *node, const char *name)
+{
+    purc_variant_t ret;
+    if (ops->stack && is_plain_var_name(name)) {
+        ret = pcintr_find_named_var_cached(ops->stack, name, node);
+    }
+    else if (ops->find_var) {
+        ret = ops->find_var(ops->find_var_ctxt, name);
+    }
+    else {
+        pcinst_set_error(PCVARIANT_ERROR_NOT_FOUND);
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (ret) {
+        purc_variant_ref(ret);
+    }
+    return ret;
+}
+
+purc_variant_t pcvcm_find_variable_by_name_var(struct pcvcm_node_op *ops,
+        struct pcvcm_node *node, purc_variant_t name_var)
+{
+    if (!purc_variant_is_string(name_var)) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    const char *name = purc_variant_get_string_const(name_var);
+    if (!name || name[0] == 0) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    return pcvcm_find_variable(ops, node, name);
+}
+
 static
 purc_variant_t pcvcm_node_get_variable_to_variant(struct pcvcm_node *node,
        struct pcvcm_node_op *ops, bool silently)
@@ -1136,27 +1190,7 @@ purc_variant_t pcvcm_node_get_variable_to_variant(struct pcvcm_node *node,
         goto out;
     }
 
-    if (!purc_variant_is_string(name_var)) {
-        goto out_unref_name_var;
-    }
-
-    const char *name = purc_variant_get_string_const(name_var);
-    size_t nr_name = strlen(name);
-    if (!name || nr_name == 0) {
-        goto out_unref_name_var;
-    }
-
-    if(!ops->find_var) {
-        pcinst_set_error(PCVARIANT_ERROR_NOT_FOUND);
-        goto out_unref_name_var;
-    }
-
-    ret = ops->find_var(ops->find_var_ctxt, name);
-    if (ret) {
-        purc_variant_ref(ret);
-    }
-
-out_unref_name_var:
+    ret = pcvcm_find_variable_by_name_var(ops, node, name_var);
     purc_variant_unref(name_var);
 
 out:
@@ -1182,11 +1216,6 @@ static bool is_handle_as_getter(struct pcvcm_node *node)
     return true;
 }
 
-enum method_type {
-    GETTER_METHOD,
-    SETTER_METHOD
-};
-
 static
 purc_variant_t call_dvariant_method(purc_variant_t root, purc_variant_t var,
         size_t nr_args, purc_variant_t *argv, enum method_type type,
@@ -1277,28 +1306,13 @@ inner_native_wrapper_get_param(purc_variant_t val)
     return purc_variant_object_get_by_ckey(val, KEY_PARAM_NODE);
 }
 
-static
-purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
-       struct pcvcm_node_op *ops, bool silently)
+purc_variant_t pcvcm_get_element(struct pcvcm_node *node,
+        purc_variant_t caller_var, purc_variant_t param_var, bool silently)
 {
     purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    purc_variant_t inner_ret = PURC_VARIANT_INVALID;
     struct pcvcm_node *caller_node = FIRST_CHILD(node);
-    if (!caller_node) {
-        goto out;
-    }
-
-    purc_variant_t caller_var = pcvcm_node_to_variant(caller_node, ops,
-            silently);
-    if (caller_var == PURC_VARIANT_INVALID) {
-        goto out;
-    }
-
     struct pcvcm_node *param_node  = NEXT_CHILD(caller_node);
-    purc_variant_t param_var = pcvcm_node_to_variant(param_node, ops,
-            silently);
-    if (param_var == PURC_VARIANT_INVALID) {
-        goto out_unref_caller_var;
-    }
 
     bool has_index = true;
     int64_t index = -1;
@@ -1316,11 +1330,10 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
     if (is_inner_native_wrapper(caller_var)) {
         purc_variant_t inner_caller = inner_native_wrapper_get_caller(caller_var);
         purc_variant_t inner_param = inner_native_wrapper_get_param(caller_var);
-        purc_variant_t inner_ret = call_nvariant_method(inner_caller,
+        inner_ret = call_nvariant_method(inner_caller,
                 purc_variant_get_string_const(inner_param), 0, NULL,
                 GETTER_METHOD, silently);
         if (inner_ret) {
-            purc_variant_unref(caller_var);
             caller_var = inner_ret;
         }
     }
@@ -1328,18 +1341,18 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
     if (purc_variant_is_object(caller_var)) {
         purc_variant_t val = purc_variant_object_get(caller_var, param_var);
         if (val == PURC_VARIANT_INVALID) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_ref(val);
         if (!purc_variant_is_dynamic(val)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
 
         if (!is_handle_as_getter(node)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
 
         ret_var = call_dvariant_method(caller_var, val, 0, NULL, GETTER_METHOD,
@@ -1348,30 +1361,30 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
     }
     else if (purc_variant_is_array(caller_var)) {
         if (!has_index) {
-            goto out_unref_param_var;
+            goto out;
         }
         if (index < 0) {
             size_t len = purc_variant_array_get_size(caller_var);
             index += len;
         }
         if (index < 0) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_t val = purc_variant_array_get(caller_var, index);
         if (val == PURC_VARIANT_INVALID) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_ref(val);
         if (!purc_variant_is_dynamic(val)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
 
         if (!is_handle_as_getter(node)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
         ret_var = call_dvariant_method(caller_var, val, 0, NULL, GETTER_METHOD,
                 silently);
@@ -1379,30 +1392,30 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
     }
     else if (purc_variant_is_set(caller_var)) {
         if (!has_index) {
-            goto out_unref_param_var;
+            goto out;
         }
         if (index < 0) {
             size_t len = purc_variant_set_get_size(caller_var);
             index += len;
         }
         if (index < 0) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_t val = purc_variant_set_get_by_index(caller_var, index);
         if (val == PURC_VARIANT_INVALID) {
-            goto out_unref_param_var;
+            goto out;
         }
 
         purc_variant_ref(val);
         if (!purc_variant_is_dynamic(val)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
 
         if (!is_handle_as_getter(node)) {
             ret_var = val;
-            goto out_unref_param_var;
+            goto out;
         }
         ret_var = call_dvariant_method(caller_var, val, 0, NULL, GETTER_METHOD,
                 silently);
@@ -1413,20 +1426,49 @@ purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
                 get_attach_variant(FIRST_CHILD(caller_node)),
                 caller_var, 1, &param_var, GETTER_METHOD,
                 silently);
-        goto out_unref_param_var;
     }
     else if (purc_variant_is_native(caller_var)) {
         if (!is_handle_as_getter(node)) {
             ret_var = inner_native_wrapper_create(caller_var, param_var);
-            goto out_unref_param_var;
+            goto out;
         }
         ret_var = call_nvariant_method(caller_var,
                 purc_variant_get_string_const(param_var), 0, NULL,
                 GETTER_METHOD, silently);
-        goto out_unref_param_var;
     }
 
-out_unref_param_var:
+out:
+    if (inner_ret) {
+        purc_variant_unref(inner_ret);
+    }
+    return ret_var;
+}
+
+static
+purc_variant_t pcvcm_node_get_element_to_variant(struct pcvcm_node *node,
+       struct pcvcm_node_op *ops, bool silently)
+{
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    struct pcvcm_node *caller_node = FIRST_CHILD(node);
+    if (!caller_node) {
+        goto out;
+    }
+
+    purc_variant_t caller_var = pcvcm_node_to_variant(caller_node, ops,
+            silently);
+    if (caller_var == PURC_VARIANT_INVALID) {
+        goto out;
+    }
+
+    struct pcvcm_node *param_node  = NEXT_CHILD(caller_node);
+    purc_variant_t param_var = pcvcm_node_to_variant(param_node, ops,
+            silently);
+    if (param_var == PURC_VARIANT_INVALID) {
+        goto out_unref_caller_var;
+    }
+
+    ret_var = pcvcm_get_element(node, caller_var, param_var, silently);
+
     purc_variant_unref(param_var);
 out_unref_caller_var:
     purc_variant_unref(caller_var);
@@ -1434,6 +1476,40 @@ out:
     return ret_var;
 }
 
+bool pcvcm_is_callable(purc_variant_t caller_var)
+{
+    return purc_variant_is_dynamic(caller_var)
+        || is_inner_native_wrapper(caller_var);
+}
+
+purc_variant_t pcvcm_call_method(struct pcvcm_node *node,
+        purc_variant_t caller_var, size_t nr_params, purc_variant_t *params,
+        enum method_type type, bool silently)
+{
+    purc_variant_t ret_var = PURC_VARIANT_INVALID;
+    struct pcvcm_node *caller_node = FIRST_CHILD(node);
+
+    if (purc_variant_is_dynamic(caller_var)) {
+        ret_var = call_dvariant_method(
+                get_attach_variant(FIRST_CHILD(caller_node)),
+                caller_var, nr_params, params, type, silently);
+    }
+    else if (is_inner_native_wrapper(caller_var)) {
+        purc_variant_t nv = inner_native_wrapper_get_caller(caller_var);
+        if (purc_variant_is_native(nv)) {
+            purc_variant_t name = inner_native_wrapper_get_param(caller_var);
+            if (name) {
+                ret_var = call_nvariant_method(nv,
+                        purc_variant_get_string_const(name), nr_params,
+                        params, type, silently);
+            }
+        }
+    }
+
+    return ret_var;
+}
+
+static
 purc_variant_t pcvcm_node_call_method_to_variant(struct pcvcm_node *node,
        struct pcvcm_node_op *ops, enum method_type type, bool silently)
 {
@@ -1448,8 +1524,7 @@ purc_variant_t pcvcm_node_call_method_to_variant(struct pcvcm_node *node,
         goto out;
     }
 
-    if (!purc_variant_is_dynamic(caller_var)
-            && !is_inner_native_wrapper(caller_var)) {
+    if (!pcvcm_is_callable(caller_var)) {
         goto out_unref_caller_var;
     }
 
@@ -1476,22 +1551,8 @@ purc_variant_t pcvcm_node_call_method_to_variant(struct pcvcm_node *node,
         }
     }
 
-    if (purc_variant_is_dynamic(caller_var)) {
-        ret_var = call_dvariant_method(
-                get_attach_variant(FIRST_CHILD(caller_node)),
-                caller_var, nr_params, params, type, silently);
-    }
-    else if (is_inner_native_wrapper(caller_var)) {
-        purc_variant_t nv = inner_native_wrapper_get_caller(caller_var);
-        if (purc_variant_is_native(nv)) {
-            purc_variant_t name = inner_native_wrapper_get_param(caller_var);
-            if (name) {
-                ret_var = call_nvariant_method(nv,
-                        purc_variant_get_string_const(name), nr_params,
-                        params, type, silently);
-            }
-        }
-    }
+    ret_var = pcvcm_call_method(node, caller_var, nr_params, params, type,
+            silently);
 
 out_unref_params:
     for (size_t i = 0; i < nr_params; i++) {
@@ -1612,6 +1673,23 @@ static bool has_fatal_error()
     return (err == PURC_ERROR_OUT_OF_MEMORY);
 }
 
+purc_variant_t pcvcm_node_finish(struct pcvcm_node *node, purc_variant_t ret,
+        bool silently)
+{
+    if (ret == PURC_VARIANT_INVALID
+            && silently && !has_fatal_error()) {
+        ret = purc_variant_make_undefined();
+    }
+
+    node->attach = (uintptr_t)ret;
+
+    if (_print_vcm_log) {
+        PRINT_VCM_NODE(node);
+        PRINT_VARIANT(ret);
+    }
+    return ret;
+}
+
 purc_variant_t pcvcm_node_to_variant(struct pcvcm_node *node,
         struct pcvcm_node_op *ops, bool silently)
 {
@@ -1694,18 +1772,7 @@ purc_variant_t pcvcm_node_to_variant(struct pcvcm_node *node,
             break;
     }
 
-    if (ret == PURC_VARIANT_INVALID
-            && silently && !has_fatal_error()) {
-        ret = purc_variant_make_undefined();
-    }
-
-    node->attach = (uintptr_t)ret;
-
-    if (_print_vcm_log) {
-        PRINT_VCM_NODE(node);
-        PRINT_VARIANT(ret);
-    }
-    return ret;
+    return pcvcm_node_finish(node, ret, silently);
 }
 
 static inline bool is_digit(char c)
@@ -1755,6 +1822,46 @@ purc_variant_t pcvcm_eval(struct pcvcm_node *tree, struct pcintr_stack *stack,
     return pcvcm_eval_ex(tree, NULL, NULL, silently);
 }
 
+/*
+ * The tree belongs to the vDOM, which may be evaluated by the instances on
+ * other threads at the same time. So the counter and the program are
+ * accessed atomically; only the evaluation which reaches the threshold
+ * compiles the tree, and a program is published only once.
+ */
+static struct pcvcm_program *get_program(struct pcvcm_node *tree)
+{
+    struct pcvcm_program *program;
+    program = __atomic_load_n(&tree->program, __ATOMIC_ACQUIRE);
+    if (program) {
+        return program;
+    }
+
+    if (__atomic_load_n(&tree->nr_evals, __ATOMIC_RELAXED) ==
+            VCM_NOT_COMPILABLE) {
+        return NULL;
+    }
+
+    if (__atomic_add_fetch(&tree->nr_evals, 1, __ATOMIC_RELAXED) !=
+            VCM_COMPILE_THRESHOLD) {
+        return NULL;
+    }
+
+    program = pcvcm_program_compile(tree);
+    if (program == NULL) {
+        __atomic_store_n(&tree->nr_evals, VCM_NOT_COMPILABLE,
+                __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    struct pcvcm_program *expected = NULL;
+    if (!__atomic_compare_exchange_n(&tree->program, &expected, program,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        pcvcm_program_destroy(program);
+        program = expected;
+    }
+    return program;
+}
+
 purc_variant_t pcvcm_eval_ex(struct pcvcm_node *tree,
         cb_find_var find_var, void *ctxt, bool silently)
 {
@@ -1768,14 +1875,26 @@ purc_variant_t pcvcm_eval_ex(struct pcvcm_node *tree,
         PC_DEBUG("pcvcm_eval_ex|begin|silently=%d\n", silently);
     }
 
+    struct pcinst *inst = pcinst_current();
+    bool tree_walker = inst && inst->vcm_tree_walker;
+
     purc_variant_t ret = PURC_VARIANT_INVALID;
 
     struct pcvcm_node_op ops = {
         .find_var = find_var,
         .find_var_ctxt = ctxt,
+        .stack = (find_var == find_stack_var) ? ctxt : NULL,
     };
 
-    if (tree) {
+    struct pcvcm_program *program = NULL;
+    if (tree && !tree_walker) {
+        program = get_program(tree);
+    }
+
+    if (program) {
+        ret = pcvcm_program_execute(program, &ops, silently);
+    }
+    else if (tree) {
         ret = pcvcm_node_to_variant(tree, &ops, silently);
     }
     else if (silently) {
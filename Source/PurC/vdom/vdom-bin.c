@@ -0,0 +1,839 @@
+/*
+ * @file vdom-bin.c
+ * @date 2022/11/02
+ * @brief The binary serialization of vDOM documents.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "private/instance.h"
+#include "private/errors.h"
+#include "private/debug.h"
+#include "private/utils.h"
+#include "private/vdom.h"
+
+#include "vdom-internal.h"
+
+/*
+ * The layout of a compiled document:
+ *
+ *  - a fixed-size header (struct bin_header);
+ *  - the payload: the nodes in pre-order.
+ *
+ * In the payload, the unsigned integers are LEB128-encoded, the strings are
+ * encoded as the length plus one (zero for NULL) followed by the bytes and
+ * a terminating null byte, so that they can be used in place, and the
+ * numbers are stored in the native byte order; the header records the byte
+ * order and the size of long double, and the document is rejected if they
+ * do not match the current ones.
+ */
+
+#define BIN_MAGIC           "PURCVDOM"
+#define BIN_BYTE_ORDER      0x0102
+
+/* the nodes nested deeper than this are not supported */
+#define BIN_MAX_DEPTH       1024
+
+/* the flags of an element */
+#define ELEM_SELF_CLOSING   0x01
+#define ELEM_ROOT           0x02
+#define ELEM_HEAD           0x04
+#define ELEM_BODY           0x08
+#define ELEM_CURRENT_BODY   0x10
+
+struct bin_header {
+    char        magic[8];
+    uint32_t    version;
+    uint16_t    byte_order;
+    uint8_t     sz_long_double;
+    uint8_t     reserved;
+    /* the version of PurC which compiled the document */
+    char        purc_version[16];
+    /* the digest of the source of the document */
+    unsigned char digest[PCVDOM_BIN_DIGEST_SIZE];
+    uint64_t    sz_payload;
+    uint64_t    checksum;
+};
+
+/* A FNV-1a like hash on 64-bit words; it is used to detect a corrupted
+   file, not a forged one */
+static uint64_t
+checksum(const uint8_t *data, size_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL ^ len;
+    uint64_t word;
+
+    for (; len >= sizeof(word); len -= sizeof(word)) {
+        memcpy(&word, data, sizeof(word));
+        data += sizeof(word);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 32;
+    }
+
+    for (; len > 0; len--) {
+        hash = (hash ^ *data++) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static void
+make_header(struct bin_header *header, const unsigned char *digest)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, BIN_MAGIC, sizeof(header->magic));
+    header->version = PCVDOM_BIN_VERSION;
+    header->byte_order = BIN_BYTE_ORDER;
+    header->sz_long_double = sizeof(long double);
+    strncpy(header->purc_version, PURC_VERSION_STRING,
+            sizeof(header->purc_version) - 1);
+    if (digest)
+        memcpy(header->digest, digest, PCVDOM_BIN_DIGEST_SIZE);
+}
+
+struct dump_ctxt {
+    purc_rwstream_t     out;
+    struct pcvdom_document *doc;
+    size_t              nr_bodies;
+    int                 err;
+};
+
+static void
+dump_bytes(struct dump_ctxt *ctxt, const void *data, size_t len)
+{
+    if (ctxt->err || len == 0)
+        return;
+
+    if (purc_rwstream_write(ctxt->out, data, len) != (ssize_t)len)
+        ctxt->err = -1;
+}
+
+static void
+dump_uint(struct dump_ctxt *ctxt, uint64_t v)
+{
+    uint8_t buf[10];
+    size_t n = 0;
+
+    do {
+        buf[n] = v & 0x7F;
+        v >>= 7;
+        if (v)
+            buf[n] |= 0x80;
+        n++;
+    } while (v);
+
+    dump_bytes(ctxt, buf, n);
+}
+
+static void
+dump_string(struct dump_ctxt *ctxt, const char *str, size_t len)
+{
+    if (str == NULL) {
+        dump_uint(ctxt, 0);
+        return;
+    }
+
+    dump_uint(ctxt, len + 1);
+    dump_bytes(ctxt, str, len);
+    dump_bytes(ctxt, "", 1);
+}
+
+static void
+dump_vcm(struct dump_ctxt *ctxt, struct pcvcm_node *node, int depth)
+{
+    if (depth > BIN_MAX_DEPTH) {
+        ctxt->err = -1;
+        return;
+    }
+
+    dump_uint(ctxt, node->type);
+    dump_uint(ctxt, node->extra);
+    dump_uint(ctxt, node->is_closed);
+
+    switch (node->type) {
+    case PCVCM_NODE_TYPE_BOOLEAN:
+        dump_uint(ctxt, node->b);
+        break;
+
+    case PCVCM_NODE_TYPE_NUMBER:
+        dump_bytes(ctxt, &node->d, sizeof(node->d));
+        break;
+
+    case PCVCM_NODE_TYPE_LONG_INT:
+    case PCVCM_NODE_TYPE_ULONG_INT:
+        dump_bytes(ctxt, &node->u64, sizeof(node->u64));
+        break;
+
+    case PCVCM_NODE_TYPE_LONG_DOUBLE:
+        dump_bytes(ctxt, &node->ld, sizeof(node->ld));
+        break;
+
+    case PCVCM_NODE_TYPE_STRING:
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE:
+        dump_string(ctxt, (const char *)node->sz_ptr[1], node->sz_ptr[0]);
+        break;
+
+    default:
+        break;
+    }
+
+    dump_uint(ctxt, pcvcm_node_children_count(node));
+
+    struct pctree_node *child = node->tree_node.first_child;
+    while (child) {
+        dump_vcm(ctxt, (struct pcvcm_node *)child, depth + 1);
+        child = child->next;
+    }
+}
+
+static void
+dump_nullable_vcm(struct dump_ctxt *ctxt, struct pcvcm_node *vcm, int depth)
+{
+    dump_uint(ctxt, vcm ? 1 : 0);
+    if (vcm)
+        dump_vcm(ctxt, vcm, depth);
+}
+
+static void
+dump_attr(struct dump_ctxt *ctxt, struct pcvdom_attr *attr)
+{
+    dump_string(ctxt, attr->key, strlen(attr->key));
+    dump_uint(ctxt, attr->op);
+    dump_nullable_vcm(ctxt, attr->val, 0);
+}
+
+static ssize_t
+body_index(struct pcvdom_document *doc, struct pcvdom_element *elem)
+{
+    size_t nr = pcutils_arrlist_length(doc->bodies);
+    for (size_t i = 0; i < nr; i++) {
+        if (pcutils_arrlist_get_idx(doc->bodies, i) == elem)
+            return i;
+    }
+
+    return -1;
+}
+
+static void
+dump_node(struct dump_ctxt *ctxt, struct pcvdom_node *node, int depth)
+{
+    if (depth > BIN_MAX_DEPTH) {
+        ctxt->err = -1;
+        return;
+    }
+
+    dump_uint(ctxt, node->type);
+
+    switch (node->type) {
+    case PCVDOM_NODE_ELEMENT: {
+        struct pcvdom_element *elem = PCVDOM_ELEMENT_FROM_NODE(node);
+        struct pcvdom_document *doc = ctxt->doc;
+        ssize_t idx = body_index(doc, elem);
+        unsigned flags = 0;
+
+        if (elem->self_closing)
+            flags |= ELEM_SELF_CLOSING;
+        if (doc->root == elem)
+            flags |= ELEM_ROOT;
+        if (doc->head == elem)
+            flags |= ELEM_HEAD;
+        if (idx >= 0)
+            flags |= ELEM_BODY;
+        if (doc->body == elem)
+            flags |= ELEM_CURRENT_BODY;
+
+        dump_string(ctxt, elem->tag_name, strlen(elem->tag_name));
+        dump_uint(ctxt, flags);
+        if (idx >= 0) {
+            dump_uint(ctxt, idx);
+            ctxt->nr_bodies++;
+        }
+
+        size_t nr_attrs = pcutils_sorted_array_count(elem->attrs);
+        dump_uint(ctxt, nr_attrs);
+        for (size_t i = 0; i < nr_attrs && !ctxt->err; i++) {
+            void *attr;
+            pcutils_sorted_array_get(elem->attrs, i, &attr);
+            dump_attr(ctxt, attr);
+        }
+        break;
+    }
+
+    case PCVDOM_NODE_CONTENT: {
+        struct pcvdom_content *content = PCVDOM_CONTENT_FROM_NODE(node);
+        if (content->vcm == NULL)
+            ctxt->err = -1;
+        else
+            dump_vcm(ctxt, content->vcm, 0);
+        break;
+    }
+
+    case PCVDOM_NODE_COMMENT: {
+        struct pcvdom_comment *comment = PCVDOM_COMMENT_FROM_NODE(node);
+        if (comment->text == NULL)
+            ctxt->err = -1;
+        else
+            dump_string(ctxt, comment->text, strlen(comment->text));
+        break;
+    }
+
+    case PCVDOM_NODE_DOCUMENT:
+    default:
+        ctxt->err = -1;
+        return;
+    }
+
+    dump_uint(ctxt, pctree_node_children_number(&node->node));
+
+    struct pctree_node *child = node->node.first_child;
+    while (child) {
+        dump_node(ctxt, container_of(child, struct pcvdom_node, node),
+                depth + 1);
+        child = child->next;
+    }
+}
+
+static void
+dump_doctype_string(struct dump_ctxt *ctxt, const char *str)
+{
+    dump_string(ctxt, str, str ? strlen(str) : 0);
+}
+
+int
+pcvdom_document_dump_bin(struct pcvdom_document *doc,
+        const unsigned char *digest, purc_rwstream_t out)
+{
+    if (!doc || !out) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    purc_rwstream_t payload = purc_rwstream_new_buffer(0, 0);
+    if (!payload)
+        return -1;
+
+    struct dump_ctxt ctxt = { payload, doc, 0, 0 };
+
+    dump_doctype_string(&ctxt, doc->doctype.name);
+    dump_doctype_string(&ctxt, doc->doctype.tag_prefix);
+    dump_doctype_string(&ctxt, doc->doctype.system_info);
+    dump_uint(&ctxt, doc->quirks);
+    dump_uint(&ctxt, pcutils_arrlist_length(doc->bodies));
+
+    dump_uint(&ctxt, pctree_node_children_number(&doc->node.node));
+    struct pctree_node *child = doc->node.node.first_child;
+    while (child) {
+        dump_node(&ctxt, container_of(child, struct pcvdom_node, node), 1);
+        child = child->next;
+    }
+
+    /* a body which is not in the tree can not be restored */
+    if (ctxt.nr_bodies != pcutils_arrlist_length(doc->bodies))
+        ctxt.err = -1;
+
+    int ret = -1;
+    if (ctxt.err) {
+        pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+        goto done;
+    }
+
+    size_t sz_payload;
+    const uint8_t *data = purc_rwstream_get_mem_buffer(payload, &sz_payload);
+
+    struct bin_header header;
+    make_header(&header, digest);
+    header.sz_payload = sz_payload;
+    header.checksum = checksum(data, sz_payload);
+
+    if (purc_rwstream_write(out, &header, sizeof(header)) !=
+                (ssize_t)sizeof(header) ||
+            purc_rwstream_write(out, data, sz_payload) != (ssize_t)sz_payload)
+        goto done;
+
+    ret = 0;
+
+done:
+    purc_rwstream_destroy(payload);
+    return ret;
+}
+
+struct load_ctxt {
+    const uint8_t          *p;
+    const uint8_t          *end;
+    struct pcvdom_document *doc;
+    size_t                  nr_bodies;
+    int                     err;
+};
+
+static uint64_t
+load_uint(struct load_ctxt *ctxt)
+{
+    uint64_t v = 0;
+    unsigned shift = 0;
+
+    while (!ctxt->err) {
+        if (ctxt->p >= ctxt->end || shift > 63) {
+            ctxt->err = -1;
+            break;
+        }
+
+        uint8_t c = *ctxt->p++;
+        v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80))
+            return v;
+        shift += 7;
+    }
+
+    return 0;
+}
+
+static bool
+load_bytes(struct load_ctxt *ctxt, void *buf, size_t len)
+{
+    if (ctxt->err || (size_t)(ctxt->end - ctxt->p) < len) {
+        ctxt->err = -1;
+        return false;
+    }
+
+    memcpy(buf, ctxt->p, len);
+    ctxt->p += len;
+    return true;
+}
+
+/* returns the string in place; *len is the length without the null byte */
+static const char *
+load_string(struct load_ctxt *ctxt, size_t *len)
+{
+    uint64_t n = load_uint(ctxt);
+    *len = 0;
+    if (ctxt->err || n == 0)
+        return NULL;
+
+    if ((uint64_t)(ctxt->end - ctxt->p) < n || ctxt->p[n - 1] != 0) {
+        ctxt->err = -1;
+        return NULL;
+    }
+
+    const char *str = (const char *)ctxt->p;
+    ctxt->p += n;
+    *len = n - 1;
+    return str;
+}
+
+static const char *
+load_nonnull_string(struct load_ctxt *ctxt)
+{
+    size_t len;
+    const char *str = load_string(ctxt, &len);
+    if (str == NULL || strlen(str) != len)
+        ctxt->err = -1;
+    return ctxt->err ? NULL : str;
+}
+
+static struct pcvcm_node *
+load_vcm(struct load_ctxt *ctxt, int depth)
+{
+    struct pcvcm_node *node = NULL;
+
+    if (depth > BIN_MAX_DEPTH) {
+        ctxt->err = -1;
+        return NULL;
+    }
+
+    uint64_t type = load_uint(ctxt);
+    uint64_t extra = load_uint(ctxt);
+    uint64_t is_closed = load_uint(ctxt);
+    if (ctxt->err)
+        return NULL;
+
+    switch (type) {
+    case PCVCM_NODE_TYPE_UNDEFINED:
+        node = pcvcm_node_new_undefined();
+        break;
+
+    case PCVCM_NODE_TYPE_OBJECT:
+        node = pcvcm_node_new_object(0, NULL);
+        break;
+
+    case PCVCM_NODE_TYPE_ARRAY:
+        node = pcvcm_node_new_array(0, NULL);
+        break;
+
+    case PCVCM_NODE_TYPE_STRING: {
+        size_t len;
+        const char *str = load_string(ctxt, &len);
+        if (str == NULL || strlen(str) != len)
+            ctxt->err = -1;
+        else
+            node = pcvcm_node_new_string(str);
+        break;
+    }
+
+    case PCVCM_NODE_TYPE_NULL:
+        node = pcvcm_node_new_null();
+        break;
+
+    case PCVCM_NODE_TYPE_BOOLEAN: {
+        uint64_t b = load_uint(ctxt);
+        if (!ctxt->err)
+            node = pcvcm_node_new_boolean(b != 0);
+        break;
+    }
+
+    case PCVCM_NODE_TYPE_NUMBER: {
+        double d;
+        if (load_bytes(ctxt, &d, sizeof(d)))
+            node = pcvcm_node_new_number(d);
+        break;
+    }
+
+    case PCVCM_NODE_TYPE_LONG_INT: {
+        int64_t i64;
+        if (load_bytes(ctxt, &i64, sizeof(i64)))
+            node = pcvcm_node_new_longint(i64);
+        break;
+    }
+
+    case PCVCM_NODE_TYPE_ULONG_INT: {
+        uint64_t u64;
+        if (load_bytes(ctxt, &u64, sizeof(u64)))
+            node = pcvcm_node_new_ulongint(u64);
+        break;
+    }
+
+    case PCVCM_NODE_TYPE_LONG_DOUBLE: {
+        long double ld;
+        if (load_bytes(ctxt, &ld, sizeof(ld)))
+            node = pcvcm_node_new_longdouble(ld);
+        break;
+    }
+
+    case PCVCM_NODE_TYPE_BYTE_SEQUENCE: {
+        size_t len;
+        const char *bytes = load_string(ctxt, &len);
+        if (!ctxt->err)
+            node = pcvcm_node_new_byte_sequence(bytes, len);
+        break;
+    }
+
+    case PCVCM_NODE_TYPE_FUNC_CONCAT_STRING:
+        node = pcvcm_node_new_concat_string(0, NULL);
+        break;
+
+    case PCVCM_NODE_TYPE_FUNC_GET_VARIABLE:
+        node = pcvcm_node_new_get_variable(NULL);
+        break;
+
+    case PCVCM_NODE_TYPE_FUNC_GET_ELEMENT:
+        node = pcvcm_node_new_get_element(NULL, NULL);
+        break;
+
+    case PCVCM_NODE_TYPE_FUNC_CALL_GETTER:
+        node = pcvcm_node_new_call_getter(NULL, 0, NULL);
+        break;
+
+    case PCVCM_NODE_TYPE_FUNC_CALL_SETTER:
+        node = pcvcm_node_new_call_setter(NULL, 0, NULL);
+        break;
+
+    case PCVCM_NODE_TYPE_CJSONEE:
+        node = pcvcm_node_new_cjsonee();
+        break;
+
+    case PCVCM_NODE_TYPE_CJSONEE_OP_AND:
+        node = pcvcm_node_new_cjsonee_op_and();
+        break;
+
+    case PCVCM_NODE_TYPE_CJSONEE_OP_OR:
+        node = pcvcm_node_new_cjsonee_op_or();
+        break;
+
+    case PCVCM_NODE_TYPE_CJSONEE_OP_SEMICOLON:
+        node = pcvcm_node_new_cjsonee_op_semicolon();
+        break;
+
+    default:
+        ctxt->err = -1;
+        break;
+    }
+
+    if (node == NULL) {
+        ctxt->err = -1;
+        return NULL;
+    }
+
+    node->extra = (uint32_t)extra;
+    node->is_closed = is_closed != 0;
+
+    uint64_t nr_children = load_uint(ctxt);
+    for (uint64_t i = 0; i < nr_children && !ctxt->err; i++) {
+        struct pcvcm_node *child = load_vcm(ctxt, depth + 1);
+        if (child)
+            pctree_node_append_child(&node->tree_node, &child->tree_node);
+    }
+
+    if (ctxt->err) {
+        pcvcm_node_destroy(node);
+        return NULL;
+    }
+
+    return node;
+}
+
+static struct pcvcm_node *
+load_nullable_vcm(struct load_ctxt *ctxt)
+{
+    uint64_t has_vcm = load_uint(ctxt);
+    if (ctxt->err || !has_vcm)
+        return NULL;
+    return load_vcm(ctxt, 0);
+}
+
+static int
+load_attrs(struct load_ctxt *ctxt, struct pcvdom_element *elem)
+{
+    uint64_t nr_attrs = load_uint(ctxt);
+
+    for (uint64_t i = 0; i < nr_attrs && !ctxt->err; i++) {
+        const char *key = load_nonnull_string(ctxt);
+        uint64_t op = load_uint(ctxt);
+        if (ctxt->err || op >= PCHVML_ATTRIBUTE_MAX) {
+            ctxt->err = -1;
+            break;
+        }
+
+        struct pcvcm_node *vcm = load_nullable_vcm(ctxt);
+        if (ctxt->err)
+            break;
+
+        struct pcvdom_attr *attr = pcvdom_attr_create(key, op, vcm);
+        if (attr == NULL) {
+            if (vcm)
+                pcvcm_node_destroy(vcm);
+            ctxt->err = -1;
+            break;
+        }
+
+        if (pcvdom_element_append_attr(elem, attr)) {
+            pcvdom_attr_destroy(attr);
+            ctxt->err = -1;
+        }
+    }
+
+    return ctxt->err;
+}
+
+static struct pcvdom_node *
+load_node(struct load_ctxt *ctxt, int depth);
+
+static int
+load_children(struct load_ctxt *ctxt, struct pcvdom_node *parent, int depth)
+{
+    uint64_t nr_children = load_uint(ctxt);
+
+    for (uint64_t i = 0; i < nr_children && !ctxt->err; i++) {
+        struct pcvdom_node *child = load_node(ctxt, depth);
+        if (child)
+            pctree_node_append_child(&parent->node, &child->node);
+    }
+
+    return ctxt->err;
+}
+
+static struct pcvdom_element *
+load_element(struct load_ctxt *ctxt, int depth)
+{
+    struct pcvdom_document *doc = ctxt->doc;
+    const char *tag_name = load_nonnull_string(ctxt);
+    uint64_t flags = load_uint(ctxt);
+    if (ctxt->err)
+        return NULL;
+
+    struct pcvdom_element *elem = pcvdom_element_create_c(tag_name);
+    if (elem == NULL) {
+        ctxt->err = -1;
+        return NULL;
+    }
+
+    elem->self_closing = (flags & ELEM_SELF_CLOSING) ? 1 : 0;
+
+    if (flags & ELEM_BODY) {
+        uint64_t idx = load_uint(ctxt);
+        if (ctxt->err || idx >= pcutils_arrlist_length(doc->bodies) ||
+                pcutils_arrlist_get_idx(doc->bodies, idx)) {
+            ctxt->err = -1;
+            goto failed;
+        }
+        pcutils_arrlist_put_idx(doc->bodies, idx, elem);
+        ctxt->nr_bodies++;
+    }
+
+    if (load_attrs(ctxt, elem) || load_children(ctxt, &elem->node, depth + 1))
+        goto failed;
+
+    if (flags & ELEM_ROOT)
+        doc->root = elem;
+    if (flags & ELEM_HEAD)
+        doc->head = elem;
+    if (flags & ELEM_CURRENT_BODY)
+        doc->body = elem;
+    return elem;
+
+failed:
+    /* the bodies list does not own the elements and the document will be
+       destroyed without using it */
+    pcvdom_node_destroy(&elem->node);
+    return NULL;
+}
+
+static struct pcvdom_node *
+load_node(struct load_ctxt *ctxt, int depth)
+{
+    struct pcvdom_node *node = NULL;
+
+    if (depth > BIN_MAX_DEPTH) {
+        ctxt->err = -1;
+        return NULL;
+    }
+
+    uint64_t type = load_uint(ctxt);
+    if (ctxt->err)
+        return NULL;
+
+    switch (type) {
+    case PCVDOM_NODE_ELEMENT: {
+        struct pcvdom_element *elem = load_element(ctxt, depth);
+        return elem ? &elem->node : NULL;
+    }
+
+    case PCVDOM_NODE_CONTENT: {
+        struct pcvcm_node *vcm = load_vcm(ctxt, 0);
+        if (vcm) {
+            struct pcvdom_content *content = pcvdom_content_create(vcm);
+            if (content)
+                node = &content->node;
+            else
+                pcvcm_node_destroy(vcm);
+        }
+        break;
+    }
+
+    case PCVDOM_NODE_COMMENT: {
+        const char *text = load_nonnull_string(ctxt);
+        if (text) {
+            struct pcvdom_comment *comment = pcvdom_comment_create(text);
+            if (comment)
+                node = &comment->node;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    if (node == NULL) {
+        ctxt->err = -1;
+        return NULL;
+    }
+
+    /* the contents and the comments have no children */
+    if (load_children(ctxt, node, depth + 1)) {
+        pcvdom_node_destroy(node);
+        return NULL;
+    }
+
+    return node;
+}
+
+static char *
+load_doctype_string(struct load_ctxt *ctxt)
+{
+    size_t len;
+    const char *str = load_string(ctxt, &len);
+    if (ctxt->err || str == NULL)
+        return NULL;
+
+    char *dup = strdup(str);
+    if (dup == NULL)
+        ctxt->err = -1;
+    return dup;
+}
+
+struct pcvdom_document *
+pcvdom_document_load_bin(const void *buf, size_t len,
+        const unsigned char *digest)
+{
+    struct bin_header header;
+    struct bin_header expected;
+
+    if (buf == NULL || len < sizeof(header)) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return NULL;
+    }
+
+    /* the buffer may be not aligned */
+    memcpy(&header, buf, sizeof(header));
+    make_header(&expected, digest ? digest : header.digest);
+    expected.sz_payload = header.sz_payload;
+    expected.checksum = header.checksum;
+    if (memcmp(&header, &expected, sizeof(header)) ||
+            header.sz_payload != len - sizeof(header)) {
+        pcinst_set_error(PURC_ERROR_NOT_DESIRED_ENTITY);
+        return NULL;
+    }
+
+    const uint8_t *payload = (const uint8_t *)buf + sizeof(header);
+    if (checksum(payload, header.sz_payload) != header.checksum) {
+        pcinst_set_error(PURC_ERROR_NOT_DESIRED_ENTITY);
+        return NULL;
+    }
+
+    struct pcvdom_document *doc = pcvdom_document_create();
+    if (doc == NULL)
+        return NULL;
+
+    struct load_ctxt ctxt = { payload, payload + header.sz_payload,
+        doc, 0, 0 };
+
+    doc->doctype.name = load_doctype_string(&ctxt);
+    doc->doctype.tag_prefix = load_doctype_string(&ctxt);
+    doc->doctype.system_info = load_doctype_string(&ctxt);
+    doc->quirks = load_uint(&ctxt) ? 1 : 0;
+
+    /* the slots are filled when the bodies are loaded */
+    uint64_t nr_bodies = load_uint(&ctxt);
+    if (nr_bodies > header.sz_payload)
+        ctxt.err = -1;
+    for (uint64_t i = 0; i < nr_bodies && !ctxt.err; i++) {
+        if (pcutils_arrlist_put_idx(doc->bodies, i, NULL))
+            ctxt.err = -1;
+    }
+
+    if (!ctxt.err)
+        load_children(&ctxt, &doc->node, 1);
+
+    if (ctxt.err || ctxt.p != ctxt.end || ctxt.nr_bodies != nr_bodies) {
+        pcvdom_document_unref(doc);
+        pcinst_set_error(PURC_ERROR_NOT_DESIRED_ENTITY);
+        return NULL;
+    }
+
+    return doc;
+}
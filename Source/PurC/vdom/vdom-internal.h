@@ -33,6 +33,8 @@
 #error "Not implemented for this platform."
 #endif                          /* } */
 
+#include "private/sorted-array.h"
+
 #define PCVDOM_NODE_IS_DOCUMENT(_n) \
     (((_n) && (_n)->type==PCVDOM_NODE_DOCUMENT))
 #define PCVDOM_NODE_IS_ELEMENT(_n) \
@@ -93,6 +95,12 @@ struct pcvdom_attr {
     const struct pchvml_attr_entry  *pre_defined;
     char                     *key;
 
+    // resolved when the attr is created, for the fast dispatch:
+    //   PCHVML_KEYWORD_ENUM(HVML, xxx) of the key, or -1 if not a keyword
+    //   and the atom of the keyword, or 0 if not a keyword
+    int                       keyword;
+    purc_atom_t               atom;
+
     // operator
     enum pchvml_attr_operator       op;
 
@@ -108,9 +116,10 @@ struct pcvdom_element {
     pcvdom_tag_id           tag_id;
     char                   *tag_name;
 
-    // key: char *, the same as struct pcvdom_attr:key
-    // val: struct pcvdom_attr*
-    struct pcutils_map     *attrs;
+    // sorted by key; compact and traversed by index
+    // sortv: char *, the same as struct pcvdom_attr:key
+    // data: struct pcvdom_attr*
+    struct sorted_array    *attrs;
 
     unsigned int            self_closing:1;
 };
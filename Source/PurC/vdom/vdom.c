@@ -31,6 +31,7 @@
 #include "private/stringbuilder.h"
 
 #include "hvml-attr.h"
+#include "keywords.h"
 
 #include "vdom-internal.h"
 
@@ -256,6 +257,10 @@ pcvdom_attr_create(const char *key, enum pchvml_attr_operator op,
 
     attr->val = vcm;
 
+    attr->keyword = PCHVML_KEYWORD_ENUM_OF(HVML, attr->key);
+    if (attr->keyword >= 0)
+        attr->atom = pchvml_keyword(attr->keyword);
+
     return attr;
 }
 
@@ -353,10 +358,15 @@ pcvdom_element_append_attr(struct pcvdom_element *elem,
 
     PC_ASSERT(elem->attrs);
 
+    // the attr with the same key is replaced
+    pcutils_sorted_array_remove(elem->attrs, attr->key);
+
     int r;
-    r = pcutils_map_find_replace_or_insert(elem->attrs,
-            attr->key, attr, NULL);
-    PC_ASSERT(r==0);
+    r = pcutils_sorted_array_add(elem->attrs, attr->key, attr);
+    if (r) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
 
     attr->parent = elem;
 
@@ -551,15 +561,13 @@ pcvdom_element_get_attr_c(struct pcvdom_element *elem,
         return NULL;
     }
 
-    pcutils_map_entry *entry;
-    entry = pcutils_map_find(elem->attrs, key);
-
-    if (!entry || !entry->val) {
+    void *attr;
+    if (!pcutils_sorted_array_find(elem->attrs, key, &attr) || !attr) {
         pcinst_set_error(PURC_ERROR_NOT_EXISTS);
         return NULL;
     }
 
-    return entry->val;
+    return attr;
 }
 
 // operation api
@@ -802,14 +810,17 @@ element_serialize(struct pcvdom_element *element, int level, int push,
     char *tag_name = element->tag_name;
 
     if (push) {
-        // key: char *, the same as struct pcvdom_attr:key
-        // val: struct pcvdom_attr*
-        struct pcutils_map *attrs = element->attrs;
+        struct sorted_array *attrs = element->attrs;
 
         ud->cb("<", 1, ud->ctxt);
         ud->cb(tag_name, strlen(tag_name), ud->ctxt);
 
-        pcutils_map_traverse(attrs, ud, attr_serialize);
+        size_t nr = pcutils_sorted_array_count(attrs);
+        for (size_t i = 0; i < nr; i++) {
+            void *attr;
+            const void *key = pcutils_sorted_array_get(attrs, i, &attr);
+            attr_serialize((void *)key, attr, ud);
+        }
 
         ud->cb(">", 1, ud->ctxt);
     }
@@ -1036,8 +1047,6 @@ document_set_doctype(struct pcvdom_document *doc,
 static void
 element_reset(struct pcvdom_element *elem)
 {
-    int r;
-
     if (elem->tag_id==VTT(_UNDEF) && elem->tag_name) {
         free(elem->tag_name);
     }
@@ -1051,8 +1060,7 @@ element_reset(struct pcvdom_element *elem)
     }
 
     if (elem->attrs) {
-        r = pcutils_map_destroy(elem->attrs);
-        PC_ASSERT(r==0);
+        pcutils_sorted_array_destroy(elem->attrs);
         elem->attrs = NULL;
     }
 }
@@ -1065,24 +1073,6 @@ element_destroy(struct pcvdom_element *elem)
     free(elem);
 }
 
-static void*
-element_attr_copy_key(const void *key)
-{
-    return (void*)key;
-}
-
-static void
-element_attr_free_key(void *key)
-{
-    UNUSED_PARAM(key);
-}
-
-static void*
-element_attr_copy_val(const void *val)
-{
-    return (void*)val;
-}
-
 static int
 element_attr_comp_key(const void *key1, const void *key2)
 {
@@ -1093,8 +1083,10 @@ element_attr_comp_key(const void *key1, const void *key2)
 }
 
 static void
-element_attr_free_val(void *val)
+element_attr_free(void *key, void *val)
 {
+    UNUSED_PARAM(key);
+
     struct pcvdom_attr *attr = (struct pcvdom_attr*)val;
     attr->parent = NULL;
     attr_destroy(attr);
@@ -1115,9 +1107,8 @@ element_create(void)
 
     elem->tag_id    = VTT(_UNDEF);
 
-    elem->attrs = pcutils_map_create(element_attr_copy_key, element_attr_free_key,
-        element_attr_copy_val, element_attr_free_val,
-        element_attr_comp_key, false); // non-thread-safe
+    elem->attrs = pcutils_sorted_array_create(SAFLAG_DEFAULT, 0,
+        element_attr_free, element_attr_comp_key);
     if (!elem->attrs) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         element_destroy(elem);
@@ -1237,6 +1228,7 @@ attr_create(void)
         return NULL;
     }
 
+    attr->keyword = -1;
     return attr;
 }
 
@@ -1335,20 +1327,16 @@ pcvdom_element_is_hvml_operation(struct pcvdom_element *element)
 struct pcvdom_attr*
 pcvdom_element_find_attr(struct pcvdom_element *element, const char *key)
 {
-    struct pcutils_map *attrs = element->attrs;
+    struct sorted_array *attrs = element->attrs;
     if (!attrs)
         return NULL;
 
-    pcutils_map_entry *entry;
-    entry = pcutils_map_find(attrs, key);
-    if (!entry)
+    void *attr;
+    if (!pcutils_sorted_array_find(attrs, key, &attr))
         return NULL;
-    PC_ASSERT(entry->val);
+    PC_ASSERT(attr);
 
-    struct pcvdom_attr *attr;
-    attr = (struct pcvdom_attr*)entry->val;
-
-    return attr;
+    return (struct pcvdom_attr*)attr;
 }
 
 purc_variant_t
@@ -125,6 +125,7 @@ PURC_CHECK_HAVE_INCLUDE(HAVE_UTIME_H utime.h)
 PURC_CHECK_HAVE_INCLUDE(HAVE_LANGINFO_H langinfo.h)
 PURC_CHECK_HAVE_INCLUDE(HAVE_SYS_IOCTL_H sys/ioctl.h)
 PURC_CHECK_HAVE_INCLUDE(HAVE_SYS_SELECT_H sys/select.h)
+PURC_CHECK_HAVE_INCLUDE(HAVE_SYS_EVENTFD_H sys/eventfd.h)
 PURC_CHECK_HAVE_INCLUDE(HAVE_SYS_PARAM_H sys/param.h)
 PURC_CHECK_HAVE_INCLUDE(HAVE_MMAP sys/mman.h)
 PURC_CHECK_HAVE_INCLUDE(HAVE_PTHREAD_NP_H pthread_np.h)
@@ -25,6 +25,7 @@
 #include "config.h"
 
 #include <libgen.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -34,6 +35,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 #if OS(LINUX) || OS(UNIX)
 // get path from env or __FILE__/../<rel> otherwise
@@ -171,3 +173,76 @@ TEST(local_fetcher, async)
     purc_cleanup();
 #endif                        /* } */
 }
+
+static void write_file(const char *file, char c, size_t sz)
+{
+    FILE *fp = fopen(file, "w");
+    ASSERT_NE(fp, nullptr);
+    for (size_t i = 0; i < sz; i++) {
+        fputc(c, fp);
+    }
+    fclose(fp);
+}
+
+static void check_response(const char *url, char c, size_t sz)
+{
+    struct pcfetcher_resp_header resp_header = {};
+    purc_rwstream_t resp = pcfetcher_request_sync(url,
+            PCFETCHER_REQUEST_METHOD_GET, NULL, 10, &resp_header);
+    ASSERT_NE(resp, nullptr);
+    ASSERT_EQ(resp_header.ret_code, 200);
+    ASSERT_EQ(resp_header.sz_resp, sz);
+
+    char *buf = (char *)malloc(sz + 1);
+    ASSERT_EQ(purc_rwstream_read(resp, buf, sz + 1), (ssize_t)sz);
+    for (size_t i = 0; i < sz; i++) {
+        ASSERT_EQ(buf[i], c);
+    }
+    free(buf);
+
+    /* the cached content is read-only */
+    ASSERT_EQ(purc_rwstream_write(resp, "x", 1), -1);
+
+    purc_rwstream_destroy(resp);
+    free(resp_header.mime_type);
+}
+
+TEST(local_fetcher, cache)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.sample",
+            "pcfetcher", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    char file[] = "/tmp/purc-test-local-fetcher-XXXXXX";
+    int fd = mkstemp(file);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    char url[PATH_MAX + 8];
+    snprintf(url, sizeof(url), "file://%s", file);
+
+    /* the second response comes from the cache */
+    write_file(file, 'a', 100);
+    check_response(url, 'a', 100);
+    check_response(url, 'a', 100);
+
+    /* the changed file is loaded again */
+    write_file(file, 'b', 200);
+    check_response(url, 'b', 200);
+
+    /* a large file is mapped into memory */
+    write_file(file, 'c', 1024 * 1024);
+    check_response(url, 'c', 1024 * 1024);
+    check_response(url, 'c', 1024 * 1024);
+
+    unlink(file);
+
+    struct pcfetcher_resp_header resp_header = {};
+    purc_rwstream_t resp = pcfetcher_request_sync(url,
+            PCFETCHER_REQUEST_METHOD_GET, NULL, 10, &resp_header);
+    ASSERT_EQ(resp, nullptr);
+    ASSERT_EQ(resp_header.ret_code, 404);
+
+    purc_cleanup();
+}
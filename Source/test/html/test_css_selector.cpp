@@ -0,0 +1,377 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Checks the CSS selector engine of the HTML document, and the id/class
+ * indexes are kept in sync with the changes of the document.
+ *
+ * Also compares the lookups by the id index and by walking the tree.
+ * Use env NR_ELEMENTS to change the number of the elements, e.g.:
+ *
+ *  NR_ELEMENTS=1000000 ./test_css_selector
+ */
+
+#include "purc.h"
+#include "private/document.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gtest/gtest.h>
+#include <string>
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_nr_elements(void)
+{
+    const char *env = getenv("NR_ELEMENTS");
+    size_t nr = env ? (size_t)atoll(env) : 0;
+    return nr ? nr : 20000;
+}
+
+static std::string elem_name(purc_document_t doc, pcdoc_element_t elem)
+{
+    const char *id;
+    size_t len;
+    id = pcdoc_element_id(doc, elem, &len);
+    return id ? std::string(id, len) : std::string("?");
+}
+
+/* selects the elements; returns their ids separated by spaces,
+   or `!` for a bad selector */
+static std::string
+select(purc_document_t doc, const char *selector)
+{
+    pcdoc_elem_coll_t coll;
+    coll = pcdoc_elem_coll_new_from_document(doc, selector);
+    if (coll == NULL)
+        return "!";
+
+    std::string ids;
+    for (size_t i = 0; i < pcutils_arrlist_length(coll->elems); i++) {
+        pcdoc_element_t elem;
+        elem = (pcdoc_element_t)pcutils_arrlist_get_idx(coll->elems, i);
+        if (i > 0)
+            ids += ' ';
+        ids += elem_name(doc, elem);
+    }
+
+    pcdoc_elem_coll_delete(doc, coll);
+    return ids;
+}
+
+static const char *html =
+    "<html id='h'><head id='hd'></head>"
+    "<body id='b' class='page'>"
+    "<div id='d1' class='box main' lang='en-US'>"
+    "  <p id='p1' class='text'>one</p>"
+    "  <p id='p2' class='text note' title='hello world'>two</p>"
+    "  <span id='s1' data-x='abc'>three</span>"
+    "</div>"
+    "<div id='d2' class='box'>"
+    "  <section id='sec'><p id='p3' class='Text'>four</p></section>"
+    "  <p id='p4' class='text'>five</p>"
+    "</div>"
+    "</body></html>";
+
+TEST(css_selector, selectors)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hvml.test",
+            "css_selector", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML, html, 0);
+    ASSERT_NE(doc, nullptr);
+
+    static const struct {
+        const char *selector;
+        const char *ids;
+    } cases[] = {
+        { "#p2", "p2" },
+        { "#none", "" },
+        { ".text", "p1 p2 p4" },
+        { ".Text", "p3" },
+        { ".box.main", "d1" },
+        { "p", "p1 p2 p3 p4" },
+        { "P.text", "p1 p2 p4" },
+        { "div p", "p1 p2 p3 p4" },
+        { "div > p", "p1 p2 p4" },
+        { "body > * > p", "p1 p2 p4" },
+        { "section p, #s1", "s1 p3" },
+        { "#s1, section p", "s1 p3" },
+        { ".note, .text", "p1 p2 p4" },
+        { "p + p", "p2" },
+        { "p ~ span", "s1" },
+        { "section + p", "p4" },
+        { "#d1 ~ div .text", "p4" },
+        { "[data-x]", "s1" },
+        { "[data-x=abc]", "s1" },
+        { "[data-x='ab']", "" },
+        { "[title~=world]", "p2" },
+        { "[lang|=en]", "d1" },
+        { "[data-x^=a]", "s1" },
+        { "[data-x$=bc]", "s1" },
+        { "[data-x*=b]", "s1" },
+        { "[data-x=ABC i]", "s1" },
+        { "[ID=p1]", "p1" },
+        { "div[class~=main] span", "s1" },
+        { "*", "h hd b d1 p1 p2 s1 d2 sec p3 p4" },
+        { "", "!" },
+        { "p,", "!" },
+        { "p:first-child", "!" },
+        { "[data-x", "!" },
+        { "> p", "!" },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        ASSERT_EQ(select(doc, cases[i].selector), cases[i].ids)
+            << cases[i].selector;
+    }
+
+    pcdoc_element_t elem;
+    elem = pcdoc_find_element_in_document(doc, ".box .text");
+    ASSERT_NE(elem, nullptr);
+    ASSERT_EQ(elem_name(doc, elem), "p1");
+
+    /* the scope and the filter */
+    pcdoc_element_t d2 = pcdoc_find_element_in_document(doc, "#d2");
+    ASSERT_NE(d2, nullptr);
+    elem = pcdoc_find_element_in_descendants(doc, d2, ".text");
+    ASSERT_EQ(elem_name(doc, elem), "p4");
+    ASSERT_EQ(pcdoc_find_element_in_descendants(doc, d2, "#p1"), nullptr);
+
+    pcdoc_elem_coll_t all = pcdoc_elem_coll_new_from_document(doc, "p");
+    pcdoc_elem_coll_t some = pcdoc_elem_coll_select(doc, all, "div > p");
+    ASSERT_NE(some, nullptr);
+    ASSERT_EQ(pcutils_arrlist_length(some->elems), 3u);
+    pcdoc_elem_coll_delete(doc, some);
+    pcdoc_elem_coll_delete(doc, all);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(css_selector, escapes)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hvml.test",
+            "css_selector", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* an id of many digits, which can only be selected by escapes */
+    std::string digits;
+    for (int i = 0; i < 64; i++)
+        digits += (char)('0' + i % 10);
+
+    std::string content = "<html><body>"
+        "<p id='123456' class='1st'></p>"
+        "<p id='" + digits + "'></p>"
+        "<p id='a b'></p>"
+        "</body></html>";
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            content.c_str(), content.length());
+    ASSERT_NE(doc, nullptr);
+
+    static const struct {
+        const char *selector;
+        const char *ids;
+    } cases[] = {
+        { "#\\31 \\32 \\33 \\34 \\35 \\36", "123456" },
+        { "#\\31\\32\\33\\34\\35\\36", "123456" },
+        { "#\\31 23456", "123456" },
+        { "#\\00003123456", "123456" },
+        { "#\\31 \\32 3\\34 56", "123456" },
+        { ".\\31 st", "123456" },
+        { "#a\\ b", "a b" },
+        { "[id=\\31 23456]", "123456" },
+        { "#\\31 \\32 \\33 \\34 \\35 \\36 p", "" },
+        { "#\\", "!" },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        ASSERT_EQ(select(doc, cases[i].selector), cases[i].ids)
+            << cases[i].selector;
+    }
+
+    /* a chain of hexadecimal escapes, each ended by a whitespace */
+    std::string selector = "#";
+    for (char c : digits) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\%x ", (unsigned)c);
+        selector += buf;
+    }
+    ASSERT_EQ(select(doc, selector.c_str()), digits);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(css_selector, index_sync)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hvml.test",
+            "css_selector", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML, html, 0);
+    ASSERT_NE(doc, nullptr);
+
+    /* build the indexes */
+    ASSERT_EQ(select(doc, "#p1"), "p1");
+
+    /* change the id and the class */
+    pcdoc_element_t elem = pcdoc_find_element_in_document(doc, "#p1");
+    pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE, "id", "q1", 0);
+    pcdoc_element_set_attribute(doc, elem, PCDOC_OP_DISPLACE,
+            "class", "text hot", 0);
+    ASSERT_EQ(select(doc, "#p1"), "");
+    ASSERT_EQ(select(doc, "#q1"), "q1");
+    ASSERT_EQ(select(doc, ".hot"), "q1");
+
+    pcdoc_element_set_attribute(doc, elem, PCDOC_OP_ERASE, "class", NULL, 0);
+    ASSERT_EQ(select(doc, ".hot"), "");
+    ASSERT_EQ(select(doc, ".text"), "p2 p4");
+
+    /* new contents */
+    pcdoc_element_t d2 = pcdoc_find_element_in_document(doc, "#d2");
+    pcdoc_element_new_content(doc, d2, PCDOC_OP_APPEND,
+            "<p id='n1' class='text'>new<b id='n2' class='hot'></b></p>", 0);
+    ASSERT_EQ(select(doc, ".hot"), "n2");
+    ASSERT_EQ(select(doc, ".text"), "p2 p4 n1");
+    ASSERT_EQ(select(doc, "#d2 > .text"), "p4 n1");
+
+    pcdoc_element_new_content(doc, d2, PCDOC_OP_PREPEND,
+            "<i id='n3' class='hot'></i>", 0);
+    ASSERT_EQ(select(doc, ".hot"), "n3 n2");
+
+    /* erase, clear, and displace */
+    pcdoc_element_erase(doc, pcdoc_find_element_in_document(doc, "#n1"));
+    ASSERT_EQ(select(doc, "#n2"), "");
+    ASSERT_EQ(select(doc, ".hot"), "n3");
+
+    pcdoc_element_clear(doc, d2);
+    ASSERT_EQ(select(doc, ".hot, #p3, #p4"), "");
+    ASSERT_EQ(select(doc, ".box"), "d1 d2");
+
+    pcdoc_element_t d1 = pcdoc_find_element_in_document(doc, "#d1");
+    pcdoc_element_new_content(doc, d1, PCDOC_OP_DISPLACE,
+            "<em id='e1' class='text'></em>", 0);
+    ASSERT_EQ(select(doc, ".text"), "e1");
+    ASSERT_EQ(select(doc, "#q1, #p2, #s1"), "");
+
+    pcdoc_element_t e2 = pcdoc_element_new_element(doc, d1,
+            PCDOC_OP_APPEND, "em", false);
+    pcdoc_element_set_attribute(doc, e2, PCDOC_OP_DISPLACE, "id", "e2", 0);
+    pcdoc_element_set_attribute(doc, e2, PCDOC_OP_DISPLACE,
+            "class", "text", 0);
+    ASSERT_EQ(select(doc, ".text"), "e1 e2");
+    ASSERT_EQ(select(doc, "#d1 > #e2"), "e2");
+
+    /* displace with a text content */
+    pcdoc_element_new_text_content(doc, d1, PCDOC_OP_DISPLACE, "text", 0);
+    ASSERT_EQ(select(doc, ".text, #e1, #e2"), "");
+    ASSERT_EQ(select(doc, ".box"), "d1 d2");
+
+    e2 = pcdoc_element_new_element(doc, d1, PCDOC_OP_APPEND, "em", false);
+    pcdoc_element_set_attribute(doc, e2, PCDOC_OP_DISPLACE, "id", "e2", 0);
+    pcdoc_element_set_attribute(doc, e2, PCDOC_OP_DISPLACE,
+            "class", "text", 0);
+
+    /* same as walking the tree */
+    ASSERT_EQ(select(doc, ".text"), select(doc, "[class~=text]"));
+    ASSERT_EQ(select(doc, "#e2"), select(doc, "[id=e2]"));
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(css_selector, lookup_by_id)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hvml.test",
+            "css_selector", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    size_t nr = get_nr_elements();
+    std::string content = "<html><body>";
+    for (size_t i = 0; i < nr; i++) {
+        char buf[128];
+        snprintf(buf, sizeof(buf),
+                "<div class='row r%zu'><span id='e%zu'>%zu</span></div>",
+                i % 10, i, i);
+        content += buf;
+    }
+    content += "</body></html>";
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            content.c_str(), content.length());
+    ASSERT_NE(doc, nullptr);
+
+    const size_t nr_lookups = 100;
+    struct timespec ts;
+
+    /* the indexes are built on the first query */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ASSERT_NE(pcdoc_find_element_in_document(doc, "#e0"), nullptr);
+    fprintf(stderr, "indexes built in %.3f ms\n", elapsed_ms(&ts));
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_lookups; i++) {
+        char selector[64];
+        size_t n = (i * 7919) % nr;
+        snprintf(selector, sizeof(selector), "#e%zu", n);
+        pcdoc_element_t elem = pcdoc_find_element_in_document(doc, selector);
+        ASSERT_NE(elem, nullptr);
+        ASSERT_EQ(elem_name(doc, elem), selector + 1);
+    }
+    double index_ms = elapsed_ms(&ts);
+
+    /* the attribute selector can not use the indexes */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_lookups; i++) {
+        char selector[64];
+        size_t n = (i * 7919) % nr;
+        snprintf(selector, sizeof(selector), "[id=e%zu]", n);
+        pcdoc_element_t elem = pcdoc_find_element_in_document(doc, selector);
+        ASSERT_NE(elem, nullptr);
+    }
+    double walk_ms = elapsed_ms(&ts);
+
+    fprintf(stderr, "%zu lookups in %zu elements: %.3f ms by the index; "
+            "%.3f ms by walking the tree\n",
+            nr_lookups, nr * 2, index_ms, walk_ms);
+    ASSERT_LT(index_ms * 10, walk_ms);
+
+    /* the classes with many elements fall back to walking the tree */
+    pcdoc_elem_coll_t coll = pcdoc_elem_coll_new_from_document(doc, ".r3");
+    ASSERT_NE(coll, nullptr);
+    ASSERT_EQ(pcutils_arrlist_length(coll->elems), (nr + 6) / 10);
+    pcdoc_elem_coll_delete(doc, coll);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
@@ -0,0 +1,251 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Checks the children of the elements got by index (which are cached)
+ * and by the sibling cursor agree after the changes of the document.
+ *
+ * Also iterates over the rows of a large table by both ways. Use env
+ * NR_ROWS to change the number of the rows, e.g.:
+ *
+ *  NR_ROWS=1000000 ./test_doc_children
+ */
+
+#include "purc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gtest/gtest.h>
+#include <string>
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_nr_rows(void)
+{
+    const char *env = getenv("NR_ROWS");
+    size_t nr = env ? (size_t)atoll(env) : 0;
+    return nr ? nr : 20000;
+}
+
+static std::string node_name(purc_document_t doc, pcdoc_node node)
+{
+    if (node.type == PCDOC_NODE_ELEMENT) {
+        const char *id;
+        size_t len;
+        id = pcdoc_element_id(doc, node.elem, &len);
+        return id ? std::string(id, len) : std::string("?");
+    }
+    else if (node.type == PCDOC_NODE_TEXT) {
+        const char *text;
+        size_t len;
+        pcdoc_text_content_get_text(doc, node.text_node, &text, &len);
+        return "'" + std::string(text, len) + "'";
+    }
+
+    return "-";
+}
+
+/* lists the children by index */
+static std::string children_by_index(purc_document_t doc,
+        pcdoc_element_t elem)
+{
+    size_t nr_elems, nr_texts;
+    pcdoc_element_children_count(doc, elem, &nr_elems, &nr_texts, NULL);
+
+    std::string names;
+    for (size_t i = 0; i < nr_elems; i++) {
+        pcdoc_node node;
+        node.type = PCDOC_NODE_ELEMENT;
+        node.elem = pcdoc_element_get_child_element(doc, elem, i);
+        names += node_name(doc, node) + " ";
+    }
+    names += "|";
+    for (size_t i = 0; i < nr_texts; i++) {
+        pcdoc_node node;
+        node.type = PCDOC_NODE_TEXT;
+        node.text_node = pcdoc_element_get_child_text_node(doc, elem, i);
+        names += " " + node_name(doc, node);
+    }
+
+    /* out of the range */
+    if (pcdoc_element_get_child_element(doc, elem, nr_elems) ||
+            pcdoc_element_get_child_text_node(doc, elem, nr_texts))
+        names += " !";
+
+    return names;
+}
+
+/* lists the children by the cursor */
+static std::string children_by_cursor(purc_document_t doc,
+        pcdoc_element_t elem)
+{
+    std::string names;
+    pcdoc_node node;
+
+    node = pcdoc_element_first_child(doc, elem, PCDOC_NODE_ELEMENT);
+    while (node.type != PCDOC_NODE_VOID) {
+        names += node_name(doc, node) + " ";
+        node = pcdoc_node_next_sibling(doc, node, PCDOC_NODE_ELEMENT);
+    }
+    names += "|";
+
+    node = pcdoc_element_first_child(doc, elem, PCDOC_NODE_TEXT);
+    while (node.type != PCDOC_NODE_VOID) {
+        names += " " + node_name(doc, node);
+        node = pcdoc_node_next_sibling(doc, node, PCDOC_NODE_TEXT);
+    }
+
+    return names;
+}
+
+TEST(doc_children, changes)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hvml.test",
+            "doc_children", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const char *html = "<html><body id='b'>"
+        "<ul id='l'><li id='a'>A</li>x<!-- c --><li id='b2'>B</li>y</ul>"
+        "</body></html>";
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML, html, 0);
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_t body = purc_document_body(doc);
+    pcdoc_element_t ul = pcdoc_element_get_child_element(doc, body, 0);
+    ASSERT_NE(ul, nullptr);
+
+    std::string expected = "a b2 | 'x' 'y'";
+    ASSERT_EQ(children_by_index(doc, ul), expected);
+    ASSERT_EQ(children_by_cursor(doc, ul), expected);
+
+    pcdoc_element_t a = pcdoc_element_get_child_element(doc, ul, 0);
+    pcdoc_element_t b2 = pcdoc_element_get_child_element(doc, ul, 1);
+
+    /* append, prepend, and insert */
+    pcdoc_element_t e;
+    e = pcdoc_element_new_element(doc, ul, PCDOC_OP_APPEND, "li", false);
+    pcdoc_element_set_attribute(doc, e, PCDOC_OP_DISPLACE, "id", "c", 0);
+    e = pcdoc_element_new_element(doc, ul, PCDOC_OP_PREPEND, "li", false);
+    pcdoc_element_set_attribute(doc, e, PCDOC_OP_DISPLACE, "id", "z", 0);
+    e = pcdoc_element_new_element(doc, b2, PCDOC_OP_INSERTBEFORE, "li", false);
+    pcdoc_element_set_attribute(doc, e, PCDOC_OP_DISPLACE, "id", "m", 0);
+    pcdoc_element_new_text_content(doc, a, PCDOC_OP_INSERTAFTER, "t", 0);
+    pcdoc_element_new_content(doc, ul, PCDOC_OP_APPEND,
+            "<li id='d'></li>w", 0);
+
+    expected = "z a m b2 c d | 't' 'x' 'y' 'w'";
+    ASSERT_EQ(children_by_index(doc, ul), expected);
+    ASSERT_EQ(children_by_cursor(doc, ul), expected);
+
+    /* the cache of a child element */
+    pcdoc_element_new_text_content(doc, b2, PCDOC_OP_APPEND, "B2", 0);
+    ASSERT_EQ(children_by_index(doc, b2), "| 'B' 'B2'");
+
+    /* erase and clear */
+    pcdoc_element_erase(doc, b2);
+    pcdoc_element_erase(doc, pcdoc_element_get_child_element(doc, ul, 0));
+    expected = "a m c d | 't' 'x' 'y' 'w'";
+    ASSERT_EQ(children_by_index(doc, ul), expected);
+    ASSERT_EQ(children_by_cursor(doc, ul), expected);
+
+    ASSERT_EQ(children_by_index(doc, a), "| 'A'");
+    pcdoc_element_clear(doc, a);
+    ASSERT_EQ(children_by_index(doc, a), "|");
+    ASSERT_EQ(children_by_cursor(doc, a), "|");
+
+    /* displace */
+    pcdoc_element_new_text_content(doc, ul, PCDOC_OP_DISPLACE, "only", 0);
+    ASSERT_EQ(children_by_index(doc, ul), "| 'only'");
+    pcdoc_element_new_content(doc, ul, PCDOC_OP_DISPLACE,
+            "<li id='n'>N</li>", 0);
+    ASSERT_EQ(children_by_index(doc, ul), "n |");
+    e = pcdoc_element_new_element(doc, ul, PCDOC_OP_DISPLACE, "li", false);
+    pcdoc_element_set_attribute(doc, e, PCDOC_OP_DISPLACE, "id", "o", 0);
+    ASSERT_EQ(children_by_index(doc, ul), "o |");
+    ASSERT_EQ(children_by_cursor(doc, ul), "o |");
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
+
+TEST(doc_children, large_table)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HTML, "cn.fmsoft.hvml.test",
+            "doc_children", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    size_t nr = get_nr_rows();
+    std::string html = "<html><body><table><tbody>";
+    for (size_t i = 0; i < nr; i++) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "<tr><td>%zu</td></tr>\n", i);
+        html += buf;
+    }
+    html += "</tbody></table></body></html>";
+
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html.c_str(), html.length());
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_element_t tbody = pcdoc_find_element_in_document(doc, "tbody");
+    ASSERT_NE(tbody, nullptr);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    size_t nr_rows;
+    pcdoc_element_children_count(doc, tbody, &nr_rows, NULL, NULL);
+    ASSERT_EQ(nr_rows, nr);
+    for (size_t i = 0; i < nr_rows; i++) {
+        pcdoc_element_t tr = pcdoc_element_get_child_element(doc, tbody, i);
+        ASSERT_NE(tr, nullptr);
+    }
+    double index_ms = elapsed_ms(&ts);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    size_t n = 0;
+    pcdoc_node node;
+    node = pcdoc_element_first_child(doc, tbody, PCDOC_NODE_ELEMENT);
+    while (node.type != PCDOC_NODE_VOID) {
+        ASSERT_EQ(node.elem, pcdoc_element_get_child_element(doc, tbody, n));
+        n++;
+        node = pcdoc_node_next_sibling(doc, node, PCDOC_NODE_ELEMENT);
+    }
+    double cursor_ms = elapsed_ms(&ts);
+    ASSERT_EQ(n, nr);
+
+    fprintf(stderr, "%zu rows iterated: %.3f ms by index; "
+            "%.3f ms by the cursor (with the checks by index)\n",
+            nr, index_ms, cursor_ms);
+
+    /* linear, not quadratic */
+    ASSERT_LT(index_ms, cursor_ms * 10 + 10);
+
+    purc_document_delete(doc);
+    purc_cleanup();
+}
@@ -0,0 +1,223 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Measures the tokenizer reader with large eJSON and HVML documents,
+ * and checks that reading a memory-backed stream in place gives the same
+ * result as reading a stream which returns the bytes in small pieces.
+ *
+ * Use env LOOPS to repeat the parsing, and env SIZE (in KB) to change
+ * the size of the generated documents, e.g.:
+ *
+ *  LOOPS=20 SIZE=4096 ./test_tkz_perf
+ */
+
+#include "purc.h"
+
+#include "private/hvml.h"
+#include "private/utils.h"
+#include "purc-rwstream.h"
+#include "hvml/hvml-token.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+struct piece_reader {
+    const string *src;
+    size_t pos;
+    size_t piece;
+};
+
+static ssize_t read_piece(void *ctxt, void *buf, size_t count)
+{
+    struct piece_reader *rd = (struct piece_reader *)ctxt;
+    size_t left = rd->src->size() - rd->pos;
+    if (count > rd->piece)
+        count = rd->piece;
+    if (count > left)
+        count = left;
+    memcpy(buf, rd->src->data() + rd->pos, count);
+    rd->pos += count;
+    return count;
+}
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_env_size(const char *name, size_t def)
+{
+    const char *env = getenv(name);
+    size_t sz = env ? (size_t)atoll(env) : 0;
+    return sz ? sz : def;
+}
+
+static string make_ejson(size_t sz)
+{
+    string json = "[";
+    for (size_t i = 0; json.size() < sz; i++) {
+        char item[256];
+        snprintf(item, sizeof(item),
+                "%s{\"id\": %zu, \"name\": \"item-%zu 名称\", "
+                "\"price\": %zu.25, \"tags\": [\"a\", \"b\", true, null], "
+                "\"desc\": \"line\\nwith \\\"escapes\\\" and ümlauts\"}",
+                i ? ", " : "", i, i, i);
+        json += item;
+    }
+    json += "]";
+    return json;
+}
+
+static string make_hvml(size_t sz)
+{
+    string hvml = "<!DOCTYPE hvml>\n<hvml target=\"html\">\n<body>\n";
+    for (size_t i = 0; hvml.size() < sz; i++) {
+        char item[256];
+        snprintf(item, sizeof(item),
+                "  <div id=\"item-%zu\" class=\"item\">条目 %zu: "
+                "<span>$DATA.type($x)</span></div>\n"
+                "  <init as=\"v%zu\" with=\"[1, 2, {\\\"k\\\": %zu}]\" />\n",
+                i, i, i, i);
+        hvml += item;
+    }
+    hvml += "</body>\n</hvml>\n";
+    return hvml;
+}
+
+static size_t count_hvml_tokens(purc_rwstream_t rws)
+{
+    struct pchvml_parser *parser = pchvml_create(0, 32);
+    size_t nr_tokens = 0;
+    struct pchvml_token *token;
+    while ((token = pchvml_next_token(parser, rws)) != NULL) {
+        enum pchvml_token_type type = pchvml_token_get_type(token);
+        pchvml_token_destroy(token);
+        nr_tokens++;
+        if (type == PCHVML_TOKEN_EOF)
+            break;
+    }
+    pchvml_destroy(parser);
+    return nr_tokens;
+}
+
+TEST(tkz_perf, ejson)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "tkz_perf", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    size_t nr_loops = get_env_size("LOOPS", 1);
+    string json = make_ejson(get_env_size("SIZE", 256) * 1024);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_variant_t in_place = PURC_VARIANT_INVALID;
+    for (size_t i = 0; i < nr_loops; i++) {
+        if (in_place)
+            purc_variant_unref(in_place);
+        in_place = purc_variant_make_from_json_string(json.c_str(),
+                json.size());
+        ASSERT_NE(in_place, nullptr);
+    }
+    fprintf(stderr, "eJSON %zu bytes x %zu from memory: %.2f ms\n",
+            json.size(), nr_loops, elapsed_ms(&ts));
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_variant_t pieces = PURC_VARIANT_INVALID;
+    for (size_t i = 0; i < nr_loops; i++) {
+        struct piece_reader rd = { &json, 0, 4093 };
+        purc_rwstream_t rws = purc_rwstream_new_for_read(&rd, read_piece);
+        if (pieces)
+            purc_variant_unref(pieces);
+        pieces = purc_variant_load_from_json_stream(rws);
+        purc_rwstream_destroy(rws);
+        ASSERT_NE(pieces, nullptr);
+    }
+    fprintf(stderr, "eJSON %zu bytes x %zu from stream: %.2f ms\n",
+            json.size(), nr_loops, elapsed_ms(&ts));
+
+    ASSERT_TRUE(purc_variant_is_equal_to(in_place, pieces));
+
+    /* split the multi-byte characters across the reads */
+    struct piece_reader rd = { &json, 0, 7 };
+    purc_rwstream_t rws = purc_rwstream_new_for_read(&rd, read_piece);
+    purc_variant_t small = purc_variant_load_from_json_stream(rws);
+    purc_rwstream_destroy(rws);
+    ASSERT_NE(small, nullptr);
+    ASSERT_TRUE(purc_variant_is_equal_to(in_place, small));
+
+    purc_variant_unref(small);
+    purc_variant_unref(pieces);
+    purc_variant_unref(in_place);
+    purc_cleanup();
+}
+
+TEST(tkz_perf, hvml)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hybridos.test",
+            "tkz_perf", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    size_t nr_loops = get_env_size("LOOPS", 1);
+    string hvml = make_hvml(get_env_size("SIZE", 256) * 1024);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    size_t nr_in_place = 0;
+    for (size_t i = 0; i < nr_loops; i++) {
+        purc_rwstream_t rws = purc_rwstream_new_from_mem(
+                (void *)hvml.c_str(), hvml.size());
+        nr_in_place = count_hvml_tokens(rws);
+        purc_rwstream_destroy(rws);
+    }
+    fprintf(stderr, "HVML %zu bytes x %zu from memory: %.2f ms\n",
+            hvml.size(), nr_loops, elapsed_ms(&ts));
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    size_t nr_pieces = 0;
+    for (size_t i = 0; i < nr_loops; i++) {
+        struct piece_reader rd = { &hvml, 0, 4093 };
+        purc_rwstream_t rws = purc_rwstream_new_for_read(&rd, read_piece);
+        nr_pieces = count_hvml_tokens(rws);
+        purc_rwstream_destroy(rws);
+    }
+    fprintf(stderr, "HVML %zu bytes x %zu from stream: %.2f ms\n",
+            hvml.size(), nr_loops, elapsed_ms(&ts));
+
+    ASSERT_GT(nr_in_place, 1UL);
+    ASSERT_EQ(nr_in_place, nr_pieces);
+
+    struct piece_reader rd = { &hvml, 0, 7 };
+    purc_rwstream_t rws = purc_rwstream_new_for_read(&rd, read_piece);
+    ASSERT_EQ(count_hvml_tokens(rws), nr_in_place);
+    purc_rwstream_destroy(rws);
+
+    purc_cleanup();
+}
@@ -0,0 +1,193 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Measures the round-trip latency of the messages moved between two
+ * instances: the peer instance takes the pings either by the timed blocking
+ * take (purc_inst_take_away_message_timed()) or by polling the move buffer
+ * every millisecond. Use env NR_ROUNDS to change the number of the rounds,
+ * e.g.:
+ *
+ *  NR_ROUNDS=10000 ./test_pingpong
+ */
+
+#include "purc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+static volatile purc_atom_t main_inst;
+static volatile purc_atom_t peer_inst;
+
+static size_t get_nr_rounds(void)
+{
+    const char *env = getenv("NR_ROUNDS");
+    size_t nr = env ? (size_t)atoll(env) : 0;
+    return nr ? nr : 1000;
+}
+
+static pcrdr_msg *make_event(const char *name)
+{
+    return pcrdr_make_event_message(
+            PCRDR_MSG_TARGET_INSTANCE, 1,
+            name, NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+}
+
+static pcrdr_msg *take_by_polling(void)
+{
+    size_t n = 0;
+    while (purc_inst_holding_messages_count(&n) == 0 && n == 0)
+        usleep(1000);
+
+    return purc_inst_take_away_message(0);
+}
+
+static void *peer_entry(void *arg)
+{
+    bool polling = (arg != NULL);
+
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+            polling ? "pong_polling" : "pong_timed", NULL);
+    if (ret != PURC_ERROR_OK)
+        return NULL;
+
+    peer_inst = purc_inst_create_move_buffer(PCINST_MOVE_BUFFER_FLAG_NONE, 16);
+
+    for (;;) {
+        pcrdr_msg *msg = polling ? take_by_polling() :
+            purc_inst_take_away_message_timed(0, -1);
+        if (msg == NULL)
+            break;
+
+        bool quit = strcmp(purc_variant_get_string_const(msg->eventName),
+                "quit") == 0;
+        pcrdr_release_message(msg);
+        if (quit)
+            break;
+
+        pcrdr_msg *pong = make_event("pong");
+        if (purc_inst_move_message(main_inst, pong) == 0)
+            pcrdr_release_message(pong);
+    }
+
+    purc_inst_destroy_move_buffer();
+    purc_cleanup();
+    return NULL;
+}
+
+/* returns the average round-trip time in microseconds */
+static double ping_pong(bool polling, size_t nr_rounds)
+{
+    pthread_t th;
+
+    peer_inst = 0;
+    if (pthread_create(&th, NULL, peer_entry, polling ? (void *)1 : NULL))
+        return -1;
+
+    while (peer_inst == 0)
+        usleep(1000);
+
+    struct timespec ts_start;
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    size_t nr_pongs = 0;
+    for (size_t i = 0; i < nr_rounds; i++) {
+        pcrdr_msg *ping = make_event("ping");
+        if (purc_inst_move_message(peer_inst, ping) == 0)
+            pcrdr_release_message(ping);
+
+        pcrdr_msg *pong = purc_inst_take_away_message_timed(0, 1000);
+        if (pong == NULL)
+            break;
+
+        pcrdr_release_message(pong);
+        nr_pongs++;
+    }
+
+    double elapsed = purc_get_elapsed_seconds(&ts_start, NULL);
+
+    pcrdr_msg *quit = make_event("quit");
+    if (purc_inst_move_message(peer_inst, quit) == 0)
+        pcrdr_release_message(quit);
+    pthread_join(th, NULL);
+
+    if (nr_pongs != nr_rounds)
+        return -1;
+
+    return elapsed * 1000000 / nr_rounds;
+}
+
+TEST(move_buffer, timed_take)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+            "timed_take", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    main_inst = purc_inst_create_move_buffer(PCINST_MOVE_BUFFER_FLAG_NONE, 16);
+    ASSERT_NE(main_inst, 0);
+
+    /* times out with no message */
+    struct timespec ts_start;
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    pcrdr_msg *msg = purc_inst_take_away_message_timed(0, 50);
+    ASSERT_EQ(msg, nullptr);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_TIMEOUT);
+    ASSERT_GE(purc_get_elapsed_seconds(&ts_start, NULL), 0.045);
+
+    /* returns at once if the message is there */
+    msg = make_event("self");
+    ASSERT_EQ(purc_inst_move_message(main_inst, msg), 1u);
+    msg = purc_inst_take_away_message_timed(0, 0);
+    ASSERT_NE(msg, nullptr);
+    pcrdr_release_message(msg);
+
+    purc_inst_destroy_move_buffer();
+    purc_cleanup();
+}
+
+TEST(move_buffer, ping_pong)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+            "ping_pong", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    main_inst = purc_inst_create_move_buffer(PCINST_MOVE_BUFFER_FLAG_NONE, 16);
+    ASSERT_NE(main_inst, 0);
+
+    size_t nr_rounds = get_nr_rounds();
+    double timed_us = ping_pong(false, nr_rounds);
+    ASSERT_GT(timed_us, 0);
+
+    /* polling is much slower; do not wait too long */
+    double polling_us = ping_pong(true, nr_rounds / 10 + 1);
+    ASSERT_GT(polling_us, 0);
+
+    fprintf(stderr, "average round trip: %.2f us with the timed take; "
+            "%.2f us with polling\n", timed_us, polling_us);
+
+    purc_inst_destroy_move_buffer();
+    purc_cleanup();
+}
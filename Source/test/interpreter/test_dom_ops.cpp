@@ -0,0 +1,321 @@
+/*
+ * @file test_dom_ops.cpp
+ * @date 2022/10/24
+ * @brief The benchmark of sending DOM operations to the headless renderer
+ *      in batch, and the test of failing to send them.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#undef NDEBUG
+
+#include "purc.h"
+#include "pcrdr/connect.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <gtest/gtest.h>
+
+#define NR_CELLS            500
+#define LOG_FILE            "/tmp/purc-test-dom-ops.log"
+
+using namespace std;
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+/* The updates are made when observing the idle event, i.e., after the
+   document was loaded by the renderer. If `same_cell` is true, all updates
+   change the text content of the first cell. */
+static string
+make_hvml(size_t nr_cells, bool same_cell)
+{
+    string hvml =
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"html\">"
+        "  <body>"
+        "    <table><tr>";
+
+    for (size_t i = 0; i < nr_cells; i++) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "<td id=\"c%zu\">0</td>", i);
+        hvml += buf;
+    }
+
+    char buf[1024];
+    snprintf(buf, sizeof(buf),
+        "    </tr></table>"
+        "    <observe on=\"$CRTN\" for=\"idle\">"
+        "      <iterate on 0 onlyif $L.lt($0<, %zu) "
+        "          with $EJSON.arith('+', $0<, 1) nosetotail >"
+        "        <update on=\"%s\" at=\"textContent\" "
+        "            with=\"$EJSON.stringify($?)\" />"
+        "      </iterate>"
+        "      <forget on=\"$CRTN\" for=\"idle\" />"
+        "    </observe>"
+        "  </body>"
+        "</hvml>", nr_cells, same_cell ? "#c0" : "#c$?");
+    hvml += buf;
+    return hvml;
+}
+
+/* returns the number of the requests sent to the renderer */
+static size_t
+count_requests(void)
+{
+    FILE *fp = fopen(LOG_FILE, "r");
+    if (fp == NULL)
+        return 0;
+
+    size_t n = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), fp)) {
+        if (strcmp(line, ">>>\n") == 0)
+            n++;
+    }
+
+    fclose(fp);
+    return n;
+}
+
+static double
+run_hvml(const char *max_dom_ops, size_t nr_cells, bool same_cell,
+        size_t *nr_requests)
+{
+    setenv("PURC_RDR_DOM_OPS", max_dom_ops, 1);
+    unlink(LOG_FILE);
+
+    purc_instance_extra_info info = {};
+    info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    info.renderer_uri = "file://" LOG_FILE;
+    info.workspace_name = "main";
+
+    int ret = purc_init_ex(PURC_MODULE_HVML | PURC_MODULE_PCRDR,
+            "cn.fmsoft.hvml.test", "dom_ops", &info);
+    if (ret != PURC_ERROR_OK)
+        return -1;
+
+    string hvml = make_hvml(nr_cells, same_cell);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml.c_str());
+    EXPECT_NE(vdom, nullptr);
+    if (vdom) {
+        purc_renderer_extra_info extra_info = {};
+        extra_info.title = "dom_ops";
+        purc_coroutine_t co = purc_schedule_vdom(vdom,
+                0, PURC_VARIANT_INVALID, PCRDR_PAGE_TYPE_PLAINWIN,
+                "main",         /* target_workspace */
+                NULL,           /* target_group */
+                "dom_ops",      /* page_name */
+                &extra_info, NULL, NULL);
+        EXPECT_NE(co, nullptr);
+        purc_run(NULL);
+    }
+    double ms = elapsed_ms(&ts);
+
+    purc_cleanup();
+    unsetenv("PURC_RDR_DOM_OPS");
+
+    *nr_requests = count_requests();
+    unlink(LOG_FILE);
+    return ms;
+}
+
+TEST(dom_ops, headless)
+{
+    static const struct {
+        const char *name;
+        bool same_cell;
+    } cases[] = {
+        { "distinct cells", false },
+        { "same cell",      true },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        size_t nr_sync, nr_batch;
+
+        /* every operation waits for the response */
+        double sync_ms = run_hvml("0", NR_CELLS, cases[i].same_cell,
+                &nr_sync);
+        /* the operations are queued and pipelined */
+        double batch_ms = run_hvml("64", NR_CELLS, cases[i].same_cell,
+                &nr_batch);
+        ASSERT_GE(sync_ms, 0);
+        ASSERT_GE(batch_ms, 0);
+
+        fprintf(stderr, "%s, %d updates: sync %8.2f ms (%zu requests), "
+                "batch %8.2f ms (%zu requests)\n", cases[i].name, NR_CELLS,
+                sync_ms, nr_sync, batch_ms, nr_batch);
+
+        /* the repeated updates of the same cell are coalesced */
+        if (cases[i].same_cell) {
+            ASSERT_LT(nr_batch, nr_sync);
+        }
+        else {
+            ASSERT_LE(nr_batch, nr_sync);
+        }
+    }
+}
+
+static int (*real_send_message)(pcrdr_conn *conn, pcrdr_msg *msg);
+static size_t nr_failed_sends;
+static uint64_t dom_error_code;
+static uint64_t nr_dropped_ops;
+
+static int
+failing_send_message(pcrdr_conn *conn, pcrdr_msg *msg)
+{
+    (void)conn;
+    (void)msg;
+    nr_failed_sends++;
+    return -1;
+}
+
+/* $RDR.fail(): fails to send the requests to the renderer from now on */
+static purc_variant_t
+fail_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    (void)root;
+    (void)nr_args;
+    (void)argv;
+    (void)silently;
+
+    pcrdr_conn *conn = purc_get_conn_to_renderer();
+    real_send_message = conn->send_message;
+    conn->send_message = failing_send_message;
+    return purc_variant_make_boolean(true);
+}
+
+/* $RDR.recover([$?]): sends the requests again, and records the data of
+   the `domError` event if given */
+static purc_variant_t
+recover_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    (void)root;
+    (void)silently;
+
+    pcrdr_conn *conn = purc_get_conn_to_renderer();
+    conn->send_message = real_send_message;
+
+    if (nr_args > 0 && purc_variant_is_object(argv[0])) {
+        purc_variant_t v;
+        v = purc_variant_object_get_by_ckey(argv[0], "retCode");
+        if (v)
+            purc_variant_cast_to_ulongint(v, &dom_error_code, false);
+        v = purc_variant_object_get_by_ckey(argv[0], "dropped");
+        if (v)
+            purc_variant_cast_to_ulongint(v, &nr_dropped_ops, false);
+    }
+    return purc_variant_make_boolean(true);
+}
+
+TEST(dom_ops, send_failure)
+{
+    setenv("PURC_RDR_DOM_OPS", "64", 1);
+    unlink(LOG_FILE);
+
+    purc_instance_extra_info info = {};
+    info.renderer_prot = PURC_RDRPROT_HEADLESS;
+    info.renderer_uri = "file://" LOG_FILE;
+    info.workspace_name = "main";
+
+    int ret = purc_init_ex(PURC_MODULE_HVML | PURC_MODULE_PCRDR,
+            "cn.fmsoft.hvml.test", "dom_ops", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    static const struct purc_dvobj_method methods[] = {
+        { "fail", fail_getter, NULL },
+        { "recover", recover_getter, NULL },
+    };
+    purc_variant_t rdr = purc_dvobj_make_from_methods(methods,
+            PCA_TABLESIZE(methods));
+    ASSERT_NE(rdr, nullptr);
+    ASSERT_TRUE(purc_bind_runner_variable("RDR", rdr));
+    purc_variant_unref(rdr);
+
+    /* the three updates are queued, then the first one fails to send
+       and the other two are dropped; give up if no `domError` event
+       comes in five seconds */
+    const char *hvml =
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"html\">"
+        "  <body>"
+        "    <p id=\"c0\">0</p><p id=\"c1\">0</p><p id=\"c2\">0</p>"
+        "    <update on=\"$TIMERS\" to=\"unite\">"
+        "      [{ \"id\" : \"deadline\", \"interval\" : 5000, "
+        "          \"active\" : \"yes\" }]"
+        "    </update>"
+        "    <observe on=\"$CRTN\" for=\"rdrState:domError\">"
+        "      <init as \"recovered\" with $RDR.recover($?) />"
+        "      <forget on=\"$CRTN\" for=\"rdrState:domError\" />"
+        "      <forget on=\"$TIMERS\" for=\"expired:deadline\" />"
+        "    </observe>"
+        "    <observe on=\"$TIMERS\" for=\"expired:deadline\">"
+        "      <init as \"recovered\" with $RDR.recover() />"
+        "      <forget on=\"$CRTN\" for=\"rdrState:domError\" />"
+        "      <forget on=\"$TIMERS\" for=\"expired:deadline\" />"
+        "    </observe>"
+        "    <observe on=\"$CRTN\" for=\"idle\">"
+        "      <init as \"failed\" with $RDR.fail() />"
+        "      <update on=\"#c0\" at=\"textContent\" with=\"1\" />"
+        "      <update on=\"#c1\" at=\"textContent\" with=\"1\" />"
+        "      <update on=\"#c2\" at=\"textContent\" with=\"1\" />"
+        "      <forget on=\"$CRTN\" for=\"idle\" />"
+        "    </observe>"
+        "  </body>"
+        "</hvml>";
+
+    nr_failed_sends = 0;
+    dom_error_code = 0;
+    nr_dropped_ops = 0;
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+    ASSERT_NE(vdom, nullptr);
+
+    purc_renderer_extra_info extra_info = {};
+    extra_info.title = "dom_ops";
+    purc_coroutine_t co = purc_schedule_vdom(vdom,
+            0, PURC_VARIANT_INVALID, PCRDR_PAGE_TYPE_PLAINWIN,
+            "main",         /* target_workspace */
+            NULL,           /* target_group */
+            "dom_ops",      /* page_name */
+            &extra_info, NULL, NULL);
+    ASSERT_NE(co, nullptr);
+    purc_run(NULL);
+
+    purc_cleanup();
+    unsetenv("PURC_RDR_DOM_OPS");
+    unlink(LOG_FILE);
+
+    ASSERT_EQ(nr_failed_sends, 1u);
+    ASSERT_EQ(dom_error_code, (uint64_t)PCRDR_SC_IOERR);
+    ASSERT_EQ(nr_dropped_ops, 3u);
+}
@@ -0,0 +1,182 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Checks the variants allocated for the stack frames: the live values
+ * sampled by `$VSTAT.sample()` (which calls purc_variant_usage_stat()) in
+ * the innermost element of a shallow and a deep nesting, then pushes and
+ * pops many frames. Set env NR_LOOPS to change the number of the
+ * iterations and report the numbers, e.g.:
+ *
+ *  NR_LOOPS=100000 ./test_frame_churn
+ */
+
+#include "purc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <gtest/gtest.h>
+#include <string>
+
+static size_t nr_sampled_objects;
+static size_t nr_sampled_values;
+static size_t nr_counted;
+
+static purc_variant_t
+sample_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    (void)root;
+    (void)nr_args;
+    (void)argv;
+    (void)silently;
+
+    const struct purc_variant_stat *stat = purc_variant_usage_stat();
+    nr_sampled_objects = stat->nr_values[PURC_VARIANT_TYPE_OBJECT];
+    nr_sampled_values = stat->nr_total_values;
+    return purc_variant_make_boolean(true);
+}
+
+static purc_variant_t
+count_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    (void)root;
+    (void)nr_args;
+    (void)argv;
+    (void)silently;
+
+    nr_counted++;
+    return purc_variant_make_ulongint(nr_counted);
+}
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+/* returns 0 if env NR_LOOPS is not set */
+static size_t get_nr_loops(void)
+{
+    const char *env = getenv("NR_LOOPS");
+    return env ? (size_t)atoll(env) : 0;
+}
+
+static bool
+run_hvml(const std::string &hvml)
+{
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml.c_str());
+    if (vdom == NULL)
+        return false;
+
+    purc_schedule_vdom_null(vdom);
+    purc_run(NULL);
+    return true;
+}
+
+/* samples the live values in the innermost one of `depth` nested elements */
+static void
+sample_nested(unsigned depth, size_t *nr_objects, size_t *nr_values)
+{
+    std::string hvml = "<!DOCTYPE hvml><hvml target=\"html\"><body>";
+    for (unsigned i = 0; i < depth; i++)
+        hvml += "<div>";
+    hvml += "<p>$VSTAT.sample()</p>";
+    for (unsigned i = 0; i < depth; i++)
+        hvml += "</div>";
+    hvml += "</body></hvml>";
+
+    nr_sampled_objects = 0;
+    nr_sampled_values = 0;
+    ASSERT_TRUE(run_hvml(hvml));
+    *nr_objects = nr_sampled_objects;
+    *nr_values = nr_sampled_values;
+}
+
+TEST(frame_churn, nested)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "frame_churn", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    static const struct purc_dvobj_method methods[] = {
+        { "sample", sample_getter, NULL },
+        { "count", count_getter, NULL },
+    };
+    purc_variant_t vstat = purc_dvobj_make_from_methods(methods,
+            PCA_TABLESIZE(methods));
+    ASSERT_NE(vstat, nullptr);
+    ASSERT_TRUE(purc_bind_runner_variable("VSTAT", vstat));
+    purc_variant_unref(vstat);
+
+    const unsigned depth = 200;
+    size_t shallow_objects, shallow_values;
+    size_t deep_objects, deep_values;
+    sample_nested(1, &shallow_objects, &shallow_values);
+    sample_nested(depth + 1, &deep_objects, &deep_values);
+    ASSERT_GT(shallow_values, 0u);
+
+    double objects_per_frame =
+        ((double)deep_objects - (double)shallow_objects) / depth;
+    double values_per_frame =
+        ((double)deep_values - (double)shallow_values) / depth;
+
+    /* `$!`, the attributes, and the templates are not created for the
+       frames not using them */
+    ASSERT_LT(objects_per_frame, 1.0);
+
+    /* push and pop a few frames in every iteration but the first one */
+    size_t nr_loops = get_nr_loops();
+    bool report = nr_loops > 0;
+    if (nr_loops == 0)
+        nr_loops = 1000;
+
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+            "<!DOCTYPE hvml><hvml target=\"void\"><body>"
+            "<iterate on 0 onlyif $L.lt($0<, %zu) "
+            "    with $EJSON.arith('+', $0<, 1) nosetotail >"
+            "  <test with $L.gt($?, 0) >"
+            "    <div><p>$VSTAT.count()</p></div>"
+            "  </test>"
+            "</iterate>"
+            "</body></hvml>", nr_loops);
+
+    nr_counted = 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ASSERT_TRUE(run_hvml(buf));
+    double ms = elapsed_ms(&ts);
+    ASSERT_EQ(nr_counted, nr_loops - 1);
+
+    if (report) {
+        fprintf(stderr, "live variants per frame of <div>: "
+                "%.2f objects, %.2f values in total\n",
+                objects_per_frame, values_per_frame);
+        fprintf(stderr, "%zu iterations pushing 3 frames: %.2f ms\n",
+                nr_loops, ms);
+    }
+
+    purc_cleanup();
+}
@@ -0,0 +1,209 @@
+/*
+ * @file test_observer_index.cpp
+ * @date 2022/10/28
+ * @brief The test of dispatching events to a large number of observers.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#undef NDEBUG
+
+#include "purc.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+/* the events dispatched, in the order of dispatching */
+static vector<string> dispatched;
+static bool timed_out;
+
+static string to_string(purc_variant_t v)
+{
+    uint64_t u;
+    if (purc_variant_cast_to_ulongint(v, &u, true))
+        return std::to_string(u);
+    return "?";
+}
+
+/* $LOG.hit(<observer>, $?): records the observer and the event payload */
+static purc_variant_t
+hit_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    (void)root;
+    (void)silently;
+
+    if (nr_args < 2 || !purc_variant_is_string(argv[0]))
+        return purc_variant_make_boolean(false);
+
+    dispatched.push_back(string(purc_variant_get_string_const(argv[0])) +
+            " " + to_string(argv[1]));
+    return purc_variant_make_boolean(true);
+}
+
+/* $LOG.timeout(): records that the deadline expired */
+static purc_variant_t
+timeout_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
+        bool silently)
+{
+    (void)root;
+    (void)nr_args;
+    (void)argv;
+    (void)silently;
+
+    timed_out = true;
+    return purc_variant_make_boolean(true);
+}
+
+/* Every observer of a `click` (ping) records itself with the payload and
+   forgets itself when its event comes, and the events are fired in the
+   reverse order. The sub types are delimited by `n` because a literal sub
+   type is searched in the one of the event. Besides, the `event` (pong)
+   events are all observed by the sub type `n`. Only the registered
+   message types can be observed. The coroutine exits at the deadline if
+   any event is lost. */
+static string
+make_hvml(size_t nr_observers)
+{
+    char buf[512];
+    /* allow 30 ms per event (two events per observer) */
+    snprintf(buf, sizeof(buf),
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"html\">"
+        "  <body>"
+        "    <init as=\"src\" with=\"{'id':'src'}\" />"
+        "    <init as=\"pongs\" with=\"[]\" />"
+        "    <update on=\"$TIMERS\" to=\"unite\">"
+        "      [{ \"id\" : \"deadline\", \"interval\" : %zu, "
+        "          \"active\" : \"yes\" }]"
+        "    </update>"
+        "    <observe on=\"$TIMERS\" for=\"expired:deadline\">"
+        "      <init as=\"late\" with=\"$LOG.timeout()\" />"
+        "      <exit with=\"false\" />"
+        "    </observe>", nr_observers * 60);
+    string hvml = buf;
+
+    for (size_t i = 0; i < nr_observers; i++) {
+        snprintf(buf, sizeof(buf),
+            "<observe on=\"$src\" for=\"click:n%zun\">"
+            "  <init as=\"hit\" with=\"$LOG.hit('ping n%zun', $?)\" />"
+            "  <forget on=\"$src\" for=\"click:n%zun\" />"
+            "</observe>", i, i, i);
+        hvml += buf;
+    }
+
+    snprintf(buf, sizeof(buf),
+        "<observe on=\"$src\" for=\"event:n\">"
+        "  <init as=\"hit\" with=\"$LOG.hit('pong', $?)\" />"
+        "  <update on=\"$pongs\" to=\"append\" with=\"$?\" />"
+        "  <test with=\"$L.ge($EJSON.count($pongs), %zu)\">"
+        "    <forget on=\"$src\" for=\"event:n\" />"
+        "    <forget on=\"$TIMERS\" for=\"expired:deadline\" />"
+        "  </test>"
+        "</observe>", nr_observers);
+    hvml += buf;
+
+    for (size_t i = nr_observers; i > 0; i--) {
+        snprintf(buf, sizeof(buf),
+            "<fire on=\"$src\" for=\"click:n%zun\" with=\"%zu\" />"
+            "<fire on=\"$src\" for=\"event:n%zun\" with=\"%zu\" />",
+            i - 1, i - 1, i - 1, i - 1);
+        hvml += buf;
+    }
+
+    hvml +=
+        "  </body>"
+        "</hvml>";
+    return hvml;
+}
+
+static double
+run_hvml(size_t nr_observers)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "observer_index", &info);
+    if (ret != PURC_ERROR_OK)
+        return -1;
+
+    static const struct purc_dvobj_method methods[] = {
+        { "hit", hit_getter, NULL },
+        { "timeout", timeout_getter, NULL },
+    };
+    purc_variant_t log = purc_dvobj_make_from_methods(methods,
+            PCA_TABLESIZE(methods));
+    EXPECT_NE(log, nullptr);
+    EXPECT_TRUE(purc_bind_runner_variable("LOG", log));
+    purc_variant_unref(log);
+
+    dispatched.clear();
+    timed_out = false;
+
+    string hvml = make_hvml(nr_observers);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml.c_str());
+    EXPECT_NE(vdom, nullptr);
+    if (vdom) {
+        purc_schedule_vdom_null(vdom);
+        purc_run(NULL);
+    }
+    double ms = elapsed_ms(&ts);
+
+    bool cleanup = purc_cleanup();
+    EXPECT_EQ(cleanup, true);
+    return ms;
+}
+
+TEST(observer_index, dispatch)
+{
+    static const size_t nr_observers[] = { 100, 1000, 4000 };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(nr_observers); i++) {
+        size_t n = nr_observers[i];
+        double ms = run_hvml(n);
+        ASSERT_GE(ms, 0);
+        ASSERT_FALSE(timed_out);
+
+        /* every event goes to the observer of it only, in the firing order */
+        ASSERT_EQ(dispatched.size(), n * 2);
+        for (size_t j = 0; j < n; j++) {
+            size_t k = n - 1 - j;
+            ASSERT_EQ(dispatched[j * 2],
+                    "ping n" + std::to_string(k) + "n " + std::to_string(k));
+            ASSERT_EQ(dispatched[j * 2 + 1], "pong " + std::to_string(k));
+        }
+
+        fprintf(stderr, "%zu observers, %zu events: %8.2f ms\n",
+                n, n * 2, ms);
+    }
+}
@@ -0,0 +1,177 @@
+/*
+ * @file test_scheduler.cpp
+ * @date 2022/10/17
+ * @brief The program to test the ready and pending queues and the quanta
+ *  of the scheduler.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#undef NDEBUG
+
+#include "purc.h"
+#include "private/interpreter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <gtest/gtest.h>
+
+#define NR_COROUTINES       64
+
+static const char *hvml =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"html\">"
+    "  <body>"
+    "    <iterate on 0 onlyif $L.lt($0<, 10) with $EJSON.arith('+', $0<, 1) nosetotail >"
+    "      <p>$?</p>"
+    "    </iterate>"
+    "  </body>"
+    "</hvml>";
+
+/* a CPU-bound program */
+static const char *hvml_busy =
+    "<!DOCTYPE hvml>"
+    "<hvml target=\"html\">"
+    "  <body>"
+    "    <iterate on 0 onlyif $L.lt($0<, 2000) with $EJSON.arith('+', $0<, 1) nosetotail >"
+    "      <init as \"x\" with $? temporarily />"
+    "    </iterate>"
+    "  </body>"
+    "</hvml>";
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static struct pcintr_sched_stats
+run_coroutines(bool polling)
+{
+    struct pcintr_sched_stats stats = { };
+
+    if (polling)
+        setenv("PURC_SCHEDULE_POLLING", "1", 1);
+    else
+        unsetenv("PURC_SCHEDULE_POLLING");
+
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "scheduler", &info);
+    if (ret != PURC_ERROR_OK)
+        return stats;
+
+    for (int i = 0; i < NR_COROUTINES; i++) {
+        purc_vdom_t vdom = purc_load_hvml_from_string(hvml);
+        EXPECT_NE(vdom, nullptr);
+        purc_schedule_vdom_null(vdom);
+    }
+
+    purc_run(NULL);
+
+    const struct pcintr_sched_stats *p = pcintr_get_sched_stats();
+    EXPECT_NE(p, nullptr);
+    if (p)
+        stats = *p;
+
+    purc_cleanup();
+    unsetenv("PURC_SCHEDULE_POLLING");
+    return stats;
+}
+
+TEST(scheduler, ready_queue)
+{
+    struct pcintr_sched_stats queued = run_coroutines(false);
+    struct pcintr_sched_stats polled = run_coroutines(true);
+
+    ASSERT_GT(queued.nr_ticks, 0UL);
+    ASSERT_GT(polled.nr_ticks, 0UL);
+
+    /* both modes execute the same programs */
+    ASSERT_EQ(queued.nr_steps, polled.nr_steps);
+
+    /* only the coroutines having messages are visited for events */
+    ASSERT_LE(queued.nr_dispatches, polled.nr_dispatches);
+}
+
+static struct pcintr_sched_stats
+run_busy_coroutines(unsigned int quantum_steps, int nr_coroutines,
+        double *ms)
+{
+    struct pcintr_sched_stats stats = { };
+
+    purc_instance_extra_info info = {};
+    info.sched_quantum_steps = quantum_steps;
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "scheduler", &info);
+    if (ret != PURC_ERROR_OK)
+        return stats;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (int i = 0; i < nr_coroutines; i++) {
+        purc_vdom_t vdom = purc_load_hvml_from_string(hvml_busy);
+        EXPECT_NE(vdom, nullptr);
+        purc_schedule_vdom_null(vdom);
+    }
+
+    purc_run(NULL);
+    *ms = elapsed_ms(&ts);
+
+    const struct pcintr_sched_stats *p = pcintr_get_sched_stats();
+    EXPECT_NE(p, nullptr);
+    if (p)
+        stats = *p;
+
+    purc_cleanup();
+    return stats;
+}
+
+TEST(scheduler, quantum)
+{
+    static const unsigned int quanta[] = { 1, 16, 64 };
+
+    for (int nr_coroutines = 1; nr_coroutines <= 4; nr_coroutines *= 4) {
+        struct pcintr_sched_stats one_step = { };
+        for (size_t i = 0; i < PCA_TABLESIZE(quanta); i++) {
+            double ms = 0;
+            struct pcintr_sched_stats stats;
+            stats = run_busy_coroutines(quanta[i], nr_coroutines, &ms);
+            ASSERT_GT(stats.nr_ticks, 0UL);
+
+            fprintf(stderr, "%d coroutine(s) with quantum of %u steps: "
+                    "%.2f ms, %llu steps in %llu ticks, %llu preemptions\n",
+                    nr_coroutines, quanta[i], ms,
+                    (unsigned long long)stats.nr_steps,
+                    (unsigned long long)stats.nr_ticks,
+                    (unsigned long long)stats.nr_preemptions);
+
+            if (i == 0) {
+                one_step = stats;
+                continue;
+            }
+
+            /* the same programs are executed in fewer ticks */
+            ASSERT_EQ(stats.nr_steps, one_step.nr_steps);
+            ASSERT_LT(stats.nr_ticks, one_step.nr_ticks);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * @file test_set_update.cpp
+ * @date 2022/10/20
+ * @brief The benchmark of updating the members of large sets with
+ *      the `update` element.
+ *
+ * Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#undef NDEBUG
+
+#include "purc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <gtest/gtest.h>
+
+#define NR_UPDATES          2000
+
+using namespace std;
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+/* Every update changes a field out of the unique key of a member; checking
+   the uniqueness of the set shall not cost more with more members. */
+static string
+make_hvml(size_t nr_members, size_t nr_updates)
+{
+    string hvml =
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"void\">"
+        "  <body>"
+        "    <init as=\"users\" uniquely against=\"id\">"
+        "      [";
+
+    for (size_t i = 0; i < nr_members; i++) {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%s{ \"id\": %zu, \"age\": 0 }",
+                i ? ", " : "", i);
+        hvml += buf;
+    }
+
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+        "      ]"
+        "    </init>"
+        "    <iterate on 0 onlyif $L.lt($0<, %zu) "
+        "        with $EJSON.arith('+', $0<, 1) nosetotail >"
+        "      <update on=\"$users[$EJSON.arith('%%', $?, %zu)]\" "
+        "          at=\".age\" with=\"$?\" />"
+        "    </iterate>"
+        "  </body>"
+        "</hvml>", nr_updates, nr_members);
+    hvml += buf;
+    return hvml;
+}
+
+static double
+run_hvml(size_t nr_members, size_t nr_updates)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "set_update", &info);
+    if (ret != PURC_ERROR_OK)
+        return -1;
+
+    string hvml = make_hvml(nr_members, nr_updates);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_vdom_t vdom = purc_load_hvml_from_string(hvml.c_str());
+    EXPECT_NE(vdom, nullptr);
+    if (vdom) {
+        purc_schedule_vdom_null(vdom);
+        purc_run(NULL);
+    }
+    double ms = elapsed_ms(&ts);
+
+    purc_cleanup();
+    return ms;
+}
+
+TEST(set_update, large_sets)
+{
+    static const size_t sizes[] = { 1024, 4096, 16384 };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(sizes); i++) {
+        /* the time of loading the program and initializing the set */
+        double init_ms = run_hvml(sizes[i], 0);
+        double total_ms = run_hvml(sizes[i], NR_UPDATES);
+        ASSERT_GE(init_ms, 0);
+        ASSERT_GE(total_ms, 0);
+
+        fprintf(stderr, "%6zu members: init %8.2f ms, "
+                "%d updates %8.2f ms\n",
+                sizes[i], init_ms, NR_UPDATES, total_ms - init_ms);
+    }
+}
@@ -0,0 +1,181 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#undef NDEBUG
+
+#include "purc.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <gtest/gtest.h>
+
+#define NR_LOOPS        20000
+
+static const char *json_data =
+    "{\"id\":\"c12\",\"n\":3.5,\"i\":-7,\"ok\":true,\"nil\":null,"
+    "\"arr\":[1,2,\"three\",{\"x\":[]}],\"s\":\"h\\u00e9llo\"}";
+
+static ssize_t write_to_string(void *ctxt, const void *buf, size_t count)
+{
+    std::string *str = (std::string *)ctxt;
+    str->append((const char *)buf, count);
+    return count;
+}
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static pcrdr_msg *
+make_json_request(const char *operation)
+{
+    pcrdr_msg *msg = pcrdr_make_request_message(PCRDR_MSG_TARGET_DOM,
+            0x1234, operation, NULL, "request-id",
+            PCRDR_MSG_ELEMENT_TYPE_HANDLE, "5678", "textContent",
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+    if (msg) {
+        msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+        msg->data = purc_variant_make_from_json_string(json_data,
+                strlen(json_data));
+    }
+    return msg;
+}
+
+/* compares the messages including the JSON data */
+static void
+check_same_messages(pcrdr_msg *msg_a, pcrdr_msg *msg_b)
+{
+    if (msg_a->dataType == PCRDR_MSG_DATA_TYPE_JSON) {
+        ASSERT_EQ(msg_b->dataType, PCRDR_MSG_DATA_TYPE_JSON);
+        ASSERT_EQ(purc_variant_compare_ex(msg_a->data, msg_b->data,
+                    PCVARIANT_COMPARE_OPT_AUTO), 0);
+
+        purc_variant_t data_a = msg_a->data, data_b = msg_b->data;
+        msg_a->data = msg_b->data = PURC_VARIANT_INVALID;
+        int ret = pcrdr_compare_messages(msg_a, msg_b);
+        msg_a->data = data_a;
+        msg_b->data = data_b;
+        ASSERT_EQ(ret, 0);
+    }
+    else {
+        ASSERT_EQ(pcrdr_compare_messages(msg_a, msg_b), 0);
+    }
+}
+
+TEST(message_codec, binary)
+{
+    int ret = purc_init_ex(PURC_MODULE_PCRDR, "cn.fmsoft.hvml.test",
+            "msg_codec", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    pcrdr_msg *msgs[5];
+    /* a well-known operation and a named one */
+    msgs[0] = make_json_request(PCRDR_OPERATION_UPDATE);
+    msgs[1] = make_json_request("to_do_something");
+    msgs[2] = pcrdr_make_request_message(PCRDR_MSG_TARGET_SESSION,
+            0, PCRDR_OPERATION_ENDSESSION, NULL, NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_PLAIN, "The data", 0);
+    msgs[3] = pcrdr_make_response_message("request-id", NULL,
+            PCRDR_SC_OK, 0xdeadbeef, PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+    msgs[4] = pcrdr_make_event_message(PCRDR_MSG_TARGET_PLAINWINDOW,
+            0x55, "click", NULL, PCRDR_MSG_ELEMENT_TYPE_ID, "button", NULL,
+            PCRDR_MSG_DATA_TYPE_JSON, json_data, strlen(json_data));
+
+    for (size_t i = 0; i < PCA_TABLESIZE(msgs); i++) {
+        ASSERT_NE(msgs[i], nullptr);
+
+        std::string packet;
+        ret = pcrdr_serialize_message_bin(msgs[i], write_to_string, &packet);
+        ASSERT_EQ(ret, 0);
+
+        pcrdr_msg *msg_parsed;
+        ret = pcrdr_parse_packet_bin(packet.data(), packet.size(),
+                &msg_parsed);
+        ASSERT_EQ(ret, 0);
+        check_same_messages(msgs[i], msg_parsed);
+        pcrdr_release_message(msg_parsed);
+
+        /* a truncated packet is a bad one */
+        for (size_t len = 0; len < packet.size(); len++) {
+            ret = pcrdr_parse_packet_bin(packet.data(), len, &msg_parsed);
+            ASSERT_EQ(ret, -1);
+        }
+    }
+
+    for (size_t i = 0; i < PCA_TABLESIZE(msgs); i++) {
+        pcrdr_release_message(msgs[i]);
+    }
+
+    purc_cleanup();
+}
+
+TEST(message_codec, benchmark)
+{
+    int ret = purc_init_ex(PURC_MODULE_PCRDR, "cn.fmsoft.hvml.test",
+            "msg_codec", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    pcrdr_msg *msg = make_json_request(PCRDR_OPERATION_UPDATE);
+    ASSERT_NE(msg, nullptr);
+
+    for (int binary = 0; binary < 2; binary++) {
+        std::string packet;
+        size_t nr_bytes = 0;
+
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (int i = 0; i < NR_LOOPS; i++) {
+            pcrdr_msg *msg_parsed;
+
+            packet.clear();
+            if (binary) {
+                ret = pcrdr_serialize_message_bin(msg,
+                        write_to_string, &packet);
+                ASSERT_EQ(ret, 0);
+                ret = pcrdr_parse_packet_bin(packet.data(), packet.size(),
+                        &msg_parsed);
+            }
+            else {
+                ret = pcrdr_serialize_message(msg, write_to_string, &packet);
+                ASSERT_EQ(ret, 0);
+                ret = pcrdr_parse_packet(&packet[0], packet.size(),
+                        &msg_parsed);
+            }
+            ASSERT_EQ(ret, 0);
+
+            nr_bytes += packet.size();
+            pcrdr_release_message(msg_parsed);
+        }
+
+        fprintf(stderr, "%s encoding: %d messages, %zu bytes, %.2f ms\n",
+                binary ? "binary" : "text", NR_LOOPS, nr_bytes,
+                elapsed_ms(&ts));
+    }
+
+    pcrdr_release_message(msg);
+    purc_cleanup();
+}
+
@@ -0,0 +1,213 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Checks the responses to the pending requests of a renderer connection
+ * are matched in any order, and the requests not answered in time expire.
+ *
+ * The responses are fed through the extra message source of a connection
+ * to the headless renderer.
+ */
+
+#undef NDEBUG
+
+#include "purc.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <deque>
+#include <string>
+#include <gtest/gtest.h>
+
+#define LOG_FILE        "file:///tmp/test_pending_requests.log"
+
+struct responses {
+    /* the responses to feed */
+    std::deque<pcrdr_msg *> to_feed;
+    /* the requests answered, expired, and cancelled in order */
+    std::string answered;
+    std::string expired;
+    std::string cancelled;
+};
+
+static pcrdr_msg *feed_response(pcrdr_conn *conn, void *ctxt)
+{
+    (void)conn;
+    struct responses *rsps = (struct responses *)ctxt;
+    if (rsps->to_feed.empty())
+        return NULL;
+
+    pcrdr_msg *msg = rsps->to_feed.front();
+    rsps->to_feed.pop_front();
+    return msg;
+}
+
+static int on_response(pcrdr_conn *conn, const char *request_id, int state,
+        void *context, const pcrdr_msg *response_msg)
+{
+    (void)conn;
+    struct responses *rsps = (struct responses *)context;
+    switch (state) {
+    case PCRDR_RESPONSE_RESULT:
+        if (response_msg == NULL)
+            return -1;
+        rsps->answered += std::string(request_id) + " ";
+        break;
+    case PCRDR_RESPONSE_TIMEOUT:
+        rsps->expired += std::string(request_id) + " ";
+        break;
+    case PCRDR_RESPONSE_CANCELLED:
+        rsps->cancelled += std::string(request_id) + " ";
+        break;
+    }
+    return 0;
+}
+
+static void add_request(pcrdr_conn *conn, struct responses *rsps,
+        const char *request_id, int seconds_expected)
+{
+    purc_variant_t id = purc_variant_make_string(request_id, false);
+    ASSERT_EQ(pcrdr_set_handler_for_response_from_extra_source(conn, id,
+                seconds_expected, rsps, on_response), 0);
+    purc_variant_unref(id);
+}
+
+static void feed(struct responses *rsps, const char *request_id)
+{
+    pcrdr_msg *msg = pcrdr_make_response_message(request_id, NULL,
+            PCRDR_SC_OK, 0, PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+    ASSERT_NE(msg, nullptr);
+    rsps->to_feed.push_back(msg);
+}
+
+/* dispatches the fed responses and checks the timeouts */
+static void dispatch_all(pcrdr_conn *conn, struct responses *rsps)
+{
+    while (!rsps->to_feed.empty()) {
+        pcrdr_wait_and_dispatch_message(conn, 1);
+    }
+}
+
+static pcrdr_conn *connect_headless(void)
+{
+    pcrdr_conn *conn = NULL;
+    pcrdr_msg *msg = pcrdr_headless_connect(LOG_FILE, "cn.fmsoft.hvml.test",
+            "pending_requests", &conn);
+    if (msg)
+        pcrdr_release_message(msg);
+    return conn;
+}
+
+TEST(pending_requests, out_of_order)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "pending_requests", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    pcrdr_conn *conn = connect_headless();
+    ASSERT_NE(conn, nullptr);
+
+    struct responses rsps;
+    pcrdr_conn_set_extra_message_source(conn, feed_response, &rsps, NULL);
+
+    add_request(conn, &rsps, "r1", 30);
+    add_request(conn, &rsps, "r2", 30);
+    add_request(conn, &rsps, "r3", 1);
+    add_request(conn, &rsps, "r4", 30);
+    add_request(conn, &rsps, "r5", 30);
+    ASSERT_EQ(pcrdr_conn_pending_requests_count(conn), 5u);
+
+    /* answered in an order other than the sending order; the response
+       to an unknown request is ignored */
+    feed(&rsps, "r4");
+    feed(&rsps, "r2");
+    feed(&rsps, "unknown");
+    feed(&rsps, "r1");
+    dispatch_all(conn, &rsps);
+    ASSERT_EQ(rsps.answered, "r4 r2 r1 ");
+
+    /* r3 expires in a second or two (it may have expired already) */
+    for (int i = 0; i < 300 && rsps.expired.empty(); i++) {
+        pcrdr_wait_and_dispatch_message(conn, 10);
+    }
+    ASSERT_EQ(rsps.expired, "r3 ");
+    ASSERT_EQ(pcrdr_conn_pending_requests_count(conn), 1u);
+
+    /* a late response to the expired request is ignored */
+    rsps.answered.clear();
+    feed(&rsps, "r3");
+    feed(&rsps, "r5");
+    dispatch_all(conn, &rsps);
+    ASSERT_EQ(rsps.answered, "r5 ");
+    ASSERT_EQ(rsps.expired, "r3 ");
+    ASSERT_EQ(pcrdr_conn_pending_requests_count(conn), 0u);
+
+    /* the requests still pending are cancelled when disconnecting */
+    add_request(conn, &rsps, "r6", 30);
+    pcrdr_disconnect(conn);
+    ASSERT_EQ(rsps.cancelled, "r6 ");
+
+    purc_cleanup();
+}
+
+TEST(pending_requests, many)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "pending_requests", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    pcrdr_conn *conn = connect_headless();
+    ASSERT_NE(conn, nullptr);
+
+    struct responses rsps;
+    pcrdr_conn_set_extra_message_source(conn, feed_response, &rsps, NULL);
+
+    /* enough to grow the index and the timeout heap several times */
+    const int nr = 200;
+    char id[32];
+    for (int i = 0; i < nr; i++) {
+        snprintf(id, sizeof(id), "req-%d", i);
+        add_request(conn, &rsps, id, 30 + i % 7);
+    }
+    ASSERT_EQ(pcrdr_conn_pending_requests_count(conn), (size_t)nr);
+
+    /* the odd ones backwards, then the even ones */
+    std::string expected;
+    for (int i = nr - 1; i >= 0; i -= 2) {
+        snprintf(id, sizeof(id), "req-%d", i);
+        feed(&rsps, id);
+        expected += std::string(id) + " ";
+    }
+    for (int i = 0; i < nr; i += 2) {
+        snprintf(id, sizeof(id), "req-%d", i);
+        feed(&rsps, id);
+        expected += std::string(id) + " ";
+    }
+
+    dispatch_all(conn, &rsps);
+    ASSERT_EQ(rsps.answered, expected);
+    ASSERT_EQ(rsps.expired, "");
+    ASSERT_EQ(pcrdr_conn_pending_requests_count(conn), 0u);
+
+    pcrdr_disconnect(conn);
+    purc_cleanup();
+}
@@ -0,0 +1,219 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Checks the SIMD kernels for validating UTF-8 strings, counting the
+ * characters, and finding the bytes to escape in JSON strings give the
+ * same results as the scalar ones, and measures them on every level
+ * supported by the CPU.
+ *
+ * Use env LOOPS to repeat the operations, e.g.:
+ *
+ *  LOOPS=1000 ./test_simd
+ */
+
+#include "purc.h"
+#include "private/simd.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+static const char *level_names[] = { "none", "sse2", "avx2" };
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_loops(void)
+{
+    const char *env = getenv("LOOPS");
+    size_t loops = env ? (size_t)atoll(env) : 0;
+    return loops ? loops : 100;
+}
+
+static uint32_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (uint32_t)*state;
+}
+
+static const char *valid_chars[] = {
+    "a", "Z", " ", "\xc3\xa9", "\xe4\xb8\xad", "\xf0\x9f\x98\x80",
+    "\xed\x9f\xbf", "\xf4\x8f\xbf\xbf", "\xe0\xa0\x80", "\xf0\x90\x80\x80",
+    "\n", "\"", "/", "\\",
+};
+
+static const char *invalid_chars[] = {
+    "\x80", "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xed\xa0\x80",
+    "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xff", "\xc3", "\xe4\xb8",
+    "\xf0\x9f\x98", "\xf8\x88\x80\x80\x80",
+};
+
+/* a string of ASCII letters mixed with other characters by the rate */
+static string make_text(uint64_t *state, size_t len, unsigned per_mille,
+        bool with_invalid)
+{
+    string text;
+
+    while (text.size() < len) {
+        unsigned r = next_random(state) % 1000;
+        if (r >= per_mille) {
+            text += (char)('a' + r % 26);
+        }
+        else if (with_invalid && r < per_mille / 50) {
+            text += invalid_chars[next_random(state) %
+                PCA_TABLESIZE(invalid_chars)];
+        }
+        else if (with_invalid && r == per_mille / 50) {
+            text += '\0';
+        }
+        else {
+            text += valid_chars[next_random(state) %
+                PCA_TABLESIZE(valid_chars)];
+        }
+    }
+
+    return text;
+}
+
+TEST(simd, same_results)
+{
+    int supported = pcutils_simd_set_level(PCUTILS_SIMD_AVX2);
+    uint64_t state = UINT64_C(0x9E3779B97F4A7C15);
+
+    for (int i = 0; i < 20000; i++) {
+        string text = make_text(&state, next_random(&state) % 300,
+                next_random(&state) % 1000, true);
+        size_t len = text.size();
+        if (next_random(&state) % 2)
+            len = next_random(&state) % (len + 1);
+        const char *str = text.c_str();
+
+        size_t nr_chars[3], nr_leads[3], spans[3][2];
+        const char *ends[3];
+        bool valids[3];
+
+        for (int level = 0; level <= supported; level++) {
+            ASSERT_EQ(pcutils_simd_set_level(level), level);
+            valids[level] = pcutils_string_check_utf8_len(str, len,
+                    &nr_chars[level], &ends[level]);
+            nr_leads[level] = pcutils_utf8_count_chars(str, len);
+            spans[level][0] = pcutils_json_escape_span(str, len, false);
+            spans[level][1] = pcutils_json_escape_span(str, len, true);
+
+            ASSERT_EQ(valids[level], valids[0]) << level_names[level];
+            ASSERT_EQ(ends[level], ends[0]) << level_names[level];
+            ASSERT_EQ(nr_chars[level], nr_chars[0]) << level_names[level];
+            ASSERT_EQ(nr_leads[level], nr_leads[0]) << level_names[level];
+            ASSERT_EQ(spans[level][0], spans[0][0]) << level_names[level];
+            ASSERT_EQ(spans[level][1], spans[0][1]) << level_names[level];
+        }
+
+        if (valids[0]) {
+            ASSERT_EQ(nr_leads[0], nr_chars[0]);
+        }
+    }
+
+    pcutils_simd_set_level(PCUTILS_SIMD_AVX2);
+}
+
+TEST(simd, kernels_perf)
+{
+    static const struct {
+        const char *name;
+        unsigned per_mille;     /* the rate of the characters not letters */
+    } texts[] = {
+        { "ascii", 0 },
+        { "sparse", 10 },
+        { "dense", 500 },
+    };
+
+    size_t nr_loops = get_loops();
+    int supported = pcutils_simd_set_level(PCUTILS_SIMD_AVX2);
+    uint64_t state = UINT64_C(0x9E3779B97F4A7C15);
+
+    for (size_t i = 0; i < PCA_TABLESIZE(texts); i++) {
+        string text = make_text(&state, 64 * 1024, texts[i].per_mille, false);
+        const char *str = text.c_str();
+        size_t len = text.size();
+        double mb = len * nr_loops / 1048576.0;
+
+        for (int level = 0; level <= supported; level++) {
+            ASSERT_EQ(pcutils_simd_set_level(level), level);
+
+            struct timespec ts;
+            size_t nr_chars = 0;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            for (size_t n = 0; n < nr_loops; n++) {
+                ASSERT_TRUE(pcutils_string_check_utf8_len(str, len,
+                            &nr_chars, NULL));
+            }
+            double validate_ms = elapsed_ms(&ts);
+
+            size_t nr_leads = 0;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            for (size_t n = 0; n < nr_loops; n++) {
+                nr_leads = pcutils_utf8_count_chars(str, len);
+            }
+            double count_ms = elapsed_ms(&ts);
+            ASSERT_EQ(nr_leads, nr_chars);
+
+            /* walk through all the bytes to escape as the serializer does */
+            size_t nr_escaped = 0;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            for (size_t n = 0; n < nr_loops; n++) {
+                size_t pos = 0;
+                nr_escaped = 0;
+                while (pos < len) {
+                    pos += pcutils_json_escape_span(str + pos, len - pos,
+                            true);
+                    if (pos < len) {
+                        nr_escaped++;
+                        pos++;
+                    }
+                }
+            }
+            double escape_ms = elapsed_ms(&ts);
+            if (texts[i].per_mille == 0) {
+                ASSERT_EQ(nr_escaped, 0U);
+            }
+
+            fprintf(stderr, "%-6s %s: validate %8.2f MB/s, "
+                    "count %8.2f MB/s, escape %8.2f MB/s\n",
+                    texts[i].name, level_names[level],
+                    mb / (validate_ms / 1000.0),
+                    mb / (count_ms / 1000.0),
+                    mb / (escape_ms / 1000.0));
+        }
+    }
+
+    pcutils_simd_set_level(PCUTILS_SIMD_AVX2);
+}
@@ -0,0 +1,253 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Measures appending, getting, inserting, removing and iterating the
+ * members of arrays stored contiguously, and checks the results against
+ * a std::vector; also checks the arrays in a set still keep the set
+ * unique after being changed.
+ *
+ * Use env LOOPS to repeat the operations, e.g.:
+ *
+ *  LOOPS=1000 ./test_array_perf
+ */
+
+#include "purc.h"
+#include "private/variant.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_loops(void)
+{
+    const char *env = getenv("LOOPS");
+    size_t loops = env ? (size_t)atoll(env) : 0;
+    return loops ? loops : 10;
+}
+
+static void check_same(purc_variant_t arr, const vector<purc_variant_t> &vec)
+{
+    ASSERT_EQ(purc_variant_array_get_size(arr), (ssize_t)vec.size());
+
+    purc_variant_t v;
+    size_t idx;
+    foreach_value_in_variant_array(arr, v, idx) {
+        ASSERT_EQ(v, vec[idx]);
+    } end_foreach;
+
+    foreach_value_in_variant_array_reverse(arr, v, idx) {
+        ASSERT_EQ(v, vec[idx]);
+    } end_foreach;
+}
+
+TEST(array_perf, packed)
+{
+    static const size_t sizes[] = { 1, 4, 5, 64, 1024, 16384 };
+    size_t nr_loops = get_loops();
+
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "array_perf", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    for (size_t i = 0; i < PCA_TABLESIZE(sizes); i++) {
+        size_t nr_vals = sizes[i];
+        size_t loops = nr_loops * 1024 / nr_vals;
+        if (loops == 0)
+            loops = 1;
+
+        vector<purc_variant_t> vals;
+        for (size_t j = 0; j < nr_vals; j++) {
+            vals.push_back(purc_variant_make_ulongint(j));
+        }
+
+        struct timespec ts;
+        purc_variant_t arr = PURC_VARIANT_INVALID;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (size_t n = 0; n < loops; n++) {
+            if (arr)
+                purc_variant_unref(arr);
+            arr = purc_variant_make_array_0();
+            for (size_t j = 0; j < nr_vals; j++) {
+                purc_variant_array_append(arr, vals[j]);
+            }
+        }
+        double append_ms = elapsed_ms(&ts);
+        check_same(arr, vals);
+
+        size_t nr_found = 0;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (size_t n = 0; n < loops; n++) {
+            for (size_t j = 0; j < nr_vals; j++) {
+                if (purc_variant_array_get(arr, j) == vals[j])
+                    nr_found++;
+            }
+        }
+        double get_ms = elapsed_ms(&ts);
+        ASSERT_EQ(nr_found, loops * nr_vals);
+
+        uint64_t sum = 0;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (size_t n = 0; n < loops; n++) {
+            purc_variant_t v;
+            size_t idx;
+            foreach_value_in_variant_array(arr, v, idx) {
+                (void)idx;
+                sum += v->u64;
+            } end_foreach;
+        }
+        double iterate_ms = elapsed_ms(&ts);
+        ASSERT_EQ(sum, loops * nr_vals * (nr_vals - 1) / 2);
+
+        /* insert into and remove from the middle, then check the order */
+        vector<purc_variant_t> model(vals);
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (size_t n = 0; n < loops; n++) {
+            size_t pos = (n * 7919) % (model.size() + 1);
+            purc_variant_t v = vals[n % nr_vals];
+            ASSERT_TRUE(purc_variant_array_insert_before(arr, pos, v));
+            model.insert(model.begin() + pos, v);
+
+            pos = (n * 104729) % model.size();
+            ASSERT_TRUE(purc_variant_array_remove(arr, pos));
+            model.erase(model.begin() + pos);
+        }
+        double insert_remove_ms = elapsed_ms(&ts);
+        check_same(arr, model);
+
+        /* remove the current member while iterating */
+        purc_variant_t v;
+        size_t idx;
+        size_t nr_visited = 0;
+        foreach_value_in_variant_array_safe(arr, v, idx) {
+            ASSERT_EQ(v, model[nr_visited]);
+            nr_visited++;
+            ASSERT_TRUE(purc_variant_array_remove(arr, idx));
+        } end_foreach;
+        ASSERT_EQ(nr_visited, model.size());
+        ASSERT_EQ(purc_variant_array_get_size(arr), 0);
+
+        fprintf(stderr, "%6zu members x %6zu: append %8.2f ms, "
+                "get %8.2f ms, iterate %8.2f ms, insert/remove %8.2f ms\n",
+                nr_vals, loops, append_ms, get_ms, iterate_ms,
+                insert_remove_ms);
+
+        purc_variant_unref(arr);
+        for (size_t j = 0; j < nr_vals; j++) {
+            purc_variant_unref(vals[j]);
+        }
+    }
+
+    purc_cleanup();
+}
+
+static purc_variant_t make_member(const char *first, const char *last)
+{
+    purc_variant_t name = purc_variant_make_array_0();
+    purc_variant_t s = purc_variant_make_string(first, false);
+    purc_variant_array_append(name, s);
+    purc_variant_unref(s);
+    if (last) {
+        s = purc_variant_make_string(last, false);
+        purc_variant_array_append(name, s);
+        purc_variant_unref(s);
+    }
+
+    purc_variant_t member = purc_variant_make_object_0();
+    purc_variant_object_set_by_static_ckey(member, "name", name);
+    purc_variant_unref(name);
+    return member;
+}
+
+TEST(array_perf, in_set)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "array_perf", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_variant_t xu = make_member("xiaohong", "xu");
+    purc_variant_t xue = make_member("xiaohong", NULL);
+    purc_variant_t set = purc_variant_make_set_by_ckey(2, "name", xu, xue);
+    ASSERT_NE(set, nullptr);
+    ASSERT_EQ(purc_variant_set_get_size(set), 2);
+
+    /* the members are kept in the order of adding */
+    purc_variant_t elem, name, other, other_name;
+    other = purc_variant_set_get_by_index(set, 0);
+    other_name = purc_variant_object_get_by_ckey(other, "name");
+    ASSERT_NE(other_name, nullptr);
+    elem = purc_variant_set_get_by_index(set, 1);
+    name = purc_variant_object_get_by_ckey(elem, "name");
+    ASSERT_NE(name, nullptr);
+
+    purc_variant_t xu_str = purc_variant_make_string("xu", false);
+    purc_variant_t shuming = purc_variant_make_string("shuming", false);
+    purc_variant_t zhang = purc_variant_make_string("zhang", false);
+
+    /* this makes the two members duplicated */
+    ASSERT_FALSE(purc_variant_array_append(name, xu_str));
+    ASSERT_EQ(purc_variant_array_get_size(name), 1);
+
+    /* while these keep them unique */
+    ASSERT_TRUE(purc_variant_array_insert_before(name, 0, shuming));
+    ASSERT_TRUE(purc_variant_array_prepend(other_name, shuming));
+    ASSERT_TRUE(purc_variant_array_set(name, 0, zhang));
+    ASSERT_EQ(pcvariant_array_sort(name, NULL, NULL), 0);
+    ASSERT_EQ(purc_variant_array_get(name, 1), zhang);
+    ASSERT_TRUE(purc_variant_array_remove(name, 1));
+    ASSERT_TRUE(purc_variant_array_remove(other_name, 0));
+
+    /* the members moved by sorting still refer to the set */
+    ASSERT_FALSE(purc_variant_array_append(name, xu_str));
+    ASSERT_EQ(purc_variant_array_get_size(name), 1);
+    ASSERT_EQ(purc_variant_set_get_size(set), 2);
+
+    /* the array no longer belongs to the set once replaced */
+    purc_variant_ref(name);
+    purc_variant_t li = make_member("li", NULL);
+    purc_variant_t li_name = purc_variant_object_get_by_ckey(li, "name");
+    ASSERT_TRUE(purc_variant_object_set_by_static_ckey(elem, "name",
+                li_name));
+    purc_variant_unref(li);
+    ASSERT_TRUE(purc_variant_array_append(name, xu_str));
+    ASSERT_TRUE(purc_variant_array_append(name, xu_str));
+    ASSERT_EQ(purc_variant_array_get_size(name), 3);
+    purc_variant_unref(name);
+
+    purc_variant_unref(zhang);
+    purc_variant_unref(shuming);
+    purc_variant_unref(xu_str);
+    purc_variant_unref(set);
+    purc_variant_unref(xue);
+    purc_variant_unref(xu);
+
+    purc_cleanup();
+}
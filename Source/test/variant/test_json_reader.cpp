@@ -0,0 +1,291 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Checks the JSON reader (purc_json_reader_read(), used by
+ * `$STREAM.readjson` and `$STREAM.readndjson`) yields the records one by one,
+ * skips the malformed ones, and resumes a record across the partial reads
+ * of a non-blocking pipe.
+ *
+ * Also reads a large NDJSON feed from a pipe. Use env NR_RECORDS to change
+ * the number of the records, e.g.:
+ *
+ *  NR_RECORDS=10000000 ./test_json_reader
+ */
+
+#include "purc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <string>
+
+static size_t get_nr_records(void)
+{
+    const char *env = getenv("NR_RECORDS");
+    size_t nr = env ? (size_t)atoll(env) : 0;
+    return nr ? nr : 100000;
+}
+
+static std::string serialize(purc_variant_t v)
+{
+    purc_rwstream_t rws = purc_rwstream_new_buffer(64, 0);
+    purc_variant_serialize(v, rws, 0, PCVARIANT_SERIALIZE_OPT_PLAIN, NULL);
+
+    size_t sz_content = 0;
+    const char *buf = (const char *)purc_rwstream_get_mem_buffer(rws,
+            &sz_content);
+    std::string s(buf, sz_content);
+    purc_rwstream_destroy(rws);
+    return s;
+}
+
+/* reads all records; the malformed ones are represented by `!` */
+static std::string
+read_all(const char *json, unsigned int flags)
+{
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void *)json,
+            strlen(json));
+    purc_json_reader_t reader = purc_json_reader_new(flags);
+    std::string records;
+
+    for (;;) {
+        purc_variant_t v = purc_json_reader_read(reader, rws);
+        if (v) {
+            records += serialize(v);
+            records += ' ';
+            purc_variant_unref(v);
+        }
+        else if (purc_get_last_error() == PURC_ERROR_NO_DATA) {
+            break;
+        }
+        else {
+            records += "! ";
+        }
+    }
+
+    purc_json_reader_delete(reader);
+    purc_rwstream_destroy(rws);
+    return records;
+}
+
+TEST(json_reader, records)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "json_reader", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* the top-level values, e.g., NDJSON */
+    ASSERT_EQ(read_all("1 \"a b\" {\"x\": [1, \"]\"]}\n[3]\n null true",
+                PCVRNT_JSON_READER_FLAG_NONE),
+            "1 \"a b\" {\"x\":[1,\"]\"]} [3] null true ");
+
+    /* malformed records are skipped */
+    ASSERT_EQ(read_all("{\"a\": 1}\n{\"a\" 2}\n}\n{\"a\": 3}\n",
+                PCVRNT_JSON_READER_FLAG_NONE),
+            "{\"a\":1} ! ! {\"a\":3} ");
+
+    /* eJSON records */
+    ASSERT_EQ(read_all("{'a': 10L}\n[1, 2, ]\n",
+                PCVRNT_JSON_READER_FLAG_NONE),
+            "{\"a\":10} [1,2] ");
+
+    /* the elements of the top-level arrays */
+    ASSERT_EQ(read_all("[1, {\"a\": \"]\"}, [2, 3], \"x\\\"]\"] [] {\"b\": 4}",
+                PCVRNT_JSON_READER_FLAG_ELEMENTS),
+            "1 {\"a\":\"]\"} [2,3] \"x\\\"]\" {\"b\":4} ");
+
+    /* a truncated record */
+    ASSERT_EQ(read_all("[1, [2, 3",
+                PCVRNT_JSON_READER_FLAG_ELEMENTS),
+            "1 ! ");
+
+    purc_cleanup();
+}
+
+TEST(json_reader, partial_reads)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "json_reader", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    purc_rwstream_t rws = purc_rwstream_new_from_unix_fd(fds[0]);
+    purc_json_reader_t reader;
+    reader = purc_json_reader_new(PCVRNT_JSON_READER_FLAG_ELEMENTS);
+
+    /* feed the bytes one by one */
+    const char *json = "[{\"id\": 1, \"tags\": [\"a\", \"b\"]}, 23, \"c\"]";
+    std::string records;
+    for (const char *p = json; *p; p++) {
+        ASSERT_EQ(write(fds[1], p, 1), 1);
+
+        purc_variant_t v = purc_json_reader_read(reader, rws);
+        if (v) {
+            records += serialize(v);
+            records += ' ';
+            purc_variant_unref(v);
+        }
+        else {
+            ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NOT_READY);
+        }
+    }
+
+    /* `23` is complete only after the separator */
+    ASSERT_EQ(records, "{\"id\":1,\"tags\":[\"a\",\"b\"]} 23 \"c\" ");
+
+    close(fds[1]);
+    ASSERT_EQ(purc_json_reader_read(reader, rws), nullptr);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NO_DATA);
+
+    purc_json_reader_delete(reader);
+    purc_rwstream_destroy(rws);
+    close(fds[0]);
+    purc_cleanup();
+}
+
+TEST(json_reader, switch_flags)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "json_reader", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* all in the buffer of the reader after the first read */
+    const char *json = "{\"a\": 1} [2, 3] [4] [5, 6]";
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void *)json,
+            strlen(json));
+    purc_json_reader_t reader;
+    reader = purc_json_reader_new(PCVRNT_JSON_READER_FLAG_NONE);
+
+    purc_variant_t v = purc_json_reader_read(reader, rws);
+    ASSERT_EQ(serialize(v), "{\"a\":1}");
+    purc_variant_unref(v);
+
+    /* the bytes read ahead are kept */
+    ASSERT_TRUE(purc_json_reader_set_flags(reader,
+                PCVRNT_JSON_READER_FLAG_ELEMENTS));
+    v = purc_json_reader_read(reader, rws);
+    ASSERT_EQ(serialize(v), "2");
+    purc_variant_unref(v);
+
+    /* not in the middle of an array */
+    ASSERT_FALSE(purc_json_reader_set_flags(reader,
+                PCVRNT_JSON_READER_FLAG_NONE));
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_WRONG_STAGE);
+
+    v = purc_json_reader_read(reader, rws);
+    ASSERT_EQ(serialize(v), "3");
+    purc_variant_unref(v);
+    v = purc_json_reader_read(reader, rws);
+    ASSERT_EQ(serialize(v), "4");
+    purc_variant_unref(v);
+
+    /* but after the last element */
+    ASSERT_TRUE(purc_json_reader_set_flags(reader,
+                PCVRNT_JSON_READER_FLAG_NONE));
+    v = purc_json_reader_read(reader, rws);
+    ASSERT_EQ(serialize(v), "[5,6]");
+    purc_variant_unref(v);
+
+    ASSERT_EQ(purc_json_reader_read(reader, rws), nullptr);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NO_DATA);
+    ASSERT_TRUE(purc_json_reader_set_flags(reader,
+                PCVRNT_JSON_READER_FLAG_NONE));
+
+    purc_json_reader_delete(reader);
+    purc_rwstream_destroy(rws);
+    purc_cleanup();
+}
+
+static void *write_records(void *arg)
+{
+    int fd = (int)(intptr_t)arg;
+    size_t nr = get_nr_records();
+    char buf[128];
+
+    for (size_t i = 0; i < nr; i++) {
+        int len = snprintf(buf, sizeof(buf),
+                "{\"id\": %zu, \"level\": \"info\", \"msg\": \"line %zu\"}\n",
+                i, i);
+        if (write(fd, buf, len) != len)
+            break;
+    }
+
+    close(fd);
+    return NULL;
+}
+
+TEST(json_reader, large_feed)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "json_reader", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    pthread_t th;
+    ASSERT_EQ(pthread_create(&th, NULL, write_records,
+                (void *)(intptr_t)fds[1]), 0);
+
+    purc_rwstream_t rws = purc_rwstream_new_from_unix_fd(fds[0]);
+    purc_json_reader_t reader;
+    reader = purc_json_reader_new(PCVRNT_JSON_READER_FLAG_NONE);
+
+    size_t nr = 0;
+    size_t max_live = 0;
+    purc_variant_t v;
+    while ((v = purc_json_reader_read(reader, rws))) {
+        purc_variant_t id = purc_variant_object_get_by_ckey(v, "id");
+        ASSERT_EQ((size_t)purc_variant_numberify(id), nr);
+        purc_variant_unref(v);
+        nr++;
+
+        if (nr % 1000 == 0) {
+            size_t live = purc_variant_usage_stat()->nr_total_values;
+            if (live > max_live)
+                max_live = live;
+        }
+    }
+
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_NO_DATA);
+    ASSERT_EQ(nr, get_nr_records());
+
+    /* the live values do not grow with the records read */
+    fprintf(stderr, "%zu records read; at most %zu live values\n",
+            nr, max_live);
+    ASSERT_LT(max_live, 1000u);
+
+    pthread_join(th, NULL);
+    purc_json_reader_delete(reader);
+    purc_rwstream_destroy(rws);
+    close(fds[0]);
+    purc_cleanup();
+}
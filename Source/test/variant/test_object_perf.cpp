@@ -0,0 +1,273 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Compares getting, setting and iterating the members of objects indexed
+ * by the hash of keys against the plain rbtree (PURC_VARIANT_OBJECT_INDEX=0),
+ * and checks both give the same members in the same order.
+ *
+ * Use env LOOPS to repeat the operations, e.g.:
+ *
+ *  LOOPS=1000 ./test_object_perf
+ */
+
+#include "purc.h"
+#include "private/variant.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+struct perf_result {
+    double set_ms;
+    double get_ms;
+    double replace_ms;
+    double iterate_ms;
+    string keys;
+    string json;
+    size_t nr_found;
+};
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_loops(void)
+{
+    const char *env = getenv("LOOPS");
+    size_t loops = env ? (size_t)atoll(env) : 0;
+    return loops ? loops : 10;
+}
+
+static vector<string> make_keys(size_t nr_keys)
+{
+    vector<string> keys;
+    for (size_t i = 0; i < nr_keys; i++) {
+        char buf[64];
+        /* shuffle the order of insertion a bit */
+        snprintf(buf, sizeof(buf), "member_%zu", (i * 7919) % nr_keys);
+        keys.push_back(buf);
+    }
+    return keys;
+}
+
+static struct perf_result
+run_object(size_t nr_keys, size_t nr_loops, bool indexed)
+{
+    struct perf_result res = { };
+
+    if (indexed)
+        unsetenv(PURC_ENVV_VARIANT_OBJECT_INDEX);
+    else
+        setenv(PURC_ENVV_VARIANT_OBJECT_INDEX, "0", 1);
+
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "object_perf", NULL);
+    if (ret != PURC_ERROR_OK)
+        return res;
+
+    vector<string> keys = make_keys(nr_keys);
+    vector<purc_variant_t> vals;
+    for (size_t i = 0; i < nr_keys; i++) {
+        vals.push_back(purc_variant_make_ulongint(i));
+    }
+
+    struct timespec ts;
+    purc_variant_t obj = PURC_VARIANT_INVALID;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t n = 0; n < nr_loops; n++) {
+        if (obj)
+            purc_variant_unref(obj);
+        obj = purc_variant_make_object_0();
+        for (size_t i = 0; i < nr_keys; i++) {
+            purc_variant_object_set_by_static_ckey(obj, keys[i].c_str(),
+                    vals[i]);
+        }
+    }
+    res.set_ms = elapsed_ms(&ts);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t n = 0; n < nr_loops; n++) {
+        res.nr_found = 0;
+        for (size_t i = 0; i < nr_keys; i++) {
+            purc_variant_t v;
+            v = purc_variant_object_get_by_ckey(obj, keys[i].c_str());
+            if (v == vals[i])
+                res.nr_found++;
+        }
+    }
+    res.get_ms = elapsed_ms(&ts);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t n = 0; n < nr_loops; n++) {
+        for (size_t i = 0; i < nr_keys; i++) {
+            purc_variant_object_set_by_static_ckey(obj, keys[i].c_str(),
+                    vals[nr_keys - i - 1]);
+        }
+    }
+    res.replace_ms = elapsed_ms(&ts);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t sum = 0;
+    for (size_t n = 0; n < nr_loops; n++) {
+        purc_variant_t k, v;
+        foreach_key_value_in_variant_object(obj, k, v) {
+            (void)k;
+            sum += v->u64;
+        } end_foreach;
+    }
+    res.iterate_ms = elapsed_ms(&ts);
+    EXPECT_EQ(sum, nr_loops * nr_keys * (nr_keys - 1) / 2);
+
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(obj, k, v) {
+        (void)v;
+        res.keys += purc_variant_get_string_const(k);
+        res.keys += ";";
+    } end_foreach;
+
+    char *json = NULL;
+    purc_variant_stringify_alloc(&json, obj);
+    if (json) {
+        res.json = json;
+        free(json);
+    }
+
+    /* remove every other member, then look up all of them again */
+    for (size_t i = 0; i < nr_keys; i += 2) {
+        purc_variant_object_remove_by_static_ckey(obj, keys[i].c_str(),
+                false);
+    }
+    for (size_t i = 0; i < nr_keys; i++) {
+        purc_variant_t v;
+        v = purc_variant_object_get_by_ckey(obj, keys[i].c_str());
+        if (i % 2) {
+            EXPECT_EQ(v, vals[nr_keys - i - 1]);
+        }
+        else {
+            EXPECT_EQ(v, nullptr);
+        }
+    }
+
+    purc_variant_unref(obj);
+    for (size_t i = 0; i < nr_keys; i++) {
+        purc_variant_unref(vals[i]);
+    }
+
+    purc_cleanup();
+    unsetenv(PURC_ENVV_VARIANT_OBJECT_INDEX);
+    return res;
+}
+
+TEST(object_perf, index_vs_rbtree)
+{
+    static const size_t sizes[] = { 4, 8, 9, 16, 64, 1024, 16384 };
+    size_t nr_loops = get_loops();
+
+    for (size_t i = 0; i < PCA_TABLESIZE(sizes); i++) {
+        size_t loops = nr_loops * 1024 / sizes[i];
+        if (loops == 0)
+            loops = 1;
+
+        struct perf_result rbtree = run_object(sizes[i], loops, false);
+        struct perf_result hashed = run_object(sizes[i], loops, true);
+
+        fprintf(stderr, "%6zu members x %6zu: "
+                "set %8.2f/%8.2f ms, get %8.2f/%8.2f ms, "
+                "replace %8.2f/%8.2f ms, iterate %8.2f/%8.2f ms "
+                "(rbtree/indexed)\n",
+                sizes[i], loops,
+                rbtree.set_ms, hashed.set_ms,
+                rbtree.get_ms, hashed.get_ms,
+                rbtree.replace_ms, hashed.replace_ms,
+                rbtree.iterate_ms, hashed.iterate_ms);
+
+        ASSERT_EQ(rbtree.nr_found, sizes[i]);
+        ASSERT_EQ(hashed.nr_found, sizes[i]);
+        ASSERT_EQ(rbtree.keys, hashed.keys);
+        ASSERT_EQ(rbtree.json, hashed.json);
+    }
+}
+
+/* the index dropped after an OOM is rebuilt large enough for all members */
+TEST(object_perf, rebuild_after_drop)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "object_perf", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const size_t nr_keys = 256;
+    vector<string> keys = make_keys(nr_keys * 2);
+    purc_variant_t obj = purc_variant_make_object_0();
+    for (size_t i = 0; i < nr_keys; i++) {
+        purc_variant_t v = purc_variant_make_ulongint(i);
+        purc_variant_object_set_by_static_ckey(obj, keys[i].c_str(), v);
+        purc_variant_unref(v);
+    }
+
+    /* drop the index as obj_index_add() does when failed to grow it */
+    variant_obj_t data = (variant_obj_t)obj->sz_ptr[1];
+    ASSERT_NE(data->index, nullptr);
+    free(data->index);
+    data->index = NULL;
+    data->sz_index = 0;
+
+    for (size_t i = nr_keys; i < nr_keys * 2; i++) {
+        purc_variant_t v = purc_variant_make_ulongint(i);
+        purc_variant_object_set_by_static_ckey(obj, keys[i].c_str(), v);
+        purc_variant_unref(v);
+    }
+    ASSERT_NE(data->index, nullptr);
+    ASSERT_GE(data->sz_index, data->size * 2);
+
+    for (size_t i = 0; i < nr_keys * 2; i++) {
+        purc_variant_t v;
+        v = purc_variant_object_get_by_ckey(obj, keys[i].c_str());
+        ASSERT_NE(v, nullptr);
+        ASSERT_EQ(v->u64, i);
+    }
+
+    for (size_t i = 0; i < nr_keys * 2; i += 2) {
+        ASSERT_TRUE(purc_variant_object_remove_by_static_ckey(obj,
+                    keys[i].c_str(), false));
+    }
+    for (size_t i = 0; i < nr_keys * 2; i++) {
+        purc_variant_t v;
+        v = purc_variant_object_get_by_ckey(obj, keys[i].c_str());
+        if (i % 2) {
+            ASSERT_NE(v, nullptr);
+            ASSERT_EQ(v->u64, i);
+        }
+        else {
+            ASSERT_EQ(v, nullptr);
+        }
+    }
+
+    purc_variant_unref(obj);
+    purc_cleanup();
+}
@@ -0,0 +1,254 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Measures the throughput of serializing and stringifying arrays of
+ * integral and fractional numbers, and checks every number serialized
+ * reads back to the same double.
+ *
+ * Use env LOOPS to repeat the operations, e.g.:
+ *
+ *  LOOPS=100 ./test_serializer_perf
+ */
+
+#include "purc.h"
+#include "private/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+#define NR_NUMBERS      10000
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_loops(void)
+{
+    const char *env = getenv("LOOPS");
+    size_t loops = env ? (size_t)atoll(env) : 0;
+    return loops ? loops : 10;
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    /* xorshift64 keeps the numbers the same on every run */
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static vector<double> make_doubles(bool integral)
+{
+    vector<double> vals;
+    uint64_t state = UINT64_C(88172645463325252);
+
+    while (vals.size() < NR_NUMBERS) {
+        uint64_t r = next_random(&state);
+        double d;
+
+        if (integral) {
+            d = (double)(int64_t)(r % 2000000000) - 1000000000;
+        }
+        else if (vals.size() % 2) {
+            /* the numbers written by people, like prices */
+            d = (double)(int64_t)(r % 2000000) / 100.0 - 10000;
+        }
+        else {
+            memcpy(&d, &r, sizeof(d));
+            if (!isfinite(d))
+                continue;
+        }
+        vals.push_back(d);
+    }
+
+    return vals;
+}
+
+static void check_round_trip(const char *json, const vector<double> &vals)
+{
+    const char *p = json;
+    ASSERT_EQ(*p, '[');
+    p++;
+
+    for (size_t i = 0; i < vals.size(); i++) {
+        char *end;
+        double d = strtod(p, &end);
+        ASSERT_NE(end, p);
+        ASSERT_EQ(memcmp(&d, &vals[i], sizeof(d)), 0) <<
+            "number " << vals[i] << " is serialized as " <<
+            string(p, end - p);
+        p = end;
+        ASSERT_EQ(*p, (i + 1 < vals.size()) ? ',' : ']');
+        p++;
+    }
+}
+
+static void run_numbers(const char *what, bool integral, size_t nr_loops)
+{
+    vector<double> vals = make_doubles(integral);
+
+    purc_variant_t arr = purc_variant_make_array_0();
+    for (size_t i = 0; i < vals.size(); i++) {
+        purc_variant_t v = purc_variant_make_number(vals[i]);
+        purc_variant_array_append(arr, v);
+        purc_variant_unref(v);
+    }
+
+    size_t nr_bytes = 0;
+    purc_rwstream_t rws = NULL;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t n = 0; n < nr_loops; n++) {
+        if (rws)
+            purc_rwstream_destroy(rws);
+        rws = purc_rwstream_new_buffer(1024, 0);
+        size_t len_expected = 0;
+        ssize_t len = purc_variant_serialize(arr, rws, 0,
+                PCVARIANT_SERIALIZE_OPT_PLAIN, &len_expected);
+        ASSERT_GT(len, 0);
+        nr_bytes += len;
+    }
+    double serialize_ms = elapsed_ms(&ts);
+
+    purc_rwstream_write(rws, "", 1);
+    size_t sz_content;
+    const char *json = (const char *)purc_rwstream_get_mem_buffer(rws,
+            &sz_content);
+    check_round_trip(json, vals);
+    purc_rwstream_destroy(rws);
+
+    /* the format used by the serializer before, for reference */
+    char buf[64];
+    size_t nr_printed = 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t n = 0; n < nr_loops; n++) {
+        for (size_t i = 0; i < vals.size(); i++) {
+            nr_printed += snprintf(buf, sizeof(buf), "%.17g", vals[i]);
+        }
+    }
+    double printf_ms = elapsed_ms(&ts);
+    ASSERT_GT(nr_printed, 0U);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t n = 0; n < nr_loops; n++) {
+        char *str = NULL;
+        ASSERT_GT(purc_variant_stringify_alloc(&str, arr), 0);
+        free(str);
+    }
+    double stringify_ms = elapsed_ms(&ts);
+
+    fprintf(stderr, "%-10s x %6zu: serialize %8.2f ms (%6.2f MB/s), "
+            "%%.17g %8.2f ms, stringify %8.2f ms\n",
+            what, nr_loops, serialize_ms,
+            nr_bytes / 1048576.0 / (serialize_ms / 1000.0),
+            printf_ms, stringify_ms);
+
+    purc_variant_unref(arr);
+}
+
+TEST(serializer_perf, numbers)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "serializer_perf", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    size_t nr_loops = get_loops();
+    run_numbers("integral", true, nr_loops);
+    run_numbers("fractional", false, nr_loops);
+
+    purc_cleanup();
+}
+
+TEST(serializer_perf, shortest)
+{
+    static const struct {
+        double d;
+        const char *expected;
+    } cases[] = {
+        { 0.1, "0.1" },
+        { -0.1, "-0.1" },
+        { 0.1 + 0.2, "0.30000000000000004" },
+        { 123.456, "123.456" },
+        { 1e-4, "0.0001" },
+        { 1e-5, "1e-05" },
+        { 1.5e300, "1.5e+300" },
+        { 5e-324, "5e-324" },
+        { 1.7976931348623157e308, "1.7976931348623157e+308" },
+        { 1e16, "10000000000000000" },
+        { 1.25e17, "1.25e+17" },
+        { -0.0, "-0" },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        char buf[PCUTILS_DTOA_BUFSZ];
+        size_t len = pcutils_dtoa_shortest(cases[i].d, buf);
+        ASSERT_STREQ(buf, cases[i].expected);
+        ASSERT_EQ(len, strlen(cases[i].expected));
+    }
+
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "serializer_perf", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    static const struct {
+        double d;
+        const char *serialized;
+        const char *stringified;
+    } numbers[] = {
+        { 0.1, "0.1", "0.1" },
+        { 2.0, "2", "2" },
+        { -0.0, "-0", "-0" },
+        { 1e15 + 0.125, "1000000000000000.1", "1e+15" },
+        { 123456789.0, "123456789", "1.23457e+08" },
+        { 1e20, "100000000000000000000", "1e+20" },
+        { 1e200, "1e+200", "1e+200" },
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(numbers); i++) {
+        purc_variant_t v = purc_variant_make_number(numbers[i].d);
+        char buf[128];
+        purc_rwstream_t rws = purc_rwstream_new_from_mem(buf,
+                sizeof(buf) - 1);
+        size_t len_expected = 0;
+        ssize_t n = purc_variant_serialize(v, rws, 0,
+                PCVARIANT_SERIALIZE_OPT_PLAIN, &len_expected);
+        ASSERT_GT(n, 0);
+        buf[n] = 0;
+        ASSERT_STREQ(buf, numbers[i].serialized);
+        purc_rwstream_destroy(rws);
+
+        n = purc_variant_stringify_buff(buf, sizeof(buf), v);
+        ASSERT_STREQ(buf, numbers[i].stringified);
+        purc_variant_unref(v);
+    }
+
+    purc_cleanup();
+}
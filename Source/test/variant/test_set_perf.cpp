@@ -0,0 +1,434 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Compares adding, finding and removing the elements of sets indexed by
+ * the hash of the unique-key fields against the plain rbtree
+ * (PURC_VARIANT_SET_INDEX=0), and checks both keep the same elements in
+ * the same order.
+ *
+ * Also measures changing the members of large sets in place, which checks
+ * the uniqueness by probing the changed member only.
+ *
+ * Use env LOOPS to repeat the operations, e.g.:
+ *
+ *  LOOPS=100 ./test_set_perf
+ */
+
+#include "purc.h"
+#include "private/variant.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+struct perf_result {
+    double add_ms;
+    double find_ms;
+    double remove_ms;
+    string json;
+    size_t nr_found;
+};
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_loops(void)
+{
+    const char *env = getenv("LOOPS");
+    size_t loops = env ? (size_t)atoll(env) : 0;
+    return loops ? loops : 10;
+}
+
+static purc_variant_t make_member(size_t id)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "user_%zu", id);
+
+    purc_variant_t member = purc_variant_make_object_0();
+    purc_variant_t v = purc_variant_make_string(buf, false);
+    purc_variant_object_set_by_static_ckey(member, "name", v);
+    purc_variant_unref(v);
+    v = purc_variant_make_ulongint(id % 7);
+    purc_variant_object_set_by_static_ckey(member, "group", v);
+    purc_variant_unref(v);
+    return member;
+}
+
+static struct perf_result
+run_set(size_t nr_members, size_t nr_loops, bool indexed)
+{
+    struct perf_result res = { };
+
+    if (indexed)
+        unsetenv(PURC_ENVV_VARIANT_SET_INDEX);
+    else
+        setenv(PURC_ENVV_VARIANT_SET_INDEX, "0", 1);
+
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "set_perf", NULL);
+    if (ret != PURC_ERROR_OK)
+        return res;
+
+    vector<purc_variant_t> members;
+    vector<purc_variant_t> names;
+    vector<purc_variant_t> groups;
+    for (size_t i = 0; i < nr_members; i++) {
+        /* shuffle the order of adding a bit */
+        members.push_back(make_member((i * 7919) % nr_members));
+        names.push_back(purc_variant_ref(
+                    purc_variant_object_get_by_ckey(members[i], "name")));
+        groups.push_back(purc_variant_ref(
+                    purc_variant_object_get_by_ckey(members[i], "group")));
+    }
+
+    struct timespec ts;
+    purc_variant_t set = PURC_VARIANT_INVALID;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t n = 0; n < nr_loops; n++) {
+        if (set)
+            purc_variant_unref(set);
+        set = purc_variant_make_set_by_ckey(0, "name group", NULL);
+        for (size_t i = 0; i < nr_members; i++) {
+            purc_variant_set_add(set, members[i], false);
+        }
+    }
+    res.add_ms = elapsed_ms(&ts);
+    EXPECT_EQ(purc_variant_set_get_size(set), nr_members);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t n = 0; n < nr_loops; n++) {
+        res.nr_found = 0;
+        for (size_t i = 0; i < nr_members; i++) {
+            purc_variant_t v;
+            v = purc_variant_set_get_member_by_key_values(set,
+                    names[i], groups[i]);
+            if (v == members[i])
+                res.nr_found++;
+        }
+    }
+    res.find_ms = elapsed_ms(&ts);
+
+    /* the duplicated elements are still found */
+    for (size_t i = 0; i < nr_members; i++) {
+        purc_variant_t dup = make_member((i * 7919) % nr_members);
+        EXPECT_EQ(pcvariant_set_find(set, dup), members[i]);
+        purc_variant_unref(dup);
+    }
+    EXPECT_EQ(purc_variant_set_get_size(set), nr_members);
+
+    /* changing the unique-key field of a member moves it in the set */
+    if (nr_members > 0) {
+        purc_variant_t renamed = purc_variant_make_string("renamed", false);
+        EXPECT_TRUE(purc_variant_object_set_by_static_ckey(members[0],
+                    "name", renamed));
+        EXPECT_EQ(purc_variant_set_get_member_by_key_values(set,
+                    renamed, groups[0]), members[0]);
+        EXPECT_EQ(purc_variant_set_get_member_by_key_values(set,
+                    names[0], groups[0]), nullptr);
+        purc_clr_error();
+        EXPECT_TRUE(purc_variant_object_set_by_static_ckey(members[0],
+                    "name", names[0]));
+        purc_variant_unref(renamed);
+    }
+
+    char *json = NULL;
+    purc_variant_stringify_alloc(&json, set);
+    if (json) {
+        res.json = json;
+        free(json);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    for (size_t i = 0; i < nr_members; i += 2) {
+        EXPECT_TRUE(purc_variant_set_remove(set, members[i], false));
+    }
+    res.remove_ms = elapsed_ms(&ts);
+
+    for (size_t i = 0; i < nr_members; i++) {
+        purc_variant_t v;
+        v = purc_variant_set_get_member_by_key_values(set,
+                names[i], groups[i]);
+        EXPECT_EQ(v, (i % 2) ? members[i] : nullptr);
+    }
+    purc_clr_error();
+
+    purc_variant_unref(set);
+    for (size_t i = 0; i < nr_members; i++) {
+        purc_variant_unref(members[i]);
+        purc_variant_unref(names[i]);
+        purc_variant_unref(groups[i]);
+    }
+
+    purc_cleanup();
+    unsetenv(PURC_ENVV_VARIANT_SET_INDEX);
+    return res;
+}
+
+TEST(set_perf, index_vs_rbtree)
+{
+    static const size_t sizes[] = { 4, 8, 9, 16, 64, 1024, 4096 };
+    size_t nr_loops = get_loops();
+
+    for (size_t i = 0; i < PCA_TABLESIZE(sizes); i++) {
+        size_t loops = nr_loops * 256 / sizes[i];
+        if (loops == 0)
+            loops = 1;
+
+        struct perf_result rbtree = run_set(sizes[i], loops, false);
+        struct perf_result hashed = run_set(sizes[i], loops, true);
+
+        fprintf(stderr, "%6zu members x %6zu: "
+                "add %8.2f/%8.2f ms, find %8.2f/%8.2f ms, "
+                "remove %8.2f/%8.2f ms (rbtree/indexed)\n",
+                sizes[i], loops,
+                rbtree.add_ms, hashed.add_ms,
+                rbtree.find_ms, hashed.find_ms,
+                rbtree.remove_ms, hashed.remove_ms);
+
+        ASSERT_EQ(rbtree.nr_found, sizes[i]);
+        ASSERT_EQ(hashed.nr_found, sizes[i]);
+        ASSERT_EQ(rbtree.json, hashed.json);
+    }
+}
+
+TEST(set_perf, generic_and_caseless)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "set_perf", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* without the unique key, the elements are compared as strings */
+    purc_variant_t set = purc_variant_make_set_by_ckey(0, NULL, NULL);
+    purc_variant_t caseless = purc_variant_make_set_by_ckey_ex(0, "name",
+            true, NULL);
+    for (size_t i = 0; i < 100; i++) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "Value %zu", i);
+        purc_variant_t s = purc_variant_make_string(buf, false);
+        ASSERT_TRUE(purc_variant_set_add(set, s, false));
+        purc_variant_unref(s);
+
+        /* a number is equal to the string of the same digits */
+        purc_variant_t n = purc_variant_make_ulongint(i);
+        ASSERT_TRUE(purc_variant_set_add(set, n, false));
+        snprintf(buf, sizeof(buf), "%zu", i);
+        s = purc_variant_make_string(buf, false);
+        ASSERT_FALSE(purc_variant_set_add(set, s, false));
+        ASSERT_EQ(pcvariant_set_find(set, s), n);
+        purc_variant_unref(s);
+        purc_variant_unref(n);
+
+        purc_variant_t member = purc_variant_make_object_0();
+        snprintf(buf, sizeof(buf), "Name %zu", i);
+        s = purc_variant_make_string(buf, false);
+        purc_variant_object_set_by_static_ckey(member, "name", s);
+        purc_variant_unref(s);
+        ASSERT_TRUE(purc_variant_set_add(caseless, member, false));
+        purc_variant_unref(member);
+    }
+    ASSERT_EQ(purc_variant_set_get_size(set), 200);
+    purc_clr_error();
+
+    purc_variant_t s = purc_variant_make_string("name 42", false);
+    ASSERT_NE(purc_variant_set_get_member_by_key_values(caseless, s),
+            nullptr);
+    purc_variant_unref(s);
+
+    purc_variant_unref(caseless);
+    purc_variant_unref(set);
+
+    purc_cleanup();
+}
+
+static purc_variant_t make_name(size_t id)
+{
+    purc_variant_t name = purc_variant_make_array_0();
+    purc_variant_t v = purc_variant_make_string("user", false);
+    purc_variant_array_append(name, v);
+    purc_variant_unref(v);
+    v = purc_variant_make_ulongint(id);
+    purc_variant_array_append(name, v);
+    purc_variant_unref(v);
+    return name;
+}
+
+static purc_variant_t make_record(size_t id)
+{
+    purc_variant_t record = purc_variant_make_object_0();
+    purc_variant_t v = make_name(id);
+    purc_variant_object_set_by_static_ckey(record, "name", v);
+    purc_variant_unref(v);
+    v = purc_variant_make_ulongint(0);
+    purc_variant_object_set_by_static_ckey(record, "age", v);
+    purc_variant_unref(v);
+    return record;
+}
+
+TEST(set_perf, update_members)
+{
+    static const size_t sizes[] = { 256, 1024, 4096, 16384 };
+    size_t nr_loops = get_loops();
+
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "set_perf", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    for (size_t i = 0; i < PCA_TABLESIZE(sizes); i++) {
+        size_t nr_records = sizes[i];
+        size_t nr_updates = nr_loops * 100;
+
+        purc_variant_t set = purc_variant_make_set_by_ckey(0, "name", NULL);
+        vector<purc_variant_t> records;
+        for (size_t j = 0; j < nr_records; j++) {
+            records.push_back(make_record(j));
+            ASSERT_TRUE(purc_variant_set_add(set, records[j], false));
+        }
+
+        /* change the fields out of the unique key */
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (size_t n = 0; n < nr_updates; n++) {
+            purc_variant_t record = records[(n * 7919) % nr_records];
+            purc_variant_t age = purc_variant_make_ulongint(n);
+            ASSERT_TRUE(purc_variant_object_set_by_static_ckey(record,
+                        "age", age));
+            purc_variant_unref(age);
+        }
+        double field_ms = elapsed_ms(&ts);
+
+        /* change the descendants in the unique key */
+        size_t serial = nr_records;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (size_t n = 0; n < nr_updates; n++) {
+            purc_variant_t record = records[(n * 7919) % nr_records];
+            purc_variant_t name = purc_variant_object_get_by_ckey(record,
+                    "name");
+            purc_variant_t id = purc_variant_make_ulongint(serial++);
+            ASSERT_TRUE(purc_variant_array_set(name, 1, id));
+            purc_variant_unref(id);
+        }
+        double descendant_ms = elapsed_ms(&ts);
+
+        /* replace the unique key */
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        for (size_t n = 0; n < nr_updates; n++) {
+            purc_variant_t record = records[(n * 7919) % nr_records];
+            purc_variant_t name = make_name(serial++);
+            ASSERT_TRUE(purc_variant_object_set_by_static_ckey(record,
+                        "name", name));
+            ASSERT_EQ(purc_variant_set_get_member_by_key_values(set, name),
+                    record);
+            purc_variant_unref(name);
+        }
+        double key_ms = elapsed_ms(&ts);
+
+        /* but never to the key of another member */
+        purc_variant_t name0 = purc_variant_object_get_by_ckey(records[0],
+                "name");
+        purc_variant_t name1 = purc_variant_object_get_by_ckey(records[1],
+                "name");
+        purc_variant_t id0 = purc_variant_array_get(name0, 1);
+        ASSERT_FALSE(purc_variant_array_set(name1, 1, id0));
+        ASSERT_FALSE(purc_variant_object_set_by_static_ckey(records[1],
+                    "name", name0));
+        purc_clr_error();
+        ASSERT_EQ(purc_variant_object_get_by_ckey(records[1], "name"), name1);
+
+        ASSERT_EQ(purc_variant_set_get_size(set), nr_records);
+        for (size_t j = 0; j < nr_records; j++) {
+            purc_variant_t name = purc_variant_object_get_by_ckey(records[j],
+                    "name");
+            ASSERT_EQ(purc_variant_set_get_member_by_key_values(set, name),
+                    records[j]);
+        }
+
+        fprintf(stderr, "%6zu members, %6zu updates: "
+                "field %8.2f ms, descendant %8.2f ms, key %8.2f ms\n",
+                nr_records, nr_updates, field_ms, descendant_ms, key_ms);
+
+        purc_variant_unref(set);
+        for (size_t j = 0; j < nr_records; j++) {
+            purc_variant_unref(records[j]);
+        }
+    }
+
+    purc_cleanup();
+}
+
+TEST(set_perf, nested_sets)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "set_perf", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* two sets in a generic set must never become equal */
+    purc_variant_t inner1 = purc_variant_make_set_by_ckey(0, NULL, NULL);
+    purc_variant_t inner2 = purc_variant_make_set_by_ckey(0, NULL, NULL);
+    purc_variant_t outer = purc_variant_make_set_by_ckey(0, NULL, NULL);
+
+    vector<purc_variant_t> vals;
+    for (size_t i = 0; i < 64; i++) {
+        vals.push_back(purc_variant_make_ulongint(i));
+        ASSERT_TRUE(purc_variant_set_add(inner1, vals[i], false));
+        if (i < 63) {
+            ASSERT_TRUE(purc_variant_set_add(inner2, vals[i], false));
+        }
+    }
+
+    ASSERT_TRUE(purc_variant_set_add(outer, inner1, false));
+    ASSERT_TRUE(purc_variant_set_add(outer, inner2, false));
+    ASSERT_EQ(purc_variant_set_get_size(outer), 2);
+
+    /* growing inner2 would make it equal to inner1 */
+    ASSERT_FALSE(purc_variant_set_add(inner2, vals[63], false));
+    ASSERT_EQ(purc_variant_set_get_size(inner2), 63);
+    purc_clr_error();
+
+    /* shrinking inner1 likewise */
+    ASSERT_FALSE(purc_variant_set_remove(inner1, vals[63], false));
+    ASSERT_EQ(purc_variant_set_get_size(inner1), 64);
+    purc_clr_error();
+
+    /* while these keep them different */
+    ASSERT_TRUE(purc_variant_set_remove(inner1, vals[0], false));
+    ASSERT_TRUE(purc_variant_set_add(inner2, vals[63], false));
+    ASSERT_EQ(purc_variant_set_get_size(outer), 2);
+    ASSERT_EQ(pcvariant_set_find(outer, inner1), inner1);
+    ASSERT_EQ(pcvariant_set_find(outer, inner2), inner2);
+
+    purc_variant_unref(outer);
+    purc_variant_unref(inner2);
+    purc_variant_unref(inner1);
+    for (size_t i = 0; i < vals.size(); i++) {
+        purc_variant_unref(vals[i]);
+    }
+
+    purc_cleanup();
+}
@@ -0,0 +1,294 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Checks sorting against precomputed keys (pcvariant_sort_by_keys(), used
+ * by `$EJSON.sort` and the `sort` element) yields the same order as sorting
+ * with the variant comparison function, and keeps the members having the
+ * same keys in their original order.
+ *
+ * Also compares the time of both ways for large arrays. Use env NR_MEMBERS
+ * to change the size of the arrays, e.g.:
+ *
+ *  NR_MEMBERS=1000000 ./test_sort_perf
+ */
+
+#include "purc.h"
+#include "private/variant.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gtest/gtest.h>
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_nr_members(void)
+{
+    const char *env = getenv("NR_MEMBERS");
+    size_t nr = env ? (size_t)atoll(env) : 0;
+    return nr ? nr : 100000;
+}
+
+enum member_kind {
+    MEMBER_NUMBER,
+    MEMBER_STRING,
+    MEMBER_OBJECT,
+};
+
+static purc_variant_t make_member(enum member_kind kind, size_t id)
+{
+    char buf[64];
+    purc_variant_t v;
+
+    switch (kind) {
+    case MEMBER_NUMBER:
+        return purc_variant_make_number((double)(random() % 100000) / 7);
+
+    case MEMBER_STRING:
+        snprintf(buf, sizeof(buf), "%cuser_%ld", "aAbBcC"[random() % 6],
+                random() % 10000);
+        return purc_variant_make_string(buf, false);
+
+    case MEMBER_OBJECT:
+    default:
+        break;
+    }
+
+    purc_variant_t member = purc_variant_make_object_0();
+    v = purc_variant_make_ulongint(random() % 50);
+    purc_variant_object_set_by_static_ckey(member, "group", v);
+    purc_variant_unref(v);
+    snprintf(buf, sizeof(buf), "user_%ld", random() % 100);
+    v = purc_variant_make_string(buf, false);
+    purc_variant_object_set_by_static_ckey(member, "name", v);
+    purc_variant_unref(v);
+    v = purc_variant_make_ulongint(id);
+    purc_variant_object_set_by_static_ckey(member, "id", v);
+    purc_variant_unref(v);
+    return member;
+}
+
+static purc_variant_t make_array(enum member_kind kind, size_t nr)
+{
+    purc_variant_t arr = purc_variant_make_array_0();
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t v = make_member(kind, i);
+        purc_variant_array_append(arr, v);
+        purc_variant_unref(v);
+    }
+    return arr;
+}
+
+static purc_variant_t
+call_sort(purc_variant_t ejson, purc_variant_t arr,
+        const char *order, const char *option)
+{
+    purc_variant_t dynamic = purc_variant_object_get_by_ckey(ejson, "sort");
+    purc_dvariant_method getter = purc_variant_dynamic_get_getter(dynamic);
+
+    purc_variant_t argv[3];
+    argv[0] = arr;
+    argv[1] = purc_variant_make_string_static(order, false);
+    argv[2] = purc_variant_make_string_static(option, false);
+    purc_variant_t ret = getter(ejson, 3, argv, 0);
+    purc_variant_unref(argv[1]);
+    purc_variant_unref(argv[2]);
+    return ret;
+}
+
+/* sorts the objects by the group and then the name */
+static int
+decorate_object(purc_variant_t val, struct pcvariant_sort_key *keys,
+        void *ud)
+{
+    (void)ud;
+    purc_variant_t v = purc_variant_object_get_by_ckey(val, "group");
+    keys[0].d = purc_variant_numberify(v);
+    v = purc_variant_object_get_by_ckey(val, "name");
+    keys[1].s = strdup(purc_variant_get_string_const(v));
+    return 0;
+}
+
+static int
+compare_objects(purc_variant_t l, purc_variant_t r, void *ud)
+{
+    (void)ud;
+    int ret = purc_variant_compare_ex(
+            purc_variant_object_get_by_ckey(l, "group"),
+            purc_variant_object_get_by_ckey(r, "group"),
+            PCVARIANT_COMPARE_OPT_NUMBER);
+    if (ret)
+        return ret;
+
+    return purc_variant_compare_ex(
+            purc_variant_object_get_by_ckey(l, "name"),
+            purc_variant_object_get_by_ckey(r, "name"),
+            PCVARIANT_COMPARE_OPT_CASE);
+}
+
+TEST(sort_by_keys, same_order)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "sort_by_keys", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    static const struct {
+        enum member_kind    kind;
+        const char         *order;
+        const char         *option;
+        uintptr_t           sort_opt;
+    } cases[] = {
+        { MEMBER_NUMBER, "asc", "number",
+            PCVARIANT_SORT_ASC | PCVARIANT_COMPARE_OPT_NUMBER },
+        { MEMBER_NUMBER, "desc", "auto",
+            PCVARIANT_SORT_DESC | PCVARIANT_COMPARE_OPT_NUMBER },
+        { MEMBER_STRING, "asc", "case",
+            PCVARIANT_SORT_ASC | PCVARIANT_COMPARE_OPT_CASE },
+        { MEMBER_STRING, "desc", "caseless",
+            PCVARIANT_SORT_DESC | PCVARIANT_COMPARE_OPT_CASELESS },
+        { MEMBER_OBJECT, "asc", "case",
+            PCVARIANT_SORT_ASC | PCVARIANT_COMPARE_OPT_CASE },
+    };
+
+    purc_variant_t ejson = purc_dvobj_ejson_new();
+    ASSERT_NE(ejson, nullptr);
+
+    srandom(1);
+    for (size_t i = 0; i < PCA_TABLESIZE(cases); i++) {
+        purc_variant_t arr = make_array(cases[i].kind, 1000);
+        purc_variant_t expected = purc_variant_container_clone(arr);
+        pcvariant_array_sort(expected, (void *)cases[i].sort_opt, NULL);
+
+        purc_variant_t sorted = call_sort(ejson, arr,
+                cases[i].order, cases[i].option);
+        ASSERT_EQ(sorted, arr);
+        purc_variant_unref(sorted);
+
+        purc_vrtcmp_opt_t opt =
+            (purc_vrtcmp_opt_t)(cases[i].sort_opt & PCVARIANT_CMPOPT_MASK);
+        for (size_t j = 0; j < 1000; j++) {
+            ASSERT_EQ(purc_variant_compare_ex(
+                        purc_variant_array_get(arr, j),
+                        purc_variant_array_get(expected, j), opt), 0);
+        }
+
+        purc_variant_unref(expected);
+        purc_variant_unref(arr);
+    }
+
+    /* multiple keys; the members of a set keep their original order
+       if the keys are the same */
+    purc_variant_t set = purc_variant_make_set_by_ckey(0, "id",
+            PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < 2000; i++) {
+        purc_variant_t v = make_member(MEMBER_OBJECT, i);
+        purc_variant_set_add(set, v, false);
+        purc_variant_unref(v);
+    }
+
+    const enum pcvariant_sort_key_type types[] = {
+        PCVARIANT_SORT_KEY_NUMBER, PCVARIANT_SORT_KEY_STRING };
+    ret = pcvariant_sort_by_keys(set, types, PCA_TABLESIZE(types), false,
+            decorate_object, NULL);
+    ASSERT_EQ(ret, 0);
+
+    for (size_t i = 1; i < 2000; i++) {
+        purc_variant_t l = purc_variant_set_get_by_index(set, i - 1);
+        purc_variant_t r = purc_variant_set_get_by_index(set, i);
+        int diff = compare_objects(l, r, NULL);
+        ASSERT_LE(diff, 0);
+        if (diff == 0) {
+            ASSERT_LT(purc_variant_numberify(
+                        purc_variant_object_get_by_ckey(l, "id")),
+                    purc_variant_numberify(
+                        purc_variant_object_get_by_ckey(r, "id")));
+        }
+    }
+    purc_variant_unref(set);
+
+    purc_variant_unref(ejson);
+    purc_cleanup();
+}
+
+TEST(sort_by_keys, benchmark)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "sort_by_keys", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_variant_t ejson = purc_dvobj_ejson_new();
+    ASSERT_NE(ejson, nullptr);
+
+    size_t nr = get_nr_members();
+    static const char *kinds[] = { "numbers", "strings", "objects" };
+    const enum pcvariant_sort_key_type types[] = {
+        PCVARIANT_SORT_KEY_NUMBER, PCVARIANT_SORT_KEY_STRING };
+
+    srandom(2);
+    for (int kind = MEMBER_NUMBER; kind <= MEMBER_OBJECT; kind++) {
+        purc_variant_t arr = make_array((enum member_kind)kind, nr);
+        purc_variant_t copy = purc_variant_container_clone(arr);
+
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        if (kind == MEMBER_OBJECT) {
+            pcvariant_array_sort(copy, NULL, compare_objects);
+        }
+        else {
+            pcvariant_array_sort(copy, (void *)(uintptr_t)
+                    (kind == MEMBER_NUMBER ? PCVARIANT_COMPARE_OPT_NUMBER :
+                     PCVARIANT_COMPARE_OPT_CASELESS), NULL);
+        }
+        double cmp_ms = elapsed_ms(&ts);
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        if (kind == MEMBER_OBJECT) {
+            ret = pcvariant_sort_by_keys(arr, types, PCA_TABLESIZE(types),
+                    false, decorate_object, NULL);
+            ASSERT_EQ(ret, 0);
+        }
+        else {
+            purc_variant_t sorted = call_sort(ejson, arr, "asc",
+                    kind == MEMBER_NUMBER ? "number" : "caseless");
+            ASSERT_EQ(sorted, arr);
+            purc_variant_unref(sorted);
+        }
+        double keys_ms = elapsed_ms(&ts);
+
+        fprintf(stderr, "%zu %s: sorted with the comparison function in "
+                "%.2f ms; against the precomputed keys in %.2f ms\n",
+                nr, kinds[kind], cmp_ms, keys_ms);
+
+        purc_variant_unref(copy);
+        purc_variant_unref(arr);
+    }
+
+    purc_variant_unref(ejson);
+    purc_cleanup();
+}
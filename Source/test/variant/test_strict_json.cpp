@@ -0,0 +1,333 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Checks the strict JSON parser (pcvariant_make_from_strict_json(), used
+ * by purc_variant_make_from_json_string() and the friends) makes the same
+ * variants as the eJSON parser, and gives up the text using any syntax
+ * beyond JSON.
+ *
+ * Also compares the throughput of both parsers. Use env JSON_SIZE_MB to
+ * change the size of the JSON text, e.g.:
+ *
+ *  JSON_SIZE_MB=100 ./test_strict_json
+ */
+
+#include "purc.h"
+#include "private/variant.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gtest/gtest.h>
+#include <string>
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static size_t get_json_size(void)
+{
+    const char *env = getenv("JSON_SIZE_MB");
+    size_t mb = env ? (size_t)atoll(env) : 0;
+    return (mb ? mb : 8) * 1024 * 1024;
+}
+
+static purc_variant_t parse_by_ejson(const std::string &json)
+{
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(json.c_str(), json.length());
+    if (ptree == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v;
+    v = purc_variant_ejson_parse_tree_evalute(ptree, NULL, NULL, false);
+    purc_variant_ejson_parse_tree_destroy(ptree);
+    return v;
+}
+
+/* compares the stringified values, for NaN and Infinity are not equal
+   to themselves */
+static bool is_same_value(purc_variant_t l, purc_variant_t r)
+{
+    char *sl = NULL, *sr = NULL;
+    purc_variant_stringify_alloc(&sl, l);
+    purc_variant_stringify_alloc(&sr, r);
+
+    bool same = sl && sr && strcmp(sl, sr) == 0 &&
+        purc_variant_get_type(l) == purc_variant_get_type(r);
+    free(sl);
+    free(sr);
+    return same;
+}
+
+static void append_random_string(std::string &json)
+{
+    static const char *pieces[] = {
+        "a", "Z", "0", " ", "_", "\\\"", "\\\\", "\\/", "\\n", "\\t",
+        "\\u00e9", "\\uD83D\\uDE00", "\xc3\xa9", "\xe4\xb8\xad",
+        "{", "]", ":",
+    };
+
+    json += '"';
+    for (long i = random() % 12; i > 0; i--)
+        json += pieces[random() % PCA_TABLESIZE(pieces)];
+    json += '"';
+}
+
+static void append_random_number(std::string &json)
+{
+    static const char *numbers[] = {
+        "0", "-0", "7", "-42", "123456789012345", "1234567890123456",
+        "12345678901234567890", "-9223372036854775808", "0.5", "-3.25",
+        "1e10", "1E-5", "2.5e+3", "6.02214076e23", "1e400", "4.9e-324",
+    };
+
+    json += numbers[random() % PCA_TABLESIZE(numbers)];
+}
+
+static void append_random_value(std::string &json, int depth)
+{
+    long kind = random() % (depth > 5 ? 5 : 7);
+    switch (kind) {
+    case 0:
+        append_random_string(json);
+        break;
+    case 1:
+        append_random_number(json);
+        break;
+    case 2:
+        json += "true";
+        break;
+    case 3:
+        json += "false";
+        break;
+    case 4:
+        json += "null";
+        break;
+    case 5:
+        json += "[ ";
+        for (long i = random() % 5; i >= 0; i--) {
+            append_random_value(json, depth + 1);
+            if (i > 0)
+                json += ",\n";
+        }
+        json += " ]";
+        break;
+    default:
+        json += "{";
+        for (long i = random() % 5; i >= 0; i--) {
+            /* a few duplicate keys */
+            char key[16];
+            snprintf(key, sizeof(key), "\"k%ld\"", random() % 8);
+            json += key;
+            json += " : ";
+            append_random_value(json, depth + 1);
+            if (i > 0)
+                json += ", ";
+        }
+        json += "}";
+        break;
+    }
+}
+
+TEST(strict_json, same_as_ejson)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "strict_json", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    static const char *docs[] = {
+        "0",
+        "-0",
+        "  true ",
+        "null",
+        "\"\"",
+        "\"plain\"",
+        "\"\\b\\f\\n\\r\\t\"",
+        "\"\\\"\\\\\\/\"",
+        "\"\\u4e2d\\uD83D\\uDE00\"",
+        "\"\xe4\xb8\xad\xe6\x96\x87\"",
+        "\xef\xbb\xbf{\"bom\": 1}",
+        "[]",
+        "{}",
+        "[ [ ], { }, [[[]]] ]",
+        "{\"a\": 1, \"b\": [true, false, null], \"c\": {\"d\": \"e\"}}",
+        "{\"dup\": 1, \"dup\": 2}",
+        "[1.5, -2e-3, 1E+2, 123456789012345678901234567890]",
+        "\t\n [\"a\" ,\"b\"]\n",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(docs); i++) {
+        std::string json = docs[i];
+        purc_variant_t fast = pcvariant_make_from_strict_json(json.c_str(),
+                json.length());
+        purc_variant_t slow = parse_by_ejson(json);
+        ASSERT_NE(fast, nullptr) << json;
+        ASSERT_NE(slow, nullptr) << json;
+        ASSERT_TRUE(is_same_value(fast, slow)) << json;
+        purc_variant_unref(fast);
+        purc_variant_unref(slow);
+    }
+
+    srandom(1);
+    for (int i = 0; i < 500; i++) {
+        std::string json = "[";
+        append_random_value(json, 0);
+        json += "]";
+
+        purc_variant_t fast = pcvariant_make_from_strict_json(json.c_str(),
+                json.length());
+        purc_variant_t slow = parse_by_ejson(json);
+        ASSERT_NE(fast, nullptr) << json;
+        ASSERT_NE(slow, nullptr) << json;
+        ASSERT_TRUE(is_same_value(fast, slow)) << json;
+        purc_variant_unref(fast);
+        purc_variant_unref(slow);
+    }
+
+    purc_cleanup();
+}
+
+TEST(strict_json, fallback)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "strict_json", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* valid eJSON, but not strict JSON */
+    static const char *ejson_docs[] = {
+        "[1, 2, ]",
+        "{'a': 'b'}",
+        "{a: 1}",
+        "[10L, 10UL, 1.0FL]",
+        "[undefined, NaN, Infinity]",
+        "\"a\\$b\"",
+        "[01]",
+        "[1] 2",
+        "b64U2VyaWFs",
+        "bx0102",
+        "\"\"\"triple\"\"\"",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(ejson_docs); i++) {
+        std::string json = ejson_docs[i];
+        ASSERT_EQ(pcvariant_make_from_strict_json(json.c_str(),
+                    json.length()), nullptr) << json;
+
+        /* falls back to the eJSON parser */
+        purc_variant_t v = purc_variant_make_from_json_string(json.c_str(),
+                json.length());
+        purc_variant_t slow = parse_by_ejson(json);
+        ASSERT_EQ(v == nullptr, slow == nullptr) << json;
+        if (v) {
+            ASSERT_TRUE(is_same_value(v, slow)) << json;
+            purc_variant_unref(v);
+            purc_variant_unref(slow);
+        }
+    }
+
+    /* malformed or needing the evaluation */
+    static const char *bad_docs[] = {
+        "",
+        "   ",
+        "[",
+        "{\"a\" 1}",
+        "{\"a\": }",
+        "\"unterminated",
+        "\"bad \\x escape\"",
+        "\"\\u12\"",
+        "\"ctrl \x01\"",
+        "\"invalid \xff utf-8\"",
+        "\"$VAR\"",
+        "-",
+        "1.",
+        "1e",
+        "truex",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(bad_docs); i++) {
+        std::string json = bad_docs[i];
+        ASSERT_EQ(pcvariant_make_from_strict_json(json.c_str(),
+                    json.length()), nullptr) << json;
+    }
+
+    /* too deep for the builder stack */
+    std::string deep(100, '[');
+    deep += std::string(100, ']');
+    ASSERT_EQ(pcvariant_make_from_strict_json(deep.c_str(), deep.length()),
+            nullptr);
+
+    purc_cleanup();
+}
+
+TEST(strict_json, benchmark)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hvml.test",
+            "strict_json", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    /* an array of records like those in the datasets */
+    size_t size = get_json_size();
+    std::string json = "[";
+    srandom(2);
+    for (size_t i = 0; json.length() < size; i++) {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%s\n  {\"id\": %zu, \"name\": "
+                "\"user_%ld\", \"score\": %ld.%02ld, \"active\": %s, "
+                "\"tags\": [\"t%ld\", \"t%ld\"], \"note\": null}",
+                i ? "," : "", i, random() % 100000, random() % 1000,
+                random() % 100, (random() & 1) ? "true" : "false",
+                random() % 10, random() % 10);
+        json += buf;
+    }
+    json += "\n]\n";
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_variant_t fast = pcvariant_make_from_strict_json(json.c_str(),
+            json.length());
+    double fast_ms = elapsed_ms(&ts);
+    ASSERT_NE(fast, nullptr);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    purc_variant_t slow = parse_by_ejson(json);
+    double slow_ms = elapsed_ms(&ts);
+    ASSERT_NE(slow, nullptr);
+
+    ASSERT_TRUE(is_same_value(fast, slow));
+    purc_variant_unref(fast);
+    purc_variant_unref(slow);
+
+    /* only reported: the timings depend on the machine and its load */
+    double mb = json.length() / 1024.0 / 1024.0;
+    fprintf(stderr, "%.1f MB of JSON: %.2f MB/s by the strict parser; "
+            "%.2f MB/s by the eJSON parser\n",
+            mb, mb * 1000 / fast_ms, mb * 1000 / slow_ms);
+
+    purc_cleanup();
+}
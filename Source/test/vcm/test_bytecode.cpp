@@ -0,0 +1,205 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc.h"
+#include "private/vcm.h"
+
+#include <stdlib.h>
+#include <string>
+#include <gtest/gtest.h>
+
+using namespace std;
+
+/* evaluate a tree this many times, the bytecode is used after the first */
+#define NR_EVALS        4
+
+struct bytecode_test_data {
+    const char *jsonee;
+    bool silently;
+};
+
+static const struct bytecode_test_data test_cases[] = {
+    { "$X.title", false },
+    { "$X.list[1]", false },
+    { "$X['list']", false },
+    { "$X.list[-1]", false },
+    { "$X.none", false },
+    { "$X.none", true },
+    { "$L.gt($X.n, 3)", false },
+    { "$EJSON.arith('+', $X.n, 2)", false },
+    { "$EJSON.type($X.list)", false },
+    { "$X.n.none()", true },
+    { "{ \"a\": $X.n, \"b\": [1, 2.5, true, null, \"s\", bx0A0B] }", false },
+    { "\"hello $X.title world\"", false },
+    { "{{ $L.lt($X.n, 3) && 'small' || 'big' }}", false },
+    { "{{ $L.gt($X.n, 3) && 'big' || 'small' }}", false },
+    { "{{ $X.none ; $X.title }}", true },
+    { "{{ $X.title ; }}", false },
+};
+
+static purc_variant_t find_var(void *ctxt, const char *name)
+{
+    purc_variant_t vars = (purc_variant_t)ctxt;
+    return purc_variant_object_get_by_ckey(vars, name);
+}
+
+static string to_string(purc_variant_t v)
+{
+    if (v == PURC_VARIANT_INVALID)
+        return "<invalid>";
+
+    char buf[1024];
+    purc_rwstream_t rws = purc_rwstream_new_from_mem(buf, sizeof(buf) - 1);
+    size_t len = 0;
+    purc_variant_serialize(v, rws, 0, PCVARIANT_SERIALIZE_OPT_PLAIN, &len);
+    purc_rwstream_destroy(rws);
+    buf[len] = 0;
+    return string(purc_variant_typename(purc_variant_get_type(v))) + ":" + buf;
+}
+
+static string eval(struct purc_ejson_parse_tree *ptree, purc_variant_t vars,
+        bool silently)
+{
+    purc_variant_t v = purc_variant_ejson_parse_tree_evalute(ptree,
+            find_var, vars, silently);
+    string s = to_string(v);
+    if (v)
+        purc_variant_unref(v);
+    return s;
+}
+
+static purc_variant_t make_vars(void)
+{
+    const char *x = "{ \"title\": \"Object title\", "
+        "\"list\": [1, 2, 3], \"n\": 5 }";
+    purc_variant_t obj = purc_variant_make_from_json_string(x, strlen(x));
+    purc_variant_t l = purc_dvobj_logical_new();
+    purc_variant_t ejson = purc_dvobj_ejson_new();
+
+    purc_variant_t vars = purc_variant_make_object_0();
+    purc_variant_object_set_by_static_ckey(vars, "X", obj);
+    purc_variant_object_set_by_static_ckey(vars, "L", l);
+    purc_variant_object_set_by_static_ckey(vars, "EJSON", ejson);
+    purc_variant_unref(obj);
+    purc_variant_unref(l);
+    purc_variant_unref(ejson);
+    return vars;
+}
+
+/* evaluates the case NR_EVALS times in a new instance */
+static void eval_case(const bytecode_test_data &data, string *results)
+{
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "vcm_bytecode", NULL);
+
+    purc_variant_t vars = make_vars();
+    struct purc_ejson_parse_tree *ptree;
+    ptree = purc_variant_ejson_parse_string(data.jsonee,
+            strlen(data.jsonee));
+    ASSERT_NE(ptree, nullptr);
+
+    for (int i = 0; i < NR_EVALS; i++) {
+        results[i] = eval(ptree, vars, data.silently);
+    }
+    purc_variant_ejson_parse_tree_destroy(ptree);
+
+    purc_variant_unref(vars);
+    purc_cleanup();
+}
+
+class test_vcm_bytecode : public testing::TestWithParam<bytecode_test_data>
+{
+protected:
+    void TearDown() {
+        unsetenv("PURC_VCM_TREE_WALKER");
+    }
+};
+
+TEST_P(test_vcm_bytecode, same_as_tree_walker)
+{
+    bytecode_test_data data = GetParam();
+
+    /* the variable is read when the instance is initialized */
+    setenv("PURC_VCM_TREE_WALKER", "1", 1);
+    string expected[NR_EVALS];
+    eval_case(data, expected);
+    ASSERT_EQ(expected[0], expected[NR_EVALS - 1]);
+
+    unsetenv("PURC_VCM_TREE_WALKER");
+    string results[NR_EVALS];
+    eval_case(data, results);
+    for (int i = 0; i < NR_EVALS; i++) {
+        ASSERT_EQ(results[i], expected[i]) << "Test Case: " << data.jsonee
+            << "; evaluation: " << i;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(vcm_bytecode, test_vcm_bytecode,
+        testing::ValuesIn(test_cases));
+
+/* like a vDOM, a tree may outlive the instance which compiled it */
+TEST(vcm_bytecode, tree_outlives_instance)
+{
+    const char *jsonee =
+        "{ \"a\": $X.n, \"b\": [1, 2.5, true, null, \"s\", bx0A0B] }";
+    struct purc_ejson_parse_tree *ptree = NULL;
+    string results[2];
+
+    for (int n = 0; n < 2; n++) {
+        purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+                "vcm_bytecode", NULL);
+
+        if (ptree == NULL) {
+            ptree = purc_variant_ejson_parse_string(jsonee, strlen(jsonee));
+            ASSERT_NE(ptree, nullptr);
+        }
+
+        purc_variant_t vars = make_vars();
+        for (int i = 0; i < NR_EVALS; i++) {
+            results[n] = eval(ptree, vars, false);
+        }
+
+        /* the constants are prebuilt once in the heap of this instance,
+           not made on every evaluation nor held by the compiled tree */
+        const struct purc_variant_stat *stat = purc_variant_usage_stat();
+        size_t nr_numbers = stat->nr_values[PURC_VARIANT_TYPE_NUMBER];
+        size_t nr_strings = stat->nr_values[PURC_VARIANT_TYPE_STRING];
+
+        for (int i = 0; i < NR_EVALS; i++) {
+            ASSERT_EQ(eval(ptree, vars, false), results[n]);
+        }
+
+        stat = purc_variant_usage_stat();
+        ASSERT_EQ(stat->nr_values[PURC_VARIANT_TYPE_NUMBER], nr_numbers);
+        ASSERT_EQ(stat->nr_values[PURC_VARIANT_TYPE_STRING], nr_strings);
+        purc_variant_unref(vars);
+
+        /* and released when the instance is cleaned up */
+        stat = purc_variant_usage_stat();
+        ASSERT_GT(stat->nr_values[PURC_VARIANT_TYPE_NUMBER], 0u);
+        ASSERT_GT(stat->nr_values[PURC_VARIANT_TYPE_STRING], 0u);
+
+        purc_cleanup();
+    }
+
+    ASSERT_EQ(results[0], results[1]);
+    ASSERT_EQ(results[0], "object:{\"a\":5,\"b\":[1,2.5,true,null,\"s\","
+            "\"0a0b\"]}");
+    purc_variant_ejson_parse_tree_destroy(ptree);
+}
@@ -19,10 +19,12 @@
 
 #include "purc.h"
 #include "private/vdom.h"
+#include "keywords.h"
 
 #include "../helpers.h"
 
 #include <gtest/gtest.h>
+#include <string>
 
 static int _element_count(struct pcvdom_element *top,
     struct pcvdom_element *elem, void *ctx)
@@ -143,3 +145,50 @@ TEST(vdom, fragment)
     }
 }
 
+static int _serialize_cb(const char *buf, size_t len, void *ctxt)
+{
+    std::string *s = (std::string*)ctxt;
+    s->append(buf, len);
+    return 0;
+}
+
+TEST(vdom, attrs)
+{
+    PurCInstance purc("cn.fmsoft.hybridos.test", "test_init", false);
+
+    /* the keywords are resolved by the binary search */
+    for (int kw = PCHVML_KEYWORD_ENUM(HVML, ADD);
+            kw <= PCHVML_KEYWORD_ENUM(HVML, WITHIN); kw++) {
+        const char *s = pchvml_keyword_str((enum pchvml_keyword_enum)kw);
+        EXPECT_EQ(PCHVML_KEYWORD_ENUM_OF(HVML, s), kw) << s;
+    }
+    EXPECT_EQ(PCHVML_KEYWORD_ENUM_OF(HVML, "nokeyword"), -1);
+    EXPECT_EQ(PCHVML_KEYWORD_ENUM_OF(MSG, "on"), -1);
+
+    struct pcvdom_element *elem = pcvdom_element_create(PCHVML_TAG_UPDATE);
+    ASSERT_NE(elem, nullptr);
+
+    /* the attribute with the same key is replaced */
+    const char *keys[] = { "with", "on", "foo", "at", "on" };
+    struct pcvdom_attr *attr_on = NULL;
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        struct pcvdom_attr *attr;
+        attr = pcvdom_attr_create(keys[i], PCHVML_ATTRIBUTE_OPERATOR, NULL);
+        ASSERT_NE(attr, nullptr);
+        ASSERT_EQ(0, pcvdom_element_append_attr(elem, attr));
+        if (strcmp(keys[i], "on") == 0)
+            attr_on = attr;
+    }
+
+    EXPECT_EQ(pcvdom_element_find_attr(elem, "on"), attr_on);
+    EXPECT_EQ(pcvdom_element_get_attr_c(elem, "on"), attr_on);
+    EXPECT_EQ(pcvdom_element_find_attr(elem, "bar"), nullptr);
+
+    /* in the order of the keys */
+    std::string s;
+    pcvdom_util_node_serialize_alone(pcvdom_node_from_element(elem),
+            _serialize_cb, &s);
+    EXPECT_NE(s.find("<update at foo on with>"), std::string::npos) << s;
+
+    pcvdom_node_destroy(pcvdom_node_from_element(elem));
+}
@@ -0,0 +1,302 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#undef NDEBUG
+
+#include "purc.h"
+#include "private/vdom.h"
+
+#include <gtest/gtest.h>
+#include <glob.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+
+#include "../helpers.h"
+
+#define CACHE_DIR       "/tmp/purc-test-vdom-cache"
+
+/* the cache directory is determined when the loader is initialized */
+class VdomCacheEnv : public ::testing::Environment {
+public:
+    void SetUp() override {
+        setenv("PURC_VDOM_CACHE_DIR", CACHE_DIR, 1);
+    }
+};
+
+static ::testing::Environment *const vdom_cache_env =
+    ::testing::AddGlobalTestEnvironment(new VdomCacheEnv);
+
+static double elapsed_ms(const struct timespec *from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - from->tv_sec) * 1000.0 +
+        (now.tv_nsec - from->tv_nsec) / 1000000.0;
+}
+
+static struct pcvdom_document *
+parse_hvml(const char *hvml, size_t len)
+{
+    purc_rwstream_t in = purc_rwstream_new_from_mem((void *)hvml, len);
+    struct pcvdom_document *doc = purc_load_hvml_from_rwstream(in);
+    purc_rwstream_destroy(in);
+    return doc;
+}
+
+static std::string
+dump_doc(struct pcvdom_document *doc, const unsigned char *digest)
+{
+    std::string bin;
+    purc_rwstream_t out = purc_rwstream_new_buffer(0, 0);
+    if (pcvdom_document_dump_bin(doc, digest, out) == 0) {
+        size_t len;
+        const char *data = (const char *)purc_rwstream_get_mem_buffer(out,
+                &len);
+        bin.assign(data, len);
+    }
+    purc_rwstream_destroy(out);
+    return bin;
+}
+
+static bool
+read_file(const char *file, std::string &content)
+{
+    FILE *fp = fopen(file, "r");
+    if (fp == NULL)
+        return false;
+
+    char buf[4096];
+    size_t n;
+    content.clear();
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        content.append(buf, n);
+    fclose(fp);
+    return true;
+}
+
+static bool
+write_file(const char *file, const std::string &content)
+{
+    FILE *fp = fopen(file, "w");
+    if (fp == NULL)
+        return false;
+
+    size_t n = fwrite(content.data(), 1, content.size(), fp);
+    fclose(fp);
+    return n == content.size();
+}
+
+static size_t
+count_files(const char *pattern)
+{
+    glob_t globbuf;
+    size_t n = 0;
+    if (glob(pattern, 0, NULL, &globbuf) == 0)
+        n = globbuf.gl_pathc;
+    globfree(&globbuf);
+    return n;
+}
+
+static void
+remove_cache_dir(void)
+{
+    glob_t globbuf;
+    if (glob(CACHE_DIR "/*", 0, NULL, &globbuf) == 0) {
+        for (size_t i = 0; i < globbuf.gl_pathc; i++)
+            unlink(globbuf.gl_pathv[i]);
+    }
+    globfree(&globbuf);
+    rmdir(CACHE_DIR);
+}
+
+TEST(vdom_cache, dump_load)
+{
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "vdom_cache", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    char path[PATH_MAX + 1];
+    test_getpath_from_env_or_rel(path, sizeof(path),
+        "SOURCE_FILES", "/data/*.hvml");
+
+    glob_t globbuf;
+    ASSERT_EQ(glob(path, 0, NULL, &globbuf), 0);
+
+    const unsigned char digest[PCVDOM_BIN_DIGEST_SIZE] = { 0x01, 0x02 };
+    const unsigned char other[PCVDOM_BIN_DIGEST_SIZE] = { 0x02, 0x01 };
+    size_t nr_docs = 0;
+    for (size_t i = 0; i < globbuf.gl_pathc; i++) {
+        std::string hvml;
+        ASSERT_TRUE(read_file(globbuf.gl_pathv[i], hvml));
+
+        struct pcvdom_document *doc = parse_hvml(hvml.c_str(), hvml.size());
+        if (doc == NULL) {
+            purc_clr_error();
+            continue;
+        }
+
+        std::string bin = dump_doc(doc, digest);
+        ASSERT_FALSE(bin.empty()) << globbuf.gl_pathv[i];
+
+        /* the loaded document is dumped to the same bytes */
+        struct pcvdom_document *loaded;
+        loaded = pcvdom_document_load_bin(bin.data(), bin.size(), digest);
+        ASSERT_NE(loaded, nullptr) << globbuf.gl_pathv[i];
+        ASSERT_EQ(dump_doc(loaded, digest), bin) << globbuf.gl_pathv[i];
+        pcvdom_document_unref(loaded);
+
+        /* compiled for another source */
+        loaded = pcvdom_document_load_bin(bin.data(), bin.size(), other);
+        ASSERT_EQ(loaded, nullptr);
+
+        /* truncated or corrupted */
+        for (size_t len = 0; len < bin.size(); len += bin.size() / 16 + 1) {
+            loaded = pcvdom_document_load_bin(bin.data(), len, digest);
+            ASSERT_EQ(loaded, nullptr);
+
+            std::string bad = bin;
+            bad[len] ^= 0x20;
+            loaded = pcvdom_document_load_bin(bad.data(), bad.size(),
+                    digest);
+            ASSERT_EQ(loaded, nullptr);
+        }
+
+        purc_clr_error();
+        pcvdom_document_unref(doc);
+        nr_docs++;
+    }
+    globfree(&globbuf);
+
+    ASSERT_GT(nr_docs, 0u);
+    purc_cleanup();
+}
+
+TEST(vdom_cache, files)
+{
+    remove_cache_dir();
+
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "vdom_cache", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const char *hvml =
+        "<!DOCTYPE hvml>"
+        "<hvml target=\"html\">"
+        "  <body>"
+        "    <init as=\"data\" with=[1, 2, \"three\", { x: $L.lt(1, 2) }] />"
+        "    <p>$data[2]</p>"
+        "  </body>"
+        "</hvml>";
+
+    char file_a[] = "/tmp/purc-test-vdom-cache-a.hvml";
+    char file_b[] = "/tmp/purc-test-vdom-cache-b.hvml";
+    char file_c[] = "/tmp/purc-test-vdom-cache-c.hvml";
+    ASSERT_TRUE(write_file(file_a, hvml));
+
+    purc_vdom_t vdom = purc_load_hvml_from_file(file_a);
+    ASSERT_NE(vdom, nullptr);
+    ASSERT_EQ(count_files(CACHE_DIR "/*.vdom"), 1u);
+    ASSERT_EQ(count_files(CACHE_DIR "/*.idx"), 1u);
+
+    /* the same content in another file shares the compiled document */
+    ASSERT_TRUE(write_file(file_b, hvml));
+    vdom = purc_load_hvml_from_file(file_b);
+    ASSERT_NE(vdom, nullptr);
+    ASSERT_EQ(count_files(CACHE_DIR "/*.vdom"), 1u);
+    ASSERT_EQ(count_files(CACHE_DIR "/*.idx"), 2u);
+
+    /* a corrupted cache file is ignored and replaced */
+    char pattern[] = CACHE_DIR "/*.vdom";
+    glob_t globbuf;
+    ASSERT_EQ(glob(pattern, 0, NULL, &globbuf), 0);
+    std::string cached;
+    ASSERT_TRUE(read_file(globbuf.gl_pathv[0], cached));
+    ASSERT_TRUE(write_file(globbuf.gl_pathv[0], "garbage"));
+
+    ASSERT_TRUE(write_file(file_c, hvml));
+    vdom = purc_load_hvml_from_file(file_c);
+    ASSERT_NE(vdom, nullptr);
+
+    std::string rewritten;
+    ASSERT_TRUE(read_file(globbuf.gl_pathv[0], rewritten));
+    ASSERT_EQ(rewritten, cached);
+    globfree(&globbuf);
+
+    /* a changed file is compiled again */
+    std::string changed = std::string(hvml) + "<!-- changed -->";
+    ASSERT_TRUE(write_file(file_a, changed));
+    vdom = purc_load_hvml_from_file(file_a);
+    ASSERT_NE(vdom, nullptr);
+    ASSERT_EQ(count_files(CACHE_DIR "/*.vdom"), 2u);
+    ASSERT_EQ(count_files(CACHE_DIR "/*.idx"), 3u);
+
+    purc_cleanup();
+
+    unlink(file_a);
+    unlink(file_b);
+    unlink(file_c);
+    remove_cache_dir();
+}
+
+TEST(vdom_cache, benchmark)
+{
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "vdom_cache", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    std::string hvml = "<!DOCTYPE hvml><hvml target=\"html\"><body>";
+    for (int i = 0; i < 2000; i++) {
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+            "<div id=\"d%d\">"
+            "<init as=\"v%d\" with={ \"a\": %d, \"b\": [1, \"x%d\"] } />"
+            "<p>Item %d: $v%d.a, {{ $L.gt($v%d.a, 5) && 'big' || 'small' }}"
+            "</p></div>", i, i, i, i, i, i, i);
+        hvml += buf;
+    }
+    hvml += "</body></hvml>";
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    struct pcvdom_document *doc = parse_hvml(hvml.c_str(), hvml.size());
+    double parse_ms = elapsed_ms(&ts);
+    ASSERT_NE(doc, nullptr);
+
+    std::string bin = dump_doc(doc, NULL);
+    ASSERT_FALSE(bin.empty());
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    struct pcvdom_document *loaded;
+    loaded = pcvdom_document_load_bin(bin.data(), bin.size(), NULL);
+    double load_ms = elapsed_ms(&ts);
+    ASSERT_NE(loaded, nullptr);
+
+    fprintf(stderr, "%zu bytes of HVML: parsed in %.2f ms; "
+            "%zu bytes compiled: loaded in %.2f ms\n",
+            hvml.size(), parse_ms, bin.size(), load_ms);
+
+    pcvdom_document_unref(loaded);
+    pcvdom_document_unref(doc);
+    purc_cleanup();
+}